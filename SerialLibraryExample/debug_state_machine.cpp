@@ -0,0 +1,102 @@
+/*
+ * Name				:	debug_state_machine.cpp
+ * Created			:	10/19/2026 09:12:40
+ * Author			:	Aaron Reilman
+ * Description		:	Diagnostics state machine running on a second USB CDC port next to the example state machine.
+ */
+
+
+#include "debug_state_machine.h"
+#include "example_state_machine.h"
+
+#if DEBUG_PORT_ENABLE
+
+//Add your public vars----------------
+
+
+char DEBUG_RX_BUFFER[DEBUG_RX_BUFFER_SIZE];
+SerialUSB::USBController debug_controller(1);
+DebugStateMachine::STT_DEBUG_MACHINE * debug_machine = nullptr;
+
+
+//state machine struct getter
+void DebugStateMachine::GetDebugStateMachine(STT_DEBUG_MACHINE * state_machine)
+{
+	debug_machine = state_machine;
+	state_machine->state_actions[STT_STATE::INITIALIZING] = &InitializingStateAction;
+	state_machine->state_actions[STT_STATE::IDLE] = &IdleStateAction;
+	StateMachine::ResetEventMachine(state_machine, STT_STATE::INITIALIZING);
+}
+
+//state action functions
+StateMachine::STT_STATE DebugStateMachine::InitializingStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+{
+	(void)event;
+	(void)data;
+	debug_controller.Init(DEBUG_RX_BUFFER, sizeof(DEBUG_RX_BUFFER));
+	debug_controller.SetFlushPolicy(SerialUSB::FlushPolicy::Newline);
+	//port 0 shares the USB interrupt, so its enable function masks this port too
+	debug_controller.SetEventMode(true, nullptr, &ExampleStateMachine::USBIntEnable);
+	return STT_STATE::IDLE;
+}
+
+StateMachine::STT_STATE DebugStateMachine::IdleStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+{
+	(void)data;
+	if(event != STT_EVENT::SERIAL_EVENT) return STT_STATE::IDLE;
+	uint32_t state = 0;
+	if(debug_controller.ReceiveString("state"))
+	{
+		debug_controller.TransmitString("Example state: ");
+		debug_controller.TransmitInt(ExampleStateMachine::GetState());
+		debug_controller.Transmit('\n');
+	}
+	#if STT_TRACE_ENABLE
+	else if(debug_controller.ReceiveParam(&state, "stats_"))
+	{
+		const StateMachine::STT_TRACE_STATS * stats = StateMachine::GetTraceStats(ExampleStateMachine::GetTrace(), (StateMachine::STT_STATE)state);
+		if(stats != nullptr)
+		{
+			//entries, actions, dwell ticks, action ticks, max action ticks
+			debug_controller.TransmitInt(stats->entries);
+			debug_controller.Transmit(',');
+			debug_controller.TransmitInt(stats->actions);
+			debug_controller.Transmit(',');
+			debug_controller.TransmitInt(stats->dwell_ticks);
+			debug_controller.Transmit(',');
+			debug_controller.TransmitInt(stats->action_ticks);
+			debug_controller.Transmit(',');
+			debug_controller.TransmitInt(stats->max_action_ticks);
+			debug_controller.Transmit('\n');
+		}
+		else
+		{
+			debug_controller.TransmitString("Unknown state\n");
+		}
+	}
+	#endif
+	(void)state;
+	return STT_STATE::IDLE;
+}
+
+//common action functions
+
+void DebugStateMachine::USBISR(void)
+{
+	debug_controller.ISR();
+}
+
+void DebugStateMachine::SerialTask(void)
+{
+	//same as ExampleStateMachine::SerialTask(), for the debug port
+	if(!debug_controller.HasEvents()) return;
+	debug_controller.Task();
+	if(debug_machine != nullptr) StateMachine::PostEvent(debug_machine, STT_EVENT::SERIAL_EVENT);
+}
+
+bool DebugStateMachine::HasEvents(void)
+{
+	return (debug_machine != nullptr && StateMachine::HasEvents(debug_machine)) || debug_controller.HasEvents();
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Name				:	debug_state_machine.h
+ * Created			:	10/19/2026 09:12:40
+ * Author			:	Aaron Reilman
+ * Description		:	Diagnostics state machine running on a second USB CDC port next to the example state machine.
+ */
+
+
+#ifndef __DEBUG_STATE_MACHINE_H__
+#define __DEBUG_STATE_MACHINE_H__
+
+#include "state_machine.h"
+//Add your includes---------------------
+#include "serial_communication.h"
+#include "util.h"
+
+//Add your macros-----------------------
+#define DEBUG_RX_BUFFER_SIZE	64
+//debug port runs on CDC port 1, so it is only built when tusb_config.h enables a second port
+#define DEBUG_PORT_ENABLE		(CFG_TUD_CDC > 1)
+
+/*!
+ * \brief Namespace containing the diagnostics state machine.
+ *
+ * Shows two state machines of different sizes sharing one superloop: the example state machine runs the command console on CDC port 0 and this state machine answers diagnostics
+ * requests on CDC port 1. Both are event driven (USB_Handler wakes the core and each SerialTask() services its port) and run from one StateMachine::STT_SCHEDULER in main().
+ */
+namespace DebugStateMachine
+{
+	/*!
+	 * \brief Defined enum of STT_STATEs
+	 *
+	 * Enum of uint8_t for all implemented states.
+	 */
+	enum STT_STATE : uint8_t {
+		INITIALIZING,			//!< Initializes debug serial controller
+		IDLE,					//!< Answers diagnostics commands
+		NUM_STATES				//!< Number of states
+	};
+	/*!
+	 * \brief Defined enum of STT_EVENTs
+	 *
+	 * Enum of uint8_t for all events posted to the state machine.
+	 */
+	enum STT_EVENT : uint8_t {
+		ENTRY_EVENT = StateMachine::EVENT_ENTRY,	//!< State was just transitioned to
+		SERIAL_EVENT								//!< Debug port received data or USB connection changed
+	};
+	/*!
+	 * \brief Event driven state machine type of the diagnostics state machine
+	 */
+	typedef StateMachine::STT_EVENT_MACHINE_T<STT_STATE::NUM_STATES> STT_DEBUG_MACHINE;
+	/*!
+	 * \brief Populates state machine struct with values
+	 *
+	 * Initializes state machine by populating an initialized struct with states and functions.
+	 *
+	 * \param state_machine pointer to state machine which will be populated with values
+	 */
+	void GetDebugStateMachine(STT_DEBUG_MACHINE * state_machine);
+	/*!
+	 * \brief Initializing State action function (INITIALIZING)
+	 *
+	 * Initializes the debug serial controller on CDC port 1. Must run after the example state machine has initialized clocks and the USB stack.
+	 *
+	 * \param event event being dispatched
+	 * \param data payload of event
+	 * \return state to transition to (IDLE)
+	 */
+	StateMachine::STT_STATE InitializingStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
+	/*!
+	 * \brief Idle State action function (IDLE)
+	 *
+	 * Checks for diagnostics commands sent through the debug port:\n
+	 * "state" prints the current state of the example state machine
+	 * "stats_#" (replace # with a state number) prints the trace statistics of that example state when STT_TRACE_ENABLE is 1
+	 *
+	 * \param event event being dispatched
+	 * \param data payload of event
+	 * \return state to transition to (IDLE)
+	 */
+	StateMachine::STT_STATE IdleStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
+
+	//common action functions and events----------------
+
+	/*!
+	 * \brief Runs the USB interrupt service routine through the debug controller
+	 *
+	 * Called from USB_Handler when the example state machine uses UART, so the USB stack is still serviced.
+	 */
+	void USBISR(void);
+	/*!
+	 * \brief Services the USB stack if the debug port has pending work
+	 *
+	 * Call from your superloop before running the scheduler (refer to ExampleStateMachine::SerialTask()).
+	 */
+	void SerialTask(void);
+	/*!
+	 * \brief Checks if the state machine has pending events
+	 *
+	 * \return true if an event is pending or SerialTask() has work, false otherwise
+	 */
+	bool HasEvents(void);
+}
+
+#endif //__DEBUG_STATE_MACHINE_H__
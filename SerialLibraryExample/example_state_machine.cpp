@@ -7,6 +7,7 @@
 
 
 #include "example_state_machine.h"
+#include "debug_state_machine.h"
 
 //#define USING_UART
 
@@ -21,48 +22,69 @@ SerialUART::UARTController uart_controller;
 SerialUSB::USBController usb_controller;
 #endif
 
-uint32_t param;
 bool connected = false;
 bool echo = false;
+StateMachine::STT_HSM * event_machine = nullptr;
+#if STT_TRACE_ENABLE
+StateMachine::STT_TRACE example_trace;
+uint32_t trace_offset = 0;
+bool trace_dumping = false;
+#endif
+
 
+//state table, rows in STT_STATE order
+constexpr StateMachine::STT_HSM_STATE STATE_TABLE[] = {
+	//parent								entry action									exit action		state action
+	{StateMachine::STT_NO_PARENT,			nullptr,										nullptr,		&ExampleStateMachine::DisabledStateAction},
+	{StateMachine::STT_NO_PARENT,			nullptr,										nullptr,		&ExampleStateMachine::InitializingStateAction},
+	{ExampleStateMachine::STT_STATE::SUPER,	&ExampleStateMachine::OffStateEntry,			nullptr,		&ExampleStateMachine::OffStateAction},
+	{StateMachine::STT_NO_PARENT,			nullptr,										nullptr,		&ExampleStateMachine::PromptUserStateAction},
+	{ExampleStateMachine::STT_STATE::SUPER,	nullptr,										nullptr,		&ExampleStateMachine::OnStateAction},
+	{StateMachine::STT_NO_PARENT,			nullptr,										nullptr,		&ExampleStateMachine::SuperStateAction}
+};
+static_assert(StateMachine::IsValidHSMTable(STATE_TABLE, sizeof(STATE_TABLE) / sizeof(STATE_TABLE[0])), "Invalid example state table");
 
 //state machine struct getter
-void ExampleStateMachine::GetExampleStateMachine(StateMachine::STT_MACHINE * state_machine)
+void ExampleStateMachine::GetExampleStateMachine(StateMachine::STT_HSM * state_machine)
 {
-	state_machine->current_state = STT_STATE::DISABLED;
-	state_machine->state_actions[STT_STATE::DISABLED] = &DisabledStateAction;
-	state_machine->state_actions[STT_STATE::INITIALIZING] = &InitializingStateAction;
-	state_machine->state_actions[STT_STATE::OFF] = &OffStateAction;
-	state_machine->state_actions[STT_STATE::PROMPT_USER] = &PromptUserStateAction;
-	state_machine->state_actions[STT_STATE::ON] = &OnStateAction;
+	event_machine = state_machine;
+	StateMachine::InitHSM(state_machine, STATE_TABLE, sizeof(STATE_TABLE) / sizeof(STATE_TABLE[0]), STT_STATE::DISABLED);
+	#if STT_TRACE_ENABLE
+	StateMachine::SetTrace(state_machine, &example_trace);
+	#endif
 }
 
 //state action functions
-StateMachine::STT_STATE ExampleStateMachine::DisabledStateAction(void)
+StateMachine::STT_STATE ExampleStateMachine::DisabledStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
 {
+	(void)event;
+	(void)data;
 	//do nothing
 	return STT_STATE::INITIALIZING;
 }
 
-StateMachine::STT_STATE ExampleStateMachine::InitializingStateAction(void)
+StateMachine::STT_STATE ExampleStateMachine::InitializingStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
 {
+	(void)event;
+	(void)data;
 	//TODO: CHANGE CLOCK INITIALIZATION TO FIT HARDWARE
 	// Switch CPU clock source to 32 kHz ultra low power oscillator
-	Util::enterCriticalSection();
-	GCLK->GENCTRL.reg = GCLK_GENCTRL_SRC(GCLK_SOURCE_OSCULP32K) | GCLK_GENCTRL_GENEN;  // Change generator 0 source
-	while(GCLK->STATUS.bit.SYNCBUSY);                                  // Wait for write to complete
-
-	// 8 MHz internal oscillator setup
-	SYSCTRL->OSC8M.bit.ENABLE = 0x00u;                                 // Disable oscillator
-	while(SYSCTRL->OSC8M.bit.ENABLE);                                  // Wait for oscillator to stop
-	SYSCTRL->OSC8M.bit.PRESC = 0x00u;                                  // Set options
-	SYSCTRL->OSC8M.bit.ENABLE = 0x01u;                                 // Enable oscillator
-	while(!(SYSCTRL->OSC8M.bit.ENABLE));                               // Wait for oscillator to become ready
-
-	// Set Generic Clock Generator 0 to use the 8 MHz oscillator
-	GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(0) | GCLK_GENCTRL_SRC(GCLK_SOURCE_OSC8M) | GCLK_GENCTRL_GENEN;  // Change generator 0 source
-	while(GCLK->STATUS.bit.SYNCBUSY);                                  // Wait for write to complete
-	Util::exitCriticalSection();
+	{
+		Util::CriticalSection critical_section;
+		GCLK->GENCTRL.reg = GCLK_GENCTRL_SRC(GCLK_SOURCE_OSCULP32K) | GCLK_GENCTRL_GENEN;  // Change generator 0 source
+		while(GCLK->STATUS.bit.SYNCBUSY);                                  // Wait for write to complete
+
+		// 8 MHz internal oscillator setup
+		SYSCTRL->OSC8M.bit.ENABLE = 0x00u;                                 // Disable oscillator
+		while(SYSCTRL->OSC8M.bit.ENABLE);                                  // Wait for oscillator to stop
+		SYSCTRL->OSC8M.bit.PRESC = 0x00u;                                  // Set options
+		SYSCTRL->OSC8M.bit.ENABLE = 0x01u;                                 // Enable oscillator
+		while(!(SYSCTRL->OSC8M.bit.ENABLE));                               // Wait for oscillator to become ready
+
+		// Set Generic Clock Generator 0 to use the 8 MHz oscillator
+		GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(0) | GCLK_GENCTRL_SRC(GCLK_SOURCE_OSC8M) | GCLK_GENCTRL_GENEN;  // Change generator 0 source
+		while(GCLK->STATUS.bit.SYNCBUSY);                                  // Wait for write to complete
+	}
 	
 	#ifdef USING_UART
 	UARTHAL::Peripheral uart_peripheral;
@@ -71,19 +93,32 @@ StateMachine::STT_STATE ExampleStateMachine::InitializingStateAction(void)
 	uart_controller.Init(&uart_peripheral, TX_BUFFER, sizeof(TX_BUFFER), RX_BUFFER, sizeof(RX_BUFFER));
 	#else
 	usb_controller.Init(RX_BUFFER, sizeof(RX_BUFFER));
+	usb_controller.SetFlushPolicy(SerialUSB::FlushPolicy::Newline);		//responses are sent as whole lines
+	usb_controller.SetEventMode(true, nullptr, &USBIntEnable);			//USB events are processed by SerialTask() and posted to the state machine
 	usb_controller.Task(echo);
 	#endif
 	
+	#if STT_TRACE_ENABLE
+	Util::startCycleCounter();
+	StateMachine::SetTraceTimer(&Util::getCycleCount);
+	StateMachine::ClearTrace(&example_trace);
+	#endif
 	return STT_STATE::OFF;
 }
 
-StateMachine::STT_STATE ExampleStateMachine::OffStateAction(void)
+void ExampleStateMachine::OffStateEntry(void)
 {
-	StateMachine::STT_STATE current_state = STT_STATE::OFF;
-	#ifndef USING_UART
-	usb_controller.Task(echo);
-	#endif
 	echo = false;
+	#if STT_TRACE_ENABLE
+	trace_dumping = false;
+	StateMachine::PauseTrace(&example_trace, false);
+	#endif
+}
+
+StateMachine::STT_STATE ExampleStateMachine::OffStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+{
+	(void)data;
+	if(event != STT_EVENT::SERIAL_EVENT) return STT_STATE::OFF;
 	if(TurnOn())
 	{
 		#ifdef USING_UART
@@ -91,27 +126,45 @@ StateMachine::STT_STATE ExampleStateMachine::OffStateAction(void)
 		#else
 		usb_controller.TransmitString("On command received! Turning on...\n");
 		#endif
-		current_state = STT_STATE::PROMPT_USER;
+		return STT_STATE::PROMPT_USER;
 	}
-	StateMachine::ProcessSuperState(&current_state, STT_STATE::SUPER, &SuperStateAction);
-	return current_state;
+	//super state checks for USB connect/disconnect
+	return StateMachine::STT_UNHANDLED;
 }
 
-StateMachine::STT_STATE ExampleStateMachine::PromptUserStateAction(void)
+StateMachine::STT_STATE ExampleStateMachine::PromptUserStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
 {
+	(void)event;
+	(void)data;
 	#ifdef USING_UART
 	uart_controller.TransmitString("Send strings through terminal to see responses!\n");
 	#else
-	usb_controller.Task(echo);
 	usb_controller.TransmitString("Send strings through terminal to see responses!\n");
 	#endif
 	return STT_STATE::ON;
 }
 
-StateMachine::STT_STATE ExampleStateMachine::OnStateAction(void)
+StateMachine::STT_STATE ExampleStateMachine::OnStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
 {
-	StateMachine::STT_STATE current_state = STT_STATE::ON;
+	//parsed commands arrive as events with the parameter as payload
+	if(event == STT_EVENT::INTEGER_EVENT || event == STT_EVENT::SQUARE_EVENT)
+	{
+		uint32_t value = (event == STT_EVENT::SQUARE_EVENT) ? data->u32 * data->u32 : data->u32;
+		#ifdef USING_UART
+		uart_controller.TransmitString((event == STT_EVENT::SQUARE_EVENT) ? "Square value: " : "Integer: ");
+		uart_controller.TransmitInt(value);
+		uart_controller.Transmit('\n');
+		#else
+		usb_controller.TransmitString((event == STT_EVENT::SQUARE_EVENT) ? "Square value: " : "Integer: ");
+		usb_controller.TransmitInt(value);
+		usb_controller.Transmit('\n');
+		#endif
+		return STT_STATE::ON;
+	}
+	if(event != STT_EVENT::SERIAL_EVENT) return STT_STATE::ON;
+	StateMachine::STT_EVENT_DATA param = {};
 	#ifdef USING_UART
+	SendTrace();
 	if(uart_controller.ReceiveString("hello world"))
 	{
 		uart_controller.TransmitString("World: hello!\n");
@@ -122,20 +175,22 @@ StateMachine::STT_STATE ExampleStateMachine::OnStateAction(void)
 		echo = true;
 		uart_controller.TransmitString("(Regular function will cease until unplugged)\n");
 	}
-	else if(uart_controller.ReceiveParam(&param, "integer_"))
+	else if(uart_controller.ReceiveParam(&(param.u32), "integer_"))
 	{
-		uart_controller.TransmitString("Integer: ");
-		uart_controller.TransmitInt(param);
-		uart_controller.Transmit('\n');
+		StateMachine::PostEvent(event_machine, STT_EVENT::INTEGER_EVENT, &param);
 	}
-	else if(uart_controller.ReceiveParam(&param, "square_",'!'))
+	else if(uart_controller.ReceiveParam(&(param.u32), "square_",'!'))
 	{
-		uart_controller.TransmitString("Square value: ");
-		uart_controller.TransmitInt(param * param);
-		uart_controller.Transmit('\n');
+		StateMachine::PostEvent(event_machine, STT_EVENT::SQUARE_EVENT, &param);
 	}
+	#if STT_TRACE_ENABLE
+	else if(uart_controller.ReceiveString("trace"))
+	{
+		StartTrace();
+	}
+	#endif
 	#else
-	usb_controller.Task(echo);
+	SendTrace();
 	if(usb_controller.ReceiveString("hello world"))
 	{
 		usb_controller.TransmitString("World: hello!\n");
@@ -147,18 +202,20 @@ StateMachine::STT_STATE ExampleStateMachine::OnStateAction(void)
 		usb_controller.Task(echo);
 		usb_controller.TransmitString("(Regular function will cease until unplugged)\n");
 	}
-	else if(usb_controller.ReceiveParam(&param, "integer_"))
+	else if(usb_controller.ReceiveParam(&(param.u32), "integer_"))
 	{
-		usb_controller.TransmitString("Integer: ");
-		usb_controller.TransmitInt(param);
-		usb_controller.Transmit('\n');
+		StateMachine::PostEvent(event_machine, STT_EVENT::INTEGER_EVENT, &param);
 	}
-	else if(usb_controller.ReceiveParam(&param, "square_",'!'))
+	else if(usb_controller.ReceiveParam(&(param.u32), "square_",'!'))
 	{
-		usb_controller.TransmitString("Square value: ");
-		usb_controller.TransmitInt(param * param);
-		usb_controller.Transmit('\n');
+		StateMachine::PostEvent(event_machine, STT_EVENT::SQUARE_EVENT, &param);
 	}
+	#if STT_TRACE_ENABLE
+	else if(usb_controller.ReceiveString("trace"))
+	{
+		StartTrace();
+	}
+	#endif
 	#endif
 	if(TurnOff())
 	{
@@ -167,17 +224,17 @@ StateMachine::STT_STATE ExampleStateMachine::OnStateAction(void)
 		#else
 		usb_controller.TransmitString("Off command received! Turning off...\n");
 		#endif
-		current_state = STT_STATE::OFF;
+		return STT_STATE::OFF;
 	}
-	StateMachine::ProcessSuperState(&current_state, STT_STATE::SUPER, &SuperStateAction);
-	return current_state;
+	//super state checks for USB connect/disconnect
+	return StateMachine::STT_UNHANDLED;
 }
 
-StateMachine::STT_STATE ExampleStateMachine::SuperStateAction(void)
+StateMachine::STT_STATE ExampleStateMachine::SuperStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
 {
-	#ifndef USING_UART
-	usb_controller.Task(echo);
-	#endif
+	(void)data;
+	//sub state already serviced the serial port for this event before passing it up
+	if(event != STT_EVENT::SERIAL_EVENT) return STT_STATE::SUPER;
 	if(Unplugged())
 	{
 		return STT_STATE::OFF;
@@ -236,12 +293,97 @@ bool ExampleStateMachine::TurnOff(void)
 	#endif
 }
 
+bool ExampleStateMachine::HasEvents(void)
+{
+	#ifdef USING_UART
+	return event_machine != nullptr && StateMachine::HasEvents(event_machine);
+	#else
+	return (event_machine != nullptr && StateMachine::HasEvents(event_machine)) || usb_controller.HasEvents();
+	#endif
+}
+
+StateMachine::STT_STATE ExampleStateMachine::GetState(void)
+{
+	return (event_machine != nullptr) ? event_machine->current_state : (StateMachine::STT_STATE)STT_STATE::DISABLED;
+}
+
+#if STT_TRACE_ENABLE
+const StateMachine::STT_TRACE * ExampleStateMachine::GetTrace(void)
+{
+	return &example_trace;
+}
+#endif
+
 //common action functions
 
+void ExampleStateMachine::SerialTask(void)
+{
+	#ifndef USING_UART
+	//only service the stack when it has events or received data can be moved, so idle passes of the superloop don't poll
+	if(!usb_controller.HasEvents()) return;
+	usb_controller.Task(echo);
+	//event is posted after the receive buffer is filled, so state actions never see a stale buffer
+	if(event_machine != nullptr) StateMachine::PostEvent(event_machine, STT_EVENT::SERIAL_EVENT);
+	#endif
+}
+
+void ExampleStateMachine::USBIntEnable(uint8_t itf, bool enable)
+{
+	(void)itf;
+	if(enable)
+		NVIC_EnableIRQ(USB_IRQn);
+	else
+		NVIC_DisableIRQ(USB_IRQn);
+}
+
+void ExampleStateMachine::StartTrace(void)
+{
+	#if STT_TRACE_ENABLE
+	//trace is frozen until the last chunk is sent
+	StateMachine::PauseTrace(&example_trace, true);
+	trace_offset = 0;
+	trace_dumping = true;
+	SendTrace();
+	#endif
+}
+
+void ExampleStateMachine::SendTrace(void)
+{
+	#if STT_TRACE_ENABLE
+	if(!trace_dumping) return;
+	char chunk[64];
+	#ifdef USING_UART
+	uint32_t empty = uart_controller.GetTXEmpty();
+	#else
+	uint32_t empty = usb_controller.GetTXEmpty();
+	#endif
+	if(!empty) return;
+	uint32_t count = StateMachine::SerializeTrace(&example_trace, chunk, (empty < sizeof(chunk)) ? empty : sizeof(chunk), trace_offset);
+	if(count)
+	{
+		#ifdef USING_UART
+		uart_controller.TransmitPacket(chunk, count);
+		#else
+		usb_controller.TransmitPacket(chunk, count);
+		usb_controller.Flush();
+		#endif
+		trace_offset += count;
+	}
+	else
+	{
+		trace_dumping = false;
+		StateMachine::PauseTrace(&example_trace, false);
+	}
+	#endif
+}
+
 void USB_Handler(void)
 {
+	//one ISR() call wakes the controllers of all CDC ports
 	#ifndef USING_UART
 	usb_controller.ISR();
+	#elif DEBUG_PORT_ENABLE
+	DebugStateMachine::USBISR();
 	#endif
 }
 
@@ -249,7 +391,21 @@ void SERCOM0_Handler(void)
 {
 	#ifdef USING_UART
 	uart_controller.ISR();
+	//transmit interrupts only drain the transmit buffer, so only reception and errors wake the state machine
+	SerialUART::Status status = uart_controller.GetStatus();
+	if(status.rx_interrupt == SerialUART::RXIRQState::None && status.error_state == SerialUART::UARTError::ENone) return;
+	uart_controller.ClearRXInterrupt();
+	//the example has no error handling, clearing the error status keeps the next transmit interrupt from waking the state machine again
+	uart_controller.ClearErrors();
 	if(echo) uart_controller.EchoRx();
+	if(event_machine != nullptr) StateMachine::PostEvent(event_machine, ExampleStateMachine::STT_EVENT::SERIAL_EVENT);
 	#endif
 }
 
+#if STT_TRACE_ENABLE
+void SysTick_Handler(void)
+{
+	Util::cycleCounterISR();
+}
+#endif
+
@@ -39,6 +39,17 @@ namespace ExampleStateMachine
 		ON,						//!< Primary command processing
 		SUPER					//!< Checks for off command and USB connect/disconnect
 	};
+	/*!
+	 * \brief Defined enum of STT_EVENTs
+	 *
+	 * Enum of uint8_t for all events posted to the state machine.
+	 */
+	enum STT_EVENT : uint8_t {
+		ENTRY_EVENT = StateMachine::EVENT_ENTRY,	//!< State was just transitioned to
+		SERIAL_EVENT,								//!< Serial port received data or USB connection changed
+		INTEGER_EVENT,								//!< "integer_#" command was parsed, payload holds # (u32)
+		SQUARE_EVENT								//!< "square_#!" command was parsed, payload holds # (u32)
+	};
 	/*!
 	 * \brief Populates state machine struct with values
 	 *
@@ -46,60 +57,79 @@ namespace ExampleStateMachine
 	 *
 	 * \param state_machine pointer to state machine which will be populated with values
 	 */
-	void GetExampleStateMachine(StateMachine::STT_MACHINE * state_machine);
+	void GetExampleStateMachine(StateMachine::STT_HSM * state_machine);
 	/*!
 	 * \brief Disabled State action function (DISABLED)
 	 *
 	 * Entry point for state machine, does nothing
 	 *
+	 * \param event event being dispatched
+	 * \param data payload of event
 	 * \return state to transition to (INITIALIZING)
 	 */
-	StateMachine::STT_STATE DisabledStateAction(void);
+	StateMachine::STT_STATE DisabledStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
 	/*!
 	 * \brief Initializing State action function (INITIALIZING)
 	 *
 	 * Initializes clocks and serial controllers
 	 *
+	 * \param event event being dispatched
+	 * \param data payload of event
 	 * \return state to transition to (OFF)
 	 */
-	StateMachine::STT_STATE InitializingStateAction(void);
+	StateMachine::STT_STATE InitializingStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
 	/*!
 	 * \brief Off State action function (OFF)
 	 *
 	 * Sits in an idle off state, only checking for the on ("on") command
 	 *
-	 * \return state to transition to (OFF, or PROMPT_USER, unless super state transitions out of sub-state)
+	 * \param event event being dispatched
+	 * \param data payload of event
+	 * \return state to transition to (OFF, PROMPT_USER, or STT_UNHANDLED to let super state check the event)
 	 */
-	StateMachine::STT_STATE OffStateAction(void);
+	StateMachine::STT_STATE OffStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
+	/*!
+	 * \brief Off State entry function (OFF)
+	 *
+	 * Turns off echo whenever the off state is entered
+	 */
+	void OffStateEntry(void);
 	/*!
 	 * \brief Prompt User State action function (PROMPT_USER)
 	 *
 	 * Sends a message through serial port when on moving to on state
 	 *
+	 * \param event event being dispatched
+	 * \param data payload of event
 	 * \return state to transition to (ON)
 	 */
-	StateMachine::STT_STATE PromptUserStateAction(void);
+	StateMachine::STT_STATE PromptUserStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
 	/*!
 	 * \brief On State action function (ON)
 	 *
 	 * Checks for various commands sent through serial port:\n 
 	 * "hello world" 
-	 * "integer_#" (replace # with a desired ASCII integer)
-	 * "square_#!" (replace # with a desired ASCII integer)
+	 * "integer_#" (replace # with a desired ASCII integer, posted as INTEGER_EVENT)
+	 * "square_#!" (replace # with a desired ASCII integer, posted as SQUARE_EVENT)
 	 * "echo" this will echo the received data onto the terminal and regular function will cease
+	 * "trace" sends the state machine trace (refer to StateMachine::SerializeTrace()) when STT_TRACE_ENABLE is 1
 	 * "off" turns off machine
 	 *
-	 * \return state to transition to (ON, or OFF, unless super state transitions out of sub-state)
+	 * \param event event being dispatched
+	 * \param data payload of event
+	 * \return state to transition to (ON, OFF, or STT_UNHANDLED to let super state check the event)
 	 */
-	StateMachine::STT_STATE OnStateAction(void);
+	StateMachine::STT_STATE OnStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
 	/*!
 	 * \brief Super State action function (SUPER)
 	 *
 	 * Super state which checks for USB connection and disconnection
 	 *
+	 * \param event event being dispatched
+	 * \param data payload of event
 	 * \return state to transition to (SUPER, OFF, or PROMPT_USER)
 	 */
-	StateMachine::STT_STATE SuperStateAction(void);
+	StateMachine::STT_STATE SuperStateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);
 
 	//common action functions and events----------------
 
@@ -135,6 +165,54 @@ namespace ExampleStateMachine
 	 * \return true if off command received, false otherwise
 	 */
 	bool TurnOff(void);
+	/*!
+	 * \brief Enables or disables the USB interrupt
+	 *
+	 * Passed to USBController::SetEventMode() so stack access from state actions can't be interrupted by USB_Handler.
+	 *
+	 * \param itf CDC interface number (unused, all ports share one interrupt)
+	 * \param enable true to enable USB interrupt, false to disable
+	 */
+	void USBIntEnable(uint8_t itf, bool enable);
+	/*!
+	 * \brief Services the USB stack if it has pending work
+	 *
+	 * Call from your superloop before dispatching events, so state actions only read the receive buffer. Runs USBController::Task() when USBController::HasEvents() is true, then posts a 
+	 * serial event, so data received while the state machine was busy is handled before the core sleeps.
+	 */
+	void SerialTask(void);
+	/*!
+	 * \brief Checks if the state machine has pending events
+	 *
+	 * Passed to Util::waitForInterrupt() so the core only sleeps while the state machine and USB stack are idle.
+	 *
+	 * \return true if an event is pending or SerialTask() has work, false otherwise
+	 */
+	bool HasEvents(void);
+	/*!
+	 * \brief Getter for the current state of the state machine
+	 *
+	 * \return current state (DISABLED before GetExampleStateMachine() is called)
+	 */
+	StateMachine::STT_STATE GetState(void);
+	#if STT_TRACE_ENABLE
+	/*!
+	 * \brief Getter for the trace of the state machine
+	 *
+	 * \return pointer to trace of the state machine
+	 */
+	const StateMachine::STT_TRACE * GetTrace(void);
+	#endif
+	/*!
+	 * \brief Starts sending the state machine trace through serial port
+	 *
+	 * Pauses tracing, then sends the trace in chunks each time the state machine receives a serial event. Does nothing if STT_TRACE_ENABLE is 0.
+	 */
+	void StartTrace(void);
+	/*!
+	 * \brief Sends the next chunk of the state machine trace if there is room in the transmit buffer
+	 */
+	void SendTrace(void);
 }
 
 #endif //__EXAMPLE_STATE_MACHINE_H__
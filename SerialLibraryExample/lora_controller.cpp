@@ -12,6 +12,10 @@
 SERCOMHAL::Pinout LoRa::DEFAULT_LORA_BUSY_PIN = {0, 0, 19};
 SERCOMHAL::Pinout LoRa::DEFAULT_LORA_IRQ_PIN = {0, 0, 18};
 SERCOMHAL::Pinout LoRa::DEFAULT_LORA_RESET_PIN = {0, 0, 17};
+#elif SPI_MCU_OPT == OPT_SERCOM_HOST
+SERCOMHAL::Pinout LoRa::DEFAULT_LORA_BUSY_PIN = {0, 0, 19};
+SERCOMHAL::Pinout LoRa::DEFAULT_LORA_IRQ_PIN = {0, 0, 18};
+SERCOMHAL::Pinout LoRa::DEFAULT_LORA_RESET_PIN = {0, 0, 17};
 #else
 SERCOMHAL::Pinout LoRa::DEFAULT_LORA_BUSY_PIN = {0, 0, 0};
 SERCOMHAL::Pinout LoRa::DEFAULT_LORA_IRQ_PIN = {0, 0, 0};
@@ -23,7 +27,7 @@ void LoRa::GetConfigDefaults(LoRa::Config * config_peripheral)
 	SPIHAL::GetPeripheralDefaults(&(config_peripheral->spi_sercom));
 	config_peripheral->busy_pin = DEFAULT_LORA_BUSY_PIN;
 	config_peripheral->irq_pin = DEFAULT_LORA_IRQ_PIN;
-	config_peripheral->reset_pin = DEFAULT_LORA_BUSY_PIN;
+	config_peripheral->reset_pin = DEFAULT_LORA_RESET_PIN;
 	config_peripheral->frequency = 915000000;
 	config_peripheral->output_power = OutputPower::dBm22;
 	config_peripheral->ramp_time = TxRampTime::SET_RAMP_20U;
@@ -327,7 +331,7 @@ void LoRa::LoRaController::ReadBuffer(uint8_t payload)
 	for(uint32_t i = 0; i < payload; i++)
 	{
 		spi_control.Receive(&read_data);
-		received_data.Put(read_data, &(Serial::NoIntEnable));
+		received_data.Put(read_data);
 	}
 }
 
@@ -439,22 +443,27 @@ void LoRa::LoRaController::ClearRxBuffer(void)
 
 bool LoRa::LoRaController::ReadRxChar(char * output)
 {
-	return received_data.Get(&(Serial::NoIntEnable), output);
+	return received_data.Get(output);
 }
 
 bool LoRa::LoRaController::ReadRxString(const char * input, uint32_t shift, bool move_pointer)
 {
-	return received_data.GetString(input, shift, move_pointer, &(Serial::NoIntEnable));
+	return received_data.GetString(input, shift, move_pointer);
+}
+
+bool LoRa::LoRaController::FindRxString(const char * input, uint32_t * offset)
+{
+	return received_data.Find(input, offset);
 }
 
 bool LoRa::LoRaController::ReadRxASCIIInt(uint32_t * output)
 {
-	return received_data.GetASCIIAsInt(output, &(Serial::NoIntEnable));
+	return received_data.GetASCIIAsInt(output);
 }
 
 bool LoRa::LoRaController::ReadRxParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits)
 {
-	return received_data.GetIntParam(output, input, delimiter, max_digits, &(Serial::NoIntEnable));
+	return received_data.GetIntParam(output, input, delimiter, max_digits);
 }
 
 uint32_t LoRa::LoRaController::GetRxAvailable(void) const
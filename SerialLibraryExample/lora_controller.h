@@ -344,6 +344,19 @@ namespace LoRa
 		 * \sa ReceiveSingle(), ReadRxChar(), ReadRxASCIIInt(), ReadRxParam()
 		 */
 		bool ReadRxString(const char * input, uint32_t shift = 0u, bool move_pointer = true);
+		/*!
+		 * \brief Searches unread characters in the received data buffer for a string without reading it.
+		 *
+		 * Unlike ReadRxString(), characters are not removed, so the offset can be used to read up to (or skip past) the match.\n
+		 * Useful for finding a delimiter or newline in long messages.
+		 *
+		 * \param input char array to find
+		 * \param offset pointer to number of characters before the match (default = nullptr)
+		 * \return true if input was found
+		 * \note Input array must be null-character terminated.
+		 * \sa ReadRxString(), ReadRxChar()
+		 */
+		bool FindRxString(const char * input, uint32_t * offset = nullptr);
 		/*!
 		 * \brief Reads SCII number and outputs unsigned int.
 		 *
@@ -388,7 +401,7 @@ namespace LoRa
 		uint16_t preamble_symbols;
 		bool crc_on;
 		SerialSPI::SPIController spi_control;
-		Serial::SerialBuffer received_data;
+		Serial::SerialBuffer<Serial::NoLock> received_data;
 	}; //LoRaController
 }
 
@@ -0,0 +1,545 @@
+/*
+ * Name			:	lora_simulator.cpp
+ * Created		:	10/19/2026 10:05:51 AM
+ * Author		:	Aaron Reilman
+ * Description	:	A simulated Semtech SX126x/LLCC-68 LoRa radio for host (Linux/PC) builds.
+ */
+
+
+#include "lora_simulator.h"
+
+#if (SPI_MCU_OPT == OPT_SERCOM_HOST)
+
+//chip modes (status byte 6:4)
+#define SIM_MODE_STBY_RC		0x2
+#define SIM_MODE_STBY_XOSC		0x3
+#define SIM_MODE_RX				0x5
+#define SIM_MODE_TX				0x6
+//command status (status byte 3:1)
+#define SIM_CMD_OK				0x0
+#define SIM_CMD_DATA_AVAILABLE	0x2
+#define SIM_CMD_TIMEOUT			0x3
+#define SIM_CMD_ERROR			0x4
+#define SIM_CMD_TX_DONE			0x6
+//irq bits
+#define SIM_IRQ_TX_DONE			0x0001
+#define SIM_IRQ_RX_DONE			0x0002
+#define SIM_IRQ_HEADER_VALID	0x0010
+#define SIM_IRQ_CRC_ERROR		0x0040
+#define SIM_IRQ_TIMEOUT			0x0200
+//one timeout step of SetTx/SetRx is 15.625 us
+#define SIM_TIMEOUT_STEP_NS		15625ull
+
+namespace
+{
+	bool SamePin(SERCOMHAL::Pinout a, SERCOMHAL::Pinout b)
+	{
+		return a.port == b.port && a.pin == b.pin;
+	}
+
+	uint32_t GetBandwidthHz(uint8_t bandwidth)
+	{
+		switch(bandwidth)
+		{
+			case 0x00: return 7810;
+			case 0x08: return 10420;
+			case 0x01: return 15630;
+			case 0x09: return 20830;
+			case 0x02: return 31250;
+			case 0x0A: return 41670;
+			case 0x03: return 62500;
+			case 0x04: return 125000;
+			case 0x05: return 250000;
+			case 0x06: return 500000;
+			default: return 125000;
+		}
+	}
+}
+
+void LoRa::GetSimTimingDefaults(LoRa::SimTiming * timing)
+{
+	//typical values from SX126x datasheet switching and wake up times
+	timing->busy_command = 3000;
+	timing->busy_mode_switch = 60000;
+	timing->busy_reset = 3500000;
+}
+
+LoRa::SX126xSimulator::SX126xSimulator(void)
+{
+	link = nullptr;
+	attached = false;
+	selected = false;
+	in_reset = false;
+	rx_queue_head = 0;
+	rx_queue_count = 0;
+	last_tx_length = 0;
+	GetSimTimingDefaults(&timing);
+	ClearStats();
+	ResetRadio();
+}
+
+LoRa::SX126xSimulator::~SX126xSimulator(void)
+{
+	Detach();
+}
+
+void LoRa::SX126xSimulator::Attach(LoRa::Config * config_peripheral, LoRa::SimTiming * timing_config)
+{
+	Detach();
+	config = *config_peripheral;
+	if(timing_config != nullptr)
+		timing = *timing_config;
+	else
+		GetSimTimingDefaults(&timing);
+	SPIHOST::AttachClient(config.spi_sercom.sercom_id, &Transfer, this);
+	SERCOMHOST::AttachPin(config.spi_sercom.ssl_pin, &PinWrite, nullptr, this);
+	SERCOMHOST::AttachPin(config.reset_pin, &PinWrite, nullptr, this);
+	SERCOMHOST::AttachPin(config.busy_pin, nullptr, &PinRead, this);
+	SERCOMHOST::AttachPin(config.irq_pin, nullptr, &PinRead, this);
+	attached = true;
+	ResetRadio();
+	SetBusy(timing.busy_reset);
+}
+
+void LoRa::SX126xSimulator::Detach(void)
+{
+	if(attached)
+	{
+		SPIHOST::AttachClient(config.spi_sercom.sercom_id, nullptr, nullptr);
+		SERCOMHOST::DetachPin(config.spi_sercom.ssl_pin);
+		SERCOMHOST::DetachPin(config.reset_pin);
+		SERCOMHOST::DetachPin(config.busy_pin);
+		SERCOMHOST::DetachPin(config.irq_pin);
+		attached = false;
+	}
+}
+
+void LoRa::SX126xSimulator::Link(LoRa::SX126xSimulator * peer)
+{
+	link = peer;
+}
+
+bool LoRa::SX126xSimulator::QueueRxPacket(const uint8_t * payload, uint8_t length, bool crc_error)
+{
+	if(rx_queue_count >= LORA_SIM_RX_QUEUE_SIZE) return false;
+	RxPacket * packet = &(rx_queue[(rx_queue_head + rx_queue_count) % LORA_SIM_RX_QUEUE_SIZE]);
+	for(uint32_t i = 0; i < length; i++)
+	{
+		packet->payload[i] = payload[i];
+	}
+	packet->length = length;
+	packet->crc_error = crc_error;
+	rx_queue_count++;
+	//already listening, packet starts arriving now
+	if(chip_mode == SIM_MODE_RX && pending_event != Event::RxDone) ScheduleRx();
+	return true;
+}
+
+uint8_t LoRa::SX126xSimulator::GetLastTxPacket(uint8_t * output) const
+{
+	for(uint32_t i = 0; i < last_tx_length; i++)
+	{
+		output[i] = last_tx[i];
+	}
+	return last_tx_length;
+}
+
+uint64_t LoRa::SX126xSimulator::GetTimeOnAir(uint8_t payload) const
+{
+	//time on air formula from SX126x datasheet, computed in quarter symbols to stay in integer math
+	int32_t sf = spread_factor;
+	int32_t numerator = 8 * (int32_t)payload + (crc_on ? 16 : 0) - 4 * sf + (implicit_header ? 0 : 20);
+	int32_t denominator;
+	uint64_t quarter_symbols = 4 * (uint64_t)preamble_symbols;
+	if(sf < 7)
+	{
+		quarter_symbols += 57;	//6.25 + 8
+		denominator = 4 * sf;
+	} else {
+		quarter_symbols += 49;	//4.25 + 8
+		numerator += 8;
+		denominator = low_data_rate_opt ? 4 * (sf - 2) : 4 * sf;
+	}
+	if(numerator > 0)
+		quarter_symbols += 4 * (uint64_t)((numerator + denominator - 1) / denominator) * (coding_rate + 4);
+	return quarter_symbols * (1ull << sf) * 1000000000ull / (4ull * GetBandwidthHz(bandwidth));
+}
+
+uint8_t LoRa::SX126xSimulator::PeekRegister(uint16_t address) const
+{
+	if(address < LORA_SIM_REGISTER_BASE || address >= LORA_SIM_REGISTER_BASE + LORA_SIM_REGISTER_SIZE) return 0;
+	return registers[address - LORA_SIM_REGISTER_BASE];
+}
+
+LoRa::SimStats LoRa::SX126xSimulator::GetStats(void) const
+{
+	return stats;
+}
+
+void LoRa::SX126xSimulator::ClearStats(void)
+{
+	stats = (SimStats){0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+}
+
+uint16_t LoRa::SX126xSimulator::GetIRQFlags(void) const
+{
+	return irq_flags;
+}
+
+uint32_t LoRa::SX126xSimulator::GetFrequency(void) const
+{
+	return frequency;
+}
+
+//private helper function
+uint8_t LoRa::SX126xSimulator::Transfer(uint8_t mosi, void * context)
+{
+	return ((SX126xSimulator *)context)->ProcessByte(mosi);
+}
+
+//private helper function
+void LoRa::SX126xSimulator::PinWrite(SERCOMHAL::Pinout pin, bool level, void * context)
+{
+	SX126xSimulator * radio = (SX126xSimulator *)context;
+	radio->Update();
+	if(SamePin(pin, radio->config.reset_pin))
+	{
+		//reset is active low, radio calibrates after release
+		if(!level)
+		{
+			radio->in_reset = true;
+		}
+		else if(radio->in_reset)
+		{
+			radio->in_reset = false;
+			radio->ResetRadio();
+			radio->SetBusy(radio->timing.busy_reset);
+		}
+	}
+	else if(!level && !radio->selected)
+	{
+		//NSS falling edge starts a new command frame
+		if(radio->IsBusy()) radio->stats.busy_violations++;
+		radio->selected = true;
+		radio->frame_length = 0;
+	}
+	else if(level && radio->selected)
+	{
+		//NSS rising edge executes command
+		radio->selected = false;
+		radio->stats.spi_transactions++;
+		radio->ExecuteCommand();
+	}
+}
+
+//private helper function
+bool LoRa::SX126xSimulator::PinRead(SERCOMHAL::Pinout pin, void * context)
+{
+	SX126xSimulator * radio = (SX126xSimulator *)context;
+	radio->Update();
+	uint64_t now = SERCOMHOST::GetTime();
+	if(SamePin(pin, radio->config.busy_pin))
+	{
+		bool busy = radio->IsBusy();
+		//firmware is spinning on BUSY, skip virtual clock to the falling edge
+		if(busy)
+		{
+			radio->stats.busy_polls++;
+			if(!radio->in_reset) SERCOMHOST::AdvanceTime(radio->busy_until - now);
+		}
+		return busy;
+	}
+	bool irq = radio->IsIRQ();
+	//firmware is spinning on IRQ, skip virtual clock to the next radio event
+	if(!irq)
+	{
+		radio->stats.irq_polls++;
+		if(radio->pending_event != Event::None)
+		{
+			if(radio->event_time > now) SERCOMHOST::AdvanceTime(radio->event_time - now);
+			radio->Update();
+			irq = radio->IsIRQ();
+		}
+	}
+	return irq;
+}
+
+//private helper function
+uint8_t LoRa::SX126xSimulator::ProcessByte(uint8_t mosi)
+{
+	if(!selected || in_reset) return 0xFF;
+	uint32_t index = frame_length;
+	if(index < sizeof(frame)) frame[index] = mosi;
+	frame_length++;
+	stats.spi_bytes++;
+	if(index == 0) return GetStatusByte();
+	switch(frame[0])
+	{
+		case 0x1D:	//ReadRegister: address, status, data...
+			if(index >= 4) return PeekRegister((uint16_t)(((frame[1] << 8) | frame[2]) + index - 4));
+			break;
+		case 0x1E:	//ReadBuffer: offset, status, data...
+			if(index >= 3) return data_buffer[(uint8_t)(frame[1] + index - 3)];
+			break;
+		case 0x12:	//GetIrqStatus: status, irq (15:8), irq (7:0)
+			if(index == 2) return (uint8_t)(irq_flags >> 8);
+			if(index == 3) return (uint8_t)(irq_flags & 0xFF);
+			break;
+		case 0x13:	//GetRxBufferStatus: status, payload length, rx start pointer
+			if(index == 2) return rx_payload_length;
+			if(index == 3) return rx_base;
+			break;
+	}
+	return GetStatusByte();
+}
+
+//private helper function
+void LoRa::SX126xSimulator::ExecuteCommand(void)
+{
+	if(frame_length == 0) return;
+	uint8_t * params = &(frame[1]);
+	uint32_t num_params = ((frame_length < sizeof(frame)) ? frame_length : sizeof(frame)) - 1;
+	command_status = SIM_CMD_OK;
+	switch(frame[0])
+	{
+		case 0x80:	//SetStandby
+			chip_mode = (num_params > 0 && params[0]) ? SIM_MODE_STBY_XOSC : SIM_MODE_STBY_RC;
+			pending_event = Event::None;
+			break;
+		case 0x86:	//SetRfFrequency
+			if(num_params >= 4)
+			{
+				uint64_t freq = ((uint64_t)params[0] << 24) | ((uint64_t)params[1] << 16) | ((uint64_t)params[2] << 8) | params[3];
+				frequency = (uint32_t)(freq * 32000000 / (1 << 25));
+			}
+			break;
+		case 0x8F:	//SetBufferBaseAddress
+			if(num_params >= 2)
+			{
+				tx_base = params[0];
+				rx_base = params[1];
+			}
+			break;
+		case 0x8B:	//SetModulationParams
+			if(num_params >= 4)
+			{
+				spread_factor = params[0];
+				bandwidth = params[1];
+				coding_rate = params[2];
+				low_data_rate_opt = params[3];
+			}
+			break;
+		case 0x8C:	//SetPacketParams
+			if(num_params >= 5)
+			{
+				preamble_symbols = (uint16_t)((params[0] << 8) | params[1]);
+				implicit_header = params[2];
+				payload_length = params[3];
+				crc_on = params[4];
+			}
+			break;
+		case 0x08:	//SetDioIrqParams
+			if(num_params >= 4)
+			{
+				irq_mask = (uint16_t)((params[0] << 8) | params[1]);
+				dio1_mask = (uint16_t)((params[2] << 8) | params[3]);
+			}
+			break;
+		case 0x02:	//ClearIrqStatus
+			if(num_params >= 2) irq_flags &= (uint16_t)~((params[0] << 8) | params[1]);
+			break;
+		case 0x0D:	//WriteRegister
+			for(uint32_t i = 2; i < num_params; i++)
+			{
+				uint32_t address = (uint32_t)((params[0] << 8) | params[1]) + i - 2;
+				if(address >= LORA_SIM_REGISTER_BASE && address < LORA_SIM_REGISTER_BASE + LORA_SIM_REGISTER_SIZE)
+					registers[address - LORA_SIM_REGISTER_BASE] = params[i];
+			}
+			break;
+		case 0x0E:	//WriteBuffer
+			for(uint32_t i = 1; i < num_params; i++)
+			{
+				data_buffer[(uint8_t)(params[0] + i - 1)] = params[i];
+			}
+			break;
+		case 0x82:	//SetRx
+			StartRx((num_params >= 3) ? (uint32_t)((params[0] << 16) | (params[1] << 8) | params[2]) : 0);
+			return;
+		case 0x83:	//SetTx
+			StartTx((num_params >= 3) ? (uint32_t)((params[0] << 16) | (params[1] << 8) | params[2]) : 0);
+			return;
+		case 0x8A:	//SetPacketType
+		case 0x95:	//SetPaConfig
+		case 0x8E:	//SetTxParams
+		case 0x1D:	//ReadRegister
+		case 0x1E:	//ReadBuffer
+		case 0x12:	//GetIrqStatus
+		case 0x13:	//GetRxBufferStatus
+		case 0xC0:	//GetStatus
+			break;
+		default:
+			stats.unknown_opcodes++;
+			command_status = SIM_CMD_ERROR;
+			break;
+	}
+	SetBusy(timing.busy_command);
+}
+
+//private helper function
+void LoRa::SX126xSimulator::Update(void)
+{
+	if(pending_event == Event::None || SERCOMHOST::GetTime() < event_time) return;
+	Event event = pending_event;
+	pending_event = Event::None;
+	switch(event)
+	{
+		case Event::TxDone:
+			last_tx_length = payload_length;
+			for(uint32_t i = 0; i < payload_length; i++)
+			{
+				last_tx[i] = data_buffer[(uint8_t)(tx_base + i)];
+			}
+			chip_mode = SIM_MODE_STBY_RC;
+			command_status = SIM_CMD_TX_DONE;
+			irq_flags |= SIM_IRQ_TX_DONE & irq_mask;
+			stats.tx_packets++;
+			stats.airtime += GetTimeOnAir(payload_length);
+			if(link != nullptr) link->QueueRxPacket(last_tx, last_tx_length);
+			break;
+		case Event::RxDone:
+		{
+			RxPacket * packet = &(rx_queue[rx_queue_head]);
+			for(uint32_t i = 0; i < packet->length; i++)
+			{
+				data_buffer[(uint8_t)(rx_base + i)] = packet->payload[i];
+			}
+			rx_payload_length = packet->length;
+			irq_flags |= (SIM_IRQ_RX_DONE | SIM_IRQ_HEADER_VALID | (packet->crc_error ? SIM_IRQ_CRC_ERROR : 0)) & irq_mask;
+			rx_queue_head = (rx_queue_head + 1) % LORA_SIM_RX_QUEUE_SIZE;
+			rx_queue_count--;
+			command_status = SIM_CMD_DATA_AVAILABLE;
+			stats.rx_packets++;
+			stats.airtime += GetTimeOnAir(rx_payload_length);
+			if(!rx_continuous)
+				chip_mode = SIM_MODE_STBY_RC;
+			else if(rx_queue_count > 0)
+				ScheduleRx();
+			break;
+		}
+		case Event::Timeout:
+			chip_mode = SIM_MODE_STBY_RC;
+			command_status = SIM_CMD_TIMEOUT;
+			irq_flags |= SIM_IRQ_TIMEOUT & irq_mask;
+			stats.timeouts++;
+			break;
+		case Event::None:
+			break;
+	}
+}
+
+//private helper function
+void LoRa::SX126xSimulator::ResetRadio(void)
+{
+	selected = false;
+	rx_continuous = false;
+	chip_mode = SIM_MODE_STBY_RC;
+	command_status = SIM_CMD_OK;
+	busy_until = 0;
+	pending_event = Event::None;
+	event_time = 0;
+	frame_length = 0;
+	for(uint32_t i = 0; i < sizeof(data_buffer); i++)
+	{
+		data_buffer[i] = 0;
+	}
+	for(uint32_t i = 0; i < sizeof(registers); i++)
+	{
+		registers[i] = 0;
+	}
+	//LoRa private sync word and tx clamp reset values
+	registers[0x0740 - LORA_SIM_REGISTER_BASE] = 0x14;
+	registers[0x0741 - LORA_SIM_REGISTER_BASE] = 0x24;
+	registers[0x08D8 - LORA_SIM_REGISTER_BASE] = 0xC8;
+	tx_base = 0;
+	rx_base = 0;
+	rx_payload_length = 0;
+	irq_flags = 0;
+	irq_mask = 0;
+	dio1_mask = 0;
+	frequency = 0;
+	spread_factor = 7;
+	bandwidth = 0x04;
+	coding_rate = 0x01;
+	low_data_rate_opt = 0;
+	preamble_symbols = 12;
+	implicit_header = false;
+	payload_length = 0xFF;
+	crc_on = true;
+}
+
+//private helper function
+void LoRa::SX126xSimulator::StartRx(uint32_t timeout)
+{
+	chip_mode = SIM_MODE_RX;
+	rx_continuous = (timeout == 0x00FFFFFF);
+	SetBusy(timing.busy_mode_switch);
+	pending_event = Event::None;
+	if(timeout != 0 && !rx_continuous)
+	{
+		pending_event = Event::Timeout;
+		event_time = busy_until + timeout * SIM_TIMEOUT_STEP_NS;
+	}
+	if(rx_queue_count > 0) ScheduleRx();
+}
+
+//private helper function
+void LoRa::SX126xSimulator::StartTx(uint32_t timeout)
+{
+	chip_mode = SIM_MODE_TX;
+	SetBusy(timing.busy_mode_switch);
+	pending_event = Event::TxDone;
+	event_time = busy_until + GetTimeOnAir(payload_length);
+	//tx timeout is a safety limit, only hit when time on air exceeds it
+	if(timeout != 0 && timeout * SIM_TIMEOUT_STEP_NS < GetTimeOnAir(payload_length))
+	{
+		pending_event = Event::Timeout;
+		event_time = busy_until + timeout * SIM_TIMEOUT_STEP_NS;
+	}
+}
+
+//private helper function
+void LoRa::SX126xSimulator::ScheduleRx(void)
+{
+	uint64_t start = (busy_until > SERCOMHOST::GetTime()) ? busy_until : SERCOMHOST::GetTime();
+	uint64_t done = start + GetTimeOnAir(rx_queue[rx_queue_head].length);
+	//rx timeout only stops reception if it expires before the packet finishes
+	if(pending_event == Event::Timeout && event_time <= done) return;
+	pending_event = Event::RxDone;
+	event_time = done;
+}
+
+//private helper function
+void LoRa::SX126xSimulator::SetBusy(uint32_t duration)
+{
+	busy_until = SERCOMHOST::GetTime() + duration;
+}
+
+//private helper function
+uint8_t LoRa::SX126xSimulator::GetStatusByte(void) const
+{
+	return (uint8_t)((chip_mode << 4) | (command_status << 1));
+}
+
+//private helper function
+bool LoRa::SX126xSimulator::IsBusy(void)
+{
+	return in_reset || SERCOMHOST::GetTime() < busy_until;
+}
+
+//private helper function
+bool LoRa::SX126xSimulator::IsIRQ(void)
+{
+	return (irq_flags & dio1_mask) != 0;
+}
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Name			:	lora_simulator.h
+ * Created		:	10/19/2026 10:05:51 AM
+ * Author		:	Aaron Reilman
+ * Description	:	A simulated Semtech SX126x/LLCC-68 LoRa radio for host (Linux/PC) builds.
+ */
+
+
+#ifndef __LORA_SIMULATOR_H__
+#define __LORA_SIMULATOR_H__
+
+#include "lora_controller.h"
+
+#if (SPI_MCU_OPT == OPT_SERCOM_HOST)
+
+#define LORA_SIM_RX_QUEUE_SIZE		4
+#define LORA_SIM_REGISTER_BASE		0x0600
+#define LORA_SIM_REGISTER_SIZE		0x0400
+
+namespace LoRa
+{
+	/*!
+	 * \brief Simulated radio timing (all values in nanoseconds of virtual time).
+	 */
+	struct SimTiming {
+		uint32_t busy_command;					//!< BUSY high time after a configuration, buffer, or register command
+		uint32_t busy_mode_switch;				//!< BUSY high time after SetTx/SetRx (oscillator start and PLL lock)
+		uint32_t busy_reset;					//!< BUSY high time after reset pin is released (calibration)
+	};
+	/*!
+	 * \brief Counters collected by the simulated radio, used to measure driver cost per packet.
+	 */
+	struct SimStats {
+		uint32_t spi_transactions;				//!< Number of NSS low/high frames
+		uint32_t spi_bytes;						//!< Number of bytes clocked on the %SPI bus
+		uint32_t busy_polls;					//!< Number of BUSY pin reads while BUSY was high
+		uint32_t irq_polls;						//!< Number of DIO1/IRQ pin reads while IRQ was low
+		uint32_t busy_violations;				//!< Number of frames started while BUSY was high
+		uint32_t unknown_opcodes;				//!< Number of frames with an opcode the simulator doesn't model
+		uint32_t tx_packets;					//!< Number of completed transmissions
+		uint32_t rx_packets;					//!< Number of completed receptions (including CRC errors)
+		uint32_t timeouts;						//!< Number of Tx/Rx timeouts
+		uint64_t airtime;						//!< Total time on air in nanoseconds
+	};
+	/*!
+	 * \brief Populates a timing struct with typical SX126x values
+	 *
+	 * \param timing pointer to timing struct to populate with default values
+	 */
+	void GetSimTimingDefaults(SimTiming * timing);
+	/*!
+	 * \brief Simulated SX126x/LLCC-68 radio object
+	 *
+	 * This is a host-only model of the radio which sits behind the host %SPI HAL and host pin HAL, so an unmodified LoRaController can run on a PC.\n
+	 * It decodes every opcode sent by LoRaController (standby, packet type, frequency, PA config, Tx params, buffer base address, modulation params, packet params, IRQ params,
+	 * register read/write, buffer read/write, IRQ status, Rx buffer status, SetRx, SetTx), drives BUSY after each command, and asserts IRQ after the computed time on air.\n
+	 * All time is virtual (refer to SERCOMHOST::GetTime()), so latency measurements are deterministic.
+	 */
+	class SX126xSimulator
+	{
+		//functions
+		public:
+		/*!
+		 * \brief Constructor
+		 *
+		 * Instantiates a simulated radio. Attach() must be called before the controller is initialized.
+		 *
+		 * \sa ~SX126xSimulator(), Attach()
+		 */
+		SX126xSimulator(void);
+		/*!
+		 * \brief Destructor
+		 *
+		 * Detaches radio from the simulated %SPI bus and pins.
+		 *
+		 * \sa SX126xSimulator(), Detach()
+		 */
+		~SX126xSimulator(void);
+		/*!
+		 * \brief Connects the radio to the simulated %SPI bus and pins.
+		 *
+		 * Uses the same config struct as LoRaController::Init() so both sides agree on SERCOM# and pins.
+		 *
+		 * \param config_peripheral pointer to config struct passed to LoRaController::Init()
+		 * \param timing pointer to timing struct (default = nullptr, uses GetSimTimingDefaults())
+		 * \sa Detach()
+		 */
+		void Attach(Config * config_peripheral, SimTiming * timing = nullptr);
+		/*!
+		 * \brief Disconnects the radio from the simulated %SPI bus and pins.
+		 *
+		 * \sa Attach()
+		 */
+		void Detach(void);
+		/*!
+		 * \brief Links another simulated radio as the receiver of all transmitted packets.
+		 *
+		 * \param peer simulated radio to receive packets (nullptr to unlink)
+		 */
+		void Link(SX126xSimulator * peer);
+		/*!
+		 * \brief Queues a packet to be received over the air.
+		 *
+		 * The packet is delivered (RxDone IRQ) one time on air after the radio enters receive mode, or immediately after queuing if it is already in receive mode.
+		 *
+		 * \param payload bytes of packet
+		 * \param length number of bytes in packet
+		 * \param crc_error flag packet as failing CRC check (default = false)
+		 * \return success of queuing (false if queue is full)
+		 */
+		bool QueueRxPacket(const uint8_t * payload, uint8_t length, bool crc_error = false);
+		/*!
+		 * \brief Copies the last transmitted packet.
+		 *
+		 * \param output array to copy packet into (must hold 255 bytes)
+		 * \return number of bytes in last transmitted packet
+		 */
+		uint8_t GetLastTxPacket(uint8_t * output) const;
+		/*!
+		 * \brief Computes time on air with the current modulation and packet parameters.
+		 *
+		 * \param payload number of payload bytes
+		 * \return time on air in nanoseconds
+		 */
+		uint64_t GetTimeOnAir(uint8_t payload) const;
+		/*!
+		 * \brief Reads a simulated register value without going through %SPI.
+		 *
+		 * \param address register address
+		 * \return register value (0 if out of simulated range)
+		 */
+		uint8_t PeekRegister(uint16_t address) const;
+
+		SimStats GetStats(void) const;				//!< Getter for simulation counters
+		void ClearStats(void);						//!< Clears simulation counters
+		uint16_t GetIRQFlags(void) const;			//!< Getter for pending IRQ flags (9:0)
+		uint32_t GetFrequency(void) const;			//!< Getter for RF frequency in Hz as decoded from SetRfFrequency
+
+		private:
+		//private helper functions
+		static uint8_t Transfer(uint8_t mosi, void * context);
+		static void PinWrite(SERCOMHAL::Pinout pin, bool level, void * context);
+		static bool PinRead(SERCOMHAL::Pinout pin, void * context);
+		uint8_t ProcessByte(uint8_t mosi);
+		void ExecuteCommand(void);
+		void Update(void);
+		void ResetRadio(void);
+		void StartRx(uint32_t timeout);
+		void StartTx(uint32_t timeout);
+		void ScheduleRx(void);
+		void SetBusy(uint32_t duration);
+		uint8_t GetStatusByte(void) const;
+		bool IsBusy(void);
+		bool IsIRQ(void);
+
+		//private data members
+		enum class Event { None, TxDone, RxDone, Timeout };
+		struct RxPacket {
+			uint8_t payload[255];
+			uint8_t length;
+			bool crc_error;
+		};
+		Config config;
+		SimTiming timing;
+		SimStats stats;
+		SX126xSimulator * link;
+		bool attached;
+		bool selected;
+		bool in_reset;
+		bool rx_continuous;
+		uint8_t chip_mode;
+		uint8_t command_status;
+		uint64_t busy_until;
+		Event pending_event;
+		uint64_t event_time;
+		uint8_t frame[260];
+		uint32_t frame_length;
+		uint8_t data_buffer[256];
+		uint8_t registers[LORA_SIM_REGISTER_SIZE];
+		uint8_t tx_base;
+		uint8_t rx_base;
+		uint8_t rx_payload_length;
+		uint16_t irq_flags;
+		uint16_t irq_mask;
+		uint16_t dio1_mask;
+		uint32_t frequency;
+		uint8_t spread_factor;
+		uint8_t bandwidth;
+		uint8_t coding_rate;
+		uint8_t low_data_rate_opt;
+		uint16_t preamble_symbols;
+		bool implicit_header;
+		uint8_t payload_length;
+		bool crc_on;
+		uint8_t last_tx_length;
+		uint8_t last_tx[255];
+		RxPacket rx_queue[LORA_SIM_RX_QUEUE_SIZE];
+		uint8_t rx_queue_head;
+		uint8_t rx_queue_count;
+	}; //SX126xSimulator
+}
+
+#endif
+
+#endif //__LORA_SIMULATOR_H__
@@ -8,14 +8,41 @@
 
 #include "sam.h"
 #include "example_state_machine.h"
+#include "debug_state_machine.h"
+
+#if DEBUG_PORT_ENABLE
+bool HasWork(void)
+{
+	return ExampleStateMachine::HasEvents() || DebugStateMachine::HasEvents();
+}
+#endif
 
 
 int main(void)
 {
-    StateMachine::STT_MACHINE example_state_machine;
+    StateMachine::STT_HSM example_state_machine;
 	ExampleStateMachine::GetExampleStateMachine(&example_state_machine);
+	#if DEBUG_PORT_ENABLE
+	//example state machine runs first so clocks and the USB stack are initialized before the debug port
+	DebugStateMachine::STT_DEBUG_MACHINE debug_state_machine;
+	DebugStateMachine::GetDebugStateMachine(&debug_state_machine);
+	StateMachine::STT_TASK tasks[] = {StateMachine::MakeTask(&example_state_machine, 0), StateMachine::MakeTask(&debug_state_machine, 1)};
+	StateMachine::STT_SCHEDULER scheduler;
+	StateMachine::InitScheduler(&scheduler, tasks, sizeof(tasks) / sizeof(tasks[0]), StateMachine::SchedulePolicy::Priority);
+	#endif
     while (1) 
     {
-		StateMachine::ExecuteAction(&example_state_machine);
+		//service the USB stack only if it has work, then dispatch the events it posted
+		ExampleStateMachine::SerialTask();
+		#if DEBUG_PORT_ENABLE
+		DebugStateMachine::SerialTask();
+		while(StateMachine::RunScheduler(&scheduler));
+		//sleep until an ISR posts the next event
+		Util::waitForInterrupt(&HasWork);
+		#else
+		StateMachine::ExecuteEvents(&example_state_machine);
+		//sleep until an ISR posts the next event
+		Util::waitForInterrupt(&ExampleStateMachine::HasEvents);
+		#endif
     }
 }
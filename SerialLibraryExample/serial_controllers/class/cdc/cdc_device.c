@@ -41,6 +41,9 @@ enum
   BULK_PACKET_SIZE = (TUD_OPT_HIGH_SPEED ? 512 : 64)
 };
 
+// Number of transfer buffers per data endpoint, two keeps a transfer queued while the other one completes
+#define CDCD_EP_BUFCOUNT  (CFG_TUD_EDPT_PINGPONG ? 2 : 1)
+
 typedef struct
 {
   uint8_t itf_num;
@@ -51,6 +54,11 @@ typedef struct
   // Bit 0:  DTR (Data Terminal Ready), Bit 1: RTS (Request to Send)
   uint8_t line_state;
 
+  // Transfer buffer index of the next OUT transfer to queue/complete and the next IN transfer to queue
+  uint8_t epout_queue;
+  uint8_t epout_done;
+  uint8_t epin_queue;
+
   /*------------- From this point, data is not cleared by bus reset -------------*/
   char    wanted_char;
   cdc_line_coding_t line_coding;
@@ -62,14 +70,14 @@ typedef struct
   uint8_t rx_ff_buf[CFG_TUD_CDC_RX_BUFSIZE];
   uint8_t tx_ff_buf[CFG_TUD_CDC_TX_BUFSIZE];
 
-#if CFG_FIFO_MUTEX
+#if CFG_FIFO_MUTEX && !CFG_TUSB_FIFO_SPSC
   osal_mutex_def_t rx_ff_mutex;
   osal_mutex_def_t tx_ff_mutex;
 #endif
 
   // Endpoint Transfer buffer
-  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CFG_TUD_CDC_EP_BUFSIZE];
-  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CFG_TUD_CDC_EP_BUFSIZE];
+  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CDCD_EP_BUFCOUNT][CFG_TUD_CDC_EP_BUFSIZE];
+  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CDCD_EP_BUFCOUNT][CFG_TUD_CDC_EP_BUFSIZE];
 
 }cdcd_interface_t;
 
@@ -80,16 +88,19 @@ typedef struct
 //--------------------------------------------------------------------+
 CFG_TUSB_MEM_SECTION static cdcd_interface_t _cdcd_itf[CFG_TUD_CDC];
 
-static bool _prep_out_transaction (cdcd_interface_t* p_cdc)
+static bool _prep_out_buffer (cdcd_interface_t* p_cdc)
 {
   uint8_t const rhport = 0;
   uint16_t available = tu_fifo_remaining(&p_cdc->rx_ff);
 
+  // Room for the transfer in progress (ping-pong) and the new one
+  uint16_t const needed = (uint16_t) (sizeof(p_cdc->epout_buf[0]) * (usbd_edpt_busy(rhport, p_cdc->ep_out) ? 2 : 1));
+
   // Prepare for incoming data but only allow what we can store in the ring buffer.
   // TODO Actually we can still carry out the transfer, keeping count of received bytes
   // and slowly move it to the FIFO when read().
   // This pre-check reduces endpoint claiming
-  TU_VERIFY(available >= sizeof(p_cdc->epout_buf));
+  TU_VERIFY(available >= needed);
 
   // claim endpoint
   TU_VERIFY(usbd_edpt_claim(rhport, p_cdc->ep_out));
@@ -97,9 +108,12 @@ static bool _prep_out_transaction (cdcd_interface_t* p_cdc)
   // fifo can be changed before endpoint is claimed
   available = tu_fifo_remaining(&p_cdc->rx_ff);
 
-  if ( available >= sizeof(p_cdc->epout_buf) )
+  if ( available >= needed )
   {
-    return usbd_edpt_xfer(rhport, p_cdc->ep_out, p_cdc->epout_buf, sizeof(p_cdc->epout_buf));
+    uint8_t const idx = p_cdc->epout_queue;
+    TU_VERIFY(usbd_edpt_xfer(rhport, p_cdc->ep_out, p_cdc->epout_buf[idx], sizeof(p_cdc->epout_buf[idx])));
+    p_cdc->epout_queue = (uint8_t) ((idx + 1) % CDCD_EP_BUFCOUNT);
+    return true;
   }else
   {
     // Release endpoint since we don't make any transfer
@@ -109,6 +123,18 @@ static bool _prep_out_transaction (cdcd_interface_t* p_cdc)
   }
 }
 
+// Queue OUT transfers on every free transfer buffer (both with ping-pong endpoints)
+static bool _prep_out_transaction (cdcd_interface_t* p_cdc)
+{
+  bool queued = false;
+  for ( uint8_t i = 0; i < CDCD_EP_BUFCOUNT; i++ )
+  {
+    if ( !_prep_out_buffer(p_cdc) ) break;
+    queued = true;
+  }
+  return queued;
+}
+
 //--------------------------------------------------------------------+
 // APPLICATION API
 //--------------------------------------------------------------------+
@@ -155,6 +181,18 @@ bool tud_cdc_n_peek(uint8_t itf, uint8_t* chr)
   return tu_fifo_peek(&_cdcd_itf[itf].rx_ff, chr);
 }
 
+void tud_cdc_n_read_info (uint8_t itf, tu_fifo_buffer_info_t* info)
+{
+  tu_fifo_get_read_info(&_cdcd_itf[itf].rx_ff, info);
+}
+
+void tud_cdc_n_read_advance (uint8_t itf, uint32_t count)
+{
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  tu_fifo_advance_read_pointer(&p_cdc->rx_ff, (uint16_t) count);
+  _prep_out_transaction(p_cdc);
+}
+
 void tud_cdc_n_read_flush (uint8_t itf)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
@@ -195,11 +233,13 @@ uint32_t tud_cdc_n_write_flush (uint8_t itf)
   TU_VERIFY( usbd_edpt_claim(rhport, p_cdc->ep_in), 0 );
 
   // Pull data from FIFO
-  uint16_t const count = tu_fifo_read_n(&p_cdc->tx_ff, p_cdc->epin_buf, sizeof(p_cdc->epin_buf));
+  uint8_t const idx = p_cdc->epin_queue;
+  uint16_t const count = tu_fifo_read_n(&p_cdc->tx_ff, p_cdc->epin_buf[idx], sizeof(p_cdc->epin_buf[idx]));
 
   if ( count )
   {
-    TU_ASSERT( usbd_edpt_xfer(rhport, p_cdc->ep_in, p_cdc->epin_buf, count), 0 );
+    TU_ASSERT( usbd_edpt_xfer(rhport, p_cdc->ep_in, p_cdc->epin_buf[idx], count), 0 );
+    p_cdc->epin_queue = (uint8_t) ((idx + 1) % CDCD_EP_BUFCOUNT);
     return count;
   }else
   {
@@ -247,7 +287,7 @@ void cdcd_init(void)
     // In this way, the most current data is prioritized.
     tu_fifo_config(&p_cdc->tx_ff, p_cdc->tx_ff_buf, TU_ARRAY_SIZE(p_cdc->tx_ff_buf), 1, true);
 
-#if CFG_FIFO_MUTEX
+#if CFG_FIFO_MUTEX && !CFG_TUSB_FIFO_SPSC
     tu_fifo_config_mutex(&p_cdc->rx_ff, NULL, osal_mutex_create(&p_cdc->rx_ff_mutex));
     tu_fifo_config_mutex(&p_cdc->tx_ff, osal_mutex_create(&p_cdc->tx_ff_mutex), NULL);
 #endif
@@ -435,14 +475,18 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   // Received new data
   if ( ep_addr == p_cdc->ep_out )
   {
-    tu_fifo_write_n(&p_cdc->rx_ff, &p_cdc->epout_buf, (uint16_t) xferred_bytes);
+    // Transfers complete in the order they were queued
+    uint8_t const* epout_buf = p_cdc->epout_buf[p_cdc->epout_done];
+    p_cdc->epout_done = (uint8_t) ((p_cdc->epout_done + 1) % CDCD_EP_BUFCOUNT);
+
+    tu_fifo_write_n(&p_cdc->rx_ff, epout_buf, (uint16_t) xferred_bytes);
     
     // Check for wanted char and invoke callback if needed
     if ( tud_cdc_rx_wanted_cb && (((signed char) p_cdc->wanted_char) != -1) )
     {
       for ( uint32_t i = 0; i < xferred_bytes; i++ )
       {
-        if ( (p_cdc->wanted_char == p_cdc->epout_buf[i]) && !tu_fifo_empty(&p_cdc->rx_ff) )
+        if ( (p_cdc->wanted_char == epout_buf[i]) && !tu_fifo_empty(&p_cdc->rx_ff) )
         {
           tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
         }
@@ -468,7 +512,9 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     {
       // If there is no data left, a ZLP should be sent if
       // xferred_bytes is multiple of EP Packet size and not zero
-      if ( !tu_fifo_count(&p_cdc->tx_ff) && xferred_bytes && (0 == (xferred_bytes & (BULK_PACKET_SIZE-1))) )
+      // (unless a ping-pong transfer is still in progress, its own completion decides)
+      if ( !tu_fifo_count(&p_cdc->tx_ff) && xferred_bytes && (0 == (xferred_bytes & (BULK_PACKET_SIZE-1))) &&
+           !usbd_edpt_busy(rhport, p_cdc->ep_in) )
       {
         if ( usbd_edpt_claim(rhport, p_cdc->ep_in) )
         {
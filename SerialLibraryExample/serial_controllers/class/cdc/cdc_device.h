@@ -84,6 +84,13 @@ void     tud_cdc_n_read_flush      (uint8_t itf);
 // Get a byte from FIFO at the specified position without removing it
 bool     tud_cdc_n_peek            (uint8_t itf, uint8_t* ui8);
 
+// Get pointers to received data in the FIFO (linear and wrapped part) without copying it.
+// Must be followed by tud_cdc_n_read_advance() with the number of bytes consumed
+void     tud_cdc_n_read_info       (uint8_t itf, tu_fifo_buffer_info_t* info);
+
+// Remove bytes consumed through tud_cdc_n_read_info() from the FIFO
+void     tud_cdc_n_read_advance    (uint8_t itf, uint32_t count);
+
 // Write bytes to TX FIFO, data may remain in the FIFO for a while
 uint32_t tud_cdc_n_write           (uint8_t itf, void const* buffer, uint32_t bufsize);
 
@@ -238,14 +238,19 @@ bool cdch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *it
 
 bool cdch_set_config(uint8_t dev_addr, uint8_t itf_num)
 {
-  (void) dev_addr; (void) itf_num;
+  // nothing to configure, notify usbh that this interface is ready so enumeration can continue
+  usbh_driver_set_config_complete(dev_addr, itf_num);
   return true;
 }
 
 bool cdch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes)
 {
-  (void) ep_addr;
-  tuh_cdc_xfer_isr( dev_addr, event, 0, xferred_bytes );
+  cdch_data_t const * p_cdc = get_itf(dev_addr);
+
+  cdc_pipeid_t const pipe_id = (ep_addr == p_cdc->ep_notif) ? CDC_PIPE_NOTIFICATION :
+                               (ep_addr == p_cdc->ep_in   ) ? CDC_PIPE_DATA_IN      : CDC_PIPE_DATA_OUT;
+
+  tuh_cdc_xfer_isr( dev_addr, event, pipe_id, xferred_bytes );
   return true;
 }
 
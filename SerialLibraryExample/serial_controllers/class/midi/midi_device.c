@@ -66,7 +66,7 @@ typedef struct
   uint8_t rx_ff_buf[CFG_TUD_MIDI_RX_BUFSIZE];
   uint8_t tx_ff_buf[CFG_TUD_MIDI_TX_BUFSIZE];
 
-  #if CFG_FIFO_MUTEX
+  #if CFG_FIFO_MUTEX && !CFG_TUSB_FIFO_SPSC
   osal_mutex_def_t rx_ff_mutex;
   osal_mutex_def_t tx_ff_mutex;
   #endif
@@ -384,7 +384,7 @@ void midid_init(void)
     tu_fifo_config(&midi->rx_ff, midi->rx_ff_buf, CFG_TUD_MIDI_RX_BUFSIZE, 1, false); // true, true
     tu_fifo_config(&midi->tx_ff, midi->tx_ff_buf, CFG_TUD_MIDI_TX_BUFSIZE, 1, false); // OBVS.
 
-    #if CFG_FIFO_MUTEX
+    #if CFG_FIFO_MUTEX && !CFG_TUSB_FIFO_SPSC
     tu_fifo_config_mutex(&midi->rx_ff, NULL, osal_mutex_create(&midi->rx_ff_mutex));
     tu_fifo_config_mutex(&midi->tx_ff, osal_mutex_create(&midi->tx_ff_mutex), NULL);
     #endif
@@ -50,12 +50,22 @@ enum
   MSC_STAGE_NEED_RESET,
 };
 
+// State of a READ10/WRITE10 pipeline buffer
+enum
+{
+  MSCD_BUF_EMPTY = 0,
+  MSCD_BUF_IO,    // storage callback is reading into/writing from the buffer (asynchronous I/O)
+  MSCD_BUF_READY, // READ10: data read from storage to send, WRITE10: data received to write to storage
+  MSCD_BUF_XFER,  // queued on the endpoint
+};
+
 typedef struct
 {
   // TODO optimize alignment
   CFG_TUSB_MEM_ALIGN msc_cbw_t cbw;
   CFG_TUSB_MEM_ALIGN msc_csw_t csw;
 
+  uint8_t  rhport;
   uint8_t  itf_num;
   uint8_t  ep_in;
   uint8_t  ep_out;
@@ -69,20 +79,42 @@ typedef struct
   uint8_t sense_key;
   uint8_t add_sense_code;
   uint8_t add_sense_qualifier;
+
+  // READ10/WRITE10 streaming pipeline: storage I/O on one buffer while the others are on the bus.
+  // Buffers are used in turn, storage I/O and USB transfers both complete in order.
+  uint8_t  buf_state[CFG_TUD_MSC_BUFCOUNT];
+  uint16_t buf_len[CFG_TUD_MSC_BUFCOUNT];  // READ10: bytes read from storage, WRITE10: bytes received from host
+  uint16_t buf_off[CFG_TUD_MSC_BUFCOUNT];  // WRITE10: bytes already written to storage
+  uint8_t const* buf_data[CFG_TUD_MSC_BUFCOUNT]; // READ10: data to send, class buffer or application memory (zero-copy)
+  uint8_t  io_idx;                         // next buffer for storage I/O
+  uint8_t  xfer_idx;                       // next buffer to queue on the endpoint
+  uint8_t  done_idx;                       // oldest buffer queued on the endpoint
+  uint32_t io_len;                         // READ10: bytes read from storage, WRITE10: bytes requested from host
+  bool     retry_pending;                  // simulated transfer complete queued to retry storage I/O later
+
+  // Asynchronous storage I/O: completions are tagged with the command they were started for,
+  // so a late completion of a command aborted by a reset is dropped instead of applied to the next one.
+  uint16_t cmd_seq;                        // incremented for every CBW and reset, kept across resets
+  int32_t  async_result;                   // bytes_io of the completion deferred to usbd task
 }mscd_interface_t;
 
 CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static mscd_interface_t _mscd_itf;
-CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static uint8_t _mscd_buf[CFG_TUD_MSC_EP_BUFSIZE];
+CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static uint8_t _mscd_buf[CFG_TUD_MSC_BUFCOUNT][CFG_TUD_MSC_EP_BUFSIZE];
 
 //--------------------------------------------------------------------+
 // INTERNAL OBJECT & FUNCTION DECLARATION
 //--------------------------------------------------------------------+
 static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize);
 static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc);
+static void proc_read10_pump(uint8_t rhport, mscd_interface_t* p_msc);
+static void proc_read10_sent(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes);
 
 static void proc_write10_cmd(uint8_t rhport, mscd_interface_t* p_msc);
+static void proc_write10_pump(uint8_t rhport, mscd_interface_t* p_msc);
 static void proc_write10_new_data(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes);
 
+static void proc_status_stage(uint8_t rhport, mscd_interface_t* p_msc);
+
 TU_ATTR_ALWAYS_INLINE static inline bool is_data_in(uint8_t dir)
 {
   return tu_bit_test(dir, 7);
@@ -256,7 +288,10 @@ void mscd_init(void)
 void mscd_reset(uint8_t rhport)
 {
   (void) rhport;
+  // keep counting so that completions of I/O started before the reset don't match a new command
+  uint16_t const cmd_seq = _mscd_itf.cmd_seq;
   tu_memclr(&_mscd_itf, sizeof(mscd_interface_t));
+  _mscd_itf.cmd_seq = (uint16_t) (cmd_seq + 1);
 }
 
 uint16_t mscd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len)
@@ -273,6 +308,7 @@ uint16_t mscd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
   TU_ASSERT(max_len >= drv_len, 0);
 
   mscd_interface_t * p_msc = &_mscd_itf;
+  p_msc->rhport  = rhport;
   p_msc->itf_num = itf_desc->bInterfaceNumber;
 
   // Open endpoint pair
@@ -286,6 +322,7 @@ uint16_t mscd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
 
 static void proc_bot_reset(mscd_interface_t* p_msc)
 {
+  p_msc->cmd_seq++;
   p_msc->stage       = MSC_STAGE_CMD;
   p_msc->total_len   = 0;
   p_msc->xferred_len = 0;
@@ -421,6 +458,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
       p_csw->status       = MSC_CSW_STATUS_PASSED;
 
       /*------------- Parse command and prepare DATA -------------*/
+      p_msc->cmd_seq++;
       p_msc->stage = MSC_STAGE_DATA;
       p_msc->total_len = p_cbw->total_bytes;
       p_msc->xferred_len = 0;
@@ -455,7 +493,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         // 2. IN & Zero: Process if is built-in, else Invoke app callback. Skip DATA if zero length
         if ( (p_cbw->total_bytes > 0 ) && !is_data_in(p_cbw->dir) )
         {
-          if (p_cbw->total_bytes > sizeof(_mscd_buf))
+          if (p_cbw->total_bytes > sizeof(_mscd_buf[0]))
           {
             TU_LOG(MSC_DEBUG, "  SCSI reject non READ10/WRITE10 with large data\r\n");
             fail_scsi_op(rhport, p_msc, MSC_CSW_STATUS_FAILED);
@@ -463,17 +501,17 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
           {
             // Didn't check for case 9 (Ho > Dn), which requires examining scsi command first
             // but it is OK to just receive data then responded with failed status
-            TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_buf, (uint16_t) p_msc->total_len) );
+            TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_buf[0], (uint16_t) p_msc->total_len) );
           }
         }else
         {
           // First process if it is a built-in commands
-          int32_t resplen = proc_builtin_scsi(p_cbw->lun, p_cbw->command, _mscd_buf, sizeof(_mscd_buf));
+          int32_t resplen = proc_builtin_scsi(p_cbw->lun, p_cbw->command, _mscd_buf[0], sizeof(_mscd_buf[0]));
 
           // Invoke user callback if not built-in
           if ( (resplen < 0) && (p_msc->sense_key == 0) )
           {
-            resplen = tud_msc_scsi_cb(p_cbw->lun, p_cbw->command, _mscd_buf, (uint16_t) p_msc->total_len);
+            resplen = tud_msc_scsi_cb(p_cbw->lun, p_cbw->command, _mscd_buf[0], (uint16_t) p_msc->total_len);
           }
 
           if ( resplen < 0 )
@@ -506,7 +544,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
             {
               // cannot return more than host expect
               p_msc->total_len = tu_min32((uint32_t) resplen, p_cbw->total_bytes);
-              TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_buf, (uint16_t) p_msc->total_len) );
+              TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_buf[0], (uint16_t) p_msc->total_len) );
             }
           }
         }
@@ -519,16 +557,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
 
       if (SCSI_CMD_READ_10 == p_cbw->command[0])
       {
-        p_msc->xferred_len += xferred_bytes;
-
-        if ( p_msc->xferred_len >= p_msc->total_len )
-        {
-          // Data Stage is complete
-          p_msc->stage = MSC_STAGE_STATUS;
-        }else
-        {
-          proc_read10_cmd(rhport, p_msc);
-        }
+        proc_read10_sent(rhport, p_msc, xferred_bytes);
       }
       else if (SCSI_CMD_WRITE_10 == p_cbw->command[0])
       {
@@ -541,7 +570,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         // OUT transfer, invoke callback if needed
         if ( !is_data_in(p_cbw->dir) )
         {
-          int32_t cb_result = tud_msc_scsi_cb(p_cbw->lun, p_cbw->command, _mscd_buf, (uint16_t) p_msc->total_len);
+          int32_t cb_result = tud_msc_scsi_cb(p_cbw->lun, p_cbw->command, _mscd_buf[0], (uint16_t) p_msc->total_len);
 
           if ( cb_result < 0 )
           {
@@ -607,7 +636,16 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
     default : break;
   }
 
-  if ( p_msc->stage == MSC_STAGE_STATUS )
+  if ( p_msc->stage == MSC_STAGE_STATUS ) proc_status_stage(rhport, p_msc);
+
+  return true;
+}
+
+// Send CSW once Data Stage is complete (or failed)
+static void proc_status_stage(uint8_t rhport, mscd_interface_t* p_msc)
+{
+  msc_cbw_t const * p_cbw = &p_msc->cbw;
+
   {
     // skip status if epin is currently stalled, will do it when received Clear Stall request
     if ( !usbd_edpt_stalled(rhport,  p_msc->ep_in) )
@@ -619,7 +657,7 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
         usbd_edpt_stall(rhport, p_msc->ep_in);
       }else
       {
-        TU_ASSERT( send_csw(rhport, p_msc) );
+        TU_ASSERT( send_csw(rhport, p_msc), );
       }
     }
 
@@ -634,8 +672,6 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
     }
     #endif
   }
-
-  return true;
 }
 
 /*------------------------------------------------------------------*/
@@ -825,41 +861,150 @@ static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_
   return resplen;
 }
 
-static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc)
+static inline uint8_t pipeline_next(uint8_t idx)
 {
-  msc_cbw_t const * p_cbw = &p_msc->cbw;
+  return (uint8_t) ((idx + 1) % CFG_TUD_MSC_BUFCOUNT);
+}
 
-  // block size already verified not zero
-  uint16_t const block_sz = rdwr10_get_blocksize(p_cbw);
+static void pipeline_reset(mscd_interface_t* p_msc)
+{
+  tu_memclr(p_msc->buf_state, sizeof(p_msc->buf_state));
+  tu_memclr(p_msc->buf_off, sizeof(p_msc->buf_off));
+  p_msc->io_idx        = 0;
+  p_msc->xfer_idx      = 0;
+  p_msc->done_idx      = 0;
+  p_msc->io_len        = 0;
+  p_msc->retry_pending = false;
+}
 
-  // Adjust lba with transferred bytes
-  uint32_t const lba = rdwr10_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
+// Storage is not ready: retry when the next transfer completes, or simulate one if nothing is on the bus
+static void pipeline_retry(uint8_t rhport, mscd_interface_t* p_msc, uint8_t ep_addr)
+{
+  for ( uint8_t i = 0; i < CFG_TUD_MSC_BUFCOUNT; i++ )
+  {
+    if ( p_msc->buf_state[i] == MSCD_BUF_XFER ) return;
+  }
 
-  // remaining bytes capped at class buffer
-  int32_t nbytes = (int32_t) tu_min32(sizeof(_mscd_buf), p_cbw->total_bytes-p_msc->xferred_len);
+  p_msc->retry_pending = true;
+  dcd_event_xfer_complete(rhport, ep_addr, 0, XFER_RESULT_SUCCESS, false);
+}
 
-  // Application can consume smaller bytes
-  uint32_t const offset = p_msc->xferred_len % block_sz;
-  nbytes = tud_msc_read10_cb(p_cbw->lun, lba, offset, _mscd_buf, (uint32_t) nbytes);
+// Storage read of the current I/O buffer is done, return true if the pipeline can continue
+static bool proc_read10_io_done(uint8_t rhport, mscd_interface_t* p_msc, int32_t nbytes)
+{
+  msc_cbw_t const * p_cbw = &p_msc->cbw;
+  uint8_t const idx = p_msc->io_idx;
 
   if ( nbytes < 0 )
   {
     // negative means error -> endpoint is stalled & status in CSW set to failed
     TU_LOG(MSC_DEBUG, "  tud_msc_read10_cb() return -1\r\n");
+    p_msc->buf_state[idx] = MSCD_BUF_EMPTY;
 
     // set sense
     set_sense_medium_not_present(p_cbw->lun);
 
     fail_scsi_op(rhport, p_msc, MSC_CSW_STATUS_FAILED);
+    return false;
   }
   else if ( nbytes == 0 )
   {
-    // zero means not ready -> simulate an transfer complete so that this driver callback will fired again
-    dcd_event_xfer_complete(rhport, p_msc->ep_in, 0, XFER_RESULT_SUCCESS, false);
+    // zero means not ready -> callback is invoked again with the same parameters later on
+    p_msc->buf_state[idx] = MSCD_BUF_EMPTY;
+    pipeline_retry(rhport, p_msc, p_msc->ep_in);
+    return false;
+  }
+
+  // Application can consume smaller bytes
+  p_msc->buf_len[idx]   = (uint16_t) nbytes;
+  p_msc->buf_state[idx] = MSCD_BUF_READY;
+  p_msc->io_len        += (uint32_t) nbytes;
+  p_msc->io_idx         = pipeline_next(idx);
+
+  return true;
+}
+
+static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc)
+{
+  pipeline_reset(p_msc);
+  proc_read10_pump(rhport, p_msc);
+}
+
+// Send buffers read from storage and read ahead into the free ones while they are on the bus
+static void proc_read10_pump(uint8_t rhport, mscd_interface_t* p_msc)
+{
+  msc_cbw_t const * p_cbw = &p_msc->cbw;
+
+  // block size already verified not zero
+  uint16_t const block_sz = rdwr10_get_blocksize(p_cbw);
+
+  while ( p_msc->stage == MSC_STAGE_DATA )
+  {
+    // Queue data as long as the endpoint takes it (two transfers with ping-pong endpoints)
+    uint8_t const xfer_idx = p_msc->xfer_idx;
+    if ( p_msc->buf_state[xfer_idx] == MSCD_BUF_READY && usbd_edpt_claim(rhport, p_msc->ep_in) )
+    {
+      p_msc->buf_state[xfer_idx] = MSCD_BUF_XFER;
+      p_msc->xfer_idx = pipeline_next(xfer_idx);
+      TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_in, (uint8_t*) (uintptr_t) p_msc->buf_data[xfer_idx], p_msc->buf_len[xfer_idx]), );
+      continue;
+    }
+
+    // Read ahead into the next free buffer
+    uint8_t const idx = p_msc->io_idx;
+    if ( p_msc->buf_state[idx] != MSCD_BUF_EMPTY || p_msc->io_len >= p_cbw->total_bytes ) break;
+
+    // Adjust lba with bytes read so far
+    uint32_t const lba    = rdwr10_get_lba(p_cbw->command) + (p_msc->io_len / block_sz);
+    uint32_t const offset = p_msc->io_len % block_sz;
+
+    // remaining bytes capped at class buffer
+    uint32_t const nbytes = tu_min32(sizeof(_mscd_buf[idx]), p_cbw->total_bytes - p_msc->io_len);
+
+    p_msc->buf_state[idx] = MSCD_BUF_IO;
+
+    // Send straight from application memory if it can provide the data (zero-copy)
+    void const* data = NULL;
+    int32_t result = tud_msc_read10_direct_cb ? tud_msc_read10_direct_cb(p_cbw->lun, lba, offset, nbytes, &data) : 0;
+
+    if ( result > 0 && data != NULL )
+    {
+      p_msc->buf_data[idx] = (uint8_t const*) data;
+    }
+    else
+    {
+      p_msc->buf_data[idx] = _mscd_buf[idx];
+      result = tud_msc_read10_cb(p_cbw->lun, lba, offset, _mscd_buf[idx], nbytes);
+
+      // Continued by tud_msc_async_io_done()
+      if ( result == TUD_MSC_RET_ASYNC ) break;
+    }
+
+    if ( !proc_read10_io_done(rhport, p_msc, result) ) break;
+  }
+}
+
+// READ10 data sent to host (or a simulated transfer to retry storage)
+static void proc_read10_sent(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes)
+{
+  if ( p_msc->retry_pending && xferred_bytes == 0 )
+  {
+    p_msc->retry_pending = false;
   }
   else
   {
-    TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_in, _mscd_buf, (uint16_t) nbytes), );
+    p_msc->buf_state[p_msc->done_idx] = MSCD_BUF_EMPTY;
+    p_msc->done_idx = pipeline_next(p_msc->done_idx);
+    p_msc->xferred_len += xferred_bytes;
+  }
+
+  if ( p_msc->xferred_len >= p_msc->total_len )
+  {
+    // Data Stage is complete
+    p_msc->stage = MSC_STAGE_STATUS;
+  }else
+  {
+    proc_read10_pump(rhport, p_msc);
   }
 }
 
@@ -882,27 +1027,16 @@ static void proc_write10_cmd(uint8_t rhport, mscd_interface_t* p_msc)
     return;
   }
 
-  // remaining bytes capped at class buffer
-  uint16_t nbytes = (uint16_t) tu_min32(sizeof(_mscd_buf), p_cbw->total_bytes-p_msc->xferred_len);
-
-  // Write10 callback will be called later when usb transfer complete
-  TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_buf, nbytes), );
+  pipeline_reset(p_msc);
+  proc_write10_pump(rhport, p_msc);
 }
 
-// process new data arrived from WRITE10
-static void proc_write10_new_data(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes)
+// Storage write of the current I/O buffer is done, return true if the pipeline can continue
+static bool proc_write10_io_done(uint8_t rhport, mscd_interface_t* p_msc, int32_t nbytes)
 {
   msc_cbw_t const * p_cbw = &p_msc->cbw;
-
-  // block size already verified not zero
-  uint16_t const block_sz = rdwr10_get_blocksize(p_cbw);
-
-  // Adjust lba with transferred bytes
-  uint32_t const lba = rdwr10_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
-
-  // Invoke callback to consume new data
-  uint32_t const offset = p_msc->xferred_len % block_sz;
-  int32_t nbytes = tud_msc_write10_cb(p_cbw->lun, lba, offset, _mscd_buf, xferred_bytes);
+  uint8_t const idx = p_msc->io_idx;
+  uint32_t const left = (uint32_t) (p_msc->buf_len[idx] - p_msc->buf_off[idx]);
 
   if ( nbytes < 0 )
   {
@@ -910,43 +1044,149 @@ static void proc_write10_new_data(uint8_t rhport, mscd_interface_t* p_msc, uint3
     TU_LOG(MSC_DEBUG, "  tud_msc_write10_cb() return -1\r\n");
 
     // update actual byte before failed
-    p_msc->xferred_len += xferred_bytes;
+    p_msc->xferred_len += left;
+    p_msc->buf_state[idx] = MSCD_BUF_EMPTY;
 
     // Set sense
     set_sense_medium_not_present(p_cbw->lun);
 
     fail_scsi_op(rhport, p_msc, MSC_CSW_STATUS_FAILED);
-  }else
+    return false;
+  }
+
+  p_msc->xferred_len += (uint32_t) nbytes;
+
+  // Application consume less than what we got (including zero)
+  // callback is invoked again with the left over data later on
+  if ( (uint32_t) nbytes < left )
   {
-    // Application consume less than what we got (including zero)
-    if ( (uint32_t) nbytes < xferred_bytes )
-    {
-      uint32_t const left_over = xferred_bytes - (uint32_t) nbytes;
-      if ( nbytes > 0 )
-      {
-        p_msc->xferred_len += (uint16_t) nbytes;
-        memmove(_mscd_buf, _mscd_buf+nbytes, left_over);
-      }
+    p_msc->buf_off[idx]  += (uint16_t) nbytes;
+    p_msc->buf_state[idx] = MSCD_BUF_READY;
+    pipeline_retry(rhport, p_msc, p_msc->ep_out);
+    return false;
+  }
 
-      // simulate an transfer complete with adjusted parameters --> callback will be invoked with adjusted parameter
-      dcd_event_xfer_complete(rhport, p_msc->ep_out, left_over, XFER_RESULT_SUCCESS, false);
-    }
-    else
+  // Application consume all bytes in this buffer
+  p_msc->buf_off[idx]   = 0;
+  p_msc->buf_state[idx] = MSCD_BUF_EMPTY;
+  p_msc->io_idx         = pipeline_next(idx);
+
+  if ( p_msc->xferred_len >= p_msc->total_len )
+  {
+    // Data Stage is complete
+    p_msc->stage = MSC_STAGE_STATUS;
+  }
+
+  return true;
+}
+
+// Receive into the free buffers and write the received ones to storage while the others are on the bus
+static void proc_write10_pump(uint8_t rhport, mscd_interface_t* p_msc)
+{
+  msc_cbw_t const * p_cbw = &p_msc->cbw;
+
+  // block size already verified not zero
+  uint16_t const block_sz = rdwr10_get_blocksize(p_cbw);
+
+  while ( p_msc->stage == MSC_STAGE_DATA )
+  {
+    // Prepare to receive more data from host as long as the endpoint takes it (two transfers with ping-pong endpoints)
+    uint8_t const xfer_idx = p_msc->xfer_idx;
+    if ( p_msc->buf_state[xfer_idx] == MSCD_BUF_EMPTY && p_msc->io_len < p_cbw->total_bytes &&
+         usbd_edpt_claim(rhport, p_msc->ep_out) )
     {
-      // Application consume all bytes in our buffer
-      p_msc->xferred_len += xferred_bytes;
+      // remaining bytes capped at class buffer
+      uint16_t const nbytes = (uint16_t) tu_min32(sizeof(_mscd_buf[xfer_idx]), p_cbw->total_bytes - p_msc->io_len);
 
-      if ( p_msc->xferred_len >= p_msc->total_len )
-      {
-        // Data Stage is complete
-        p_msc->stage = MSC_STAGE_STATUS;
-      }else
-      {
-        // prepare to receive more data from host
-        proc_write10_cmd(rhport, p_msc);
-      }
+      p_msc->buf_state[xfer_idx] = MSCD_BUF_XFER;
+      p_msc->xfer_idx = pipeline_next(xfer_idx);
+      p_msc->io_len  += nbytes;
+
+      // Write10 callback will be called later when usb transfer complete
+      TU_ASSERT( usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_buf[xfer_idx], nbytes), );
+      continue;
     }
+
+    // Write the oldest received buffer
+    uint8_t const idx = p_msc->io_idx;
+    if ( p_msc->buf_state[idx] != MSCD_BUF_READY ) break;
+
+    // Adjust lba with bytes written so far
+    uint32_t const lba    = rdwr10_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
+    uint32_t const offset = p_msc->xferred_len % block_sz;
+
+    p_msc->buf_state[idx] = MSCD_BUF_IO;
+    int32_t const result = tud_msc_write10_cb(p_cbw->lun, lba, offset, _mscd_buf[idx] + p_msc->buf_off[idx],
+                                              (uint32_t) (p_msc->buf_len[idx] - p_msc->buf_off[idx]));
+
+    // Continued by tud_msc_async_io_done()
+    if ( result == TUD_MSC_RET_ASYNC ) break;
+
+    if ( !proc_write10_io_done(rhport, p_msc, result) ) break;
+  }
+}
+
+// process new data arrived from WRITE10 (or a simulated transfer to retry storage)
+static void proc_write10_new_data(uint8_t rhport, mscd_interface_t* p_msc, uint32_t xferred_bytes)
+{
+  if ( p_msc->retry_pending && xferred_bytes == 0 )
+  {
+    p_msc->retry_pending = false;
+  }
+  else
+  {
+    uint8_t const idx = p_msc->done_idx;
+    p_msc->buf_len[idx]   = (uint16_t) xferred_bytes;
+    p_msc->buf_off[idx]   = 0;
+    p_msc->buf_state[idx] = MSCD_BUF_READY;
+    p_msc->done_idx = pipeline_next(idx);
   }
+
+  proc_write10_pump(rhport, p_msc);
+}
+
+// Deferred from tud_msc_async_io_done() to usbd task
+static void proc_async_io_done(void* param)
+{
+  mscd_interface_t* p_msc = &_mscd_itf;
+  uint8_t const rhport = p_msc->rhport;
+  uint16_t const seq = (uint16_t) (uintptr_t) param;
+  int32_t const nbytes = p_msc->async_result;
+
+  // Command may be aborted meanwhile (reset), or a new command may have started I/O on the same buffer
+  TU_VERIFY(seq == p_msc->cmd_seq && p_msc->stage == MSC_STAGE_DATA && p_msc->buf_state[p_msc->io_idx] == MSCD_BUF_IO, );
+
+  if (SCSI_CMD_READ_10 == p_msc->cbw.command[0])
+  {
+    if ( proc_read10_io_done(rhport, p_msc, nbytes) ) proc_read10_pump(rhport, p_msc);
+  }
+  else
+  {
+    if ( proc_write10_io_done(rhport, p_msc, nbytes) ) proc_write10_pump(rhport, p_msc);
+  }
+
+  if ( p_msc->stage == MSC_STAGE_STATUS ) proc_status_stage(rhport, p_msc);
+}
+
+uint16_t tud_msc_async_io_seq(void)
+{
+  return _mscd_itf.cmd_seq;
+}
+
+bool tud_msc_async_io_done_seq(uint16_t seq, int32_t bytes_io, bool in_isr)
+{
+  // only valid for a READ10/WRITE10 callback of the current command that returned TUD_MSC_RET_ASYNC
+  TU_VERIFY(seq == _mscd_itf.cmd_seq && _mscd_itf.stage == MSC_STAGE_DATA && _mscd_itf.buf_state[_mscd_itf.io_idx] == MSCD_BUF_IO);
+
+  // only one storage I/O is outstanding at a time, so the result can wait in the interface until usbd task runs
+  _mscd_itf.async_result = bytes_io;
+  usbd_defer_func(proc_async_io_done, (void*) (uintptr_t) seq, in_isr);
+  return true;
+}
+
+bool tud_msc_async_io_done(int32_t bytes_io, bool in_isr)
+{
+  return tud_msc_async_io_done_seq(_mscd_itf.cmd_seq, bytes_io, in_isr);
 }
 
 #endif
@@ -50,6 +50,18 @@
 
 TU_VERIFY_STATIC(CFG_TUD_MSC_EP_BUFSIZE < UINT16_MAX, "Size is not correct");
 
+// Number of CFG_TUD_MSC_EP_BUFSIZE buffers used to stream READ10/WRITE10 data. With 2 or more
+// the read/write callback works on one buffer while the previous one is transferred on the bus.
+#ifndef CFG_TUD_MSC_BUFCOUNT
+  #define CFG_TUD_MSC_BUFCOUNT  2
+#endif
+
+TU_VERIFY_STATIC(CFG_TUD_MSC_BUFCOUNT >= 1 && CFG_TUD_MSC_BUFCOUNT <= 8, "Buffer count is not correct");
+
+// Return value of tud_msc_read10_cb()/tud_msc_write10_cb() when the I/O completes later. Reserved outside any
+// errno range, so an application returning a negative error code (e.g -EBUSY) is still treated as an error.
+#define TUD_MSC_RET_ASYNC   INT32_MIN
+
 //--------------------------------------------------------------------+
 // Application API
 //--------------------------------------------------------------------+
@@ -57,6 +69,18 @@ TU_VERIFY_STATIC(CFG_TUD_MSC_EP_BUFSIZE < UINT16_MAX, "Size is not correct");
 // Set SCSI sense response
 bool tud_msc_set_sense(uint8_t lun, uint8_t sense_key, uint8_t add_sense_code, uint8_t add_sense_qualifier);
 
+// Complete a READ10/WRITE10 callback that returned TUD_MSC_RET_ASYNC, bytes_io is what the callback would
+// have returned (bytes read/written, 0 for not ready, negative for error). Can be called from an interrupt.
+bool tud_msc_async_io_done(int32_t bytes_io, bool in_isr);
+
+// Sequence number of the current SCSI command, changes with every command and reset. Read it in the
+// READ10/WRITE10 callback that returns TUD_MSC_RET_ASYNC and complete with tud_msc_async_io_done_seq(),
+// so a completion of a command aborted by a reset is dropped instead of applied to the next command.
+uint16_t tud_msc_async_io_seq(void);
+
+// Same as tud_msc_async_io_done(), returns false and drops the result if seq is not the current command
+bool tud_msc_async_io_done_seq(uint16_t seq, int32_t bytes_io, bool in_isr);
+
 //--------------------------------------------------------------------+
 // Application Callbacks (WEAK is optional)
 //--------------------------------------------------------------------+
@@ -73,6 +97,13 @@ bool tud_msc_set_sense(uint8_t lun, uint8_t sense_key, uint8_t add_sense_code, u
 //
 //   - read < 0       : Indicate application error e.g invalid address. This request will be STALLed
 //                      and return failed status in command status wrapper phase.
+//                      INT32_MIN is reserved for TUD_MSC_RET_ASYNC and must not be used as an error.
+//
+//   - TUD_MSC_RET_ASYNC : Read is started in the background (e.g DMA), application must keep filling the
+//                      buffer and call tud_msc_async_io_done() with the read result once it is done.
+//
+// - With CFG_TUD_MSC_BUFCOUNT > 1 the next call (read ahead) comes while previous data is still sent,
+//   so buffer is not the same between calls.
 int32_t tud_msc_read10_cb (uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
 
 // Invoked when received SCSI WRITE10 command
@@ -87,6 +118,13 @@ int32_t tud_msc_read10_cb (uint8_t lun, uint32_t lba, uint32_t offset, void* buf
 //
 //   - write < 0       : Indicate application error e.g invalid address. This request will be STALLed
 //                       and return failed status in command status wrapper phase.
+//                       INT32_MIN is reserved for TUD_MSC_RET_ASYNC and must not be used as an error.
+//
+//   - TUD_MSC_RET_ASYNC : Write is started in the background, buffer stays valid until the application
+//                       calls tud_msc_async_io_done() with the write result.
+//
+// - With CFG_TUD_MSC_BUFCOUNT > 1 the next data is received while the callback writes the previous one,
+//   so buffer is not the same between calls.
 //
 // TODO change buffer to const uint8_t*
 int32_t tud_msc_write10_cb (uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
@@ -123,6 +161,13 @@ int32_t tud_msc_scsi_cb (uint8_t lun, uint8_t const scsi_cmd[16], void* buffer,
 
 /*------------- Optional callbacks -------------*/
 
+// Invoked before tud_msc_read10_cb() to send data straight from application memory (zero-copy) e.g memory
+// mapped storage. Set *data to the contents of address lba * BLOCK_SIZE + offset and return number of bytes
+// available there (up to bufsize), or return 0 to read into the class buffer with tud_msc_read10_cb() instead.
+// Data must stay valid and readable by the USB controller until the command completes, and must meet the
+// controller's buffer alignment (4 bytes on SAMD, return 0 for an unaligned address).
+TU_ATTR_WEAK int32_t tud_msc_read10_direct_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint32_t bufsize, void const** data);
+
 // Invoked when received GET_MAX_LUN request, required for multiple LUNs implementation
 TU_ATTR_WEAK uint8_t tud_msc_get_maxlun_cb(void);
 
@@ -313,6 +313,20 @@ bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32
   msc_cbw_t const * cbw = &p_msc->cbw;
   msc_csw_t       * csw = &p_msc->csw;
 
+  // Transfer error (e.g. device unplugged before it was closed): end the command with a failed status
+  if ( event == XFER_RESULT_FAILED && p_msc->stage != MSC_STAGE_IDLE )
+  {
+    p_msc->stage = MSC_STAGE_IDLE;
+
+    csw->signature    = MSC_CSW_SIGNATURE;
+    csw->tag          = cbw->tag;
+    csw->data_residue = cbw->total_bytes;
+    csw->status       = MSC_CSW_STATUS_FAILED;
+
+    if (p_msc->complete_cb) p_msc->complete_cb(dev_addr, cbw, csw);
+    return true;
+  }
+
   switch (p_msc->stage)
   {
     case MSC_STAGE_CMD:
@@ -425,7 +439,7 @@ bool msch_set_config(uint8_t dev_addr, uint8_t itf_num)
     .daddr       = dev_addr,
     .ep_addr     = 0,
     .setup       = &request,
-    .buffer      = &p_msc->max_lun,
+    .buffer      = _msch_buffer,
     .complete_cb = config_get_maxlun_complete,
     .user_data    = 0
   };
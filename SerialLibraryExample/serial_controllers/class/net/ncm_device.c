@@ -124,6 +124,15 @@ typedef struct
 
   bool transferring;
 
+  uint16_t reserved_size;         // Size reserved by tud_network_xmit_reserve() and not committed yet, 0 if none
+
+  // Transmit flush policy, refer to tud_network_ncm_flush_policy()
+  uint8_t  flush_datagrams;
+  uint16_t flush_bytes;
+  uint16_t flush_timeout;
+  volatile uint16_t flush_countdown; // SOFs left before the NTB being filled is sent, 0 if timer not running (decremented in ISR)
+  bool     flush_now;                // send the NTB being filled as soon as the IN endpoint is free
+
 } ncm_interface_t;
 
 //--------------------------------------------------------------------+
@@ -151,14 +160,29 @@ CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static uint8_t receive_ntb[CFG_TUD_NCM_O
 
 static ncm_interface_t ncm_interface;
 
+// datagrams start after all the headers
+#define NCM_DATAGRAMS_OFFSET (sizeof(nth16_t) + sizeof(ndp16_t) + ((CFG_TUD_NCM_MAX_DATAGRAMS_PER_NTB + 1) * sizeof(ndp16_datagram_t)))
+
 /*
  * Set up the NTB state in ncm_interface to be ready to add datagrams.
  */
 static void ncm_prepare_for_tx(void) {
   ncm_interface.datagram_count = 0;
-  // datagrams start after all the headers
-  ncm_interface.next_datagram_offset = sizeof(nth16_t) + sizeof(ndp16_t)
-      + ((CFG_TUD_NCM_MAX_DATAGRAMS_PER_NTB + 1) * sizeof(ndp16_datagram_t));
+  ncm_interface.next_datagram_offset = NCM_DATAGRAMS_OFFSET;
+}
+
+/*
+ * Check the flush policy: true if the NTB being filled should be sent now rather than wait to aggregate more datagrams.
+ */
+static bool ncm_tx_ready(void) {
+  uint16_t const bytes = (uint16_t) (ncm_interface.next_datagram_offset - NCM_DATAGRAMS_OFFSET);
+
+  return ncm_interface.flush_now
+      || ncm_interface.datagram_count >= ncm_interface.flush_datagrams
+      || (ncm_interface.flush_bytes && bytes >= ncm_interface.flush_bytes)
+      // full: no room for another datagram of MTU size
+      || ncm_interface.datagram_count >= ncm_interface.max_datagrams_per_ntb
+      || ncm_interface.next_datagram_offset + CFG_TUD_NET_MTU > ncm_interface.ntb_in_size;
 }
 
 /*
@@ -166,7 +190,8 @@ static void ncm_prepare_for_tx(void) {
  * to start filling the other one with datagrams.
  */
 static void ncm_start_tx(void) {
-  if (ncm_interface.transferring) {
+  // a reserved datagram is still being written to the current NTB, commit starts the transfer
+  if (ncm_interface.transferring || ncm_interface.reserved_size || !ncm_interface.datagram_count || !ncm_tx_ready()) {
     return;
   }
 
@@ -194,6 +219,51 @@ static void ncm_start_tx(void) {
   // Swap to the other NTB and clear it out
   ncm_interface.current_ntb = 1 - ncm_interface.current_ntb;
   ncm_prepare_for_tx();
+
+  // Stop flush timer, restarted by the first datagram of the next NTB
+  ncm_interface.flush_now = false;
+  if (ncm_interface.flush_countdown) {
+    ncm_interface.flush_countdown = 0;
+    usbd_sof_enable(0, SOF_CONSUMER_NCM, false);
+  }
+}
+
+/*
+ * Add a datagram written at next_datagram_offset of the current NTB, and send the NTB if the flush policy allows.
+ */
+static void ncm_add_datagram(uint16_t size) {
+  transmit_ntb_t *ntb = &transmit_ntb[ncm_interface.current_ntb];
+  size_t next_datagram_offset = ncm_interface.next_datagram_offset;
+
+  ntb->ndp.datagram[ncm_interface.datagram_count].wDatagramIndex = ncm_interface.next_datagram_offset;
+  ntb->ndp.datagram[ncm_interface.datagram_count].wDatagramLength = size;
+
+  ncm_interface.datagram_count++;
+  next_datagram_offset += size;
+
+  // round up so the next datagram is aligned correctly
+  next_datagram_offset += (CFG_TUD_NCM_ALIGNMENT - 1);
+  next_datagram_offset -= (next_datagram_offset % CFG_TUD_NCM_ALIGNMENT);
+
+  ncm_interface.next_datagram_offset = next_datagram_offset;
+
+  // Start flush timer with the first datagram of the NTB, SOF is only enabled while it runs
+  if (ncm_interface.datagram_count == 1 && ncm_interface.flush_timeout && !ncm_interface.flush_countdown) {
+    ncm_interface.flush_countdown = ncm_interface.flush_timeout;
+    usbd_sof_enable(0, SOF_CONSUMER_NCM, true);
+  }
+
+  ncm_start_tx();
+}
+
+// Deferred from netd_sof() when the flush timer expires
+static void ncm_flush_timeout(void *param) {
+  (void) param;
+
+  if (ncm_interface.datagram_count && ncm_interface.itf_data_alt == 1) {
+    ncm_interface.flush_now = true;
+    ncm_start_tx();
+  }
 }
 
 static struct ecm_notify_struct ncm_notify_connected =
@@ -250,14 +320,44 @@ void netd_init(void)
   tu_memclr(&ncm_interface, sizeof(ncm_interface));
   ncm_interface.ntb_in_size = CFG_TUD_NCM_IN_NTB_MAX_SIZE;
   ncm_interface.max_datagrams_per_ntb = CFG_TUD_NCM_MAX_DATAGRAMS_PER_NTB;
+  ncm_interface.flush_datagrams = CFG_TUD_NCM_FLUSH_DATAGRAMS;
+  ncm_interface.flush_bytes = CFG_TUD_NCM_FLUSH_BYTES;
+  ncm_interface.flush_timeout = CFG_TUD_NCM_FLUSH_TIMEOUT;
   ncm_prepare_for_tx();
 }
 
 void netd_reset(uint8_t rhport)
 {
-  (void) rhport;
+  // keep the flush policy set by the application
+  uint8_t const flush_datagrams = ncm_interface.flush_datagrams;
+  uint16_t const flush_bytes = ncm_interface.flush_bytes;
+  uint16_t const flush_timeout = ncm_interface.flush_timeout;
+
+  // release SOF if the flush timer was running
+  if (ncm_interface.flush_countdown) {
+    usbd_sof_enable(rhport, SOF_CONSUMER_NCM, false);
+  }
 
   netd_init();
+
+  ncm_interface.flush_datagrams = flush_datagrams;
+  ncm_interface.flush_bytes = flush_bytes;
+  ncm_interface.flush_timeout = flush_timeout;
+}
+
+// SOF handler in ISR context, only enabled while the flush timer runs
+void netd_sof(uint8_t rhport, uint32_t frame_count)
+{
+  (void) rhport;
+  (void) frame_count;
+
+  uint16_t const countdown = ncm_interface.flush_countdown;
+  if (countdown) {
+    ncm_interface.flush_countdown = countdown - 1;
+    if (countdown == 1) {
+      usbd_defer_func(ncm_flush_timeout, NULL, true);
+    }
+  }
 }
 
 uint16_t netd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len)
@@ -470,7 +570,7 @@ bool netd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
 // poll network driver for its ability to accept another packet to transmit
 bool tud_network_can_xmit(uint16_t size)
 {
-  TU_VERIFY(ncm_interface.itf_data_alt == 1);
+  TU_VERIFY(ncm_interface.itf_data_alt == 1 && !ncm_interface.reserved_size);
 
   if (ncm_interface.datagram_count >= ncm_interface.max_datagrams_per_ntb) {
     TU_LOG2("NTB full [by count]\r\n");
@@ -489,23 +589,50 @@ bool tud_network_can_xmit(uint16_t size)
 void tud_network_xmit(void *ref, uint16_t arg)
 {
   transmit_ntb_t *ntb = &transmit_ntb[ncm_interface.current_ntb];
-  size_t next_datagram_offset = ncm_interface.next_datagram_offset;
 
-  uint16_t size = tud_network_xmit_cb(ntb->data + next_datagram_offset, ref, arg);
+  uint16_t size = tud_network_xmit_cb(ntb->data + ncm_interface.next_datagram_offset, ref, arg);
 
-  ntb->ndp.datagram[ncm_interface.datagram_count].wDatagramIndex = ncm_interface.next_datagram_offset;
-  ntb->ndp.datagram[ncm_interface.datagram_count].wDatagramLength = size;
+  ncm_add_datagram(size);
+}
 
-  ncm_interface.datagram_count++;
-  next_datagram_offset += size;
+uint8_t* tud_network_xmit_reserve(uint16_t size)
+{
+  TU_VERIFY(size && tud_network_can_xmit(size), NULL);
 
-  // round up so the next datagram is aligned correctly
-  next_datagram_offset += (CFG_TUD_NCM_ALIGNMENT - 1);
-  next_datagram_offset -= (next_datagram_offset % CFG_TUD_NCM_ALIGNMENT);
+  ncm_interface.reserved_size = size;
+  return transmit_ntb[ncm_interface.current_ntb].data + ncm_interface.next_datagram_offset;
+}
 
-  ncm_interface.next_datagram_offset = next_datagram_offset;
+void tud_network_xmit_commit(uint16_t size)
+{
+  TU_VERIFY(ncm_interface.reserved_size && size <= ncm_interface.reserved_size, );
 
+  ncm_interface.reserved_size = 0;
+
+  if (size) {
+    ncm_add_datagram(size);
+  } else {
+    // cancelled, the NTB may have been held back for the reservation
+    ncm_start_tx();
+  }
+}
+
+void tud_network_ncm_flush_policy(uint8_t min_datagrams, uint16_t min_bytes, uint16_t timeout_frames)
+{
+  ncm_interface.flush_datagrams = min_datagrams ? min_datagrams : 1;
+  ncm_interface.flush_bytes = min_bytes;
+  ncm_interface.flush_timeout = timeout_frames;
+
+  // datagrams already waiting are sent with the new policy
   ncm_start_tx();
 }
 
+void tud_network_ncm_flush(void)
+{
+  if (ncm_interface.datagram_count && ncm_interface.itf_data_alt == 1) {
+    ncm_interface.flush_now = true;
+    ncm_start_tx();
+  }
+}
+
 #endif
@@ -60,6 +60,19 @@
 #define CFG_TUD_NCM_ALIGNMENT 4
 #endif
 
+// Default NCM transmit flush policy, refer to tud_network_ncm_flush_policy()
+#ifndef CFG_TUD_NCM_FLUSH_DATAGRAMS
+#define CFG_TUD_NCM_FLUSH_DATAGRAMS 1
+#endif
+
+#ifndef CFG_TUD_NCM_FLUSH_BYTES
+#define CFG_TUD_NCM_FLUSH_BYTES 0
+#endif
+
+#ifndef CFG_TUD_NCM_FLUSH_TIMEOUT
+#define CFG_TUD_NCM_FLUSH_TIMEOUT 0
+#endif
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -101,6 +114,25 @@ extern const uint8_t tud_network_mac_address[6];
 // callback to client providing optional indication of internal state of network driver
 void tud_network_link_state_cb(bool state);
 
+// zero-copy alternative to tud_network_xmit(): reserve room for a datagram of up to size bytes directly in the NTB
+// being filled, returns where to write it or NULL if it does not fit (same as tud_network_can_xmit() false).
+// Nothing else can be transmitted until the reservation is committed.
+uint8_t* tud_network_xmit_reserve(uint16_t size);
+
+// add the reserved datagram with its actual size (up to the reserved size), 0 cancels the reservation
+void tud_network_xmit_commit(uint16_t size);
+
+// set when an NTB is sent to the host. Datagrams are aggregated into the NTB being filled until it holds min_datagrams
+// datagrams or min_bytes bytes (0: no byte threshold), or timeout_frames USB frames (SOFs) after its first datagram
+// (0: no timeout, tud_network_ncm_flush() must be called). A full NTB is always sent.
+// The timeout needs a port with dcd_sof_enable() implemented; the SOF interrupt is only requested while it runs
+// and stays on for other drivers (e.g. audio feedback) which requested it too.
+// Default (CFG_TUD_NCM_FLUSH_*) is 1/0/0: send whenever the IN endpoint is free, lowest latency.
+void tud_network_ncm_flush_policy(uint8_t min_datagrams, uint16_t min_bytes, uint16_t timeout_frames);
+
+// send the NTB being filled as soon as the IN endpoint is free, regardless of flush policy
+void tud_network_ncm_flush(void);
+
 //--------------------------------------------------------------------+
 // INTERNAL USBD-CLASS DRIVER API
 //--------------------------------------------------------------------+
@@ -110,6 +142,7 @@ uint16_t netd_open            (uint8_t rhport, tusb_desc_interface_t const * itf
 bool     netd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     netd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 void     netd_report          (uint8_t *buf, uint16_t len);
+void     netd_sof             (uint8_t rhport, uint32_t frame_count);
 
 #ifdef __cplusplus
  }
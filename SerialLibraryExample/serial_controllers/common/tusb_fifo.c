@@ -54,6 +54,16 @@ static inline void _ff_unlock(tu_fifo_mutex_t mutex)
 
 #endif
 
+// Index accesses shared between the write and read side, release/acquire ordering makes sure
+// the data copy is visible before the index that publishes it (lock free SPSC operation)
+#if defined(__GNUC__)
+  #define _ff_load_acquire(_idx)        __atomic_load_n(&(_idx), __ATOMIC_ACQUIRE)
+  #define _ff_store_release(_idx, _val) __atomic_store_n(&(_idx), (_val), __ATOMIC_RELEASE)
+#else
+  #define _ff_load_acquire(_idx)        (_idx)
+  #define _ff_store_release(_idx, _val) ((_idx) = (_val))
+#endif
+
 /** \enum tu_fifo_copy_mode_t
  * \brief Write modes intended to allow special read and write functions to be able to
  *        copy data to and from USB hardware FIFOs as needed for e.g. STM32s and others
@@ -97,6 +107,70 @@ static inline uint16_t _ff_mod(uint16_t idx, uint16_t depth)
   return idx;
 }
 
+//--------------------------------------------------------------------+
+// Copy kernels
+//--------------------------------------------------------------------+
+#if CFG_TUSB_FIFO_WORD_COPY
+// word access to byte buffers, may_alias keeps the compiler from assuming the buffers are untouched
+typedef uint32_t __attribute__((may_alias)) _ff_word_t;
+
+// Copy whole words, dst and src must be word aligned
+static inline void _ff_copy_words(_ff_word_t * dst, _ff_word_t const * src, uint16_t words)
+{
+  // 16 byte bursts
+  while ( words >= 4 )
+  {
+#if defined(__arm__) && defined(__thumb__)
+    __asm volatile ("ldmia %0!, {r3, r4, r5, r6}\n\t"
+                    "stmia %1!, {r3, r4, r5, r6}"
+                    : "+l" (src), "+l" (dst) : : "r3", "r4", "r5", "r6", "memory");
+#else
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    dst[3] = src[3];
+    dst += 4;
+    src += 4;
+#endif
+    words -= 4;
+  }
+
+  while ( words-- ) *dst++ = *src++;
+}
+#endif
+
+// Copy used by all incrementing address reads and writes
+static void _ff_copy(void * dst, void const * src, uint16_t len)
+{
+#if CFG_TUSB_FIFO_DMA_MIN_BYTES
+  if ( len >= CFG_TUSB_FIFO_DMA_MIN_BYTES && tu_fifo_dma_copy_cb && tu_fifo_dma_copy_cb(dst, src, len) ) return;
+#endif
+
+#if CFG_TUSB_FIFO_WORD_COPY
+  uint8_t * dst8 = (uint8_t *) dst;
+  uint8_t const * src8 = (uint8_t const *) src;
+
+  // Only buffers with the same alignment can be copied by words, after 0-3 leading bytes
+  if ( len >= 8 && ((((uintptr_t) dst8) ^ ((uintptr_t) src8)) & 3) == 0 )
+  {
+    while ( ((uintptr_t) dst8) & 3 )
+    {
+      *dst8++ = *src8++;
+      len--;
+    }
+
+    _ff_copy_words((_ff_word_t *) dst8, (_ff_word_t const *) src8, (uint16_t) (len >> 2));
+    dst8 += len & 0xFFFC;
+    src8 += len & 0xFFFC;
+    len &= 0x03;
+  }
+
+  while ( len-- ) *dst8++ = *src8++;
+#else
+  memcpy(dst, src, len);
+#endif
+}
+
 // Intended to be used to read from hardware USB FIFO in e.g. STM32 where all data is read from a constant address
 // Code adapted from dcd_synopsis.c
 // TODO generalize with configurable 1 byte or 4 byte each read
@@ -106,6 +180,15 @@ static void _ff_push_const_addr(uint8_t * ff_buf, const void * app_buf, uint16_t
 
   // Reading full available 32 bit words from const app address
   uint16_t full_words = len >> 2;
+#if CFG_TUSB_FIFO_WORD_COPY
+  if ( (((uintptr_t) ff_buf) & 3) == 0 )
+  {
+    // aligned fifo buffer, store whole words
+    _ff_word_t * ff_word = (_ff_word_t *) ff_buf;
+    for ( ; full_words > 0; full_words-- ) *ff_word++ = *rx_fifo;
+    ff_buf = (uint8_t *) ff_word;
+  }
+#endif
   while(full_words--)
   {
     tu_unaligned_write32(ff_buf, *rx_fifo);
@@ -129,6 +212,15 @@ static void _ff_pull_const_addr(void * app_buf, const uint8_t * ff_buf, uint16_t
 
   // Pushing full available 32 bit words to const app address
   uint16_t full_words = len >> 2;
+#if CFG_TUSB_FIFO_WORD_COPY
+  if ( (((uintptr_t) ff_buf) & 3) == 0 )
+  {
+    // aligned fifo buffer, load whole words
+    _ff_word_t const * ff_word = (_ff_word_t const *) ff_buf;
+    for ( ; full_words > 0; full_words-- ) *tx_fifo = *ff_word++;
+    ff_buf = (uint8_t const *) ff_word;
+  }
+#endif
   while(full_words--)
   {
     *tx_fifo = tu_unaligned_read32(ff_buf);
@@ -170,17 +262,17 @@ static void _ff_push_n(tu_fifo_t* f, void const * app_buf, uint16_t n, uint16_t
       if(n <= nLin)
       {
         // Linear only
-        memcpy(ff_buf, app_buf, n*f->item_size);
+        _ff_copy(ff_buf, app_buf, n*f->item_size);
       }
       else
       {
         // Wrap around
 
         // Write data to linear part of buffer
-        memcpy(ff_buf, app_buf, nLin_bytes);
+        _ff_copy(ff_buf, app_buf, nLin_bytes);
 
         // Write data wrapped around
-        memcpy(f->buffer, ((uint8_t const*) app_buf) + nLin_bytes, nWrap_bytes);
+        _ff_copy(f->buffer, ((uint8_t const*) app_buf) + nLin_bytes, nWrap_bytes);
       }
       break;
 
@@ -254,17 +346,17 @@ static void _ff_pull_n(tu_fifo_t* f, void* app_buf, uint16_t n, uint16_t rel, tu
       if ( n <= nLin )
       {
         // Linear only
-        memcpy(app_buf, ff_buf, n*f->item_size);
+        _ff_copy(app_buf, ff_buf, n*f->item_size);
       }
       else
       {
         // Wrap around
 
         // Read data from linear part of buffer
-        memcpy(app_buf, ff_buf, nLin_bytes);
+        _ff_copy(app_buf, ff_buf, nLin_bytes);
 
         // Read data wrapped part
-        memcpy((uint8_t*) app_buf + nLin_bytes, f->buffer, nWrap_bytes);
+        _ff_copy((uint8_t*) app_buf + nLin_bytes, f->buffer, nWrap_bytes);
       }
     break;
 
@@ -462,7 +554,7 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
 
   _ff_lock(f->mutex_wr);
 
-  uint16_t w = f->wr_idx, r = f->rd_idx;
+  uint16_t w = f->wr_idx, r = _ff_load_acquire(f->rd_idx);
   uint8_t const* buf8 = (uint8_t const*) data;
 
   if (!f->overwritable)
@@ -488,7 +580,7 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
   _ff_push_n(f, buf8, n, wRel, copy_mode);
 
   // Advance pointer
-  f->wr_idx = advance_pointer(f, w, n);
+  _ff_store_release(f->wr_idx, advance_pointer(f, w, n));
 
   _ff_unlock(f->mutex_wr);
 
@@ -501,10 +593,10 @@ static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo
 
   // Peek the data
   // f->rd_idx might get modified in case of an overflow so we can not use a local variable
-  n = _tu_fifo_peek_n(f, buffer, n, f->wr_idx, f->rd_idx, copy_mode);
+  n = _tu_fifo_peek_n(f, buffer, n, _ff_load_acquire(f->wr_idx), f->rd_idx, copy_mode);
 
   // Advance read pointer
-  f->rd_idx = advance_pointer(f, f->rd_idx, n);
+  _ff_store_release(f->rd_idx, advance_pointer(f, f->rd_idx, n));
 
   _ff_unlock(f->mutex_rd);
   return n;
@@ -640,10 +732,10 @@ bool tu_fifo_read(tu_fifo_t* f, void * buffer)
 
   // Peek the data
   // f->rd_idx might get modified in case of an overflow so we can not use a local variable
-  bool ret = _tu_fifo_peek(f, buffer, f->wr_idx, f->rd_idx);
+  bool ret = _tu_fifo_peek(f, buffer, _ff_load_acquire(f->wr_idx), f->rd_idx);
 
   // Advance pointer
-  f->rd_idx = advance_pointer(f, f->rd_idx, ret);
+  _ff_store_release(f->rd_idx, advance_pointer(f, f->rd_idx, ret));
 
   _ff_unlock(f->mutex_rd);
   return ret;
@@ -693,7 +785,7 @@ uint16_t tu_fifo_read_n_const_addr_full_words(tu_fifo_t* f, void * buffer, uint1
 bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 {
   _ff_lock(f->mutex_rd);
-  bool ret = _tu_fifo_peek(f, p_buffer, f->wr_idx, f->rd_idx);
+  bool ret = _tu_fifo_peek(f, p_buffer, _ff_load_acquire(f->wr_idx), f->rd_idx);
   _ff_unlock(f->mutex_rd);
   return ret;
 }
@@ -716,7 +808,7 @@ bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 uint16_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n)
 {
   _ff_lock(f->mutex_rd);
-  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, f->wr_idx, f->rd_idx, TU_FIFO_COPY_INC);
+  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, _ff_load_acquire(f->wr_idx), f->rd_idx, TU_FIFO_COPY_INC);
   _ff_unlock(f->mutex_rd);
   return ret;
 }
@@ -744,7 +836,7 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
   bool ret;
   uint16_t const w = f->wr_idx;
 
-  if ( _tu_fifo_full(f, w, f->rd_idx) && !f->overwritable )
+  if ( _tu_fifo_full(f, w, _ff_load_acquire(f->rd_idx)) && !f->overwritable )
   {
     ret = false;
   }else
@@ -755,7 +847,7 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
     _ff_push(f, data, wRel);
 
     // Advance pointer
-    f->wr_idx = advance_pointer(f, w, 1);
+    _ff_store_release(f->wr_idx, advance_pointer(f, w, 1));
 
     ret = true;
   }
@@ -867,7 +959,7 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable)
 /******************************************************************************/
 void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
 {
-  f->wr_idx = advance_pointer(f, f->wr_idx, n);
+  _ff_store_release(f->wr_idx, advance_pointer(f, f->wr_idx, n));
 }
 
 /******************************************************************************/
@@ -888,7 +980,7 @@ void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
 /******************************************************************************/
 void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 {
-  f->rd_idx = advance_pointer(f, f->rd_idx, n);
+  _ff_store_release(f->rd_idx, advance_pointer(f, f->rd_idx, n));
 }
 
 /******************************************************************************/
@@ -909,7 +1001,7 @@ void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
   // Operate on temporary values in case they change in between
-  uint16_t w = f->wr_idx, r = f->rd_idx;
+  uint16_t w = _ff_load_acquire(f->wr_idx), r = f->rd_idx;
 
   uint16_t cnt = _tu_fifo_count(f, w, r);
 
@@ -972,7 +1064,7 @@ void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 /******************************************************************************/
 void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
-  uint16_t w = f->wr_idx, r = f->rd_idx;
+  uint16_t w = f->wr_idx, r = _ff_load_acquire(f->rd_idx);
   uint16_t free = _tu_fifo_remaining(f, w, r);
 
   if (free == 0)
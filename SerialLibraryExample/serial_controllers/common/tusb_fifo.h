@@ -52,6 +52,32 @@ extern "C" {
 #define tu_fifo_mutex_t  osal_mutex_t
 #endif
 
+// Lock free single producer/single consumer mode. The write side only stores wr_idx and the read side only
+// stores rd_idx, each published with release ordering and observed with acquire ordering, so one ISR and one
+// task can share a FIFO without locks. When enabled, the CDC, vendor and MIDI drivers don't create their
+// application side mutexes (each FIFO must be used by a single application task) and the OS none event queue
+// is read without disabling the controller interrupt (tud_task()/tuh_task() must only run in one context,
+// never from an interrupt). Opt-in, only enable it when every FIFO and the event queue have exactly one
+// ISR side and one task side user.
+#ifndef CFG_TUSB_FIFO_SPSC
+  #define CFG_TUSB_FIFO_SPSC  0
+#endif
+
+// Copy data between word aligned buffers a word at a time, with 16 byte LDM/STM bursts on Cortex-M.
+// Default on for ARM GCC since newlib-nano memcpy is a byte loop, other targets use the C library memcpy.
+#ifndef CFG_TUSB_FIFO_WORD_COPY
+  #if defined(__GNUC__) && defined(__arm__)
+    #define CFG_TUSB_FIFO_WORD_COPY  1
+  #else
+    #define CFG_TUSB_FIFO_WORD_COPY  0
+  #endif
+#endif
+
+// Copies of at least this many bytes are offered to tu_fifo_dma_copy_cb() first, 0 to disable
+#ifndef CFG_TUSB_FIFO_DMA_MIN_BYTES
+  #define CFG_TUSB_FIFO_DMA_MIN_BYTES  0
+#endif
+
 typedef struct
 {
   uint8_t* buffer               ; ///< buffer pointer
@@ -108,6 +134,13 @@ void tu_fifo_config_mutex(tu_fifo_t *f, tu_fifo_mutex_t write_mutex_hdl, tu_fifo
 }
 #endif
 
+// Optional DMA assisted copy for large reads/writes (refer to CFG_TUSB_FIFO_DMA_MIN_BYTES).
+// The copy must be complete when this returns, return false to fall back to a CPU copy.
+// This only offloads the copy itself, the CPU waits for it: read/write indices are updated right after
+// and the FIFO has no pending state for an unfinished copy. To overlap a DMA transfer with the CPU, use
+// tu_fifo_get_read_info()/tu_fifo_get_write_info() to start it and advance the pointer in the DMA ISR.
+TU_ATTR_WEAK bool tu_fifo_dma_copy_cb(void * dst, void const * src, uint16_t len);
+
 bool     tu_fifo_write                  (tu_fifo_t* f, void const * p_data);
 uint16_t tu_fifo_write_n                (tu_fifo_t* f, void const * p_data, uint16_t n);
 uint16_t tu_fifo_write_n_const_addr_full_words    (tu_fifo_t* f, const void * data, uint16_t n);
@@ -265,6 +265,11 @@
 #elif TU_CHECK_MCU(OPT_MCU_F1C100S)
   #define TUP_DCD_ENDPOINT_MAX    4
 
+//------------ Virtual -------------//
+#elif TU_CHECK_MCU(OPT_MCU_VIRTUAL)
+  // full speed like the SAMD21 by default, BOARD_TUD_MAX_SPEED = OPT_MODE_HIGH_SPEED simulates high speed
+  #define TUP_DCD_ENDPOINT_MAX    16
+
 #endif
 
 //--------------------------------------------------------------------+
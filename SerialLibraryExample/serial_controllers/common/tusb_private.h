@@ -37,6 +37,8 @@ typedef struct TU_ATTR_PACKED
   volatile uint8_t busy    : 1;
   volatile uint8_t stalled : 1;
   volatile uint8_t claimed : 1;
+  volatile uint8_t queued  : 1; // second transfer queued behind the busy one (ping-pong endpoint)
+  uint8_t pingpong         : 1; // endpoint accepts a second transfer while busy
 }tu_edpt_state_t;
 
 //--------------------------------------------------------------------+
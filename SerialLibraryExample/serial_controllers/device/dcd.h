@@ -62,6 +62,9 @@ typedef enum
   // Not an DCD event, just a convenient way to defer ISR function
   USBD_EVENT_FUNC_CALL,
 
+  // Not an DCD event, transfer complete events of non control endpoints are pending (refer to CFG_TUD_EVENT_COALESCE)
+  USBD_EVENT_XFER_BATCH,
+
   DCD_EVENT_COUNT
 } dcd_eventid_t;
 
@@ -160,6 +163,11 @@ bool dcd_edpt_xfer            (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer
 // This API is optional, may be useful for register-based for transferring data.
 bool dcd_edpt_xfer_fifo       (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes) TU_ATTR_WEAK;
 
+// Check if an opened endpoint accepts a second transfer while the first one is still in progress
+// (double buffered/ping-pong endpoint). Completions must be reported in the order the transfers were queued.
+// This API is optional, usbd only queues one transfer per endpoint without it.
+bool dcd_edpt_pingpong        (uint8_t rhport, uint8_t ep_addr) TU_ATTR_WEAK;
+
 // Stall endpoint, any queuing transfer should be removed from endpoint
 void dcd_edpt_stall           (uint8_t rhport, uint8_t ep_addr);
 
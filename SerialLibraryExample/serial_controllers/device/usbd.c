@@ -46,6 +46,14 @@
   #define CFG_TUD_TASK_QUEUE_SZ   16
 #endif
 
+// Transfer complete events of non control endpoints are stored per endpoint instead of queued, a single
+// USBD_EVENT_XFER_BATCH event makes tud_task() dispatch all completed endpoints at once. Since each endpoint
+// has at most one transfer in flight (two for ping-pong endpoints, each with its own slot), bulk traffic
+// can't overflow the queue.
+#ifndef CFG_TUD_EVENT_COALESCE
+  #define CFG_TUD_EVENT_COALESCE  1
+#endif
+
 //--------------------------------------------------------------------+
 // Device Data
 //--------------------------------------------------------------------+
@@ -218,7 +226,11 @@ static usbd_class_driver_t const _usbd_driver[] =
     .open             = netd_open,
     .control_xfer_cb  = netd_control_xfer_cb,
     .xfer_cb          = netd_xfer_cb,
-    .sof                  = NULL,
+    #if CFG_TUD_NCM
+    .sof              = netd_sof,
+    #else
+    .sof              = NULL,
+    #endif
   },
   #endif
 
@@ -267,11 +279,43 @@ static inline usbd_class_driver_t const * get_driver(uint8_t drvid)
 enum { RHPORT_INVALID = 0xFFu };
 static uint8_t _usbd_rhport = RHPORT_INVALID;
 
+// Drivers which requested the SOF interrupt, bit of sof_consumer_t
+static uint8_t _usbd_sof_consumers;
+
 // Event queue
 // usbd_int_set() is used as mutex in OS NONE config
 OSAL_QUEUE_DEF(usbd_int_set, _usbd_qdef, CFG_TUD_TASK_QUEUE_SZ, dcd_event_t);
 static osal_queue_t _usbd_q;
 
+// Event queue statistics, queue depth is tracked with free running counters so stats can be reset anytime
+static tud_event_stats_t _usbd_stats;
+static uint32_t _usbd_enqueued;
+static uint32_t _usbd_dequeued; // only written by tud_task()
+
+#if CFG_TUD_EVENT_COALESCE
+TU_VERIFY_STATIC(CFG_TUD_ENDPPOINT_MAX <= 16, "pending bitmap holds 16 endpoints");
+
+typedef struct
+{
+  uint32_t len;
+  uint8_t  result;
+} usbd_xfer_done_t;
+
+// Completed transfers waiting for tud_task(), bit (2*epnum + dir) of _usbd_xfer_pending
+static usbd_xfer_done_t _usbd_xfer_done[CFG_TUD_ENDPPOINT_MAX][2];
+static volatile uint32_t _usbd_xfer_pending;
+static volatile bool _usbd_batch_queued;
+
+#if CFG_TUD_EDPT_PINGPONG
+// Second completion of a ping-pong endpoint (other bank), dispatched right after the one in _usbd_xfer_done
+static usbd_xfer_done_t _usbd_xfer_second[CFG_TUD_ENDPPOINT_MAX][2];
+static volatile uint32_t _usbd_xfer_pending_second;
+#define USBD_BATCH_MAX    (4*CFG_TUD_ENDPPOINT_MAX)
+#else
+#define USBD_BATCH_MAX    (2*CFG_TUD_ENDPPOINT_MAX)
+#endif
+#endif
+
 // Mutex for claiming endpoint, only needed when using with preempted RTOS
 #if CFG_TUSB_OS != OPT_OS_NONE
 static osal_mutex_def_t _ubsd_mutexdef;
@@ -307,7 +351,8 @@ static char const* const _usbd_event_str[DCD_EVENT_COUNT] =
   "Resume"         ,
   "Setup Received" ,
   "Xfer Complete"  ,
-  "Func Call"
+  "Func Call"      ,
+  "Xfer Batch"
 };
 
 // for usbd_control to print the name of control complete driver
@@ -441,6 +486,16 @@ static void usbd_reset(uint8_t rhport)
 {
   configuration_reset(rhport);
   usbd_control_reset();
+
+#if CFG_TUD_EVENT_COALESCE
+  // transfers completed before the reset belong to the old configuration
+  usbd_int_set(false);
+  _usbd_xfer_pending = 0;
+#if CFG_TUD_EDPT_PINGPONG
+  _usbd_xfer_pending_second = 0;
+#endif
+  usbd_int_set(true);
+#endif
 }
 
 bool tud_task_event_ready(void)
@@ -448,9 +503,114 @@ bool tud_task_event_ready(void)
   // Skip if stack is not initialized
   if ( !tusb_inited() ) return false;
 
+#if CFG_TUD_EVENT_COALESCE
+  if ( _usbd_xfer_pending ) return true;
+#endif
+
   return !osal_queue_empty(_usbd_q);
 }
 
+void tud_event_stats_get(tud_event_stats_t* stats)
+{
+  *stats = _usbd_stats;
+}
+
+void tud_event_stats_reset(void)
+{
+  tu_varclr(&_usbd_stats);
+}
+
+// Invoke the class callback associated with the endpoint address
+static void usbd_xfer_complete(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t len)
+{
+  uint8_t const epnum   = tu_edpt_number(ep_addr);
+  uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
+
+  TU_LOG(USBD_DBG, "on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) len);
+
+  tu_edpt_state_t* ep_state = &_usbd_dev.ep_status[epnum][ep_dir];
+
+  // Ping-pong endpoint stays busy with its second transfer, claim was already dropped when it was queued
+  if ( ep_state->queued )
+  {
+    ep_state->queued = 0;
+  }
+  else
+  {
+    ep_state->busy = 0;
+  }
+  if ( !ep_state->pingpong ) ep_state->claimed = 0;
+
+  if ( 0 == epnum )
+  {
+    usbd_control_xfer_cb(rhport, ep_addr, result, len);
+  }
+  else
+  {
+    usbd_class_driver_t const * driver = get_driver( _usbd_dev.ep2drv[epnum][ep_dir] );
+    TU_ASSERT(driver, );
+
+    TU_LOG(USBD_DBG, "  %s xfer callback\r\n", driver->name);
+    driver->xfer_cb(rhport, ep_addr, result, len);
+  }
+}
+
+#if CFG_TUD_EVENT_COALESCE
+// Dispatch all pending transfer complete events
+static void usbd_xfer_batch(void)
+{
+  struct
+  {
+    uint8_t ep_addr;
+    usbd_xfer_done_t done;
+  } batch[USBD_BATCH_MAX];
+  uint8_t count = 0;
+
+  // Copy the completions out while interrupts are off: once pending is cleared the
+  // controller may store the next completion of an endpoint in the same slot
+  usbd_int_set(false);
+  uint32_t pending = _usbd_xfer_pending;
+#if CFG_TUD_EDPT_PINGPONG
+  uint32_t const pending_second = _usbd_xfer_pending_second;
+  _usbd_xfer_pending_second = 0;
+#endif
+  _usbd_xfer_pending = 0;
+  _usbd_batch_queued = false;
+
+  for ( uint8_t bit = 0; pending; bit++, pending >>= 1 )
+  {
+    if ( !(pending & 1) ) continue;
+
+    uint8_t const epnum = bit >> 1;
+    uint8_t const ep_dir = bit & 1;
+
+    batch[count].ep_addr = tu_edpt_addr(epnum, ep_dir);
+    batch[count].done    = _usbd_xfer_done[epnum][ep_dir];
+    count++;
+
+#if CFG_TUD_EDPT_PINGPONG
+    if ( pending_second & TU_BIT(bit) )
+    {
+      batch[count].ep_addr = tu_edpt_addr(epnum, ep_dir);
+      batch[count].done    = _usbd_xfer_second[epnum][ep_dir];
+      count++;
+    }
+#endif
+  }
+  usbd_int_set(true);
+
+  if ( count == 0 ) return;
+  _usbd_stats.batches++;
+
+  for ( uint8_t i = 0; i < count; i++ )
+  {
+    _usbd_stats.dispatched++;
+    TU_LOG(USBD_DBG, "USBD Xfer Complete ");
+    usbd_xfer_complete(_usbd_rhport, batch[i].ep_addr, (xfer_result_t) batch[i].done.result, batch[i].done.len);
+  }
+}
+#endif
+
 /* USB Device Driver task
  * This top level thread manages all device controller event and delegates events to class-specific drivers.
  * This should be called periodically within the mainloop or rtos thread.
@@ -479,9 +639,18 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr)
   // Loop until there is no more events in the queue
   while (1)
   {
+#if CFG_TUD_EVENT_COALESCE
+    // the batch event is dropped if the queue was full, pick up its transfers before waiting for
+    // the next event, which may never come (e.g. blocking on an RTOS queue)
+    if ( _usbd_xfer_pending && !_usbd_batch_queued ) usbd_xfer_batch();
+#endif
+
     dcd_event_t event;
     if ( !osal_queue_receive(_usbd_q, &event, timeout_ms) ) return;
 
+    _usbd_dequeued++;
+    if ( event.event_id != USBD_EVENT_XFER_BATCH ) _usbd_stats.dispatched++;
+
 #if CFG_TUSB_DEBUG >= 2
     if (event.event_id == DCD_EVENT_SETUP_RECEIVED) TU_LOG(USBD_DBG, "\r\n"); // extra line for setup
     TU_LOG(USBD_DBG, "USBD %s ", event.event_id < DCD_EVENT_COUNT ? _usbd_event_str[event.event_id] : "CORRUPTED");
@@ -528,31 +697,15 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr)
       break;
 
       case DCD_EVENT_XFER_COMPLETE:
-      {
-        // Invoke the class callback associated with the endpoint address
-        uint8_t const ep_addr = event.xfer_complete.ep_addr;
-        uint8_t const epnum   = tu_edpt_number(ep_addr);
-        uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
-
-        TU_LOG(USBD_DBG, "on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event.xfer_complete.len);
-
-        _usbd_dev.ep_status[epnum][ep_dir].busy = false;
-        _usbd_dev.ep_status[epnum][ep_dir].claimed = 0;
-
-        if ( 0 == epnum )
-        {
-          usbd_control_xfer_cb(event.rhport, ep_addr, (xfer_result_t)event.xfer_complete.result, event.xfer_complete.len);
-        }
-        else
-        {
-          usbd_class_driver_t const * driver = get_driver( _usbd_dev.ep2drv[epnum][ep_dir] );
-          TU_ASSERT(driver, );
+        usbd_xfer_complete(event.rhport, event.xfer_complete.ep_addr, (xfer_result_t)event.xfer_complete.result, event.xfer_complete.len);
+      break;
 
-          TU_LOG(USBD_DBG, "  %s xfer callback\r\n", driver->name);
-          driver->xfer_cb(event.rhport, ep_addr, (xfer_result_t)event.xfer_complete.result, event.xfer_complete.len);
-        }
-      }
+#if CFG_TUD_EVENT_COALESCE
+      case USBD_EVENT_XFER_BATCH:
+        TU_LOG(USBD_DBG, "\r\n");
+        usbd_xfer_batch();
       break;
+#endif
 
       case DCD_EVENT_SUSPEND:
         // NOTE: When plugging/unplugging device, the D+/D- state are unstable and
@@ -1067,6 +1220,85 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
 //--------------------------------------------------------------------+
 // DCD Event Handler
 //--------------------------------------------------------------------+
+// Post an event to the usbd task and update queue statistics
+TU_ATTR_FAST_FUNC static bool usbd_queue_event(dcd_event_t const * event, bool in_isr)
+{
+  if ( !osal_queue_send(_usbd_q, event, in_isr) )
+  {
+    _usbd_stats.overflows++;
+    return false;
+  }
+
+  _usbd_stats.queued++;
+  uint32_t const depth = ++_usbd_enqueued - _usbd_dequeued;
+  if ( depth > _usbd_stats.max_depth ) _usbd_stats.max_depth = (uint16_t) depth;
+  return true;
+}
+
+#if CFG_TUD_EVENT_COALESCE
+// Store a non control endpoint transfer complete event, only the first pending one posts a batch event
+TU_ATTR_FAST_FUNC static void usbd_defer_xfer_complete(dcd_event_t const * event, bool in_isr)
+{
+  uint8_t const epnum  = tu_edpt_number(event->xfer_complete.ep_addr);
+  uint8_t const ep_dir = tu_edpt_dir(event->xfer_complete.ep_addr);
+  uint32_t const mask  = TU_BIT(2*epnum + ep_dir);
+  usbd_xfer_done_t* done = &_usbd_xfer_done[epnum][ep_dir];
+
+  if ( !in_isr ) usbd_int_set(false);
+
+  // Every completion is a separate transfer (and buffer), adding up lengths would corrupt the class
+  // driver's view of both. No new transfer is queued before the pending one is dispatched, so a
+  // repeated completion is a controller driver bug and is dropped.
+  bool stored = true;
+
+#if CFG_TUD_EDPT_PINGPONG
+  // Second completion of a ping-pong endpoint belongs to the other bank, it waits in the second slot
+  // and the same batch dispatches it after the first, whether the batch runs from its event or from
+  // tud_task() picking up a dropped one. The endpoint has only two banks.
+  if ( (_usbd_xfer_pending & mask) && _usbd_dev.ep_status[epnum][ep_dir].pingpong )
+  {
+    done = &_usbd_xfer_second[epnum][ep_dir];
+    if ( !(_usbd_xfer_pending_second & mask) )
+    {
+      done->len    = event->xfer_complete.len;
+      done->result = event->xfer_complete.result;
+      _usbd_xfer_pending_second |= mask;
+    }
+    else
+    {
+      stored = false;
+    }
+  }
+  else
+#endif
+  if ( _usbd_xfer_pending & mask )
+  {
+    stored = false;
+  }
+  else
+  {
+    done->len    = event->xfer_complete.len;
+    done->result = event->xfer_complete.result;
+    _usbd_xfer_pending |= mask;
+  }
+
+  bool const post = stored && !_usbd_batch_queued;
+  if ( stored ) _usbd_batch_queued = true;
+
+  if ( !in_isr ) usbd_int_set(true);
+
+  TU_ASSERT(stored, );
+
+  if ( post )
+  {
+    dcd_event_t const event_batch = { .rhport = event->rhport, .event_id = USBD_EVENT_XFER_BATCH };
+
+    // Queue full: let the next completion try again, tud_task() picks up the pending ones meanwhile
+    if ( !usbd_queue_event(&event_batch, in_isr) ) _usbd_batch_queued = false;
+  }
+}
+#endif
+
 TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
 {
   switch (event->event_id)
@@ -1076,7 +1308,7 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
       _usbd_dev.addressed  = 0;
       _usbd_dev.cfg_num    = 0;
       _usbd_dev.suspended  = 0;
-      osal_queue_send(_usbd_q, event, in_isr);
+      usbd_queue_event(event, in_isr);
     break;
 
     case DCD_EVENT_SUSPEND:
@@ -1086,8 +1318,16 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
       // suspended vs disconnected. We will skip handling SUSPEND/RESUME event if not currently connected
       if ( _usbd_dev.connected )
       {
+#if CFG_TUD_EVENT_COALESCE
+        // already suspended, the pending suspend event covers this one
+        if ( _usbd_dev.suspended )
+        {
+          _usbd_stats.coalesced++;
+          break;
+        }
+#endif
         _usbd_dev.suspended = 1;
-        osal_queue_send(_usbd_q, event, in_isr);
+        usbd_queue_event(event, in_isr);
       }
     break;
 
@@ -1095,8 +1335,16 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
       // skip event if not connected (especially required for SAMD)
       if ( _usbd_dev.connected )
       {
+#if CFG_TUD_EVENT_COALESCE
+        // not suspended, e.g. resume was already signaled by SOF
+        if ( !_usbd_dev.suspended )
+        {
+          _usbd_stats.coalesced++;
+          break;
+        }
+#endif
         _usbd_dev.suspended = 0;
-        osal_queue_send(_usbd_q, event, in_isr);
+        usbd_queue_event(event, in_isr);
       }
     break;
 
@@ -1118,14 +1366,25 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
         _usbd_dev.suspended = 0;
 
         dcd_event_t const event_resume = { .rhport = event->rhport, .event_id = DCD_EVENT_RESUME };
-        osal_queue_send(_usbd_q, &event_resume, in_isr);
+        usbd_queue_event(&event_resume, in_isr);
       }
 
       // skip osal queue for SOF in usbd task
     break;
 
+#if CFG_TUD_EVENT_COALESCE
+    case DCD_EVENT_XFER_COMPLETE:
+      if ( tu_edpt_number(event->xfer_complete.ep_addr) != 0 )
+      {
+        usbd_defer_xfer_complete(event, in_isr);
+        break;
+      }
+      usbd_queue_event(event, in_isr);
+    break;
+#endif
+
     default:
-      osal_queue_send(_usbd_q, event, in_isr);
+      usbd_queue_event(event, in_isr);
     break;
   }
 }
@@ -1194,8 +1453,21 @@ bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep)
 
   TU_ASSERT(tu_edpt_number(desc_ep->bEndpointAddress) < CFG_TUD_ENDPPOINT_MAX);
   TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) _usbd_dev.speed));
+  TU_ASSERT(dcd_edpt_open(rhport, desc_ep));
 
-  return dcd_edpt_open(rhport, desc_ep);
+#if CFG_TUD_EDPT_PINGPONG
+  if ( dcd_edpt_pingpong )
+  {
+    // Opening a direction can also take the banks of the other direction with the same number, refresh both
+    uint8_t const epnum = tu_edpt_number(desc_ep->bEndpointAddress);
+    for ( uint8_t dir = 0; dir < 2; dir++ )
+    {
+      _usbd_dev.ep_status[epnum][dir].pingpong = dcd_edpt_pingpong(rhport, tu_edpt_addr(epnum, dir));
+    }
+  }
+#endif
+
+  return true;
 }
 
 bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr)
@@ -1243,21 +1515,41 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
 
   TU_LOG(USBD_DBG, "  Queue EP %02X with %u bytes ...\r\n", ep_addr, total_bytes);
 
+  tu_edpt_state_t* ep_state = &_usbd_dev.ep_status[epnum][dir];
+
   // Attempt to transfer on a busy endpoint, sound like an race condition !
-  TU_ASSERT(_usbd_dev.ep_status[epnum][dir].busy == 0);
+  // Ping-pong endpoints take one more transfer while busy
+  TU_ASSERT(ep_state->busy == 0 || (ep_state->pingpong && ep_state->queued == 0));
 
   // Set busy first since the actual transfer can be complete before dcd_edpt_xfer()
   // could return and USBD task can preempt and clear the busy
-  _usbd_dev.ep_status[epnum][dir].busy = true;
+  bool const second = ep_state->busy;
+  if ( second )
+  {
+    ep_state->queued = 1;
+  }
+  else
+  {
+    ep_state->busy = 1;
+  }
 
   if ( dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes) )
   {
+    // Busy/queued now guard the endpoint, drop the claim so the other slot can be claimed
+    if ( ep_state->pingpong ) ep_state->claimed = 0;
     return true;
   }else
   {
     // DCD error, mark endpoint as ready to allow next transfer
-    _usbd_dev.ep_status[epnum][dir].busy = false;
-    _usbd_dev.ep_status[epnum][dir].claimed = 0;
+    if ( second )
+    {
+      ep_state->queued = 0;
+    }
+    else
+    {
+      ep_state->busy = 0;
+    }
+    ep_state->claimed = 0;
     TU_LOG(USBD_DBG, "FAILED\r\n");
     TU_BREAKPOINT();
     return false;
@@ -1323,6 +1615,7 @@ void usbd_edpt_stall(uint8_t rhport, uint8_t ep_addr)
     dcd_edpt_stall(rhport, ep_addr);
     _usbd_dev.ep_status[epnum][dir].stalled = true;
     _usbd_dev.ep_status[epnum][dir].busy = true;
+    _usbd_dev.ep_status[epnum][dir].queued = false;
   }
 }
 
@@ -1340,6 +1633,7 @@ void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr)
     dcd_edpt_clear_stall(rhport, ep_addr);
     _usbd_dev.ep_status[epnum][dir].stalled = false;
     _usbd_dev.ep_status[epnum][dir].busy = false;
+    _usbd_dev.ep_status[epnum][dir].queued = false;
   }
 }
 
@@ -1372,18 +1666,28 @@ void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr)
   dcd_edpt_close(rhport, ep_addr);
   _usbd_dev.ep_status[epnum][dir].stalled = false;
   _usbd_dev.ep_status[epnum][dir].busy = false;
+  _usbd_dev.ep_status[epnum][dir].queued = false;
   _usbd_dev.ep_status[epnum][dir].claimed = false;
 
   return;
 }
 
-void usbd_sof_enable(uint8_t rhport, bool en)
+void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en)
 {
   rhport = _usbd_rhport;
 
-  // TODO: Check needed if all drivers including the user sof_cb does not need an active SOF ISR any more.
   // Only if all drivers switched off SOF calls the SOF interrupt may be disabled
-  dcd_sof_enable(rhport, en);
+  uint8_t const consumers = _usbd_sof_consumers;
+  if ( en )
+  {
+    _usbd_sof_consumers = (uint8_t) (consumers | TU_BIT(consumer));
+  }
+  else
+  {
+    _usbd_sof_consumers = (uint8_t) (consumers & ~TU_BIT(consumer));
+  }
+
+  if ( (consumers != 0) != (_usbd_sof_consumers != 0) ) dcd_sof_enable(rhport, _usbd_sof_consumers != 0);
 }
 
 #endif
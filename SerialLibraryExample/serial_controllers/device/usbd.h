@@ -58,6 +58,23 @@ void tud_task (void)
 // Check if there is pending events need processing by tud_task()
 bool tud_task_event_ready(void);
 
+// Event queue statistics, useful to size CFG_TUD_TASK_QUEUE_SZ
+typedef struct
+{
+  uint32_t queued;     // events posted to the queue
+  uint32_t dispatched; // events handled by tud_task(), each endpoint of a transfer complete batch included
+  uint32_t coalesced;  // events merged into an already pending event (suspend, resume)
+  uint32_t batches;    // transfer complete batches handled by tud_task()
+  uint32_t overflows;  // events dropped because the queue was full
+  uint16_t max_depth;  // most events waiting in the queue at once
+} tud_event_stats_t;
+
+// Get event queue statistics (may be slightly off if events are also posted from task context)
+void tud_event_stats_get(tud_event_stats_t* stats);
+
+// Clear event queue statistics
+void tud_event_stats_reset(void);
+
 #ifndef _TUSB_DCD_H_
 extern void dcd_int_handler(uint8_t rhport);
 #endif
@@ -103,8 +103,15 @@ bool usbd_edpt_ready(uint8_t rhport, uint8_t ep_addr)
   return !usbd_edpt_busy(rhport, ep_addr) && !usbd_edpt_stalled(rhport, ep_addr);
 }
 
+// Drivers which need the SOF interrupt, it stays enabled while any of them requests it
+typedef enum
+{
+  SOF_CONSUMER_AUDIO = 0,
+  SOF_CONSUMER_NCM,
+} sof_consumer_t;
+
 // Enable SOF interrupt
-void usbd_sof_enable(uint8_t rhport, bool en);
+void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en);
 
 /*------------------------------------------------------------------*/
 /* Helper
@@ -46,6 +46,16 @@
 #define CFG_TUH_INTERFACE_MAX   8
 #endif
 
+// Maximum number of bulk transfers submitted to the host controller at once, 0 for no limit.
+// For controllers with a few host channels (pipes) shared by all devices: transfers beyond the
+// limit wait in their endpoint and a free channel goes to the waiting device that started the
+// fewest bytes, so devices share the channels by bytes whatever their transfer sizes (e.g. MSC
+// CBW/data/CSW vs a single CDC transfer). Control and interrupt transfers bypass it.
+// Can be changed at run time with tuh_configure(TUH_CFGID_XFER_CHANNELS).
+#ifndef CFG_TUH_XFER_CHANNELS
+#define CFG_TUH_XFER_CHANNELS   0
+#endif
+
 // Debug level of USBD
 #define USBH_DBG_LVL   2
 
@@ -107,6 +117,20 @@ typedef struct {
 
   tu_edpt_state_t ep_status[CFG_TUH_ENDPOINT_MAX][2];
 
+#if CFG_TUH_XFER_CHANNELS
+  // Transfer scheduler, one bit per endpoint: (epnum << 1) | dir
+  uint32_t ep_bulk;   // opened bulk endpoints, only these are scheduled
+  uint32_t ep_queued; // transfer waiting for a channel in ep_queue[]
+  uint32_t ep_active; // transfer submitted to the controller
+  uint8_t  ep_next;   // bit to look at first for the next transfer of this device
+  uint32_t xfer_bytes;// bytes of the transfers started, wraps (compared by difference)
+
+  struct {
+    uint8_t* buffer;
+    uint16_t total_bytes;
+  } ep_queue[CFG_TUH_ENDPOINT_MAX][2];
+#endif
+
 #if CFG_TUH_API_EDPT_XFER
   // TODO array can be CFG_TUH_ENDPOINT_MAX-1
   struct {
@@ -259,6 +283,16 @@ struct
   volatile uint16_t actual_len;
 }_ctrl_xfer;
 
+#if CFG_TUH_XFER_CHANNELS
+static struct
+{
+  uint8_t channels; // bulk transfers allowed in the controller at once, 0 for no limit
+  uint8_t active;   // bulk transfers submitted to the controller
+  uint8_t next_dev; // index in _usbh_devices[] to look at first, devices with equal bytes take turns
+  void*   held;     // device whose completed transfer still holds its channel (driver callback running)
+} _usbh_sched = { .channels = CFG_TUH_XFER_CHANNELS };
+#endif
+
 //------------- Helper Function -------------//
 
 TU_ATTR_ALWAYS_INLINE
@@ -273,6 +307,14 @@ static void process_device_unplugged(uint8_t rhport, uint8_t hub_addr, uint8_t h
 static bool usbh_edpt_control_open(uint8_t dev_addr, uint8_t max_packet_size);
 static bool usbh_control_xfer_cb (uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 
+#if CFG_TUH_XFER_CHANNELS
+static bool sched_submit(usbh_device_t* dev, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
+static bool sched_complete(usbh_device_t* dev, uint8_t ep_addr);
+static void sched_release(void);
+static void sched_dispatch(void);
+static void sched_close(usbh_device_t* dev);
+#endif
+
 #if CFG_TUSB_OS == OPT_OS_NONE
 // TODO rework time-related function later
 void osal_task_delay(uint32_t msec)
@@ -290,6 +332,19 @@ void osal_task_delay(uint32_t msec)
 
 bool tuh_configure(uint8_t rhport, uint32_t cfg_id, const void* cfg_param)
 {
+#if CFG_TUH_XFER_CHANNELS
+  if ( cfg_id == TUH_CFGID_XFER_CHANNELS )
+  {
+    (void) rhport;
+    TU_VERIFY(cfg_param);
+    _usbh_sched.channels = *((uint8_t const*) cfg_param);
+
+    // a higher limit lets waiting transfers start now
+    if ( tuh_inited() ) sched_dispatch();
+    return true;
+  }
+#endif
+
   if (hcd_configure)
   {
     return hcd_configure(rhport, cfg_id, cfg_param);
@@ -362,6 +417,12 @@ bool tuh_init(uint8_t controller_id)
   tu_memclr(&_dev0, sizeof(_dev0));
   tu_memclr(_usbh_devices, sizeof(_usbh_devices));
   tu_memclr(&_ctrl_xfer, sizeof(_ctrl_xfer));
+#if CFG_TUH_XFER_CHANNELS
+  // keep the limit, it may be configured before tuh_init()
+  _usbh_sched.active   = 0;
+  _usbh_sched.next_dev = 0;
+  _usbh_sched.held     = NULL;
+#endif
 
   for(uint8_t i=0; i<TOTAL_DEVICES; i++)
   {
@@ -459,6 +520,12 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr)
           dev->ep_status[epnum][ep_dir].busy    = 0;
           dev->ep_status[epnum][ep_dir].claimed = 0;
 
+#if CFG_TUH_XFER_CHANNELS
+          // the channel is held until the driver callback returns, so the device's next transfer
+          // (e.g. MSC data after the CBW) competes for it with the transfers already waiting
+          bool const sched_held = sched_complete(dev, ep_addr);
+#endif
+
           if ( 0 == epnum )
           {
             usbh_control_xfer_cb(event.dev_addr, ep_addr, event.xfer_complete.result, event.xfer_complete.len);
@@ -493,11 +560,18 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr)
 #endif
               {
                 // no driver/callback responsible for this transfer
+#if CFG_TUH_XFER_CHANNELS
+                if ( sched_held ) sched_release();
+#endif
                 TU_ASSERT(false, );
               }
 
             }
           }
+
+#if CFG_TUH_XFER_CHANNELS
+          if ( sched_held ) sched_release();
+#endif
         }
       }
       break;
@@ -791,6 +865,14 @@ bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t * b
   dev->ep_callback[epnum][dir].user_data   = user_data;
 #endif
 
+#if CFG_TUH_XFER_CHANNELS
+  if ( sched_submit(dev, dev_addr, ep_addr, buffer, total_bytes) )
+  {
+    TU_LOG2("Scheduled\r\n");
+    return true;
+  }
+#endif
+
   if ( hcd_edpt_xfer(dev->rhport, dev_addr, ep_addr, buffer, total_bytes) )
   {
     TU_LOG2("OK\r\n");
@@ -827,9 +909,193 @@ bool tuh_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const * desc_ep)
 {
   TU_ASSERT( tu_edpt_validate(desc_ep, tuh_speed_get(dev_addr)) );
 
+#if CFG_TUH_XFER_CHANNELS
+  usbh_device_t* dev = get_device(dev_addr);
+  if ( dev && desc_ep->bmAttributes.xfer == TUSB_XFER_BULK )
+  {
+    dev->ep_bulk |= TU_BIT((tu_edpt_number(desc_ep->bEndpointAddress) << 1) | tu_edpt_dir(desc_ep->bEndpointAddress));
+  }
+#endif
+
   return hcd_edpt_open(usbh_get_rhport(dev_addr), dev_addr, desc_ep);
 }
 
+//--------------------------------------------------------------------+
+// Transfer Scheduler
+//--------------------------------------------------------------------+
+
+#if CFG_TUH_XFER_CHANNELS
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t sched_ep_bit(uint8_t ep_addr)
+{
+  return TU_BIT((tu_edpt_number(ep_addr) << 1) | tu_edpt_dir(ep_addr));
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool sched_busy(usbh_device_t const* dev)
+{
+  return (dev->ep_queued | dev->ep_active) != 0 || _usbh_sched.held == dev;
+}
+
+// A device with nothing scheduled starts level with the busy device that started the fewest bytes,
+// so it cannot save up a share while idle and then take the channels from the others
+static void sched_wakeup(usbh_device_t* dev)
+{
+  if ( sched_busy(dev) ) return;
+
+  bool found = false;
+  uint32_t least = 0;
+  for ( uint8_t i = 0; i < TOTAL_DEVICES; i++ )
+  {
+    usbh_device_t const* other = &_usbh_devices[i];
+    if ( other == dev || !sched_busy(other) ) continue;
+    if ( !found || (int32_t) (other->xfer_bytes - least) < 0 ) least = other->xfer_bytes;
+    found = true;
+  }
+
+  if ( found && (int32_t) (least - dev->xfer_bytes) > 0 ) dev->xfer_bytes = least;
+}
+
+// Take a channel for a bulk transfer or queue it, returns false if the transfer is not scheduled (submitted directly)
+static bool sched_submit(usbh_device_t* dev, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+{
+  uint32_t const ep_bit = sched_ep_bit(ep_addr);
+  if ( _usbh_sched.channels == 0 || !(dev->ep_bulk & ep_bit) ) return false;
+
+  usbh_lock();
+
+  sched_wakeup(dev);
+
+  // a free channel means nothing waits, sched_dispatch() hands them out as they free up
+  bool const has_channel = (_usbh_sched.active < _usbh_sched.channels);
+  if ( has_channel )
+  {
+    _usbh_sched.active++;
+    dev->ep_active |= ep_bit;
+    dev->xfer_bytes += total_bytes;
+  }else
+  {
+    dev->ep_queue[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].buffer      = buffer;
+    dev->ep_queue[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].total_bytes = total_bytes;
+    dev->ep_queued |= ep_bit;
+  }
+
+  usbh_unlock();
+
+  if ( has_channel && !hcd_edpt_xfer(dev->rhport, dev_addr, ep_addr, buffer, total_bytes) )
+  {
+    // give the channel back, caller reports the error
+    usbh_lock();
+    _usbh_sched.active--;
+    dev->ep_active &= ~ep_bit;
+    dev->xfer_bytes -= total_bytes;
+    usbh_unlock();
+    return false;
+  }
+
+  return true;
+}
+
+// Transfer on a channel completed, returns true if its channel is now held for sched_release()
+static bool sched_complete(usbh_device_t* dev, uint8_t ep_addr)
+{
+  uint32_t const ep_bit = sched_ep_bit(ep_addr);
+  if ( !(dev->ep_active & ep_bit) ) return false;
+
+  usbh_lock();
+  dev->ep_active &= ~ep_bit;
+  _usbh_sched.held = dev;
+  usbh_unlock();
+
+  return true;
+}
+
+// Give back a channel held by sched_complete()
+static void sched_release(void)
+{
+  usbh_lock();
+  _usbh_sched.active--;
+  _usbh_sched.held = NULL;
+  usbh_unlock();
+
+  sched_dispatch();
+}
+
+// Give free channels to queued transfers: the waiting device that started the fewest bytes goes
+// first, devices with equal bytes take turns, and endpoints of a device take turns
+static void sched_dispatch(void)
+{
+  while (1)
+  {
+    usbh_lock();
+
+    uint8_t dev_idx = TOTAL_DEVICES;
+    if ( _usbh_sched.channels == 0 || _usbh_sched.active < _usbh_sched.channels )
+    {
+      for ( uint8_t i = 0; i < TOTAL_DEVICES; i++ )
+      {
+        uint8_t const idx = (uint8_t) ((_usbh_sched.next_dev + i) % TOTAL_DEVICES);
+        if ( _usbh_devices[idx].ep_queued &&
+             (dev_idx == TOTAL_DEVICES || (int32_t) (_usbh_devices[idx].xfer_bytes - _usbh_devices[dev_idx].xfer_bytes) < 0) )
+        {
+          dev_idx = idx;
+        }
+      }
+    }
+
+    if ( dev_idx == TOTAL_DEVICES )
+    {
+      usbh_unlock();
+      return;
+    }
+
+    usbh_device_t* dev = &_usbh_devices[dev_idx];
+    uint8_t bit = dev->ep_next;
+    for ( uint8_t i = 0; i < 32; i++, bit = (uint8_t) ((bit + 1) & 31) )
+    {
+      if ( dev->ep_queued & TU_BIT(bit) ) break;
+    }
+
+    uint8_t const dev_addr = (uint8_t) (dev_idx + 1);
+    uint8_t const ep_addr  = tu_edpt_addr(bit >> 1, bit & 1);
+    uint8_t const epnum    = bit >> 1;
+    uint8_t const dir      = bit & 1;
+
+    dev->ep_queued &= ~TU_BIT(bit);
+    dev->ep_active |= TU_BIT(bit);
+    dev->ep_next = (uint8_t) ((bit + 1) & 31);
+    dev->xfer_bytes += dev->ep_queue[epnum][dir].total_bytes;
+    _usbh_sched.active++;
+    _usbh_sched.next_dev = (uint8_t) ((dev_idx + 1) % TOTAL_DEVICES);
+
+    usbh_unlock();
+
+    if ( !hcd_edpt_xfer(dev->rhport, dev_addr, ep_addr, dev->ep_queue[epnum][dir].buffer, dev->ep_queue[epnum][dir].total_bytes) )
+    {
+      // report the failure to the driver like any other completion, the channel is given back then
+      TU_LOG1("[%u:%u] Scheduled EP %02X failed\r\n", dev->rhport, dev_addr, ep_addr);
+      hcd_event_xfer_complete(dev_addr, ep_addr, 0, XFER_RESULT_FAILED, false);
+    }
+  }
+}
+
+// Device is gone: drop its queued transfers and free the channels of its active ones (aborted by hcd_device_close())
+static void sched_close(usbh_device_t* dev)
+{
+  usbh_lock();
+  for ( uint8_t bit = 0; bit < 32; bit++ )
+  {
+    if ( dev->ep_active & TU_BIT(bit) ) _usbh_sched.active--;
+  }
+  dev->ep_active = 0;
+  dev->ep_queued = 0;
+  usbh_unlock();
+
+  // hand the freed channels to the other devices
+  sched_dispatch();
+}
+
+#endif
+
 bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
@@ -1142,6 +1408,9 @@ static void process_device_unplugged(uint8_t rhport, uint8_t hub_addr, uint8_t h
       }
 
       hcd_device_close(rhport, dev_addr);
+#if CFG_TUH_XFER_CHANNELS
+      sched_close(dev);
+#endif
       clear_device(dev);
       // abort on-going control xfer if any
       if (_ctrl_xfer.daddr == dev_addr) _set_control_xfer_stage(CONTROL_STAGE_IDLE);
@@ -71,6 +71,7 @@ struct tuh_xfer_s
 // ConfigID for tuh_config()
 enum
 {
+  TUH_CFGID_XFER_CHANNELS = 1, // cfg_param: uint8_t bulk transfers in the controller at once, 0 for no limit (needs CFG_TUH_XFER_CHANNELS)
   TUH_CFGID_RPI_PIO_USB_CONFIGURATION = OPT_MCU_RP2040 // cfg_param: pio_usb_configuration_t
 };
 
@@ -143,9 +143,14 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_receive(osal_queue_t qhdl, v
 {
   (void) msec; // not used, always behave as msec = 0
 
+#if CFG_TUSB_FIFO_SPSC
+  // single consumer (opt-in, refer to CFG_TUSB_FIFO_SPSC), the lock free fifo doesn't need the interrupt disabled
+  bool success = tu_fifo_read(&qhdl->ff, data);
+#else
   _osal_q_lock(qhdl);
   bool success = tu_fifo_read(&qhdl->ff, data);
   _osal_q_unlock(qhdl);
+#endif
 
   return success;
 }
@@ -49,6 +49,48 @@ static TU_ATTR_ALIGNED(4) UsbDeviceDescBank sram_registers[8][2];
 // Therefore we will need to increase it to 10 bytes here.
 static TU_ATTR_ALIGNED(4) uint8_t _setup_packet[8+2];
 
+#if CFG_TUD_EDPT_PINGPONG
+// EPCFG.EPTYPEn value using the bank as second bank of the other one (dual bank/ping-pong endpoint)
+enum { EPTYPE_DUAL_BANK = 0x5 };
+
+// Bulk endpoints using both descriptor banks for one direction, possible when the
+// other direction of the same endpoint number is not used. The controller alternates
+// between the banks (EPSTATUS.CURBK), so the next transfer is already armed when the
+// current one completes and the host gets no NAK while firmware re-arms the endpoint.
+// next_bank is only written by dcd_edpt_xfer() and done_bank by the ISR, so each has its own byte (no read-modify-write race)
+typedef struct
+{
+  uint8_t enabled;
+  uint8_t dir;
+  volatile uint8_t next_bank; // bank of the next queued transfer
+  volatile uint8_t done_bank; // bank of the oldest transfer in progress
+} pingpong_state_t;
+
+static pingpong_state_t _pingpong[8];
+
+// Drop queued transfers of a ping-pong endpoint and restart from bank 0
+static void pingpong_reset(uint8_t epnum)
+{
+  pingpong_state_t* pp = &_pingpong[epnum];
+  UsbDeviceEndpoint* ep = &USB->DEVICE.DeviceEndpoint[epnum];
+
+  if ( pp->dir == TUSB_DIR_OUT )
+  {
+    // bank ready means full for OUT, banks are made available again when a transfer is queued
+    ep->EPSTATUSSET.reg = USB_DEVICE_EPSTATUSSET_BK0RDY | USB_DEVICE_EPSTATUSSET_BK1RDY;
+  }else
+  {
+    ep->EPSTATUSCLR.reg = USB_DEVICE_EPSTATUSCLR_BK0RDY | USB_DEVICE_EPSTATUSCLR_BK1RDY;
+  }
+  ep->EPSTATUSCLR.reg = USB_DEVICE_EPSTATUSCLR_CURBK;
+  ep->EPINTFLAG.reg = USB_DEVICE_EPINTFLAG_TRCPT0 | USB_DEVICE_EPINTFLAG_TRCPT1 |
+                      USB_DEVICE_EPINTFLAG_TRFAIL0 | USB_DEVICE_EPINTFLAG_TRFAIL1;
+
+  pp->next_bank = 0;
+  pp->done_bank = 0;
+}
+#endif
+
 // ready for receiving SETUP packet
 static inline void prepare_setup(void)
 {
@@ -71,6 +113,15 @@ static void bus_reset(void)
   ep->EPCFG.reg = USB_DEVICE_EPCFG_EPTYPE0(0x1) | USB_DEVICE_EPCFG_EPTYPE1(0x1);
   ep->EPINTENSET.reg = USB_DEVICE_EPINTENSET_TRCPT0 | USB_DEVICE_EPINTENSET_TRCPT1 | USB_DEVICE_EPINTENSET_RXSTP;
 
+#if CFG_TUD_EDPT_PINGPONG
+  // Ping-pong needs to know which banks are unused, start from all endpoints disabled
+  for ( uint8_t epnum = 1; epnum < USB_EPT_NUM; epnum++ )
+  {
+    USB->DEVICE.DeviceEndpoint[epnum].EPCFG.reg = 0;
+  }
+  tu_memclr(_pingpong, sizeof(_pingpong));
+#endif
+
   // Prepare for setup packet
   prepare_setup();
 }
@@ -183,9 +234,15 @@ void dcd_connect(uint8_t rhport)
 void dcd_sof_enable(uint8_t rhport, bool en)
 {
   (void) rhport;
-  (void) en;
 
-  // TODO implement later
+  if ( en )
+  {
+    USB->DEVICE.INTENSET.reg = USB_DEVICE_INTENSET_SOF;
+  }
+  else
+  {
+    USB->DEVICE.INTENCLR.reg = USB_DEVICE_INTENCLR_SOF;
+  }
 }
 
 /*------------------------------------------------------------------*/
@@ -235,6 +292,47 @@ bool dcd_edpt_open (uint8_t rhport, tusb_desc_endpoint_t const * desc_edpt)
 
   UsbDeviceEndpoint* ep = &USB->DEVICE.DeviceEndpoint[epnum];
 
+#if CFG_TUD_EDPT_PINGPONG
+  pingpong_state_t* pp = &_pingpong[epnum];
+
+  // Give back the second bank of a ping-pong endpoint with this number (re-opened, or the other direction is opened now)
+  if ( pp->enabled )
+  {
+    if ( pp->dir == TUSB_DIR_OUT )
+    {
+      ep->EPCFG.bit.EPTYPE1 = 0;
+    }else
+    {
+      ep->EPCFG.bit.EPTYPE0 = 0;
+    }
+    pp->enabled = 0;
+  }
+
+  // Bulk endpoint takes both banks if the other direction is unused
+  uint8_t const other_type = (dir == TUSB_DIR_OUT) ? ep->EPCFG.bit.EPTYPE1 : ep->EPCFG.bit.EPTYPE0;
+  if ( desc_edpt->bmAttributes.xfer == TUSB_XFER_BULK && other_type == 0 )
+  {
+    sram_registers[epnum][1 - dir].PCKSIZE.bit.SIZE = size_value;
+
+    if ( dir == TUSB_DIR_OUT )
+    {
+      ep->EPCFG.reg = USB_DEVICE_EPCFG_EPTYPE0(desc_edpt->bmAttributes.xfer + 1) | USB_DEVICE_EPCFG_EPTYPE1(EPTYPE_DUAL_BANK);
+      ep->EPSTATUSCLR.reg = USB_DEVICE_EPSTATUSCLR_STALLRQ0 | USB_DEVICE_EPSTATUSCLR_DTGLOUT; // clear stall & dtoggle
+    }else
+    {
+      ep->EPCFG.reg = USB_DEVICE_EPCFG_EPTYPE0(EPTYPE_DUAL_BANK) | USB_DEVICE_EPCFG_EPTYPE1(desc_edpt->bmAttributes.xfer + 1);
+      ep->EPSTATUSCLR.reg = USB_DEVICE_EPSTATUSCLR_STALLRQ1 | USB_DEVICE_EPSTATUSCLR_DTGLIN; // clear stall & dtoggle
+    }
+
+    pp->enabled = 1;
+    pp->dir = dir;
+    pingpong_reset(epnum);
+    ep->EPINTENSET.reg = USB_DEVICE_EPINTENSET_TRCPT0 | USB_DEVICE_EPINTENSET_TRCPT1;
+
+    return true;
+  }
+#endif
+
   if ( dir == TUSB_DIR_OUT )
   {
     ep->EPCFG.bit.EPTYPE0 = desc_edpt->bmAttributes.xfer + 1;
@@ -250,6 +348,19 @@ bool dcd_edpt_open (uint8_t rhport, tusb_desc_endpoint_t const * desc_edpt)
   return true;
 }
 
+bool dcd_edpt_pingpong (uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+
+#if CFG_TUD_EDPT_PINGPONG
+  pingpong_state_t const* pp = &_pingpong[tu_edpt_number(ep_addr)];
+  return pp->enabled && (pp->dir == tu_edpt_dir(ep_addr));
+#else
+  (void) ep_addr;
+  return false;
+#endif
+}
+
 void dcd_edpt_close (uint8_t rhport, uint8_t ep_addr) {
   (void) rhport;
   (void) ep_addr;
@@ -270,7 +381,17 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
-  UsbDeviceDescBank* bank = &sram_registers[epnum][dir];
+  // Single bank endpoints use bank 0 for OUT and bank 1 for IN, ping-pong endpoints alternate
+  uint8_t bank_num = dir;
+#if CFG_TUD_EDPT_PINGPONG
+  if ( _pingpong[epnum].enabled )
+  {
+    bank_num = _pingpong[epnum].next_bank;
+    _pingpong[epnum].next_bank = (uint8_t) (1 - bank_num);
+  }
+#endif
+
+  UsbDeviceDescBank* bank = &sram_registers[epnum][bank_num];
   UsbDeviceEndpoint* ep = &USB->DEVICE.DeviceEndpoint[epnum];
 
   bank->ADDR.reg = (uint32_t) buffer;
@@ -282,19 +403,19 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
     prepare_setup();
   }
 
+  // Ready bank: OUT bank is made available to receive, IN bank holds data to send
   if ( dir == TUSB_DIR_OUT )
   {
     bank->PCKSIZE.bit.MULTI_PACKET_SIZE = total_bytes;
     bank->PCKSIZE.bit.BYTE_COUNT = 0;
-    ep->EPSTATUSCLR.reg = USB_DEVICE_EPSTATUSCLR_BK0RDY;
-    ep->EPINTFLAG.reg = USB_DEVICE_EPINTFLAG_TRFAIL0;
+    ep->EPSTATUSCLR.reg = bank_num ? USB_DEVICE_EPSTATUSCLR_BK1RDY : USB_DEVICE_EPSTATUSCLR_BK0RDY;
   } else
   {
     bank->PCKSIZE.bit.MULTI_PACKET_SIZE = 0;
     bank->PCKSIZE.bit.BYTE_COUNT = total_bytes;
-    ep->EPSTATUSSET.reg = USB_DEVICE_EPSTATUSSET_BK1RDY;
-    ep->EPINTFLAG.reg = USB_DEVICE_EPINTFLAG_TRFAIL1;
+    ep->EPSTATUSSET.reg = bank_num ? USB_DEVICE_EPSTATUSSET_BK1RDY : USB_DEVICE_EPSTATUSSET_BK0RDY;
   }
+  ep->EPINTFLAG.reg = bank_num ? USB_DEVICE_EPINTFLAG_TRFAIL1 : USB_DEVICE_EPINTFLAG_TRFAIL0;
 
   return true;
 }
@@ -311,6 +432,11 @@ void dcd_edpt_stall (uint8_t rhport, uint8_t ep_addr)
   } else {
     ep->EPSTATUSSET.reg = USB_DEVICE_EPSTATUSSET_STALLRQ0;
   }
+
+#if CFG_TUD_EDPT_PINGPONG
+  // Remove queued transfers of both banks
+  if ( _pingpong[epnum].enabled ) pingpong_reset(epnum);
+#endif
 }
 
 void dcd_edpt_clear_stall (uint8_t rhport, uint8_t ep_addr)
@@ -341,6 +467,37 @@ void maybe_transfer_complete(void) {
     UsbDeviceEndpoint* ep = &USB->DEVICE.DeviceEndpoint[epnum];
     uint32_t epintflag = ep->EPINTFLAG.reg;
 
+#if CFG_TUD_EDPT_PINGPONG
+    pingpong_state_t* pp = &_pingpong[epnum];
+    if ( pp->enabled )
+    {
+      // Both banks carry the same direction, report them in the order they were queued
+      for ( uint8_t i = 0; i < 2; i++ )
+      {
+        uint8_t bank_num = pp->done_bank;
+        uint8_t trcpt = bank_num ? USB_DEVICE_EPINTFLAG_TRCPT1 : USB_DEVICE_EPINTFLAG_TRCPT0;
+        if ( (epintflag & trcpt) == 0 )
+        {
+          // Only the other bank completed: done_bank is out of step with the controller, follow it.
+          // Leaving its TRCPT set would keep the interrupt firing forever.
+          bank_num = (uint8_t) (1 - bank_num);
+          trcpt = bank_num ? USB_DEVICE_EPINTFLAG_TRCPT1 : USB_DEVICE_EPINTFLAG_TRCPT0;
+          if ( (epintflag & trcpt) == 0 ) break;
+        }
+
+        UsbDeviceDescBank* bank = &sram_registers[epnum][bank_num];
+        uint16_t const total_transfer_size = bank->PCKSIZE.bit.BYTE_COUNT;
+
+        dcd_event_xfer_complete(0, tu_edpt_addr(epnum, pp->dir), total_transfer_size, XFER_RESULT_SUCCESS, true);
+
+        ep->EPINTFLAG.reg = trcpt;
+        epintflag &= ~(uint32_t) trcpt;
+        pp->done_bank = (uint8_t) (1 - bank_num);
+      }
+      continue;
+    }
+#endif
+
     // Handle IN completions
     if ((epintflag & USB_DEVICE_EPINTFLAG_TRCPT1) != 0) {
       UsbDeviceDescBank* bank = &sram_registers[epnum][TUSB_DIR_IN];
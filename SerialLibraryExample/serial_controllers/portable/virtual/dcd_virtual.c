@@ -0,0 +1,556 @@
+/*
+ * Name				:	dcd_virtual.c
+ * Created			:	10/19/2026 1:05:12 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Virtual device controller and in-process host for running the tinyUSB device stack in a host (Linux/PC) process.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUD_ENABLED && CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+#include "device/dcd.h"
+#include "device/usbd.h"
+#include "portable/virtual/dcd_virtual.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+// Buffer used by dcd_virtual_enumerate() to read the configuration descriptor
+#ifndef DCD_VIRTUAL_DESC_BUFSIZE
+#define DCD_VIRTUAL_DESC_BUFSIZE    512
+#endif
+
+typedef struct
+{
+  uint8_t * buffer;
+  tu_fifo_t * ff;
+  uint16_t total_len;
+  uint16_t actual_len;
+  uint16_t max_packet_size;
+  bool opened;
+  bool busy;      // transfer queued by the stack
+  bool stalled;
+  bool pingpong;  // second transfer can be queued while busy (bulk endpoints with CFG_TUD_EDPT_PINGPONG)
+} xfer_ctl_t;
+
+static struct
+{
+  xfer_ctl_t xfer[TUP_DCD_ENDPOINT_MAX][2];
+  xfer_ctl_t next[TUP_DCD_ENDPOINT_MAX][2];  // second transfer of ping-pong endpoints, started as soon as the first completes
+  void (*irq_handler)(void);
+  dcd_virtual_stats_t stats;
+  uint32_t frame_count;
+  uint8_t address;
+  bool connected;
+  bool int_enabled;
+  bool sof_enabled;
+} _dcd;
+
+static CFG_TUSB_MEM_ALIGN uint8_t _desc_buf[DCD_VIRTUAL_DESC_BUFSIZE];
+
+static inline xfer_ctl_t * get_xfer(uint8_t ep_addr)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  if ( epnum >= TUP_DCD_ENDPOINT_MAX ) return NULL;
+  return &_dcd.xfer[epnum][tu_edpt_dir(ep_addr)];
+}
+
+static void open_ep0(void)
+{
+  for ( uint8_t dir = 0; dir < 2; dir++ )
+  {
+    xfer_ctl_t * xfer = &_dcd.xfer[0][dir];
+    tu_memclr(xfer, sizeof(xfer_ctl_t));
+    xfer->max_packet_size = CFG_TUD_ENDPOINT0_SIZE;
+    xfer->opened = true;
+  }
+}
+
+// Raise controller interrupt and let the stack handle the posted events
+static void service(void)
+{
+  if ( _dcd.irq_handler && _dcd.int_enabled ) _dcd.irq_handler();
+  tud_task();
+}
+
+static void complete_xfer(uint8_t ep_addr, xfer_ctl_t * xfer)
+{
+  xfer->busy = false;
+  _dcd.stats.xfer_count++;
+  dcd_event_xfer_complete(0, ep_addr, xfer->actual_len, XFER_RESULT_SUCCESS, true);
+
+  // Like the second bank of a ping-pong endpoint, the queued transfer takes over without a gap on the bus
+  xfer_ctl_t * next = &_dcd.next[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  if ( next->busy )
+  {
+    *xfer = *next;
+    next->busy = false;
+  }
+
+  service();
+}
+
+// Transfer slot for a new transfer: the endpoint itself, or its second slot if busy with ping-pong enabled
+static xfer_ctl_t * queue_xfer(uint8_t ep_addr)
+{
+  xfer_ctl_t * xfer = get_xfer(ep_addr);
+  TU_ASSERT(xfer && xfer->opened, NULL);
+  if ( !xfer->busy ) return xfer;
+
+  xfer_ctl_t * next = &_dcd.next[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  TU_ASSERT(xfer->pingpong && !next->busy, NULL);
+  *next = *xfer;
+  return next;
+}
+
+// Endpoint can move a packet (host would get data/ACK instead of NAK or STALL)
+static inline bool xfer_ready(xfer_ctl_t const * xfer)
+{
+  return _dcd.connected && xfer != NULL && xfer->opened && xfer->busy && !xfer->stalled;
+}
+
+static bool get_descriptor(uint8_t type, uint8_t index, uint16_t len, uint16_t * actual_len)
+{
+  tusb_control_request_t const request =
+  {
+    .bmRequestType_bit =
+    {
+      .recipient = TUSB_REQ_RCPT_DEVICE,
+      .type      = TUSB_REQ_TYPE_STANDARD,
+      .direction = TUSB_DIR_IN
+    },
+    .bRequest = TUSB_REQ_GET_DESCRIPTOR,
+    .wValue   = tu_htole16(TU_U16(type, index)),
+    .wIndex   = 0,
+    .wLength  = tu_htole16(len)
+  };
+  return dcd_virtual_control_xfer(&request, _desc_buf, actual_len);
+}
+
+static bool set_request(uint8_t request_code, uint16_t value)
+{
+  tusb_control_request_t const request =
+  {
+    .bmRequestType_bit =
+    {
+      .recipient = TUSB_REQ_RCPT_DEVICE,
+      .type      = TUSB_REQ_TYPE_STANDARD,
+      .direction = TUSB_DIR_OUT
+    },
+    .bRequest = request_code,
+    .wValue   = tu_htole16(value),
+    .wIndex   = 0,
+    .wLength  = 0
+  };
+  return dcd_virtual_control_xfer(&request, NULL, NULL);
+}
+
+/*------------------------------------------------------------------*/
+/* Device API
+ *------------------------------------------------------------------*/
+
+void dcd_init (uint8_t rhport)
+{
+  (void) rhport;
+  void (*handler)(void) = _dcd.irq_handler;
+  dcd_virtual_stats_t const stats = _dcd.stats;
+
+  tu_memclr(&_dcd, sizeof(_dcd));
+  _dcd.irq_handler = handler;
+  _dcd.stats = stats;
+  open_ep0();
+
+  dcd_connect(rhport);
+}
+
+// Events are posted by the virtual host as they happen
+void dcd_int_handler (uint8_t rhport)
+{
+  (void) rhport;
+}
+
+void dcd_int_enable (uint8_t rhport)
+{
+  (void) rhport;
+  _dcd.int_enabled = true;
+}
+
+void dcd_int_disable (uint8_t rhport)
+{
+  (void) rhport;
+  _dcd.int_enabled = false;
+}
+
+void dcd_set_address (uint8_t rhport, uint8_t dev_addr)
+{
+  (void) dev_addr;
+
+  // Response with zlp status, address is set once status stage is complete
+  dcd_edpt_xfer(rhport, tu_edpt_addr(0, TUSB_DIR_IN), NULL, 0);
+}
+
+void dcd_remote_wakeup (uint8_t rhport)
+{
+  // Virtual host resumes the bus immediately
+  dcd_event_bus_signal(rhport, DCD_EVENT_RESUME, false);
+}
+
+void dcd_connect(uint8_t rhport)
+{
+  (void) rhport;
+  _dcd.connected = true;
+}
+
+void dcd_disconnect(uint8_t rhport)
+{
+  (void) rhport;
+  _dcd.connected = false;
+}
+
+void dcd_sof_enable(uint8_t rhport, bool en)
+{
+  (void) rhport;
+  _dcd.sof_enabled = en;
+}
+
+void dcd_edpt0_status_complete(uint8_t rhport, tusb_control_request_t const * request)
+{
+  (void) rhport;
+
+  if ( request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_DEVICE &&
+       request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD &&
+       request->bRequest == TUSB_REQ_SET_ADDRESS )
+  {
+    _dcd.address = (uint8_t) tu_le16toh(request->wValue);
+  }
+}
+
+//--------------------------------------------------------------------+
+// Endpoint API
+//--------------------------------------------------------------------+
+
+bool dcd_edpt_open (uint8_t rhport, tusb_desc_endpoint_t const * ep_desc)
+{
+  (void) rhport;
+
+  xfer_ctl_t * xfer = get_xfer(ep_desc->bEndpointAddress);
+  TU_ASSERT(xfer);
+
+  tu_memclr(xfer, sizeof(xfer_ctl_t));
+  xfer->max_packet_size = tu_edpt_packet_size(ep_desc);
+  xfer->opened = true;
+  xfer->pingpong = CFG_TUD_EDPT_PINGPONG && (ep_desc->bmAttributes.xfer == TUSB_XFER_BULK);
+
+  return true;
+}
+
+bool dcd_edpt_pingpong (uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+
+  xfer_ctl_t const * xfer = get_xfer(ep_addr);
+  return xfer != NULL && xfer->opened && xfer->pingpong;
+}
+
+void dcd_edpt_close_all (uint8_t rhport)
+{
+  (void) rhport;
+
+  // EP0 stays open
+  for ( uint8_t epnum = 1; epnum < TUP_DCD_ENDPOINT_MAX; epnum++ )
+  {
+    tu_memclr(_dcd.xfer[epnum], sizeof(_dcd.xfer[epnum]));
+    tu_memclr(_dcd.next[epnum], sizeof(_dcd.next[epnum]));
+  }
+}
+
+void dcd_edpt_close (uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+
+  xfer_ctl_t * xfer = get_xfer(ep_addr);
+  if ( xfer && tu_edpt_number(ep_addr) )
+  {
+    tu_memclr(xfer, sizeof(xfer_ctl_t));
+    tu_memclr(&_dcd.next[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)], sizeof(xfer_ctl_t));
+  }
+}
+
+bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+{
+  (void) rhport;
+
+  xfer_ctl_t * xfer = queue_xfer(ep_addr);
+  TU_ASSERT(xfer);
+
+  xfer->buffer     = buffer;
+  xfer->ff         = NULL;
+  xfer->total_len  = total_bytes;
+  xfer->actual_len = 0;
+  xfer->busy       = true;
+
+  return true;
+}
+
+bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes)
+{
+  (void) rhport;
+
+  xfer_ctl_t * xfer = queue_xfer(ep_addr);
+  TU_ASSERT(xfer);
+
+  xfer->buffer     = NULL;
+  xfer->ff         = ff;
+  xfer->total_len  = total_bytes;
+  xfer->actual_len = 0;
+  xfer->busy       = true;
+
+  return true;
+}
+
+void dcd_edpt_stall (uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+
+  xfer_ctl_t * xfer = get_xfer(ep_addr);
+  if ( xfer )
+  {
+    // Stall aborts the current and the queued ping-pong transfer, like a controller disabling the endpoint
+    xfer->stalled = true;
+    xfer->busy    = false;
+    _dcd.next[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].busy = false;
+  }
+}
+
+void dcd_edpt_clear_stall (uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+
+  xfer_ctl_t * xfer = get_xfer(ep_addr);
+  if ( xfer ) xfer->stalled = false;
+}
+
+//--------------------------------------------------------------------+
+// Virtual Host API
+//--------------------------------------------------------------------+
+
+void dcd_virtual_attach_interrupt(void (*handler)(void))
+{
+  _dcd.irq_handler = handler;
+}
+
+bool dcd_virtual_bus_reset(void)
+{
+  if ( !_dcd.connected ) return false;
+
+  dcd_edpt_close_all(0);
+  open_ep0();
+  _dcd.address = 0;
+
+  dcd_event_bus_reset(0, TUD_OPT_HIGH_SPEED ? TUSB_SPEED_HIGH : TUSB_SPEED_FULL, true);
+  service();
+
+  return true;
+}
+
+void dcd_virtual_suspend(void)
+{
+  dcd_event_bus_signal(0, DCD_EVENT_SUSPEND, true);
+  service();
+}
+
+void dcd_virtual_resume(void)
+{
+  dcd_event_bus_signal(0, DCD_EVENT_RESUME, true);
+  service();
+}
+
+void dcd_virtual_sof(void)
+{
+  _dcd.frame_count++;
+  if ( _dcd.sof_enabled )
+  {
+    dcd_event_sof(0, _dcd.frame_count, true);
+    service();
+  }
+}
+
+bool dcd_virtual_control_xfer(tusb_control_request_t const * request, void * data, uint16_t * actual_len)
+{
+  if ( actual_len ) *actual_len = 0;
+  if ( !_dcd.connected ) return false;
+
+  // SETUP is always accepted and aborts whatever was pending on EP0
+  for ( uint8_t dir = 0; dir < 2; dir++ )
+  {
+    _dcd.xfer[0][dir].busy    = false;
+    _dcd.xfer[0][dir].stalled = false;
+  }
+
+  _dcd.stats.setup_count++;
+  dcd_event_setup_received(0, (uint8_t const *) request, true);
+  service();
+
+  uint16_t const length = tu_le16toh(request->wLength);
+  uint32_t count = 0;
+  bool const dir_in = (request->bmRequestType_bit.direction == TUSB_DIR_IN);
+
+  // Data stage
+  if ( length )
+  {
+    if ( dir_in )
+    {
+      count = dcd_virtual_edpt_in(tu_edpt_addr(0, TUSB_DIR_IN), data, length);
+    }
+    else
+    {
+      count = dcd_virtual_edpt_out(tu_edpt_addr(0, TUSB_DIR_OUT), data, length);
+      if ( count != length ) return false;
+    }
+  }
+
+  // Status stage in the opposite direction of the data
+  if ( dir_in && length )
+  {
+    if ( !dcd_virtual_edpt_ready(tu_edpt_addr(0, TUSB_DIR_OUT)) ) return false;
+    dcd_virtual_edpt_out(tu_edpt_addr(0, TUSB_DIR_OUT), NULL, 0);
+  }
+  else
+  {
+    if ( !dcd_virtual_edpt_ready(tu_edpt_addr(0, TUSB_DIR_IN)) ) return false;
+    dcd_virtual_edpt_in(tu_edpt_addr(0, TUSB_DIR_IN), NULL, 0);
+  }
+
+  if ( actual_len ) *actual_len = (uint16_t) count;
+  return true;
+}
+
+bool dcd_virtual_enumerate(uint8_t config_num)
+{
+  uint16_t actual_len;
+
+  TU_VERIFY(dcd_virtual_bus_reset());
+
+  TU_VERIFY(get_descriptor(TUSB_DESC_DEVICE, 0, sizeof(tusb_desc_device_t), &actual_len));
+  TU_VERIFY(actual_len == sizeof(tusb_desc_device_t));
+  TU_VERIFY(set_request(TUSB_REQ_SET_ADDRESS, 1));
+
+  // Configuration header first for the total length, then the whole descriptor
+  TU_VERIFY(config_num);
+  TU_VERIFY(get_descriptor(TUSB_DESC_CONFIGURATION, config_num - 1, sizeof(tusb_desc_configuration_t), &actual_len));
+  TU_VERIFY(actual_len == sizeof(tusb_desc_configuration_t));
+  uint16_t const total_len = tu_le16toh(((tusb_desc_configuration_t const *) _desc_buf)->wTotalLength);
+  TU_VERIFY(get_descriptor(TUSB_DESC_CONFIGURATION, config_num - 1, tu_min16(total_len, DCD_VIRTUAL_DESC_BUFSIZE), &actual_len));
+
+  return set_request(TUSB_REQ_SET_CONFIGURATION, config_num);
+}
+
+uint32_t dcd_virtual_edpt_out(uint8_t ep_addr, void const * data, uint32_t len)
+{
+  ep_addr = tu_edpt_addr(tu_edpt_number(ep_addr), TUSB_DIR_OUT);
+  uint8_t const * src = (uint8_t const *) data;
+  uint32_t count = 0;
+
+  do
+  {
+    xfer_ctl_t * xfer = get_xfer(ep_addr);
+    if ( !xfer_ready(xfer) ) break;
+
+    uint16_t packet = (uint16_t) tu_min32(len - count, xfer->max_packet_size);
+    uint16_t const space = xfer->total_len - xfer->actual_len;
+    if ( packet > space ) packet = space;
+
+    if ( xfer->ff )
+    {
+      tu_fifo_write_n(xfer->ff, src + count, packet);
+    }
+    else if ( packet )
+    {
+      memcpy(xfer->buffer + xfer->actual_len, src + count, packet);
+    }
+    xfer->actual_len += packet;
+    count += packet;
+
+    _dcd.stats.packet_count++;
+    _dcd.stats.byte_count += packet;
+
+    // Short packet or full transfer completes it, short packet also ends the host transfer
+    bool const short_packet = (packet < xfer->max_packet_size);
+    if ( short_packet || xfer->actual_len == xfer->total_len ) complete_xfer(ep_addr, xfer);
+    if ( short_packet ) break;
+  } while ( count < len );
+
+  return count;
+}
+
+uint32_t dcd_virtual_edpt_in(uint8_t ep_addr, void * data, uint32_t len)
+{
+  ep_addr = tu_edpt_addr(tu_edpt_number(ep_addr), TUSB_DIR_IN);
+  uint8_t * dst = (uint8_t *) data;
+  uint32_t count = 0;
+
+  do
+  {
+    xfer_ctl_t * xfer = get_xfer(ep_addr);
+    if ( !xfer_ready(xfer) ) break;
+
+    uint16_t const packet = tu_min16(xfer->total_len - xfer->actual_len, xfer->max_packet_size);
+    // Packets are never split, host buffer must fit the whole packet
+    if ( packet > len - count ) break;
+
+    if ( xfer->ff )
+    {
+      tu_fifo_read_n(xfer->ff, dst + count, packet);
+    }
+    else if ( packet )
+    {
+      memcpy(dst + count, xfer->buffer + xfer->actual_len, packet);
+    }
+    xfer->actual_len += packet;
+    count += packet;
+
+    _dcd.stats.packet_count++;
+    _dcd.stats.byte_count += packet;
+
+    bool const short_packet = (packet < xfer->max_packet_size);
+    if ( xfer->actual_len == xfer->total_len ) complete_xfer(ep_addr, xfer);
+    if ( short_packet ) break;
+  } while ( count < len );
+
+  return count;
+}
+
+bool dcd_virtual_edpt_ready(uint8_t ep_addr)
+{
+  return xfer_ready(get_xfer(ep_addr));
+}
+
+bool dcd_virtual_edpt_stalled(uint8_t ep_addr)
+{
+  xfer_ctl_t const * xfer = get_xfer(ep_addr);
+  return xfer != NULL && xfer->stalled;
+}
+
+uint8_t dcd_virtual_get_address(void)
+{
+  return _dcd.address;
+}
+
+bool dcd_virtual_connected(void)
+{
+  return _dcd.connected;
+}
+
+void dcd_virtual_get_stats(dcd_virtual_stats_t * stats)
+{
+  *stats = _dcd.stats;
+}
+
+void dcd_virtual_reset_stats(void)
+{
+  tu_memclr(&_dcd.stats, sizeof(_dcd.stats));
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Name				:	dcd_virtual.h
+ * Created			:	10/19/2026 1:05:12 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Virtual device controller and in-process host for running the tinyUSB device stack in a host (Linux/PC) process.
+ */
+
+#ifndef _TUSB_DCD_VIRTUAL_H_
+#define _TUSB_DCD_VIRTUAL_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// The virtual host runs in the caller's thread. Every call below raises the controller "interrupt"
+// (the attached handler, if any) and then runs tud_task() until the stack has handled the transfer,
+// so usbd.c and the class drivers run unmodified and fully deterministic.
+
+// Transfer counters, useful for measuring per transfer overhead
+typedef struct
+{
+  uint32_t setup_count;   // SETUP packets sent by the host
+  uint32_t xfer_count;    // completed device transfers (dcd_edpt_xfer/dcd_edpt_xfer_fifo), EP0 included
+  uint32_t packet_count;  // data packets moved on the bus, ZLPs included
+  uint64_t byte_count;    // data bytes moved on the bus
+} dcd_virtual_stats_t;
+
+// Attach a handler called whenever the controller raises an interrupt (USB_Handler equivalent),
+// normally a function calling SerialUSB::USBController::ISR(). NULL to detach.
+void dcd_virtual_attach_interrupt(void (*handler)(void));
+
+// Drive a bus reset, returns false if the device is disconnected
+bool dcd_virtual_bus_reset(void);
+
+// Signal suspend/resume on the bus
+void dcd_virtual_suspend(void);
+void dcd_virtual_resume(void);
+
+// Send a start of frame (only reported to the stack if enabled with dcd_sof_enable())
+void dcd_virtual_sof(void);
+
+// Run a complete control transfer (setup, data and status stages).
+// data is read for OUT requests and written for IN requests, actual_len (may be NULL) receives the data stage length.
+// Returns false if the device stalls, does not respond or is disconnected.
+bool dcd_virtual_control_xfer(tusb_control_request_t const * request, void * data, uint16_t * actual_len);
+
+// Reset and enumerate the device: device descriptor, SET_ADDRESS, configuration descriptor and SET_CONFIGURATION
+bool dcd_virtual_enumerate(uint8_t config_num);
+
+// Host OUT transfer: sends up to len bytes to an OUT endpoint in max packet size packets.
+// Stops when the device has no transfer queued (NAK). Sends a zero length packet if len is 0.
+// Returns number of bytes accepted by the device.
+uint32_t dcd_virtual_edpt_out(uint8_t ep_addr, void const * data, uint32_t len);
+
+// Host IN transfer: reads up to len bytes from an IN endpoint, stopping at a short packet or when the device NAKs.
+// Returns number of bytes received.
+uint32_t dcd_virtual_edpt_in(uint8_t ep_addr, void * data, uint32_t len);
+
+// Check if the device has a transfer queued on an endpoint (host would get data/ACK instead of NAK)
+bool dcd_virtual_edpt_ready(uint8_t ep_addr);
+
+// Check if an endpoint is stalled
+bool dcd_virtual_edpt_stalled(uint8_t ep_addr);
+
+// Device address assigned by the last SET_ADDRESS (0 if not addressed)
+uint8_t dcd_virtual_get_address(void);
+
+// Check if the device is connected (pull-up enabled)
+bool dcd_virtual_connected(void);
+
+// Transfer counters
+void dcd_virtual_get_stats(dcd_virtual_stats_t * stats);
+void dcd_virtual_reset_stats(void);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_DCD_VIRTUAL_H_ */
@@ -0,0 +1,976 @@
+/*
+ * Name				:	hcd_virtual.c
+ * Created			:	10/19/2026 7:42:18 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Virtual host controller with simulated hub, CDC and MSC devices for running the tinyUSB host stack in a host (Linux/PC) process.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUH_ENABLED && CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+#include "host/hcd.h"
+#include "host/usbh.h"
+#include "host/hub.h"
+#include "class/cdc/cdc.h"
+#include "class/msc/msc.h"
+#include "device/usbd.h"
+#include "portable/virtual/hcd_virtual.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+// hub status change bitmap is a single byte
+TU_VERIFY_STATIC(HCD_VIRTUAL_HUB_PORTS >= 1 && HCD_VIRTUAL_HUB_PORTS <= 7, "hub supports 1 to 7 ports");
+
+#define SLOT_COUNT        (1 + HCD_VIRTUAL_HUB_PORTS)
+#define EP_MAX            4
+#define EP_SIZE           64
+#define CTRL_BUFSIZE      128
+
+typedef struct
+{
+  uint8_t * buffer;
+  uint16_t total_len;
+  uint16_t actual_len;
+  uint16_t max_packet_size;
+  uint8_t xfer_type;
+  bool opened;
+  bool busy;      // transfer queued by the stack
+} pipe_t;
+
+enum
+{
+  MSC_STAGE_CMD = 0,
+  MSC_STAGE_DATA,
+  MSC_STAGE_STATUS
+};
+
+// Simulated device, slot 0 is on the root port and slot N on hub port N
+typedef struct
+{
+  hcd_virtual_device_t type;
+  bool connected;   // plugged in
+  bool enabled;     // port is reset and enabled, the device answers on the bus
+  uint8_t address;
+  uint8_t config;
+
+  pipe_t pipe[EP_MAX][2];
+
+  // control endpoint
+  tusb_control_request_t request;
+  uint8_t ctrl_buf[CTRL_BUFSIZE];
+  uint16_t ctrl_len;    // length of response to an IN request
+  bool ctrl_stall;
+  bool ctrl_data_done;
+
+  // CDC byte counters
+  uint8_t in_seq;
+  uint8_t out_seq;
+
+  // MSC bulk-only transport
+  uint8_t msc_stage;
+  msc_cbw_t cbw;
+  msc_csw_t csw;
+  uint32_t data_len;    // bytes of data stage
+  uint32_t data_done;
+  uint32_t ready_frame; // NAK data stage until this frame
+  uint16_t latency;
+  uint8_t resp[36];     // response of commands other than READ10/WRITE10
+
+  uint64_t bytes;
+} vdev_t;
+
+static struct
+{
+  vdev_t dev[SLOT_COUNT];
+  hub_port_status_response_t hub_port[HCD_VIRTUAL_HUB_PORTS];
+  hcd_virtual_stats_t stats;
+  uint32_t frame_count;
+  uint8_t rr_next;  // pending transfer served first in the next frame
+} _hcd;
+
+//--------------------------------------------------------------------+
+// Descriptors
+//--------------------------------------------------------------------+
+
+static tusb_desc_device_t const _desc_device =
+{
+  .bLength            = sizeof(tusb_desc_device_t),
+  .bDescriptorType    = TUSB_DESC_DEVICE,
+  .bcdUSB             = 0x0200,
+  .bDeviceClass       = 0,
+  .bDeviceSubClass    = 0,
+  .bDeviceProtocol    = 0,
+  .bMaxPacketSize0    = EP_SIZE,
+  .idVendor           = 0xCafe,
+  .idProduct          = 0x4000,
+  .bcdDevice          = 0x0100,
+  .iManufacturer      = 0x00,
+  .iProduct           = 0x00,
+  .iSerialNumber      = 0x00,
+  .bNumConfigurations = 0x01
+};
+
+static uint8_t const _desc_hub[] =
+{
+  // Config number, interface count, string index, total length, attribute, power in mA
+  TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUD_CONFIG_DESC_LEN + 9 + 7, 0x00, 100),
+  // Interface: hub class, single TT, status change endpoint
+  9, TUSB_DESC_INTERFACE, 0, 0, 1, TUSB_CLASS_HUB, 0, 0, 0,
+  7, TUSB_DESC_ENDPOINT, 0x81, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(1), 12
+};
+
+static uint8_t const _desc_cdc[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, 2, 0, TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN, 0x00, 100),
+  // Interface number, string index, EP notification address and size, EP data address (out, in) and size
+  TUD_CDC_DESCRIPTOR(0, 0, 0x81, 8, 0x02, 0x82, EP_SIZE)
+};
+
+static uint8_t const _desc_msc[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN, 0x00, 100),
+  // Interface number, string index, EP Out & EP In address, EP size
+  TUD_MSC_DESCRIPTOR(0, 0, 0x01, 0x81, EP_SIZE)
+};
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+// Device answering to an address, address 0 is the one just reset on its port
+static vdev_t * find_device(uint8_t dev_addr)
+{
+  for ( uint8_t i = 0; i < SLOT_COUNT; i++ )
+  {
+    vdev_t * dev = &_hcd.dev[i];
+    if ( dev->connected && dev->enabled && dev->address == dev_addr ) return dev;
+  }
+  return NULL;
+}
+
+static void reset_device(vdev_t * dev)
+{
+  tu_memclr(dev->pipe, sizeof(dev->pipe));
+  dev->address   = 0;
+  dev->config    = 0;
+  dev->enabled   = true;
+  dev->msc_stage = MSC_STAGE_CMD;
+}
+
+static void complete_pipe(vdev_t * dev, uint8_t ep_addr, pipe_t * pipe)
+{
+  pipe->busy = false;
+  _hcd.stats.xfer_count++;
+  hcd_event_xfer_complete(dev->address, ep_addr, pipe->actual_len, XFER_RESULT_SUCCESS, true);
+}
+
+static void complete_ctrl(vdev_t * dev, uint8_t ep_addr, uint32_t len, xfer_result_t result)
+{
+  _hcd.stats.xfer_count++;
+  hcd_event_xfer_complete(dev->address, ep_addr, len, result, true);
+}
+
+static uint8_t hub_status_bitmap(void)
+{
+  uint8_t bitmap = 0;
+  for ( uint8_t port = 1; port <= HCD_VIRTUAL_HUB_PORTS; port++ )
+  {
+    if ( _hcd.hub_port[port-1].change.value ) bitmap |= (uint8_t) TU_BIT(port);
+  }
+  return bitmap;
+}
+
+static void hub_port_connect(uint8_t port)
+{
+  hub_port_status_response_t * status = &_hcd.hub_port[port-1];
+  if ( status->status.port_power )
+  {
+    status->status.connection = 1;
+    status->change.connection = 1;
+  }
+}
+
+static void hub_port_disconnect(uint8_t port)
+{
+  hub_port_status_response_t * status = &_hcd.hub_port[port-1];
+  if ( status->status.connection )
+  {
+    status->status.connection  = 0;
+    status->status.port_enable = 0;
+    status->change.connection  = 1;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Control requests of the simulated devices
+//--------------------------------------------------------------------+
+
+static bool ctrl_respond(vdev_t * dev, void const * data, uint16_t len)
+{
+  TU_VERIFY(len <= CTRL_BUFSIZE);
+  memcpy(dev->ctrl_buf, data, len);
+  dev->ctrl_len = len;
+  return true;
+}
+
+static bool hub_request(vdev_t * dev, tusb_control_request_t const * request)
+{
+  uint8_t const port = (uint8_t) request->wIndex;
+
+  if ( request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_DEVICE )
+  {
+    switch ( request->bRequest )
+    {
+      case HUB_REQUEST_GET_DESCRIPTOR:
+      {
+        descriptor_hub_desc_t const desc =
+        {
+          .bLength             = sizeof(descriptor_hub_desc_t),
+          .bDescriptorType     = 0x29,
+          .bNbrPorts           = HCD_VIRTUAL_HUB_PORTS,
+          .wHubCharacteristics = 0x0001, // individual port power switching
+          .bPwrOn2PwrGood      = 1,
+          .bHubContrCurrent    = 100,
+          .DeviceRemovable     = 0,
+          .PortPwrCtrlMask     = 0xff
+        };
+        return ctrl_respond(dev, &desc, sizeof(desc));
+      }
+
+      case HUB_REQUEST_GET_STATUS:
+      {
+        hub_status_response_t const status = { .status.value = 0, .change.value = 0 };
+        return ctrl_respond(dev, &status, sizeof(status));
+      }
+
+      default: return false;
+    }
+  }
+
+  TU_VERIFY(request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_OTHER && port >= 1 && port <= HCD_VIRTUAL_HUB_PORTS);
+  hub_port_status_response_t * status = &_hcd.hub_port[port-1];
+  vdev_t * port_dev = &_hcd.dev[port];
+
+  switch ( request->bRequest )
+  {
+    case HUB_REQUEST_GET_STATUS:
+      return ctrl_respond(dev, status, sizeof(hub_port_status_response_t));
+
+    case HUB_REQUEST_SET_FEATURE:
+      switch ( request->wValue )
+      {
+        case HUB_FEATURE_PORT_POWER:
+          status->status.port_power = 1;
+          if ( port_dev->connected ) hub_port_connect(port);
+        break;
+
+        case HUB_FEATURE_PORT_RESET:
+          // reset completes at once
+          if ( port_dev->connected )
+          {
+            reset_device(port_dev);
+            status->status.port_enable = 1;
+            status->change.reset       = 1;
+          }
+        break;
+
+        default: break;
+      }
+    return true;
+
+    case HUB_REQUEST_CLEAR_FEATURE:
+      switch ( request->wValue )
+      {
+        case HUB_FEATURE_PORT_ENABLE:
+          status->status.port_enable = 0;
+          port_dev->enabled          = false;
+        break;
+
+        case HUB_FEATURE_PORT_POWER:           status->status.port_power  = 0; break;
+        case HUB_FEATURE_PORT_CONNECTION_CHANGE: status->change.connection  = 0; break;
+        case HUB_FEATURE_PORT_ENABLE_CHANGE:   status->change.port_enable = 0; break;
+        case HUB_FEATURE_PORT_RESET_CHANGE:    status->change.reset       = 0; break;
+        default: break;
+      }
+    return true;
+
+    default: return false;
+  }
+}
+
+static bool class_request(vdev_t * dev, tusb_control_request_t const * request)
+{
+  switch ( dev->type )
+  {
+    case HCD_VIRTUAL_HUB:
+      return hub_request(dev, request);
+
+    case HCD_VIRTUAL_CDC:
+      switch ( request->bRequest )
+      {
+        case CDC_REQUEST_SET_LINE_CODING:
+        case CDC_REQUEST_SET_CONTROL_LINE_STATE:
+          return true;
+
+        case CDC_REQUEST_GET_LINE_CODING:
+        {
+          cdc_line_coding_t const coding = { .bit_rate = 115200, .stop_bits = 0, .parity = 0, .data_bits = 8 };
+          return ctrl_respond(dev, &coding, sizeof(coding));
+        }
+
+        default: return false;
+      }
+
+    case HCD_VIRTUAL_MSC:
+      switch ( request->bRequest )
+      {
+        case MSC_REQ_GET_MAX_LUN:
+        {
+          uint8_t const max_lun = 0;
+          return ctrl_respond(dev, &max_lun, 1);
+        }
+
+        case MSC_REQ_RESET:
+          dev->msc_stage = MSC_STAGE_CMD;
+          return true;
+
+        default: return false;
+      }
+
+    default: return false;
+  }
+}
+
+// Handle a SETUP packet, returns false to stall the request
+static bool process_setup(vdev_t * dev)
+{
+  tusb_control_request_t const * request = &dev->request;
+  dev->ctrl_len = 0;
+
+  if ( request->bmRequestType_bit.type == TUSB_REQ_TYPE_CLASS ) return class_request(dev, request);
+  TU_VERIFY(request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD);
+
+  switch ( request->bRequest )
+  {
+    case TUSB_REQ_GET_DESCRIPTOR:
+      switch ( tu_u16_high(request->wValue) )
+      {
+        case TUSB_DESC_DEVICE:
+        {
+          tusb_desc_device_t desc = _desc_device;
+          desc.bDeviceClass = (dev->type == HCD_VIRTUAL_HUB) ? TUSB_CLASS_HUB :
+                              (dev->type == HCD_VIRTUAL_CDC) ? TUSB_CLASS_MISC : 0;
+          desc.bDeviceSubClass = (dev->type == HCD_VIRTUAL_CDC) ? MISC_SUBCLASS_COMMON : 0;
+          desc.bDeviceProtocol = (dev->type == HCD_VIRTUAL_CDC) ? MISC_PROTOCOL_IAD : 0;
+          desc.idProduct = (uint16_t) (desc.idProduct | dev->type);
+          return ctrl_respond(dev, &desc, sizeof(desc));
+        }
+
+        case TUSB_DESC_CONFIGURATION:
+          switch ( dev->type )
+          {
+            case HCD_VIRTUAL_HUB: return ctrl_respond(dev, _desc_hub, sizeof(_desc_hub));
+            case HCD_VIRTUAL_CDC: return ctrl_respond(dev, _desc_cdc, sizeof(_desc_cdc));
+            case HCD_VIRTUAL_MSC: return ctrl_respond(dev, _desc_msc, sizeof(_desc_msc));
+            default: return false;
+          }
+
+        default: return false;
+      }
+
+    case TUSB_REQ_GET_STATUS:
+    {
+      uint16_t const status = 0;
+      return ctrl_respond(dev, &status, 2);
+    }
+
+    case TUSB_REQ_SET_ADDRESS:
+      // address is applied once status stage is complete
+      return true;
+
+    case TUSB_REQ_SET_CONFIGURATION:
+      dev->config = (uint8_t) request->wValue;
+      return true;
+
+    case TUSB_REQ_CLEAR_FEATURE:
+    case TUSB_REQ_SET_FEATURE:
+    case TUSB_REQ_SET_INTERFACE:
+      return true;
+
+    default: return false;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Bulk endpoints of the simulated devices
+//--------------------------------------------------------------------+
+
+// MSC: command received in a CBW
+static void msc_command(vdev_t * dev)
+{
+  msc_cbw_t const * cbw = &dev->cbw;
+  uint8_t const * cmd = cbw->command;
+  uint32_t resp_len = 0;
+  bool ok = true;
+
+  dev->data_done   = 0;
+  dev->ready_frame = _hcd.frame_count;
+  tu_memclr(dev->resp, sizeof(dev->resp));
+
+  switch ( cmd[0] )
+  {
+    case SCSI_CMD_TEST_UNIT_READY:
+    break;
+
+    case SCSI_CMD_INQUIRY:
+    {
+      scsi_inquiry_resp_t * inquiry = (scsi_inquiry_resp_t *) dev->resp;
+      inquiry->is_removable         = 1;
+      inquiry->version              = 2;
+      inquiry->response_data_format = 2;
+      inquiry->additional_length    = sizeof(scsi_inquiry_resp_t) - 5;
+      memcpy(inquiry->vendor_id  , "TinyUSB ", 8);
+      memcpy(inquiry->product_id , "Virtual Disk    ", 16);
+      memcpy(inquiry->product_rev, "1.0 ", 4);
+      resp_len = sizeof(scsi_inquiry_resp_t);
+    }
+    break;
+
+    case SCSI_CMD_REQUEST_SENSE:
+    {
+      scsi_sense_fixed_resp_t * sense = (scsi_sense_fixed_resp_t *) dev->resp;
+      sense->response_code = 0x70;
+      sense->add_sense_len = sizeof(scsi_sense_fixed_resp_t) - 8;
+      resp_len = sizeof(scsi_sense_fixed_resp_t);
+    }
+    break;
+
+    case SCSI_CMD_READ_CAPACITY_10:
+    {
+      scsi_read_capacity10_resp_t * capacity = (scsi_read_capacity10_resp_t *) dev->resp;
+      capacity->last_lba   = tu_htonl(HCD_VIRTUAL_MSC_BLOCK_COUNT - 1);
+      capacity->block_size = tu_htonl(HCD_VIRTUAL_MSC_BLOCK_SIZE);
+      resp_len = sizeof(scsi_read_capacity10_resp_t);
+    }
+    break;
+
+    case SCSI_CMD_READ_10:
+    case SCSI_CMD_WRITE_10:
+    {
+      uint32_t const lba   = tu_ntohl(tu_unaligned_read32(&cmd[2]));
+      uint16_t const count = tu_ntohs(tu_unaligned_read16(&cmd[7]));
+      ok = (lba + count <= HCD_VIRTUAL_MSC_BLOCK_COUNT) &&
+           ((cmd[0] == SCSI_CMD_READ_10) == tu_bit_test(cbw->dir, 7));
+      resp_len = ok ? (uint32_t) count * HCD_VIRTUAL_MSC_BLOCK_SIZE : 0;
+      dev->ready_frame = _hcd.frame_count + dev->latency;
+    }
+    break;
+
+    default:
+      ok = false;
+    break;
+  }
+
+  dev->data_len = tu_min32(resp_len, cbw->total_bytes);
+
+  dev->csw.signature    = MSC_CSW_SIGNATURE;
+  dev->csw.tag          = cbw->tag;
+  dev->csw.data_residue = cbw->total_bytes - dev->data_len;
+  dev->csw.status       = ok ? MSC_CSW_STATUS_PASSED : MSC_CSW_STATUS_FAILED;
+
+  dev->msc_stage = dev->data_len ? MSC_STAGE_DATA : MSC_STAGE_STATUS;
+}
+
+// Expected data byte at an offset of the READ10/WRITE10 data stage
+static inline uint8_t msc_data_byte(vdev_t const * dev, uint32_t offset)
+{
+  uint32_t const lba = tu_ntohl(tu_unaligned_read32(&dev->cbw.command[2]));
+  return (uint8_t) (lba + offset / HCD_VIRTUAL_MSC_BLOCK_SIZE);
+}
+
+// Device sends a packet on an IN endpoint, returns number of bytes or -1 to NAK
+static int32_t device_in(vdev_t * dev, uint8_t epnum, uint8_t * data, uint16_t len)
+{
+  switch ( dev->type )
+  {
+    case HCD_VIRTUAL_CDC:
+      TU_VERIFY(epnum == 2, -1);
+      for ( uint16_t i = 0; i < len; i++ ) data[i] = dev->in_seq++;
+      dev->bytes += len;
+      return len;
+
+    case HCD_VIRTUAL_MSC:
+      if ( dev->msc_stage == MSC_STAGE_STATUS )
+      {
+        TU_VERIFY(len >= sizeof(msc_csw_t), -1);
+        memcpy(data, &dev->csw, sizeof(msc_csw_t));
+        dev->msc_stage = MSC_STAGE_CMD;
+        return sizeof(msc_csw_t);
+      }
+
+      if ( dev->msc_stage == MSC_STAGE_DATA && tu_bit_test(dev->cbw.dir, 7) && (int32_t) (_hcd.frame_count - dev->ready_frame) >= 0 )
+      {
+        len = (uint16_t) tu_min32(len, dev->data_len - dev->data_done);
+        if ( dev->cbw.command[0] == SCSI_CMD_READ_10 )
+        {
+          for ( uint16_t i = 0; i < len; i++ ) data[i] = msc_data_byte(dev, dev->data_done + i);
+          dev->bytes += len;
+        }else
+        {
+          memcpy(data, dev->resp + dev->data_done, len);
+        }
+        dev->data_done += len;
+        if ( dev->data_done == dev->data_len ) dev->msc_stage = MSC_STAGE_STATUS;
+        return len;
+      }
+    return -1;
+
+    default: return -1;
+  }
+}
+
+// Device receives a packet on an OUT endpoint, returns false to NAK
+static bool device_out(vdev_t * dev, uint8_t epnum, uint8_t const * data, uint16_t len)
+{
+  switch ( dev->type )
+  {
+    case HCD_VIRTUAL_CDC:
+      TU_VERIFY(epnum == 2);
+      for ( uint16_t i = 0; i < len; i++ )
+      {
+        if ( data[i] != dev->out_seq++ ) _hcd.stats.error_count++;
+      }
+      dev->bytes += len;
+      return true;
+
+    case HCD_VIRTUAL_MSC:
+      if ( dev->msc_stage == MSC_STAGE_CMD )
+      {
+        msc_cbw_t const * cbw = (msc_cbw_t const *) data;
+        if ( len != sizeof(msc_cbw_t) || cbw->signature != MSC_CBW_SIGNATURE )
+        {
+          // not a CBW, drop it
+          _hcd.stats.error_count++;
+          return true;
+        }
+        memcpy(&dev->cbw, cbw, sizeof(msc_cbw_t));
+        msc_command(dev);
+        return true;
+      }
+
+      if ( dev->msc_stage == MSC_STAGE_DATA && !tu_bit_test(dev->cbw.dir, 7) && (int32_t) (_hcd.frame_count - dev->ready_frame) >= 0 )
+      {
+        len = (uint16_t) tu_min32(len, dev->data_len - dev->data_done);
+        for ( uint16_t i = 0; i < len; i++ )
+        {
+          if ( data[i] != msc_data_byte(dev, dev->data_done + i) ) _hcd.stats.error_count++;
+        }
+        dev->bytes += len;
+        dev->data_done += len;
+        if ( dev->data_done == dev->data_len ) dev->msc_stage = MSC_STAGE_STATUS;
+        return true;
+      }
+    return false;
+
+    default: return false;
+  }
+}
+
+// Move one packet of a pending transfer, returns false if the device NAKed
+static bool move_packet(vdev_t * dev, uint8_t ep_addr, pipe_t * pipe)
+{
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint16_t const len = (uint16_t) tu_min32(pipe->max_packet_size, pipe->total_len - pipe->actual_len);
+  uint8_t * data = pipe->buffer + pipe->actual_len;
+  bool complete;
+
+  if ( tu_edpt_dir(ep_addr) == TUSB_DIR_IN )
+  {
+    int32_t const count = device_in(dev, epnum, data, len);
+    if ( count < 0 ) return false;
+
+    pipe->actual_len = (uint16_t) (pipe->actual_len + count);
+    _hcd.stats.byte_count += (uint32_t) count;
+    // short packet or all data received
+    complete = (count < pipe->max_packet_size) || (pipe->actual_len == pipe->total_len);
+  }else
+  {
+    if ( !device_out(dev, epnum, data, len) ) return false;
+
+    pipe->actual_len = (uint16_t) (pipe->actual_len + len);
+    _hcd.stats.byte_count += len;
+    complete = (pipe->actual_len == pipe->total_len);
+  }
+
+  _hcd.stats.packet_count++;
+  if ( complete ) complete_pipe(dev, ep_addr, pipe);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Frame
+//--------------------------------------------------------------------+
+
+void hcd_virtual_frame(void)
+{
+  _hcd.frame_count++;
+  _hcd.stats.frame_count++;
+
+  // Periodic transfers first: hub status change endpoint, CDC notification endpoints have nothing to report
+  vdev_t * hub = &_hcd.dev[0];
+  pipe_t * status_pipe = &hub->pipe[1][TUSB_DIR_IN];
+  if ( hub->type == HCD_VIRTUAL_HUB && hub->connected && hub->enabled && status_pipe->busy )
+  {
+    uint8_t const bitmap = hub_status_bitmap();
+    if ( bitmap )
+    {
+      status_pipe->buffer[0]  = bitmap;
+      status_pipe->actual_len = 1;
+      _hcd.stats.packet_count++;
+      _hcd.stats.byte_count++;
+      complete_pipe(hub, 0x81, status_pipe);
+    }
+  }
+
+  // Pending bulk transfers
+  struct
+  {
+    uint8_t slot;
+    uint8_t ep_addr;
+    bool naked;
+  } pending[SLOT_COUNT * EP_MAX * 2];
+  uint8_t count = 0;
+
+  for ( uint8_t slot = 0; slot < SLOT_COUNT; slot++ )
+  {
+    vdev_t const * dev = &_hcd.dev[slot];
+    if ( !dev->connected || !dev->enabled ) continue;
+
+    for ( uint8_t epnum = 1; epnum < EP_MAX; epnum++ )
+    {
+      for ( uint8_t dir = 0; dir < 2; dir++ )
+      {
+        pipe_t const * pipe = &dev->pipe[epnum][dir];
+        if ( pipe->busy && pipe->xfer_type == TUSB_XFER_BULK )
+        {
+          pending[count].slot    = slot;
+          pending[count].ep_addr = tu_edpt_addr(epnum, dir);
+          pending[count].naked   = false;
+          count++;
+        }
+      }
+    }
+  }
+
+  if ( count > _hcd.stats.max_active ) _hcd.stats.max_active = count;
+  if ( count == 0 ) return;
+
+  // One packet per transfer in turn until the frame is full or every device NAKs
+  uint8_t const start = (uint8_t) (_hcd.rr_next % count);
+  uint16_t budget = HCD_VIRTUAL_PACKETS_PER_FRAME;
+  bool progress = true;
+
+  while ( budget && progress )
+  {
+    progress = false;
+    for ( uint8_t i = 0; i < count && budget; i++ )
+    {
+      uint8_t const idx = (uint8_t) ((start + i) % count);
+      if ( pending[idx].naked ) continue;
+
+      vdev_t * dev = &_hcd.dev[pending[idx].slot];
+      uint8_t const ep_addr = pending[idx].ep_addr;
+      pipe_t * pipe = &dev->pipe[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+
+      if ( !pipe->busy )
+      {
+        // completed this frame, the next transfer starts in the next frame
+        pending[idx].naked = true;
+      }
+      else if ( move_packet(dev, ep_addr, pipe) )
+      {
+        budget--;
+        progress = true;
+      }else
+      {
+        _hcd.stats.nak_count++;
+        pending[idx].naked = true;
+      }
+    }
+  }
+
+  _hcd.rr_next++;
+}
+
+//--------------------------------------------------------------------+
+// Virtual API
+//--------------------------------------------------------------------+
+
+bool hcd_virtual_attach(uint8_t port, hcd_virtual_device_t type)
+{
+  TU_VERIFY(port < SLOT_COUNT && type != HCD_VIRTUAL_NONE);
+  vdev_t * dev = &_hcd.dev[port];
+  TU_VERIFY(!dev->connected);
+
+  if ( port == 0 )
+  {
+    tu_memclr(dev, sizeof(vdev_t));
+    dev->type      = type;
+    dev->connected = true;
+    hcd_event_device_attach(TUH_OPT_RHPORT, true);
+  }else
+  {
+    // downstream port of the hub on the root port
+    vdev_t const * hub = &_hcd.dev[0];
+    TU_VERIFY(hub->connected && hub->type == HCD_VIRTUAL_HUB && type != HCD_VIRTUAL_HUB);
+
+    tu_memclr(dev, sizeof(vdev_t));
+    dev->type      = type;
+    dev->connected = true;
+    hub_port_connect(port);
+  }
+
+  return true;
+}
+
+void hcd_virtual_detach(uint8_t port)
+{
+  TU_VERIFY(port < SLOT_COUNT, );
+  vdev_t * dev = &_hcd.dev[port];
+  TU_VERIFY(dev->connected, );
+
+  // address is kept until the stack closes the device
+  dev->connected = false;
+  dev->enabled   = false;
+
+  if ( port == 0 )
+  {
+    if ( dev->type == HCD_VIRTUAL_HUB )
+    {
+      for ( uint8_t i = 1; i < SLOT_COUNT; i++ )
+      {
+        _hcd.dev[i].connected = false;
+        _hcd.dev[i].enabled   = false;
+      }
+      tu_memclr(_hcd.hub_port, sizeof(_hcd.hub_port));
+    }
+    hcd_event_device_remove(TUH_OPT_RHPORT, true);
+  }else
+  {
+    hub_port_disconnect(port);
+  }
+}
+
+void hcd_virtual_set_latency(uint8_t port, uint16_t frames)
+{
+  if ( port < SLOT_COUNT ) _hcd.dev[port].latency = frames;
+}
+
+uint8_t hcd_virtual_get_address(uint8_t port)
+{
+  return (port < SLOT_COUNT && _hcd.dev[port].connected) ? _hcd.dev[port].address : 0;
+}
+
+uint64_t hcd_virtual_device_bytes(uint8_t port)
+{
+  return (port < SLOT_COUNT) ? _hcd.dev[port].bytes : 0;
+}
+
+void hcd_virtual_get_stats(hcd_virtual_stats_t * stats)
+{
+  *stats = _hcd.stats;
+}
+
+void hcd_virtual_reset_stats(void)
+{
+  tu_memclr(&_hcd.stats, sizeof(_hcd.stats));
+  for ( uint8_t i = 0; i < SLOT_COUNT; i++ ) _hcd.dev[i].bytes = 0;
+}
+
+//--------------------------------------------------------------------+
+// Controller API
+//--------------------------------------------------------------------+
+
+bool hcd_init(uint8_t rhport)
+{
+  (void) rhport;
+
+  // device attached before the stack was up
+  if ( _hcd.dev[0].connected ) hcd_event_device_attach(TUH_OPT_RHPORT, false);
+  return true;
+}
+
+// Events are posted as the frames run
+void hcd_int_handler(uint8_t rhport)
+{
+  (void) rhport;
+}
+
+void hcd_int_enable(uint8_t rhport)
+{
+  (void) rhport;
+}
+
+void hcd_int_disable(uint8_t rhport)
+{
+  (void) rhport;
+}
+
+// Bus time only passes when somebody looks: each call runs a frame
+uint32_t hcd_frame_number(uint8_t rhport)
+{
+  (void) rhport;
+  hcd_virtual_frame();
+  return _hcd.frame_count;
+}
+
+//--------------------------------------------------------------------+
+// Port API
+//--------------------------------------------------------------------+
+
+bool hcd_port_connect_status(uint8_t rhport)
+{
+  (void) rhport;
+  return _hcd.dev[0].connected;
+}
+
+void hcd_port_reset(uint8_t rhport)
+{
+  (void) rhport;
+  if ( _hcd.dev[0].connected ) reset_device(&_hcd.dev[0]);
+}
+
+void hcd_port_reset_end(uint8_t rhport)
+{
+  (void) rhport;
+}
+
+tusb_speed_t hcd_port_speed_get(uint8_t rhport)
+{
+  (void) rhport;
+  return TUSB_SPEED_FULL;
+}
+
+void hcd_device_close(uint8_t rhport, uint8_t dev_addr)
+{
+  (void) rhport;
+
+  // a detached device is forgotten once closed
+  for ( uint8_t i = 0; i < SLOT_COUNT; i++ )
+  {
+    vdev_t * dev = &_hcd.dev[i];
+    if ( dev->type == HCD_VIRTUAL_NONE || dev->address != dev_addr ) continue;
+
+    tu_memclr(dev->pipe, sizeof(dev->pipe));
+    if ( !dev->connected ) tu_memclr(dev, sizeof(vdev_t));
+  }
+}
+
+//--------------------------------------------------------------------+
+// Endpoints API
+//--------------------------------------------------------------------+
+
+bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc)
+{
+  (void) rhport;
+
+  vdev_t * dev = find_device(dev_addr);
+  TU_VERIFY(dev);
+
+  uint8_t const epnum = tu_edpt_number(ep_desc->bEndpointAddress);
+  TU_VERIFY(epnum < EP_MAX);
+
+  for ( uint8_t dir = 0; dir < 2; dir++ )
+  {
+    // control endpoint is bidirectional
+    if ( epnum != 0 && dir != tu_edpt_dir(ep_desc->bEndpointAddress) ) continue;
+
+    pipe_t * pipe = &dev->pipe[epnum][dir];
+    tu_memclr(pipe, sizeof(pipe_t));
+    pipe->max_packet_size = tu_edpt_packet_size(ep_desc);
+    pipe->xfer_type       = ep_desc->bmAttributes.xfer;
+    pipe->opened          = true;
+  }
+
+  return true;
+}
+
+bool hcd_setup_send(uint8_t rhport, uint8_t dev_addr, uint8_t const setup_packet[8])
+{
+  (void) rhport;
+
+  vdev_t * dev = find_device(dev_addr);
+  TU_VERIFY(dev);
+
+  memcpy(&dev->request, setup_packet, sizeof(tusb_control_request_t));
+  dev->ctrl_stall     = !process_setup(dev);
+  dev->ctrl_data_done = false;
+
+  complete_ctrl(dev, tu_edpt_addr(0, TUSB_DIR_OUT), 8, XFER_RESULT_SUCCESS);
+  return true;
+}
+
+bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen)
+{
+  (void) rhport;
+
+  vdev_t * dev = find_device(dev_addr);
+  TU_VERIFY(dev);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+  TU_VERIFY(epnum < EP_MAX);
+
+  if ( epnum == 0 )
+  {
+    tusb_control_request_t const * request = &dev->request;
+
+    if ( dev->ctrl_stall )
+    {
+      complete_ctrl(dev, ep_addr, 0, XFER_RESULT_STALLED);
+    }
+    else if ( request->wLength && !dev->ctrl_data_done )
+    {
+      // data stage
+      uint16_t len = buflen;
+      dev->ctrl_data_done = true;
+      if ( dir == TUSB_DIR_IN )
+      {
+        len = tu_min16(buflen, dev->ctrl_len);
+        memcpy(buffer, dev->ctrl_buf, len);
+      }
+      complete_ctrl(dev, ep_addr, len, XFER_RESULT_SUCCESS);
+    }else
+    {
+      // status stage, completes on the old address and then the device takes its new address
+      complete_ctrl(dev, ep_addr, 0, XFER_RESULT_SUCCESS);
+      if ( request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD && request->bRequest == TUSB_REQ_SET_ADDRESS )
+      {
+        dev->address = (uint8_t) request->wValue;
+      }
+    }
+    return true;
+  }
+
+  pipe_t * pipe = &dev->pipe[epnum][dir];
+  TU_VERIFY(pipe->opened && !pipe->busy);
+
+  pipe->buffer     = buffer;
+  pipe->total_len  = buflen;
+  pipe->actual_len = 0;
+  pipe->busy       = true;
+
+  return true;
+}
+
+bool hcd_edpt_clear_stall(uint8_t dev_addr, uint8_t ep_addr)
+{
+  (void) dev_addr;
+  (void) ep_addr;
+  return true;
+}
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Name				:	hcd_virtual.h
+ * Created			:	10/19/2026 7:42:18 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Virtual host controller with simulated hub, CDC and MSC devices for running the tinyUSB host stack in a host (Linux/PC) process.
+ */
+
+#ifndef _TUSB_HCD_VIRTUAL_H_
+#define _TUSB_HCD_VIRTUAL_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// The virtual host controller runs in the caller's thread. Devices are simulated inside the controller:
+// port 0 is the root port, ports 1..HCD_VIRTUAL_HUB_PORTS are the downstream ports of a hub attached to it.
+// The bus is a full speed bus in 1 ms frames: hcd_virtual_frame() moves up to HCD_VIRTUAL_PACKETS_PER_FRAME
+// bulk packets (64 bytes each), giving the pending transfers one packet each in turn, like a real host controller.
+// Completions are posted to the stack as from the controller interrupt, tuh_task() must be called to handle them.
+// hcd_frame_number() also runs a frame, so the blocking delays in usbh.c pass bus time instead of spinning forever.
+
+// Number of downstream ports of the simulated hub
+#ifndef HCD_VIRTUAL_HUB_PORTS
+#define HCD_VIRTUAL_HUB_PORTS           4
+#endif
+
+// Bulk packets per frame, 19 x 64 bytes is about what a full speed bus carries after protocol overhead
+#ifndef HCD_VIRTUAL_PACKETS_PER_FRAME
+#define HCD_VIRTUAL_PACKETS_PER_FRAME   19
+#endif
+
+// Block size and count of the simulated MSC disks
+#define HCD_VIRTUAL_MSC_BLOCK_SIZE      512
+#define HCD_VIRTUAL_MSC_BLOCK_COUNT     0x10000
+
+typedef enum
+{
+  HCD_VIRTUAL_NONE = 0,
+  HCD_VIRTUAL_HUB,  // hub with HCD_VIRTUAL_HUB_PORTS ports, root port only
+  HCD_VIRTUAL_CDC,  // CDC ACM: IN endpoint streams a byte counter, OUT endpoint checks the host sends the same
+  HCD_VIRTUAL_MSC   // bulk-only disk: block lba reads as (uint8_t) lba in every byte, WRITE10 checks the host writes the same
+} hcd_virtual_device_t;
+
+// Bus counters, useful for measuring throughput and fairness
+typedef struct
+{
+  uint32_t frame_count;   // frames run
+  uint32_t xfer_count;    // completed transfers, control stages included
+  uint32_t packet_count;  // bulk and interrupt data packets moved on the bus
+  uint64_t byte_count;    // bulk and interrupt data bytes moved on the bus
+  uint32_t nak_count;     // packets NAKed by a device
+  uint32_t error_count;   // data mismatches found by the simulated devices
+  uint8_t  max_active;    // most bulk transfers pending in the controller at once
+} hcd_virtual_stats_t;
+
+// Connect a simulated device to a port, returns false if the port is in use or missing (no hub on the root port)
+bool hcd_virtual_attach(uint8_t port, hcd_virtual_device_t type);
+
+// Disconnect the device from a port, a hub on the root port takes its downstream devices with it
+void hcd_virtual_detach(uint8_t port);
+
+// Delay in frames before a simulated MSC disk starts the data stage of READ10/WRITE10 (NAKs until then), 0 by default
+void hcd_virtual_set_latency(uint8_t port, uint16_t frames);
+
+// Address assigned to the device on a port (0 if not addressed)
+uint8_t hcd_virtual_get_address(uint8_t port);
+
+// Payload bytes moved by the device on a port: CDC data and MSC READ10/WRITE10 data
+uint64_t hcd_virtual_device_bytes(uint8_t port);
+
+// Run one 1 ms frame: interrupt transfers first, then bulk packets in round-robin order
+void hcd_virtual_frame(void);
+
+// Bus counters
+void hcd_virtual_get_stats(hcd_virtual_stats_t * stats);
+void hcd_virtual_reset_stats(void);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_HCD_VIRTUAL_H_ */
@@ -10,6 +10,7 @@
 #define GENERIC_BUFFER_H_
 
 #include <stdint.h>
+#include <atomic>
 
 /*!
  * \brief Generic Buffer global namespace.
@@ -30,7 +31,10 @@ namespace GenericBuffer {
 	/*!
 	 * \brief Generic ring buffer template.
 	 *
-	 * Template class for a generic FIFO ring buffer. Offers very basic put and get functionality, with the ability to access raw elements to directly access and alter elements.
+	 * Template class for a generic FIFO ring buffer. Offers very basic put and get functionality, with the ability to access raw elements to directly access and alter elements.\n 
+	 * Read and write indices run over twice the array size so a full buffer can be told apart from an empty one without a shared length counter. Put() and ShiftWritePointer() only write the
+	 * write index, and Get() and ShiftReadPointer() only write the read index, so one producer and one consumer in different contexts never modify the same member.\n 
+	 * Each side publishes its own index with a release store and reads the other side's index with an acquire load, so elements are written before the consumer sees them and read before the producer reuses them.
 	 */
 	template <typename T> class GENERIC_BUFFER
 	{
@@ -72,9 +76,8 @@ namespace GenericBuffer {
 		{
 			fifo_buffer = arr;
 			buffer_size = arr_size;
-			buffer_avail = 0;
-			rd_index = 0;
-			wr_index = 0;
+			rd_index.store(0, std::memory_order_relaxed);
+			wr_index.store(0, std::memory_order_release);
 		}
 		/*!
 		 * \brief Clears ring buffer
@@ -99,8 +102,8 @@ namespace GenericBuffer {
 		 */
 		T* GetRawElements(uint32_t * read_index = nullptr, uint32_t * write_index = nullptr)
 		{
-			if(read_index != nullptr) *read_index = rd_index;
-			if(write_index != nullptr) *write_index = wr_index;
+			if(read_index != nullptr) *read_index = GetArrayIndex(rd_index.load(std::memory_order_relaxed));
+			if(write_index != nullptr) *write_index = GetArrayIndex(wr_index.load(std::memory_order_acquire));
 			return &(fifo_buffer[0]);
 		}
 		/*!
@@ -110,24 +113,53 @@ namespace GenericBuffer {
 		 *
 		 * \param shift_size size of the shift based on number of elements (ie shift_size = 1 shifts the read index 1 element forwards/backwards)
 		 * \param increase true = shifts forwards, false = shifts backwards
-		 * \note Function will cap shift amount if it increases by more than the current length or decreases by more than the size of the array.
+		 * \note Function will cap shift amount if it increases by more than the current length or decreases by more than the number of empty elements.
 		 * \sa GetRawElements()
 		 */
 		void ShiftReadPointer(uint32_t shift_size, bool increase)
 		{
-			volatile uint32_t true_shift = shift_size;
-			if(increase && (shift_size > buffer_avail))
-				true_shift = buffer_avail;
-			else if(!increase && (shift_size > buffer_size))
-				true_shift = buffer_size;
+			uint32_t rd = rd_index.load(std::memory_order_relaxed);
+			uint32_t avail = GetBufferAvailable();
 			if(increase)
 			{
-				rd_index = (rd_index + true_shift) % buffer_size;
-				buffer_avail -= true_shift;
+				if(shift_size > avail) shift_size = avail;
+				rd = AdvanceIndex(rd, shift_size);
 			} else {
-				rd_index = rd_index + ((true_shift > rd_index) * buffer_size) - true_shift;	
-				buffer_avail += true_shift;
+				if(shift_size > buffer_size - avail) shift_size = buffer_size - avail;
+				rd = (rd >= shift_size) ? rd - shift_size : rd + 2u * buffer_size - shift_size;
 			}
+			rd_index.store(rd, std::memory_order_release);
+		}
+		/*!
+		 * \brief Retrieves the contiguous empty region at the write index.
+		 *
+		 * Allows elements to be written directly into the array (such as with memcpy or DMA) instead of one at a time with Put().\n 
+		 * The region ends at the read index or the end of the array, whichever comes first, so a full write may need two spans.
+		 *
+		 * \param span_size pointer to number of elements which can be written starting at returned pointer
+		 * \return pointer to the element at the write index
+		 * \sa ShiftWritePointer()
+		 */
+		T* GetWriteSpan(uint32_t * span_size)
+		{
+			uint32_t empty = buffer_size - GetBufferAvailable();
+			uint32_t wr = GetArrayIndex(wr_index.load(std::memory_order_relaxed));
+			uint32_t to_end = buffer_size - wr;
+			*span_size = (empty < to_end) ? empty : to_end;
+			return &(fifo_buffer[wr]);
+		}
+		/*!
+		 * \brief Shifts the write pointer forwards after elements were written with GetWriteSpan().
+		 *
+		 * \param shift_size number of elements written
+		 * \note Function will cap shift amount to the number of empty elements.
+		 * \sa GetWriteSpan()
+		 */
+		void ShiftWritePointer(uint32_t shift_size)
+		{
+			uint32_t empty = buffer_size - GetBufferAvailable();
+			if(shift_size > empty) shift_size = empty;
+			wr_index.store(AdvanceIndex(wr_index.load(std::memory_order_relaxed), shift_size), std::memory_order_release);
 		}
 		/*!
 		 * \brief Adds an element to buffer
@@ -141,11 +173,11 @@ namespace GenericBuffer {
 		bool Put(T element)
 		{
 			bool success = false;
-			if(buffer_avail < buffer_size)
+			if(GetBufferAvailable() < buffer_size)
 			{
-				fifo_buffer[wr_index] = element;
-				buffer_avail++;
-				wr_index = (wr_index+1) % buffer_size;
+				uint32_t wr = wr_index.load(std::memory_order_relaxed);
+				fifo_buffer[GetArrayIndex(wr)] = element;
+				wr_index.store(AdvanceIndex(wr, 1u), std::memory_order_release);
 				success = true;
 			}
 			return success;
@@ -162,12 +194,12 @@ namespace GenericBuffer {
 		bool Get(T * output = nullptr)
 		{
 			bool result = false;
-			if(buffer_avail)
+			if(GetBufferAvailable())
 			{
+				uint32_t rd = rd_index.load(std::memory_order_relaxed);
 				result = true;
-				if(output != nullptr) *output = fifo_buffer[rd_index];
-				rd_index = (rd_index+1) % buffer_size;
-				buffer_avail--;
+				if(output != nullptr) *output = fifo_buffer[GetArrayIndex(rd)];
+				rd_index.store(AdvanceIndex(rd, 1u), std::memory_order_release);
 			}
 			return result;
 		}
@@ -182,27 +214,44 @@ namespace GenericBuffer {
 		T Peek(void)
 		{
 			volatile T output = 0;
-			if(buffer_avail) output = fifo_buffer[rd_index];
+			if(GetBufferAvailable()) output = fifo_buffer[GetArrayIndex(rd_index.load(std::memory_order_relaxed))];
 			return output;
 		}
 		uint32_t GetSize(void) const { return buffer_size; }					//!< Getter for size of array.
-		uint32_t GetBufferAvailable(void) const { return buffer_avail; }		//!< Getter for length/number of elements available in buffer.
+		//! Getter for length/number of elements available in buffer.
+		uint32_t GetBufferAvailable(void) const
+		{
+			uint32_t rd = rd_index.load(std::memory_order_acquire);
+			uint32_t wr = wr_index.load(std::memory_order_acquire);
+			return (wr >= rd) ? wr - rd : wr + 2u * buffer_size - rd;
+		}
 		//! Getter for buffer state (Empty, Full, NotEmptyNotFull)
 		BufferState GetBufferState(void) const								
 		{
-			if(!buffer_avail)
+			uint32_t avail = GetBufferAvailable();
+			if(!avail)
 				return BufferState::Empty;
-			if(buffer_avail == buffer_size)
+			if(avail == buffer_size)
 				return BufferState::Full;
 			return BufferState::NotEmptyNotFull;
 		}
 		private:
+		//private helper functions
+		uint32_t GetArrayIndex(uint32_t index) const
+		{
+			return (index >= buffer_size) ? index - buffer_size : index;
+		}
+		uint32_t AdvanceIndex(uint32_t index, uint32_t shift_size) const
+		{
+			index += shift_size;
+			return (index >= 2u * buffer_size) ? index - 2u * buffer_size : index;
+		}
+		
 		//private members
 		T * fifo_buffer;
 		uint32_t buffer_size;
-		uint32_t buffer_avail;
-		uint32_t rd_index;
-		uint32_t wr_index;
+		std::atomic<uint32_t> rd_index;		//written by the consumer only
+		std::atomic<uint32_t> wr_index;		//written by the producer only
 	};
 }
 
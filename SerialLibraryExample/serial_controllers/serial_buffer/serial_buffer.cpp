@@ -8,6 +8,72 @@
 
 #include "serial_buffer/serial_buffer.h"
 
+#include <string.h>
+
+namespace
+{
+	//searches a contiguous array, returns offset of first match or size if not found
+	uint32_t SearchArray(const char * arr, uint32_t size, const char * pattern, uint32_t numel)
+	{
+		if(!numel) return 0u;
+		if(numel > size) return size;
+		uint32_t last = size - numel;
+		if(numel >= SERIAL_BUFFER_BMH_MIN_PATTERN)
+		{
+			//skip distances are capped to a byte, shorter skips are still safe
+			uint8_t skip[256];
+			memset(skip, (numel > 255u) ? 255u : numel, sizeof(skip));
+			for(uint32_t i = 0; i < numel - 1u; i++)
+			{
+				uint32_t distance = numel - 1u - i;
+				skip[(uint8_t)pattern[i]] = (distance > 255u) ? 255u : distance;
+			}
+			uint32_t pos = 0;
+			while(pos <= last)
+			{
+				char tail = arr[pos + numel - 1u];
+				if(tail == pattern[numel - 1u] && memcmp(&(arr[pos]), pattern, numel - 1u) == 0) return pos;
+				pos += skip[(uint8_t)tail];
+			}
+			return size;
+		}
+		uint32_t pos = 0;
+		while(pos <= last)
+		{
+			const char * hit = (const char *)memchr(&(arr[pos]), pattern[0], last - pos + 1u);
+			if(hit == nullptr) break;
+			pos = hit - arr;
+			if(memcmp(hit + 1, pattern + 1, numel - 1u) == 0) return pos;
+			pos++;
+		}
+		return size;
+	}
+	
+	//searches len characters of a ring starting at index start, returns offset from start or len if not found
+	uint32_t SearchRing(const char * arr, uint32_t bsize, uint32_t start, uint32_t len, const char * pattern, uint32_t numel)
+	{
+		uint32_t len_a = (len < bsize - start) ? len : bsize - start;
+		uint32_t len_b = len - len_a;
+		uint32_t found = SearchArray(&(arr[start]), len_a, pattern, numel);
+		if(found < len_a) return found;
+		//matches which cross the end of the array
+		for(uint32_t i = (len_a >= numel) ? len_a - numel + 1u : 0u; len_b && i < len_a; i++)
+		{
+			uint32_t head = len_a - i;
+			if(numel - head <= len_b && memcmp(&(arr[start + i]), pattern, head) == 0 && memcmp(arr, &(pattern[head]), numel - head) == 0) return i;
+		}
+		found = SearchArray(arr, len_b, pattern, numel);
+		return (found < len_b) ? len_a + found : len;
+	}
+	
+	//compares numel characters of a ring starting at index start
+	bool MatchRing(const char * arr, uint32_t bsize, uint32_t start, const char * pattern, uint32_t numel)
+	{
+		uint32_t len_a = (numel < bsize - start) ? numel : bsize - start;
+		return memcmp(&(arr[start]), pattern, len_a) == 0 && memcmp(arr, &(pattern[len_a]), numel - len_a) == 0;
+	}
+}
+
 //Definition of blank interrupt enable
 void Serial::NoIntEnable(SERCOMHAL::SercomID peripheral_id, bool enable)
 {
@@ -37,66 +103,77 @@ uint32_t Serial::Int2ASCII(uint32_t num, char (*result)[10])
 }
 
 //Definition of Buffer Class
-Serial::SerialBuffer::SerialBuffer(SERCOMHAL::SercomID peripheral_id, char * buf, uint32_t buf_size)
+template <typename LockPolicy> Serial::SerialBuffer<LockPolicy>::SerialBuffer(SERCOMHAL::SercomID peripheral_id, char * buf, uint32_t buf_size)
 {
 	sercom_id = peripheral_id;
 	Reset(buf, buf_size);
 }
 
-Serial::SerialBuffer::~SerialBuffer(void)
+template <typename LockPolicy> Serial::SerialBuffer<LockPolicy>::~SerialBuffer(void)
 {
 	Clear();
 }
 
-void Serial::SerialBuffer::Reset(char * buf, uint32_t buf_size)
+template <typename LockPolicy> void Serial::SerialBuffer<LockPolicy>::Reset(char * buf, uint32_t buf_size)
 {
 	buffer.ResetBuffer(buf, buf_size);
 	index_shift = 1u;
 }
 
-void Serial::SerialBuffer::Clear(void)
+template <typename LockPolicy> void Serial::SerialBuffer<LockPolicy>::Clear(void)
 {
 	buffer.Clear();
 }
 
-bool Serial::SerialBuffer::Put(char input, void (* int_func)(uint8_t, bool))
+template <typename LockPolicy> bool Serial::SerialBuffer<LockPolicy>::Put(char input)
 {
-	int_func(sercom_id, false);
-	bool success = buffer.Put(input);
-	int_func(sercom_id, true);
-	return success;
+	LockPolicy lock(sercom_id);
+	return buffer.Put(input);
 }
 
-bool Serial::SerialBuffer::Get(void (* int_func)(uint8_t, bool), char * output)
+template <typename LockPolicy> uint32_t Serial::SerialBuffer<LockPolicy>::PutArray(const char * input, uint32_t num_bytes)
 {
-	int_func(sercom_id, false);
+	uint32_t count = 0;
+	LockPolicy lock(sercom_id);
+	//ring buffer empty region is at most two spans (write index to end of array, beginning of array to read index)
+	for(uint8_t i = 0; i < 2 && count < num_bytes; i++)
+	{
+		uint32_t span_size;
+		char * span = buffer.GetWriteSpan(&span_size);
+		if(!span_size) break;
+		if(span_size > num_bytes - count) span_size = num_bytes - count;
+		memcpy(span, &(input[count]), span_size);
+		buffer.ShiftWritePointer(span_size);
+		count += span_size;
+	}
+	return count;
+}
+
+template <typename LockPolicy> bool Serial::SerialBuffer<LockPolicy>::Get(char * output)
+{
+	LockPolicy lock(sercom_id);
 	bool result = buffer.Get(output);
 	if(result && index_shift) index_shift--;
-	int_func(sercom_id, true);
 	return result;
 }
 
-bool Serial::SerialBuffer::GetString(const char *input, uint32_t shift, bool move_pointer, void (* int_func)(uint8_t, bool))
+template <typename LockPolicy> bool Serial::SerialBuffer<LockPolicy>::GetString(const char *input, uint32_t shift, bool move_pointer)
 {
 	bool has_string = false;
 	//prevents checking after initialization or a previous string has been found until new character is received
-	while(Get(int_func));
+	while(Get());
 	if(!index_shift)
 	{
-		has_string = true;
-		uint32_t numel = 0;
-		//finds size of input string by detecting null character
-		while(input[numel] != '\0') numel++;
+		uint32_t numel = strlen(input);
 		uint32_t rd_index;
 		uint32_t bsize = buffer.GetSize();
 		char * arr_ref = buffer.GetRawElements(&rd_index);
-		uint32_t reader = rd_index + ((shift > rd_index) * bsize) - shift;
-		for(uint32_t i = 0; i < numel; i++)
+		if(numel <= bsize && shift <= bsize)
 		{
-			//iterates backwards in buffer and input string and checks if each element is equal to each other
-			reader = (!reader) ? bsize - 1 : reader - 1;
-			has_string = (input[numel - 1 - i] == arr_ref[reader]);
-			if(!has_string) break;
+			//string ends shift characters before the read index, compared as at most two contiguous spans
+			uint32_t start = rd_index + 2u * bsize - shift - numel;
+			while(start >= bsize) start -= bsize;
+			has_string = MatchRing(arr_ref, bsize, start, input, numel);
 		}
 		if(has_string)
 		{
@@ -104,17 +181,16 @@ bool Serial::SerialBuffer::GetString(const char *input, uint32_t shift, bool mov
 			if(move_pointer && shift > 0u)
 			{
 				//moves buffer back by the shift amount if string has been found
-				int_func(sercom_id, false);
+				LockPolicy lock(sercom_id);
 				buffer.ShiftReadPointer(shift, false);
 				index_shift += shift;
-				int_func(sercom_id, true);
 			}
 		}
 	}
 	return has_string;
 }
 
-bool Serial::SerialBuffer::GetASCIIAsInt(uint32_t * output, void (* int_func)(uint8_t, bool))
+template <typename LockPolicy> bool Serial::SerialBuffer<LockPolicy>::GetASCIIAsInt(uint32_t * output)
 {
 	bool result = false;
 	*output = 0u;
@@ -122,7 +198,7 @@ bool Serial::SerialBuffer::GetASCIIAsInt(uint32_t * output, void (* int_func)(ui
 	while(received > 47u && received < 58u)
 	{
 		result = true;
-		Get(int_func);
+		Get();
 		*output *= 10u;
 		*output += received - 48u;
 		received = buffer.Peek();
@@ -130,11 +206,11 @@ bool Serial::SerialBuffer::GetASCIIAsInt(uint32_t * output, void (* int_func)(ui
 	return result;
 }
 
-bool Serial::SerialBuffer::GetIntParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits, void (* int_func)(uint8_t, bool))
+template <typename LockPolicy> bool Serial::SerialBuffer<LockPolicy>::GetIntParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits)
 {
 	bool result = false;
 	uint8_t i = 1u;
-	while(!GetString(input, i, true, int_func) && i < max_digits+1u) i++;
+	while(!GetString(input, i, true) && i < max_digits+1u) i++;
 	if(i<max_digits+1u)
 	{
 		volatile uint32_t temp_index;
@@ -142,10 +218,10 @@ bool Serial::SerialBuffer::GetIntParam(uint32_t * output, const char *input, cha
 		uint32_t bsize = buffer.GetSize();
 		char * arr_ref = buffer.GetRawElements(&rd_index);
 		temp_index = (!rd_index) ? bsize - 1 : rd_index - 1;
-		if(GetASCIIAsInt(output, int_func))
+		if(GetASCIIAsInt(output))
 		{
 			char read_delimiter;
-			if(!delimiter || (delimiter && Get(int_func, &read_delimiter) && read_delimiter == delimiter))
+			if(!delimiter || (delimiter && Get(&read_delimiter) && read_delimiter == delimiter))
 			{
 				result = true;
 				arr_ref[temp_index] = '\0';
@@ -157,29 +233,49 @@ bool Serial::SerialBuffer::GetIntParam(uint32_t * output, const char *input, cha
 	return result;
 }
 
-void Serial::SerialBuffer::SetSercomID(SERCOMHAL::SercomID peripheral_id)
+template <typename LockPolicy> bool Serial::SerialBuffer<LockPolicy>::Find(const char *input, uint32_t * offset)
+{
+	uint32_t rd_index;
+	uint32_t avail;
+	char * arr_ref;
+	{
+		//unread characters are not overwritten by the producer, so only the snapshot needs the lock
+		LockPolicy lock(sercom_id);
+		arr_ref = buffer.GetRawElements(&rd_index);
+		avail = buffer.GetBufferAvailable();
+	}
+	uint32_t found = SearchRing(arr_ref, buffer.GetSize(), rd_index, avail, input, strlen(input));
+	if(found < avail && offset != nullptr) *offset = found;
+	return found < avail;
+}
+
+template <typename LockPolicy> void Serial::SerialBuffer<LockPolicy>::SetSercomID(SERCOMHAL::SercomID peripheral_id)
 {
 	sercom_id = peripheral_id;
 }
 
-SERCOMHAL::SercomID Serial::SerialBuffer::GetSercomID(void) const
+template <typename LockPolicy> SERCOMHAL::SercomID Serial::SerialBuffer<LockPolicy>::GetSercomID(void) const
 {
 	return sercom_id;
 }
 
-uint32_t Serial::SerialBuffer::GetBufferAvailable(void) const
+template <typename LockPolicy> uint32_t Serial::SerialBuffer<LockPolicy>::GetBufferAvailable(void) const
 {
 	return buffer.GetBufferAvailable();
 }
 
-uint32_t Serial::SerialBuffer::GetBufferEmpty(void) const
+template <typename LockPolicy> uint32_t Serial::SerialBuffer<LockPolicy>::GetBufferEmpty(void) const
 {
 	return buffer.GetSize() - buffer.GetBufferAvailable();
 }
 
-GenericBuffer::BufferState Serial::SerialBuffer::GetBufferState(void) const
+template <typename LockPolicy> GenericBuffer::BufferState Serial::SerialBuffer<LockPolicy>::GetBufferState(void) const
 {
 	return buffer.GetBufferState();
 }
 
-
+//lock policies used by the serial controllers
+template class Serial::SerialBuffer<Serial::NoLock>;
+template class Serial::SerialBuffer<Serial::IrqMaskLock>;
+template class Serial::SerialBuffer<Serial::CriticalSectionLock>;
+template class Serial::SerialBuffer<Serial::SPSCLockFree>;
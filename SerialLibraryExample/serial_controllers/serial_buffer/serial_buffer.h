@@ -12,6 +12,10 @@
 #include "serial_common/common_hal.h"
 #include "serial_buffer/generic_buffer.h"
 
+#ifndef SERIAL_BUFFER_BMH_MIN_PATTERN
+#define SERIAL_BUFFER_BMH_MIN_PATTERN		8		//!< Minimum string length for SerialBuffer::Find() to use a Boyer-Moore-Horspool skip table.
+#endif
+
 /*!
  * \brief %Serial Buffer global namespace.
  *
@@ -22,10 +26,10 @@ namespace Serial
 	/*!
 	 * \brief Blank Interrupt Enable function to be used as blank parameter for implementing serial buffer.
 	 *
-	 * This function emulates an unimplemented/unneeded interrupt enabling function for passing into serial buffer functions when parameters do not need to be enabled or disabled.
+	 * This function emulates an unimplemented/unneeded interrupt enabling function for passing into controller functions when interrupts do not need to be enabled or disabled.
 	 *
 	 * \note This function doesn't do anything but is necessary for passing as a parameter.
-	 * \sa SerialBuffer.Put(), SerialBuffer.Get(), SerialBuffer.GetString(), SerialBuffer.GetASCIIAsInt(), SerialBuffer.GetIntParam()
+	 * \sa SerialUSB::USBController.SetEventMode()
 	 */
 	void NoIntEnable(SERCOMHAL::SercomID peripheral_id = 0u, bool enable = false);
 	/*!
@@ -40,12 +44,60 @@ namespace Serial
 	 * \sa SerialBuffer.GetASCIIAsInt()
 	 */
 	uint32_t Int2ASCII(uint32_t num, char (*result)[10]);
+	/*!
+	 * \brief Lock policy for buffers only used from a single context.
+	 *
+	 * Compiles to nothing.
+	 */
+	struct NoLock
+	{
+		explicit NoLock(SERCOMHAL::SercomID peripheral_id) { (void)peripheral_id; }
+	};
+	/*!
+	 * \brief Lock policy which masks the SERCOM# interrupt of the buffer while it is accessed.
+	 *
+	 * Use when the buffer is shared with the peripheral's interrupt handler. Other interrupts keep running.
+	 */
+	typedef SERCOMHAL::SercomIRQLock IrqMaskLock;
+	/*!
+	 * \brief Lock policy which disables all interrupts while the buffer is accessed.
+	 *
+	 * Use when the buffer is shared with an interrupt handler other than its own SERCOM#.
+	 */
+	class CriticalSectionLock
+	{
+		public:
+		explicit CriticalSectionLock(SERCOMHAL::SercomID peripheral_id) : state(SERCOMHAL::DisableInterrupts()) { (void)peripheral_id; }
+		~CriticalSectionLock() { SERCOMHAL::RestoreInterrupts(state); }
+		CriticalSectionLock(const CriticalSectionLock &) = delete;
+		CriticalSectionLock & operator=(const CriticalSectionLock &) = delete;
+		
+		private:
+		uint32_t state;
+	};
+	/*!
+	 * \brief Lock-free policy for one producer context and one consumer context.
+	 *
+	 * Compiles to nothing. The ring buffer's read and write indices are atomics updated from separate sides, the producer publishing the write index and the consumer the read index
+	 * with release stores and each reading the other's with acquire loads (refer to GenericBuffer::GENERIC_BUFFER).\n 
+	 * The producer may only call Put() and PutArray(), and the consumer the Get functions. Reset() and Clear() must not run while the other side is active.
+	 *
+	 * \note GetString() with move_pointer and GetIntParam() step back over characters which were already read, so the producer must not fill the buffer completely while they run.
+	 */
+	struct SPSCLockFree
+	{
+		explicit SPSCLockFree(SERCOMHAL::SercomID peripheral_id) { (void)peripheral_id; }
+	};
 	/*!
 	 * \brief %Serial Buffer object
 	 *
-	 * This is a %Serial Buffer object which acts as a generic high-level character array with FIFO functionality and basic string reading abilities.
+	 * This is a %Serial Buffer object which acts as a generic high-level character array with FIFO functionality and basic string reading abilities.\n 
+	 * Access is guarded by LockPolicy, which is constructed with the buffer's SERCOM# for the duration of each buffer update, so locking is resolved at compile time.\n 
+	 * Instantiated for NoLock, IrqMaskLock, CriticalSectionLock and SPSCLockFree.
+	 *
+	 * \tparam LockPolicy scoped lock type constructed from a SERCOMHAL::SercomID
 	 */
-	class SerialBuffer
+	template <typename LockPolicy> class SerialBuffer
 	{
 		//functions
 		public:
@@ -95,22 +147,31 @@ namespace Serial
 		 * Adds char to end of buffer. Prevents addition to a full buffer.
 		 *
 		 * \param input char to be added to end of buffer
-		 * \param int_func interrupt function pointer to be invoked
 		 * \return true unless buffer is full and char was attempted to be added
 		 * \sa Get()
 		 */ 
-		bool Put(char input, void (* int_func)(uint8_t, bool));
+		bool Put(char input);
+		/*!
+		 * \brief Puts an array of characters into the buffer.
+		 *
+		 * Copies directly into the contiguous empty spans of the ring buffer (at most two copies) instead of calling Put() per character.
+		 *
+		 * \param input character array to add to end of buffer
+		 * \param num_bytes number of characters in input
+		 * \return number of characters added (less than num_bytes if buffer fills)
+		 * \sa Put()
+		 */
+		uint32_t PutArray(const char * input, uint32_t num_bytes);
 		/*!
 		 * \brief Gets char from buffer.
 		 *
 		 * Removes char from front of buffer and sets output pointer parameter to the received char.
 		 *
-		 * \param int_func interrupt function pointer to be invoked
 		 * \param output pointer to received char (default = nullptr)
 		 * \return success of reception
 		 * \sa Put(), GetString(), GetASCIIAsInt(), GetIntParam()
 		 */
-		bool Get(void (* int_func)(uint8_t, bool), char * output = nullptr);
+		bool Get(char * output = nullptr);
 		/*!
 		 * \brief Reads entire buffer and checks if it is equal to the input string.
 		 *
@@ -124,23 +185,21 @@ namespace Serial
 		 * \param input char array to be detected
 		 * \param shift offset of string from front of buffer
 		 * \param move_pointer moves rd_index to end of detected string if shift is on
-		 * \param int_func interrupt function pointer to be invoked
 		 * \return if buffer was equal to string
 		 * \note Input array must be null-character terminated.
 		 * \sa Get(), GetASCIIAsInt(), GetIntParam()
 		 */
-		bool GetString(const char *input, uint32_t shift, bool move_pointer, void (* int_func)(uint8_t, bool));
+		bool GetString(const char *input, uint32_t shift, bool move_pointer);
 		/*!
 		 * \brief Gets ASCII integers from front of buffer. 
 		 *
 		 * Removes ASCII numeric digits from front of buffer and sets output pointer parameter to unsigned int value of the ASCII digits.
 		 *
 		 * \param output pointer to received int value
-		 * \param int_func interrupt function pointer to be invoked
 		 * \return success of reception (returns false if no integer was detected)
 		 * \sa Get(), GetIntParam(), GetString()
 		 */
-		bool GetASCIIAsInt(uint32_t * output, void (* int_func)(uint8_t, bool));
+		bool GetASCIIAsInt(uint32_t * output);
 		/*!
 		 * \brief Reads entire buffer and checks if it is equal to the input string + numeric parameter.
 		 *
@@ -155,12 +214,25 @@ namespace Serial
 		 * \param input input string to be detected
 		 * \param max_digits maximum number of digits in parameter, must not exceed 9
 		 * \param delimiter optional delimiting character after int parameter (default = '\0')
-		 * \param int_func interrupt function pointer to be invoked
 		 * \return success of reception (will return false if string value not detected, no integer detected, or no delimiter detected if set)
 		 * \note Input array must be null-character terminated.
 		 * \sa GetString(), GetASCIIAsInt(), Get()
 		 */
-		bool GetIntParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits, void (* int_func)(uint8_t, bool));
+		bool GetIntParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits);
+		/*!
+		 * \brief Searches unread characters for a string.
+		 *
+		 * Finds the first occurrence of input among the characters available in the buffer without removing them.\n 
+		 * The ring is searched as its two contiguous spans: single characters (delimiters, newlines) with memchr, short strings with memchr on the first character followed by memcmp, 
+		 * and strings of SERIAL_BUFFER_BMH_MIN_PATTERN or more characters with a Boyer-Moore-Horspool skip table.
+		 *
+		 * \param input char array to find
+		 * \param offset pointer to number of characters before the match (default = nullptr)
+		 * \return true if input was found
+		 * \note Input array must be null-character terminated. The C library memchr/memcmp do the word-at-a-time (or SIMD on host builds) comparison.
+		 * \sa GetString(), Get()
+		 */
+		bool Find(const char *input, uint32_t * offset = nullptr);
 		
 		void SetSercomID(SERCOMHAL::SercomID peripheral_id);		//!< Setter for SERCOM ID used on hardware.
 		SERCOMHAL::SercomID GetSercomID(void) const;				//!< Getter for SERCOM ID used on hardware.
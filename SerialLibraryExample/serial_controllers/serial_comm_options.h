@@ -10,6 +10,7 @@
 
 #define OPT_SERCOM_NONE		0
 #define OPT_SERCOM_SAMD21	1
+#define OPT_SERCOM_HOST		2
 
 #define OPT_SERCOM_UART		1
 #define OPT_SERCOM_SPI		2
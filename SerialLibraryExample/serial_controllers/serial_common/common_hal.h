@@ -84,6 +84,65 @@ namespace SERCOMHAL
 	 * \note Must configure pin as an output to use
 	 */
 	void OutputLow(Pinout output_pin);
+	/*!
+	 * \brief Masks the interrupt line of a SERCOM#
+	 *
+	 * Holds off only the given peripheral's interrupt, so other interrupts (USB, SysTick, other SERCOMs) keep running. An interrupt raised while masked runs once the line is restored.
+	 *
+	 * \param sercom_id SERCOM# to mask
+	 * \return true if the interrupt line was enabled before masking (pass to RestoreSercomIRQ())
+	 * \note Implementation is selected by SERCOM_MCU_OPT (NVIC on SAMD21, a recursive mutex on host builds).
+	 * \sa RestoreSercomIRQ(), SercomIRQLock
+	 */
+	bool MaskSercomIRQ(SercomID sercom_id);
+	/*!
+	 * \brief Restores the interrupt line of a SERCOM# masked by MaskSercomIRQ()
+	 *
+	 * \param sercom_id SERCOM# to restore
+	 * \param enabled value returned by the matching MaskSercomIRQ() call
+	 * \sa MaskSercomIRQ(), SercomIRQLock
+	 */
+	void RestoreSercomIRQ(SercomID sercom_id, bool enabled);
+	/*!
+	 * \brief Disables all interrupts
+	 *
+	 * \return previous interrupt state (pass to RestoreInterrupts())
+	 * \note Implementation is selected by SERCOM_MCU_OPT (PRIMASK on SAMD21, a recursive mutex shared by all simulated interrupts on host builds).
+	 * \sa RestoreInterrupts()
+	 */
+	uint32_t DisableInterrupts(void);
+	/*!
+	 * \brief Restores interrupt state saved by DisableInterrupts()
+	 *
+	 * \param state value returned by the matching DisableInterrupts() call
+	 * \sa DisableInterrupts()
+	 */
+	void RestoreInterrupts(uint32_t state);
+	/*!
+	 * \brief Scoped per-peripheral interrupt mask
+	 *
+	 * Masks a SERCOM# interrupt line on construction and restores its previous state on destruction. Nested locks on the same SERCOM# only re-enable the line when the outermost lock is released.
+	 */
+	class SercomIRQLock
+	{
+		public:
+		/*!
+		 * \brief Constructor
+		 *
+		 * \param sercom_id SERCOM# to mask while lock is in scope
+		 */
+		explicit SercomIRQLock(SercomID sercom_id) : id(sercom_id), enabled(MaskSercomIRQ(sercom_id)) {}
+		/*!
+		 * \brief Destructor, restores interrupt line
+		 */
+		~SercomIRQLock() { RestoreSercomIRQ(id, enabled); }
+		SercomIRQLock(const SercomIRQLock &) = delete;
+		SercomIRQLock & operator=(const SercomIRQLock &) = delete;
+		
+		private:
+		SercomID id;
+		bool enabled;
+	};
 }
 
 #endif //__COMMON_HAL_H__
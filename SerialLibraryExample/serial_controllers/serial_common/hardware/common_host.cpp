@@ -0,0 +1,200 @@
+/*
+ * Name				:	common_host.cpp
+ * Created			:	10/19/2026 9:12:40 AM
+ * Author			:	Aaron Reilman
+ * Description		:	Common generic hardware functionality for host (Linux/PC) simulation builds.
+ */
+
+#include "serial_comm_config.h"
+
+#if (SERCOM_MCU_OPT == OPT_SERCOM_HOST)
+
+#include "serial_common/hardware/common_host.h"
+
+#include <mutex>
+
+namespace
+{
+	struct SimPin {
+		bool level;
+		bool output;
+		SERCOMHOST::PinWriteHook write_hook;
+		SERCOMHOST::PinReadHook read_hook;
+		void * context;
+	};
+	struct SimIRQ {
+		void (*handler)(void);
+		SERCOMHOST::IRQPending pending;
+		bool enabled;
+		bool active;
+	};
+	SimPin sim_pins[NUM_HOST_PORTS][NUM_HOST_PINS];
+	SimIRQ sim_irqs[NUM_HOST_SERCOMS];
+	//held by dispatch and by masked sections, so device model threads can't run a handler inside a masked section
+	std::recursive_mutex irq_locks[NUM_HOST_SERCOMS];
+	//held by dispatch and by critical sections, so no handler runs inside a critical section
+	std::recursive_mutex global_irq_lock;
+	uint32_t global_irq_depth = 0;
+	uint64_t sim_time = 0;
+
+	SimPin * GetSimPin(SERCOMHAL::Pinout pin)
+	{
+		if(pin.port >= NUM_HOST_PORTS || pin.pin >= NUM_HOST_PINS)
+			return nullptr;
+		return &(sim_pins[pin.port][pin.pin]);
+	}
+}
+
+void SERCOMHOST::AttachPin(SERCOMHAL::Pinout pin, SERCOMHOST::PinWriteHook write_hook, SERCOMHOST::PinReadHook read_hook, void * context)
+{
+	SimPin * sim_pin = GetSimPin(pin);
+	if(sim_pin != nullptr)
+	{
+		sim_pin->write_hook = write_hook;
+		sim_pin->read_hook = read_hook;
+		sim_pin->context = context;
+	}
+}
+
+void SERCOMHOST::DetachPin(SERCOMHAL::Pinout pin)
+{
+	AttachPin(pin, nullptr, nullptr, nullptr);
+}
+
+void SERCOMHOST::SetPinLevel(SERCOMHAL::Pinout pin, bool level)
+{
+	SimPin * sim_pin = GetSimPin(pin);
+	if(sim_pin != nullptr) sim_pin->level = level;
+}
+
+void SERCOMHOST::AttachInterrupt(SERCOMHAL::SercomID sercom_id, void (*handler)(void))
+{
+	if(sercom_id < NUM_HOST_SERCOMS) sim_irqs[sercom_id].handler = handler;
+}
+
+void SERCOMHOST::SetInterruptSource(SERCOMHAL::SercomID sercom_id, SERCOMHOST::IRQPending pending)
+{
+	if(sercom_id < NUM_HOST_SERCOMS) sim_irqs[sercom_id].pending = pending;
+}
+
+void SERCOMHOST::EnableInterrupt(SERCOMHAL::SercomID sercom_id, bool enable)
+{
+	if(sercom_id < NUM_HOST_SERCOMS) sim_irqs[sercom_id].enabled = enable;
+}
+
+void SERCOMHOST::DispatchInterrupt(SERCOMHAL::SercomID sercom_id)
+{
+	if(sercom_id >= NUM_HOST_SERCOMS) return;
+	//take both together, masked sections and critical sections may nest in either order
+	std::unique_lock<std::recursive_mutex> global_lock(global_irq_lock, std::defer_lock);
+	std::unique_lock<std::recursive_mutex> lock(irq_locks[sercom_id], std::defer_lock);
+	std::lock(global_lock, lock);
+	SimIRQ * irq = &(sim_irqs[sercom_id]);
+	//handler is already running, outer loop will pick up the new flags
+	if(global_irq_depth || irq->active || !irq->enabled || irq->handler == nullptr || irq->pending == nullptr) return;
+	irq->active = true;
+	while(irq->enabled && irq->pending(sercom_id)) irq->handler();
+	irq->active = false;
+}
+
+uint64_t SERCOMHOST::GetTime(void)
+{
+	return sim_time;
+}
+
+void SERCOMHOST::AdvanceTime(uint64_t nanoseconds)
+{
+	sim_time += nanoseconds;
+}
+
+void SERCOMHOST::ResetSimulation(void)
+{
+	for(uint8_t port = 0; port < NUM_HOST_PORTS; port++)
+	{
+		for(uint8_t pin = 0; pin < NUM_HOST_PINS; pin++)
+			sim_pins[port][pin] = (SimPin){false, false, nullptr, nullptr, nullptr};
+	}
+	for(uint8_t i = 0; i < NUM_HOST_SERCOMS; i++)
+		sim_irqs[i] = (SimIRQ){nullptr, nullptr, false, false};
+	sim_time = 0;
+}
+
+bool SERCOMHAL::MaskSercomIRQ(SERCOMHAL::SercomID sercom_id)
+{
+	if(sercom_id >= NUM_HOST_SERCOMS) return false;
+	//stays locked until RestoreSercomIRQ()
+	irq_locks[sercom_id].lock();
+	bool enabled = sim_irqs[sercom_id].enabled;
+	sim_irqs[sercom_id].enabled = false;
+	return enabled;
+}
+
+void SERCOMHAL::RestoreSercomIRQ(SERCOMHAL::SercomID sercom_id, bool enabled)
+{
+	if(sercom_id >= NUM_HOST_SERCOMS) return;
+	if(enabled) sim_irqs[sercom_id].enabled = true;
+	irq_locks[sercom_id].unlock();
+	//run anything raised while masked
+	if(enabled) SERCOMHOST::DispatchInterrupt(sercom_id);
+}
+
+uint32_t SERCOMHAL::DisableInterrupts(void)
+{
+	//stays locked until RestoreInterrupts()
+	global_irq_lock.lock();
+	global_irq_depth++;
+	return 0u;
+}
+
+void SERCOMHAL::RestoreInterrupts(uint32_t state)
+{
+	(void)state;
+	bool outermost = (--global_irq_depth == 0u);
+	global_irq_lock.unlock();
+	//run anything raised inside the critical section
+	if(!outermost) return;
+	for(uint8_t i = 0; i < NUM_HOST_SERCOMS; i++)
+		SERCOMHOST::DispatchInterrupt(i);
+}
+
+void SERCOMHAL::ConfigPin(SERCOMHAL::Pinout pin, bool output, bool multiplexed, SERCOMHAL::PullResistor pull)
+{
+	(void)multiplexed;
+	SimPin * sim_pin = GetSimPin(pin);
+	if(sim_pin != nullptr)
+	{
+		sim_pin->output = output;
+		if(!output && pull != PullResistor::NoPull)
+			sim_pin->level = (pull == PullResistor::PinPullUp);
+	}
+}
+
+bool SERCOMHAL::GetPinState(SERCOMHAL::Pinout pin)
+{
+	SimPin * sim_pin = GetSimPin(pin);
+	if(sim_pin == nullptr) return false;
+	if(sim_pin->read_hook != nullptr) return sim_pin->read_hook(pin, sim_pin->context);
+	return sim_pin->level;
+}
+
+void SERCOMHAL::OutputHigh(SERCOMHAL::Pinout output_pin)
+{
+	SimPin * sim_pin = GetSimPin(output_pin);
+	if(sim_pin != nullptr)
+	{
+		sim_pin->level = true;
+		if(sim_pin->write_hook != nullptr) sim_pin->write_hook(output_pin, true, sim_pin->context);
+	}
+}
+
+void SERCOMHAL::OutputLow(SERCOMHAL::Pinout output_pin)
+{
+	SimPin * sim_pin = GetSimPin(output_pin);
+	if(sim_pin != nullptr)
+	{
+		sim_pin->level = false;
+		if(sim_pin->write_hook != nullptr) sim_pin->write_hook(output_pin, false, sim_pin->context);
+	}
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Name				:	common_host.h
+ * Created			:	10/19/2026 9:12:40 AM
+ * Author			:	Aaron Reilman
+ * Description		:	Common generic hardware functionality for host (Linux/PC) simulation builds.
+ */
+
+
+#ifndef __COMMON_HOST_H__
+#define __COMMON_HOST_H__
+
+#include "serial_common/common_hal.h"
+
+#define NUM_HOST_SERCOMS	6
+#define NUM_HOST_PORTS		2
+#define NUM_HOST_PINS		32
+
+/*!
+ * \brief %SERCOM host low level driver global namespace
+ *
+ * This namespace contains the simulated pins, interrupt lines, and virtual clock used when the serial library is built for a host machine instead of a microcontroller.\n
+ * Device models (such as a simulated radio) attach hooks to pins and %SERCOM peripherals so the unmodified serial controllers can talk to them.
+ */
+namespace SERCOMHOST
+{
+	/*!
+	 * \brief An enum type for simulated SERCOM# peripherals.
+	 */
+	enum SercomID : uint8_t {
+		Sercom0,
+		Sercom1,
+		Sercom2,
+		Sercom3,
+		Sercom4,
+		Sercom5
+	};
+	/*!
+	 * \brief An enum type for pin peripheral function on simulated pins (ignored by host HAL).
+	 */
+	enum PeripheralFunction : uint8_t {
+		PF_NONE
+	};
+	/*!
+	 * \brief An enum type for a simulated pin's port.
+	 */
+	enum Port : uint8_t {
+		PORT_A, PORT_B
+	};
+	/*!
+	 * \brief Type definition for pin write hook, invoked whenever firmware drives an attached pin.
+	 */
+	typedef void (*PinWriteHook)(SERCOMHAL::Pinout pin, bool level, void * context);
+	/*!
+	 * \brief Type definition for pin read hook, invoked whenever firmware reads an attached pin.
+	 */
+	typedef bool (*PinReadHook)(SERCOMHAL::Pinout pin, void * context);
+	/*!
+	 * \brief Type definition for interrupt pending check, returns true while a peripheral interrupt line is asserted.
+	 */
+	typedef bool (*IRQPending)(SERCOMHAL::SercomID sercom_id);
+	/*!
+	 * \brief Attaches a device model to a simulated pin.
+	 *
+	 * Write hook is called after the pin level changes from OutputHigh()/OutputLow(). Read hook replaces the stored level in GetPinState().
+	 *
+	 * \param pin pinout to attach to
+	 * \param write_hook function called on output writes (nullptr to ignore writes)
+	 * \param read_hook function called on input reads (nullptr to use stored level)
+	 * \param context pointer passed back to hooks
+	 * \sa DetachPin(), SetPinLevel()
+	 */
+	void AttachPin(SERCOMHAL::Pinout pin, PinWriteHook write_hook, PinReadHook read_hook, void * context);
+	/*!
+	 * \brief Removes device model hooks from a simulated pin.
+	 *
+	 * \param pin pinout to detach
+	 * \sa AttachPin()
+	 */
+	void DetachPin(SERCOMHAL::Pinout pin);
+	/*!
+	 * \brief Drives the stored level of a simulated pin.
+	 *
+	 * Used by device models without a read hook to set the level returned by GetPinState().
+	 *
+	 * \param pin pinout to drive
+	 * \param level true = high, false = low
+	 */
+	void SetPinLevel(SERCOMHAL::Pinout pin, bool level);
+	/*!
+	 * \brief Attaches an interrupt handler to a simulated SERCOM#.
+	 *
+	 * Equivalent of the SERCOM#_Handler vector table entry on hardware. Must be attached before using interrupt driven controllers on the host.
+	 *
+	 * \param sercom_id simulated SERCOM#
+	 * \param handler interrupt handler (usually calls the controller ISR())
+	 * \sa DispatchInterrupt()
+	 */
+	void AttachInterrupt(SERCOMHAL::SercomID sercom_id, void (*handler)(void));
+	/*!
+	 * \brief Registers the peripheral interrupt source of a simulated SERCOM# (used by host HAL implementations).
+	 *
+	 * \param sercom_id simulated SERCOM#
+	 * \param pending function returning true while an enabled interrupt flag is set
+	 */
+	void SetInterruptSource(SERCOMHAL::SercomID sercom_id, IRQPending pending);
+	/*!
+	 * \brief Enables or disables interrupt line of a simulated SERCOM# (NVIC equivalent).
+	 *
+	 * \param sercom_id simulated SERCOM#
+	 * \param enable enable/disable interrupt (default = true)
+	 */
+	void EnableInterrupt(SERCOMHAL::SercomID sercom_id, bool enable = true);
+	/*!
+	 * \brief Runs the attached interrupt handler until the interrupt source is no longer pending.
+	 *
+	 * Called by host HAL implementations whenever an interrupt flag or enable changes. Nested calls from within the handler are deferred to the outer dispatch loop.
+	 *
+	 * \param sercom_id simulated SERCOM#
+	 */
+	void DispatchInterrupt(SERCOMHAL::SercomID sercom_id);
+	/*!
+	 * \brief Getter for virtual time in nanoseconds.
+	 *
+	 * The virtual clock only advances when simulated hardware spends time (bytes clocked on a bus, waiting on device pins), so measurements are deterministic.
+	 *
+	 * \return nanoseconds since start of simulation
+	 * \sa AdvanceTime()
+	 */
+	uint64_t GetTime(void);
+	/*!
+	 * \brief Advances virtual clock.
+	 *
+	 * \param nanoseconds time to add to virtual clock
+	 * \sa GetTime()
+	 */
+	void AdvanceTime(uint64_t nanoseconds);
+	/*!
+	 * \brief Resets virtual clock, pin levels, and all attached hooks and handlers.
+	 */
+	void ResetSimulation(void);
+};
+
+#endif //__COMMON_HOST_H__
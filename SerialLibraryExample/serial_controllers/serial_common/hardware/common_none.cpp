@@ -34,5 +34,27 @@ void SERCOMHAL::OutputLow(SERCOMHAL::Pinout output_pin)
 {
 	(void)output_pin;
 }
+
+bool SERCOMHAL::MaskSercomIRQ(SERCOMHAL::SercomID sercom_id)
+{
+	(void)sercom_id;
+	return false;
+}
+
+void SERCOMHAL::RestoreSercomIRQ(SERCOMHAL::SercomID sercom_id, bool enabled)
+{
+	(void)sercom_id;
+	(void)enabled;
+}
+
+uint32_t SERCOMHAL::DisableInterrupts(void)
+{
+	return 0u;
+}
+
+void SERCOMHAL::RestoreInterrupts(uint32_t state)
+{
+	(void)state;
+}
 	
 #endif
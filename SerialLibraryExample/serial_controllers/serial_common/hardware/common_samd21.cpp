@@ -128,4 +128,33 @@ void SERCOMHAL::OutputLow(SERCOMHAL::Pinout output_pin)
 	PORT->Group[output_pin.port].OUTCLR.reg = 0x1 << output_pin.pin;
 }
 
+bool SERCOMHAL::MaskSercomIRQ(SERCOMHAL::SercomID sercom_id)
+{
+	if(sercom_id > SERCOMSAMD21::SercomID::Sercom5) return false;
+	IRQn_Type irq = (IRQn_Type)(SERCOM0_IRQn + sercom_id);
+	bool enabled = (NVIC->ISER[0] & (0x1u << irq)) != 0u;
+	NVIC_DisableIRQ(irq);
+	//make sure the mask has taken effect before the caller touches shared data
+	__DSB();
+	__ISB();
+	return enabled;
+}
+
+void SERCOMHAL::RestoreSercomIRQ(SERCOMHAL::SercomID sercom_id, bool enabled)
+{
+	if(enabled && sercom_id <= SERCOMSAMD21::SercomID::Sercom5) NVIC_EnableIRQ((IRQn_Type)(SERCOM0_IRQn + sercom_id));
+}
+
+uint32_t SERCOMHAL::DisableInterrupts(void)
+{
+	uint32_t state = __get_PRIMASK();
+	__disable_irq();
+	return state;
+}
+
+void SERCOMHAL::RestoreInterrupts(uint32_t state)
+{
+	__set_PRIMASK(state);
+}
+
 #endif
\ No newline at end of file
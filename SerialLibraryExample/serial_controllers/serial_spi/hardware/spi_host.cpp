@@ -0,0 +1,212 @@
+/*
+ * Name				:	spi_host.cpp
+ * Created			:	10/19/2026 9:40:18 AM
+ * Author			:	Aaron Reilman
+ * Description		:	A simulated SPI serial communication low level driver for host (Linux/PC) builds.
+ */
+
+
+#include "serial_spi/spi_config.h"
+
+#if (SPI_MCU_OPT == OPT_SERCOM_HOST)
+
+#include "serial_spi/hardware/spi_host.h"
+
+namespace
+{
+	struct SimSPI {
+		SPIHOST::ClientTransfer transfer;
+		void * context;
+		uint32_t baud_value;
+		uint8_t rx_data;
+		bool rx_complete;
+		bool tx_complete;
+		bool overflow;
+		bool dre_enabled;
+		bool rxc_enabled;
+		bool txc_enabled;
+		bool error_enabled;
+	};
+	SimSPI sim_spi[NUM_HOST_SERCOMS];
+
+	SimSPI * GetSimSPI(SERCOMHAL::SercomID sercom_id)
+	{
+		if(sercom_id >= NUM_HOST_SERCOMS) return nullptr;
+		return &(sim_spi[sercom_id]);
+	}
+
+	bool SimSPIPending(SERCOMHAL::SercomID sercom_id)
+	{
+		SimSPI * spi = GetSimSPI(sercom_id);
+		//data register is always empty in simulation, bytes are exchanged as soon as they are written
+		return spi->dre_enabled || (spi->rxc_enabled && spi->rx_complete) || (spi->txc_enabled && spi->tx_complete) || (spi->error_enabled && spi->overflow);
+	}
+}
+
+void SPIHOST::GetPeripheralDefaults(SPIHAL::Peripheral * peripheral, SERCOMHAL::SercomID sercom_id)
+{
+	uint8_t first_pin = (uint8_t)(4u * sercom_id);
+	peripheral->sercom_id = sercom_id;
+	peripheral->mosi_pin = (SERCOMHAL::Pinout){SERCOMHOST::PeripheralFunction::PF_NONE, SERCOMHOST::Port::PORT_B, first_pin};
+	peripheral->miso_pin = (SERCOMHAL::Pinout){SERCOMHOST::PeripheralFunction::PF_NONE, SERCOMHOST::Port::PORT_B, (uint8_t)(first_pin + 1u)};
+	peripheral->sck_pin = (SERCOMHAL::Pinout){SERCOMHOST::PeripheralFunction::PF_NONE, SERCOMHOST::Port::PORT_B, (uint8_t)(first_pin + 2u)};
+	peripheral->ssl_pin = (SERCOMHAL::Pinout){SERCOMHOST::PeripheralFunction::PF_NONE, SERCOMHOST::Port::PORT_B, (uint8_t)(first_pin + 3u)};
+	//same defaults as hardware implementations so simulated timing matches
+	peripheral->baud_value = 50000;
+	peripheral->clock_mode = SPIHAL::ClockMode::Mode0;
+	peripheral->endianess = SPIHAL::Endian::MSB;
+	peripheral->extra_spi_params[0] = 0;
+}
+
+void SPIHAL::GetPeripheralDefaults(SPIHAL::Peripheral * peripheral)
+{
+	SPIHOST::GetPeripheralDefaults(peripheral, SERCOMHOST::SercomID::Sercom4);
+}
+
+void SPIHOST::AttachClient(SERCOMHAL::SercomID sercom_id, SPIHOST::ClientTransfer transfer, void * context)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi != nullptr)
+	{
+		spi->transfer = transfer;
+		spi->context = context;
+	}
+}
+
+uint32_t SPIHOST::GetBaud(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	return (spi != nullptr) ? spi->baud_value : 0;
+}
+
+void SPIHAL::InitSercom(SPIHAL::Peripheral * peripheral, bool is_client)
+{
+	SimSPI * spi = GetSimSPI(peripheral->sercom_id);
+	if(spi == nullptr) return;
+	if(!is_client)
+	{
+		SERCOMHAL::ConfigPin(peripheral->ssl_pin, true, false);
+		SERCOMHAL::OutputHigh(peripheral->ssl_pin);
+	}
+	spi->baud_value = peripheral->baud_value;
+	spi->rx_complete = false;
+	spi->tx_complete = false;
+	spi->overflow = false;
+	SERCOMHOST::SetInterruptSource(peripheral->sercom_id, &SimSPIPending);
+	SERCOMHOST::EnableInterrupt(peripheral->sercom_id, true);
+}
+
+void SPIHAL::DeinitSercom(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return;
+	SERCOMHOST::EnableInterrupt(sercom_id, false);
+	spi->baud_value = 0;
+	spi->rx_complete = false;
+	spi->tx_complete = false;
+	spi->overflow = false;
+}
+
+bool SPIHAL::ReadyToTransmit(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	return spi != nullptr && spi->dre_enabled;
+}
+
+bool SPIHAL::ReadyToReceive(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	return spi != nullptr && spi->rx_complete && spi->rxc_enabled;
+}
+
+uint8_t SPIHAL::GetSercomRX(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return 0x00;
+	spi->rx_complete = false;
+	return spi->rx_data;
+}
+
+void SPIHAL::SetSercomTX(uint8_t input, SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return;
+	//full duplex exchange with client, 8 clock periods per byte
+	if(spi->baud_value) SERCOMHOST::AdvanceTime(8000000000ull / spi->baud_value);
+	uint8_t output = (spi->transfer != nullptr) ? spi->transfer(input, spi->context) : 0xFF;
+	if(spi->rx_complete) spi->overflow = true;
+	spi->rx_data = output;
+	spi->rx_complete = true;
+	spi->tx_complete = true;
+	SERCOMHOST::DispatchInterrupt(sercom_id);
+}
+
+void SPIHAL::EnableTxEmpty(SERCOMHAL::SercomID sercom_id, bool enable)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return;
+	spi->dre_enabled = enable;
+	if(enable) SERCOMHOST::DispatchInterrupt(sercom_id);
+}
+
+void SPIHAL::EnableRxFull(SERCOMHAL::SercomID sercom_id, bool enable)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return;
+	spi->rxc_enabled = enable;
+	if(enable) SERCOMHOST::DispatchInterrupt(sercom_id);
+}
+
+bool SPIHAL::TransmitComplete(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return false;
+	bool result = spi->tx_complete && spi->txc_enabled;
+	if(result) spi->tx_complete = false;
+	return result;
+}
+
+void SPIHAL::EnableTxComplete(SERCOMHAL::SercomID sercom_id, bool enable)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return;
+	spi->txc_enabled = enable;
+	if(enable) SERCOMHOST::DispatchInterrupt(sercom_id);
+}
+
+bool SPIHAL::SPISelectLow(SERCOMHAL::SercomID sercom_id)
+{
+	(void)sercom_id;
+	return false;
+}
+
+void SPIHAL::EnableSPISelectLow(SERCOMHAL::SercomID sercom_id, bool enable)
+{
+	(void)sercom_id;
+	(void)enable;
+}
+
+void SPIHAL::EnableSercomErrors(SERCOMHAL::SercomID sercom_id, bool enable)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return;
+	spi->error_enabled = enable;
+	if(enable) SERCOMHOST::DispatchInterrupt(sercom_id);
+}
+
+bool SPIHAL::SercomHasErrors(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	return spi != nullptr && spi->error_enabled && spi->overflow;
+}
+
+bool SPIHAL::CheckOverflowError(SERCOMHAL::SercomID sercom_id)
+{
+	SimSPI * spi = GetSimSPI(sercom_id);
+	if(spi == nullptr) return false;
+	bool has_overflow_error = spi->overflow;
+	spi->overflow = false;
+	return has_overflow_error;
+}
+
+#endif
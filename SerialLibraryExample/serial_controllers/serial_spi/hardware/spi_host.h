@@ -0,0 +1,55 @@
+/*
+ * Name				:	spi_host.h
+ * Created			:	10/19/2026 9:40:18 AM
+ * Author			:	Aaron Reilman
+ * Description		:	A simulated SPI serial communication low level driver for host (Linux/PC) builds.
+ */
+
+
+#ifndef __SPI_HOST_H__
+#define __SPI_HOST_H__
+
+#include "serial_spi/spi_hal.h"
+
+#include "serial_common/hardware/common_host.h"
+
+
+/*!
+ * \brief %SPI host low level driver global namespace
+ *
+ * This namespace contains the helper functions for connecting simulated %SPI clients to a simulated SERCOM#.\n
+ * Each byte written to the data register is exchanged with the attached client and costs 8 %SPI clock periods of virtual time (refer to SERCOMHOST::GetTime()).
+ */
+namespace SPIHOST
+{
+	/*!
+	 * \brief Type definition for client transfer function, exchanges one MOSI byte for one MISO byte.
+	 */
+	typedef uint8_t (*ClientTransfer)(uint8_t mosi, void * context);
+	/*!
+	 * \brief Populates a peripheral struct with default values
+	 *
+	 * Populates peripheral struct with default values at specific simulated SERCOM#. Pins are placed on PORT_B starting at pin 4 * sercom_id (MOSI, MISO, SCK, SSL).
+	 *
+	 * \param peripheral pointer to peripheral struct to populate with default values
+	 * \param sercom_id SERCOM# to be configured as %SPI (default = Sercom4)
+	 */
+	void GetPeripheralDefaults(SPIHAL::Peripheral * peripheral, SERCOMHAL::SercomID sercom_id = SERCOMHOST::SercomID::Sercom4);
+	/*!
+	 * \brief Connects a simulated client to a SERCOM#.
+	 *
+	 * \param sercom_id simulated SERCOM#
+	 * \param transfer client transfer function (nullptr disconnects client, MISO then reads 0xFF)
+	 * \param context pointer passed back to transfer function
+	 */
+	void AttachClient(SERCOMHAL::SercomID sercom_id, ClientTransfer transfer, void * context);
+	/*!
+	 * \brief Getter for %SPI baud rate set on simulated SERCOM# by SPIHAL::InitSercom().
+	 *
+	 * \param sercom_id simulated SERCOM#
+	 * \return baud rate (0 if SERCOM# is not initialized)
+	 */
+	uint32_t GetBaud(SERCOMHAL::SercomID sercom_id);
+}
+
+#endif //__SPI_HOST_H__
@@ -18,6 +18,8 @@
 #ifndef SPI_MCU_OPT
 	#if (SERCOM_MCU_OPT == OPT_SERCOM_SAMD21)
 		#define SPI_MCU_OPT		OPT_SERCOM_SAMD21
+	#elif (SERCOM_MCU_OPT == OPT_SERCOM_HOST)
+		#define SPI_MCU_OPT		OPT_SERCOM_HOST
 	#else
 		#define SPI_MCU_OPT		OPT_SERCOM_NONE
 	#endif
@@ -26,6 +28,8 @@
 
 #if (SPI_MCU_OPT == OPT_SERCOM_SAMD21)
 	#include "serial_spi/hardware/spi_samd21.h"
+#elif (SPI_MCU_OPT == OPT_SERCOM_HOST)
+	#include "serial_spi/hardware/spi_host.h"
 #else 
 	#warning "SPI not defined for this MCU!"
 #endif
@@ -125,7 +125,9 @@ bool SerialUART::UARTController::Transmit(char input)
 
 bool SerialUART::UARTController::Receive(char * output)
 {
-	return rx_buffer.Get(&UARTHAL::EnableRxFull, output);
+	bool success = rx_buffer.Get(output);
+	ResumeRX();
+	return success;
 }
 
 bool SerialUART::UARTController::TransmitPacket(const char * input, uint32_t num_bytes)
@@ -171,7 +173,14 @@ bool SerialUART::UARTController::EchoRx(void)
 
 bool SerialUART::UARTController::ReceiveString(const char *input, uint32_t shift, bool move_pointer)
 {
-	return rx_buffer.GetString(input, shift, move_pointer, &UARTHAL::EnableRxFull);
+	bool success = rx_buffer.GetString(input, shift, move_pointer);
+	ResumeRX();
+	return success;
+}
+
+bool SerialUART::UARTController::FindString(const char *input, uint32_t * offset)
+{
+	return rx_buffer.Find(input, offset);
 }
 
 bool SerialUART::UARTController::TransmitInt(uint32_t input)
@@ -183,18 +192,29 @@ bool SerialUART::UARTController::TransmitInt(uint32_t input)
 
 bool SerialUART::UARTController::ReceiveInt(uint32_t * output)
 {
-	return rx_buffer.GetASCIIAsInt(output, &UARTHAL::EnableRxFull);
+	bool success = rx_buffer.GetASCIIAsInt(output);
+	ResumeRX();
+	return success;
 }
 
 bool SerialUART::UARTController::ReceiveParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits)
 {
-	return rx_buffer.GetIntParam(output, input, delimiter, max_digits, &UARTHAL::EnableRxFull);;
+	bool success = rx_buffer.GetIntParam(output, input, delimiter, max_digits);
+	ResumeRX();
+	return success;
 }
 
 //private helper function
 void SerialUART::UARTController::PutRXBuffer(char input)
 {
-	rx_buffer.Put(input, &Serial::NoIntEnable);
+	rx_buffer.Put(input);
+}
+
+//private helper function
+void SerialUART::UARTController::ResumeRX(void)
+{
+	//ISR stops receiving when the buffer fills, restart it now that space may be free
+	UARTHAL::EnableRxFull(rx_buffer.GetSercomID(), true);
 }
 
 //private helper function
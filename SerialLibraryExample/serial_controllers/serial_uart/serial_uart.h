@@ -230,6 +230,19 @@ namespace SerialUART
 		 * \sa Receive(), ReceiveParam(), ReceiveInt()
 		 */
 		bool ReceiveString(const char *input, uint32_t shift = 0u, bool move_pointer = true);
+		/*!
+		 * \brief Searches unread characters in the receive buffer for a string without reading it.
+		 *
+		 * Unlike ReceiveString(), characters are not removed, so the offset can be used to read up to (or skip past) the match.\n 
+		 * Useful for finding a delimiter or newline in long messages.
+		 *
+		 * \param input char array to find
+		 * \param offset pointer to number of characters before the match (default = nullptr)
+		 * \return true if input was found
+		 * \note Input array must be null-character terminated.
+		 * \sa ReceiveString(), Receive()
+		 */
+		bool FindString(const char *input, uint32_t * offset = nullptr);
 		/*!
 		 * \brief Transmits unsigned int as ASCII string.
 		 *
@@ -294,12 +307,13 @@ namespace SerialUART
 		private:
 		//private helper functions
 		void PutRXBuffer(char input);
+		void ResumeRX(void);
 		char GetTXBuffer(void);
 		void HandleErrors(void);
 		
 		//private data members
 		GenericBuffer::GENERIC_BUFFER<char> tx_buffer;
-		Serial::SerialBuffer rx_buffer;
+		Serial::SerialBuffer<Serial::IrqMaskLock> rx_buffer;
 		Status status;
 		bool error_on;
 	}; //UARTController
@@ -0,0 +1,17 @@
+/*
+ * Name				:	usb_host.cpp
+ * Created			:	10/19/2026 1:05:12 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Host (Linux/PC) implementation of clock drivers for USB, used with the virtual device controller.
+ */
+
+
+#include "serial_usb/serial_usb.h"
+
+#if CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+//no clocks or pins on the virtual controller
+void SerialUSB::USBFeedIOClocks(void) {}
+void SerialUSB::ResetUSB(void) {}
+
+#endif
@@ -8,9 +8,36 @@
 
 #include "serial_usb/serial_usb.h"
 
+#include <string.h>
+
+namespace
+{
+	//controller of each CDC port, used to route stack callbacks
+	SerialUSB::USBController * cdc_controllers[CFG_TUD_CDC];
+
+	bool HasActiveController(void)
+	{
+		for(uint8_t i = 0; i < CFG_TUD_CDC; i++)
+		{
+			if(cdc_controllers[i] != nullptr) return true;
+		}
+		return false;
+	}
+}
+
 //Definition of Controller Class
-SerialUSB::USBController::USBController(void)
+SerialUSB::USBController::USBController(uint8_t cdc_itf)
 {
+	itf = cdc_itf;
+	flush_policy = FlushPolicy::Immediate;
+	flush_interval = 0;
+	flush_start = 0;
+	flush_timer = nullptr;
+	flush_pending = false;
+	event_wakeup = nullptr;
+	event_int = &(Serial::NoIntEnable);
+	event_mode = false;
+	rx_echo = false;
 	usb_on = false;
 	detached = true;
 	//ResetUSB();
@@ -26,12 +53,18 @@ void SerialUSB::USBController::Init(char * buf, uint32_t buf_size)
 	if(!usb_on)
 	{
 		ResetBuffer(buf, buf_size);
+		if(itf < CFG_TUD_CDC) cdc_controllers[itf] = this;
 		USBFeedIOClocks();
 		usb_on = true;
 		if(tud_inited())
+		{
 			Reattach();
+		}
 		else
-			tusb_init();	//tiny usb init (tusb_config.h must be configured to device mode, 1 CDC port and using the correct hardware environment)
+		{
+			tusb_init();	//tiny usb init (tusb_config.h must be configured to device mode, CFG_TUD_CDC ports and using the correct hardware environment)
+			detached = false;	//stack connects to the host when initialized
+		}
 	}
 }
 
@@ -41,7 +74,9 @@ void SerialUSB::USBController::Deinit(void)
 	{
 		//no teardown available for tiny usb stack
 		ClearBuffers();
-		Detach();
+		if(itf < CFG_TUD_CDC && cdc_controllers[itf] == this) cdc_controllers[itf] = nullptr;
+		//stack is shared by all CDC ports, so only disconnect from the host once the last port is deinitialized
+		if(!HasActiveController()) Detach();
 		usb_on = false;
 	}
 }
@@ -53,14 +88,29 @@ void SerialUSB::USBController::ResetBuffer(char * buf, uint32_t buf_size)
 
 void SerialUSB::USBController::ClearBuffers(bool clear_tx, bool clear_rx)
 {
-	if(clear_tx) tud_cdc_write_clear();
+	event_int(itf, false);
+	if(clear_tx)
+	{
+		tud_cdc_n_write_clear(itf);
+		flush_pending = false;
+	}
 	if(clear_rx) usb_buffer.Clear();
+	event_int(itf, true);
 }
 
 void SerialUSB::USBController::ISR(void)
 {
 	#if (CFG_TUSB_MCU != OPT_MCU_NONE)
 	tud_int_handler(0);
+	if(tud_task_event_ready())
+	{
+		//stack events are only processed by Task(), so wake the context of every event driven controller
+		for(uint8_t i = 0; i < CFG_TUD_CDC; i++)
+		{
+			USBController * controller = cdc_controllers[i];
+			if(controller != nullptr && controller->event_mode && controller->event_wakeup != nullptr) controller->event_wakeup();
+		}
+	}
 	#endif
 }
 
@@ -68,18 +118,15 @@ void SerialUSB::USBController::Task(bool echo)
 {
 	if(usb_on)
 	{
-		if(tud_cdc_available() && usb_buffer.GetBufferState() != GenericBuffer::BufferState::Full)
+		rx_echo = echo;
+		event_int(itf, false);
+		//data left in the CDC FIFO while the receive buffer was full (the receive callback only moves data in event mode)
+		if(tud_cdc_n_available(itf)) ReceiveFIFO(echo);
+		if(flush_pending && flush_policy == FlushPolicy::Timer)
 		{
-			char packet[usb_buffer.GetBufferEmpty()];
-			uint32_t count = tud_cdc_read(packet, usb_buffer.GetBufferEmpty());
-			if(echo)
-			{
-				tud_cdc_write(packet, count);
-				tud_cdc_write_flush();
-			} else {
-				for(uint32_t i = 0; i < count; i++) PutBuffer(packet[i]);
-			}
+			if(flush_timer == nullptr || (uint32_t)(flush_timer() - flush_start) >= flush_interval) FlushFIFO();
 		}
+		event_int(itf, true);
 		tud_task();
 	}
 }
@@ -87,13 +134,19 @@ void SerialUSB::USBController::Task(bool echo)
 bool SerialUSB::USBController::Transmit(char input)
 {
 	bool success = false;
-	if(usb_on) success = tud_cdc_write_char(input);
+	if(usb_on)
+	{
+		event_int(itf, false);
+		success = tud_cdc_n_write_char(itf, input);
+		if(success) TransmitFlush(&input, 1);
+		event_int(itf, true);
+	}
 	return success;
 }
 
 bool SerialUSB::USBController::Receive(char * output)
 {
-	return usb_buffer.Get(&(Serial::NoIntEnable), output);
+	return usb_buffer.Get(output);
 }
 
 bool SerialUSB::USBController::TransmitPacket(const char * input, uint32_t num_bytes)
@@ -101,8 +154,10 @@ bool SerialUSB::USBController::TransmitPacket(const char * input, uint32_t num_b
 	bool success = false;
 	if(usb_on)
 	{
-		uint32_t count = tud_cdc_write(input, num_bytes);
-		tud_cdc_write_flush();
+		event_int(itf, false);
+		uint32_t count = tud_cdc_n_write(itf, input, num_bytes);
+		TransmitFlush(input, count);
+		event_int(itf, true);
 		success = count == num_bytes;
 	}
 	return success;
@@ -113,15 +168,22 @@ uint32_t SerialUSB::USBController::TransmitString(const char *input)
 	uint32_t count = 0;
 	if(usb_on)
 	{
-		count = tud_cdc_write_str(input);
-		tud_cdc_write_flush();
+		event_int(itf, false);
+		count = tud_cdc_n_write_str(itf, input);
+		TransmitFlush(input, count);
+		event_int(itf, true);
 	}
 	return count;
 }
 
 bool SerialUSB::USBController::ReceiveString(const char *input, uint32_t shift, bool move_pointer)
 {
-	return usb_buffer.GetString(input, shift, move_pointer, &(Serial::NoIntEnable));
+	return usb_buffer.GetString(input, shift, move_pointer);
+}
+
+bool SerialUSB::USBController::FindString(const char *input, uint32_t * offset)
+{
+	return usb_buffer.Find(input, offset);
 }
 
 bool SerialUSB::USBController::TransmitInt(uint32_t input)
@@ -133,18 +195,109 @@ bool SerialUSB::USBController::TransmitInt(uint32_t input)
 
 bool SerialUSB::USBController::ReceiveInt(uint32_t * output)
 {
-	return usb_buffer.GetASCIIAsInt(output, &(Serial::NoIntEnable));
+	return usb_buffer.GetASCIIAsInt(output);
 }
 
 bool SerialUSB::USBController::ReceiveParam(uint32_t * output, const char *input, char delimiter, uint8_t max_digits)
 {
-	return usb_buffer.GetIntParam(output, input, delimiter, max_digits, &(Serial::NoIntEnable));
+	return usb_buffer.GetIntParam(output, input, delimiter, max_digits);
+}
+
+//private helper function
+void SerialUSB::USBController::ReceiveFIFO(bool echo)
+{
+	//read directly out of the CDC FIFO (linear part, then wrapped part) without an intermediate packet
+	tu_fifo_buffer_info_t info;
+	tud_cdc_n_read_info(itf, &info);
+	const char * segments[2] = {(const char *)info.ptr_lin, (const char *)info.ptr_wrap};
+	uint32_t lengths[2] = {info.len_lin, info.len_wrap};
+	uint32_t count = 0;
+	for(uint8_t i = 0; i < 2 && lengths[i]; i++)
+	{
+		uint32_t copied;
+		if(echo)
+			copied = tud_cdc_n_write(itf, segments[i], lengths[i]);
+		else
+			copied = usb_buffer.PutArray(segments[i], lengths[i]);
+		count += copied;
+		if(copied < lengths[i]) break;
+	}
+	if(count) tud_cdc_n_read_advance(itf, count);
+	//echo flushes through FlushFIFO() so a pending Newline/Timer/Manual flush isn't repeated later
+	if(echo) FlushFIFO();
+}
+
+void SerialUSB::USBController::SetFlushPolicy(SerialUSB::FlushPolicy policy, uint32_t interval_us, uint32_t (* micros_func)(void))
+{
+	flush_policy = policy;
+	flush_interval = interval_us;
+	flush_timer = micros_func;
+	if(flush_pending && policy == FlushPolicy::Immediate) Flush();
+}
+
+void SerialUSB::USBController::Flush(void)
+{
+	event_int(itf, false);
+	FlushFIFO();
+	event_int(itf, true);
+}
+
+void SerialUSB::USBController::SetEventMode(bool enable, void (* wakeup_func)(void), void (* int_func)(uint8_t, bool))
+{
+	event_mode = enable;
+	event_wakeup = wakeup_func;
+	event_int = (enable && int_func != nullptr) ? int_func : &(Serial::NoIntEnable);
+}
+
+bool SerialUSB::USBController::HasReceiveData(void) const
+{
+	return usb_on && tud_cdc_n_available(itf);
+}
+
+bool SerialUSB::USBController::HasEvents(void) const
+{
+	if(!usb_on) return false;
+	//received data can only be moved once the receive buffer (or the transmit FIFO when echoing) has room
+	bool rx_room = rx_echo ? (tud_cdc_n_write_available(itf) > 0) : (usb_buffer.GetBufferEmpty() > 0);
+	return tud_task_event_ready() || (flush_pending && flush_policy == FlushPolicy::Timer) || (tud_cdc_n_available(itf) && rx_room);
+}
+
+//private helper function
+void SerialUSB::USBController::TransmitFlush(const char * input, uint32_t num_bytes)
+{
+	if(!num_bytes) return;
+	switch(flush_policy)
+	{
+		case FlushPolicy::Immediate:
+			FlushFIFO();
+			break;
+		case FlushPolicy::Newline:
+			if(memchr(input, '\n', num_bytes) != nullptr) FlushFIFO();
+			else flush_pending = true;
+			break;
+		case FlushPolicy::Timer:
+			//timer starts at first unsent byte so data never waits longer than the interval
+			if(!flush_pending && flush_timer != nullptr) flush_start = flush_timer();
+			flush_pending = true;
+			break;
+		case FlushPolicy::Manual:
+			flush_pending = true;
+			break;
+	}
 }
 
 //private helper function
-void SerialUSB::USBController::PutBuffer(char input)
+void SerialUSB::USBController::FlushFIFO(void)
 {
-	usb_buffer.Put(input, &(Serial::NoIntEnable));
+	if(usb_on) tud_cdc_n_write_flush(itf);
+	flush_pending = false;
+}
+
+//private helper function
+void SerialUSB::USBController::TransmitEvent(void)
+{
+	//stack sends everything left in the transmit FIFO after a completed transfer
+	flush_pending = false;
 }
 
 //getters
@@ -153,11 +306,26 @@ uint32_t SerialUSB::USBController::GetBufferAvailable(void) const
 	return usb_buffer.GetBufferAvailable();
 }
 
+uint32_t SerialUSB::USBController::GetTXEmpty(void) const
+{
+	return usb_on ? tud_cdc_n_write_available(itf) : 0;
+}
+
 bool SerialUSB::USBController::IsConnected(void) const
 {
 	return usb_on && tud_mounted();
 }
 
+uint8_t SerialUSB::USBController::GetInterface(void) const
+{
+	return itf;
+}
+
+SerialUSB::FlushPolicy SerialUSB::USBController::GetFlushPolicy(void) const
+{
+	return flush_policy;
+}
+
 void SerialUSB::USBController::Detach(void)
 {
 	if(usb_on && !detached)
@@ -175,3 +343,17 @@ void SerialUSB::USBController::Reattach(void)
 		detached = false;
 	}
 }
+
+//tinyUSB CDC callbacks
+void tud_cdc_rx_cb(uint8_t itf)
+{
+	SerialUSB::USBController * controller = (itf < CFG_TUD_CDC) ? cdc_controllers[itf] : nullptr;
+	//moves as much as the receive buffer has room for, Task() moves the rest once the application read the buffer
+	if(controller != nullptr && controller->event_mode) controller->ReceiveFIFO(controller->rx_echo);
+}
+
+void tud_cdc_tx_complete_cb(uint8_t itf)
+{
+	SerialUSB::USBController * controller = (itf < CFG_TUD_CDC) ? cdc_controllers[itf] : nullptr;
+	if(controller != nullptr && controller->event_mode) controller->TransmitEvent();
+}
\ No newline at end of file
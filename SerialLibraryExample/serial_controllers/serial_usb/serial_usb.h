@@ -33,12 +33,24 @@
 	 * \brief Triggers USB reset operation.
 	 */
 	void ResetUSB(void);
+	/*!
+	 * \brief An enum class for when data written to the CDC transmit FIFO is sent to the host.
+	 *
+	 * Full endpoint packets (64 bytes at full speed, 512 bytes at high speed) are always sent as soon as they fill, regardless of policy.
+	 */
+	enum class FlushPolicy {
+		Immediate,				//!< Flush after every transmit call (each call becomes at least one %USB packet)
+		Newline,				//!< Flush when a newline character is written
+		Timer,					//!< Flush from Task() once the oldest unsent byte has waited the flush interval
+		Manual					//!< Only flush on full packets and Flush() calls
+	};
 	/*!
 	 * \brief %USB serial communication controller object
 	 *
 	 * This is a %USB serial communication controller which manages a single peripheral. It creates a %SerialBuffer for reception of data over USB and some simple parsing capabilities. 
 	 * This controller is interrupt and task driven, so Task() must be implemented before or after all application code in the main while loop, and ISR() must be implemented in the 
-	 * USB interrupt Handler. 
+	 * USB interrupt Handler.\n 
+	 * Each instance manages one CDC port. Set CFG_TUD_CDC in tusb_config.h to the number of ports and create one instance per port (e.g. a command console on port 0 and binary telemetry on port 1).
 	 */
 	class USBController
 	{
@@ -50,9 +62,10 @@
 		 * Instantiates controller object for USB serial communication. This will use the TinyUSB stack to perform the necessary tasks. The object instance must be initialized using Init() to begin
 		 * using it.
 		 *
+		 * \param cdc_itf index of CDC port managed by this controller, must be less than CFG_TUD_CDC (default = 0)
 		 * \sa ~USBController(), Init(), Deinit()
 		 */
-		USBController(void);
+		USBController(uint8_t cdc_itf = 0);
 		/*!
 		 * \brief Destructor
 		 *
@@ -66,7 +79,7 @@
 		 * \brief Initializes USB serial communication.
 		 *
 		 * Initializes peripheral hardware and uses optional parameter for FIFO buffer size if USB hasn't been initialized.\n 
-		 * This function will not do anything if USB is currently enabled.
+		 * This function will not do anything if USB is currently enabled. The tinyUSB stack is shared, so only the first controller initialized starts it.
 		 *
 		 * \param buf initialized character array used for FIFO receive buffer
 		 * \param buf_size buffer size
@@ -76,7 +89,7 @@
 		/*!
 		 * \brief Disables and resets USB serial communication.
 		 *
-		 * Disables USB serial controller if active.
+		 * Disables USB serial controller if active. The device is only detached from the host once the controllers of all CDC ports are deinitialized.
 		 *
 		 * \note The hardware teardown for TinyUSB is currently unimplemented. It is not recommended to call this.
 		 * \sa Init(), ClearBuffers(), ~UARTController()
@@ -106,7 +119,8 @@
 		/*!
 		 * \brief USB Interrupt Service Routine.
 		 *
-		 * Function to be called in USB interrupt handler. This calls the tusb ISR function and lets the USB stack handle interrupts.
+		 * Function to be called in USB interrupt handler. This calls the tusb ISR function and lets the USB stack handle interrupts.\n 
+		 * The stack is shared by all CDC ports, so call this from one controller only. It wakes every controller in event driven mode (refer to SetEventMode()).
 		 *
 		 * \sa Task()
 		 */
@@ -118,9 +132,46 @@
 		 * parameters. This also performs the main tusb task. There is also an option to disable the FIFO receive buffer which will not allow any read data to fill the FIFO receive buffer.
 		 *
 		 * \param echo sends all received data back to the host device allowing it to be read on a terminal (default = false)
-		 * \sa ISR()
+		 * \note In event driven mode, received data is handled by the stack callbacks instead, so Task() only updates the echo setting, moves data left in the stack while the receive buffer 
+		 * was full (refer to HasReceiveData()), services timed flushes, and processes stack events. Stack events are never processed from ISR().
+		 * \sa ISR(), SetEventMode()
 		 */
 		void Task(bool echo = false);
+		/*!
+		 * \brief Enables or disables event driven processing.
+		 *
+		 * In event driven mode the tinyUSB receive and transmit complete callbacks move received data into the FIFO receive buffer and drive transmission, so %USB latency no longer depends on how 
+		 * often the application calls Task().\n 
+		 * Stack events are always processed by Task(), so the stack and the callbacks only run in one context. ISR() calls wakeup_func (if not nullptr) when events are pending, and the application 
+		 * must call Task() from the context it wakes (such as the main loop after Util::waitForInterrupt(), or a low priority interrupt pended by wakeup_func). Without a wakeup function, call Task() 
+		 * whenever HasEvents() returns true.\n 
+		 * int_func must mask the context which calls Task() if it differs from the application context, and is used whenever the application accesses the stack. The receive buffer is lock-free, 
+		 * as it is only filled by the context processing events and only read by the application.
+		 *
+		 * \param enable enable/disable event driven mode
+		 * \param wakeup_func function called from ISR() when stack events are pending (default = nullptr)
+		 * \param int_func function pointer to interrupt enable/disable function (default = Serial::NoIntEnable)
+		 * \sa Task(), ISR(), HasEvents()
+		 */
+		void SetEventMode(bool enable, void (* wakeup_func)(void) = nullptr, void (* int_func)(uint8_t, bool) = &(Serial::NoIntEnable));
+		/*!
+		 * \brief Checks if the controller has pending work.
+		 *
+		 * Used to decide whether the MCU can sleep, e.g. Util::waitForInterrupt(&HasUSBEvents) where HasUSBEvents() calls this function.
+		 *
+		 * \return true if the stack has unprocessed events, a timed flush is waiting, or received data waiting in the stack can be moved into the receive buffer
+		 * \sa SetEventMode()
+		 */
+		bool HasEvents(void) const;
+		/*!
+		 * \brief Checks if received data is still waiting in the stack.
+		 *
+		 * Received data stays in the stack while the FIFO receive buffer is full, and is moved by Task() once the application read the buffer (HasEvents() then returns true).
+		 *
+		 * \return true if received data is waiting to be moved into the FIFO receive buffer
+		 * \sa Task(), SetEventMode()
+		 */
+		bool HasReceiveData(void) const;
 		/*!
 		 * \brief Transmit character across USB.
 		 *
@@ -181,6 +232,19 @@
 		 * \sa Receive(), ReceiveParam(), ReceiveInt(), Task()
 		 */
 		bool ReceiveString(const char *input, uint32_t shift = 0u, bool move_pointer = true);
+		/*!
+		 * \brief Searches unread characters in the FIFO receive buffer for a string without reading it.
+		 *
+		 * Unlike ReceiveString(), characters are not removed, so the offset can be used to read up to (or skip past) the match.\n 
+		 * Useful for finding a delimiter or newline in long messages.
+		 *
+		 * \param input char array to find
+		 * \param offset pointer to number of characters before the match (default = nullptr)
+		 * \return true if input was found
+		 * \note Input array must be null-character terminated.
+		 * \sa ReceiveString(), Receive()
+		 */
+		bool FindString(const char *input, uint32_t * offset = nullptr);
 		/*!
 		 * \brief Transmits unsigned int as ASCII string over USB.
 		 *
@@ -223,20 +287,57 @@
 		 */
 		bool ReceiveParam(uint32_t * output, const char *input, char delimiter = '\0', uint8_t max_digits = 8u);
 		
+		/*!
+		 * \brief Sets when transmitted data is flushed to the host.
+		 *
+		 * Policies other than Immediate coalesce consecutive transmit calls into full %USB packets, e.g. "Integer: " + digits + '\\n' is sent as one packet with FlushPolicy::Newline.\n 
+		 * With FlushPolicy::Timer, Task() flushes once micros_func() has advanced interval_us since the first unsent byte was written. If micros_func is nullptr, every call to Task() flushes.
+		 *
+		 * \param policy flush policy (default on construction = Immediate)
+		 * \param interval_us maximum time data waits in the transmit FIFO in microseconds, Timer policy only (default = 0)
+		 * \param micros_func function returning a free running microsecond count, Timer policy only (default = nullptr)
+		 * \sa Flush(), Task()
+		 */
+		void SetFlushPolicy(FlushPolicy policy, uint32_t interval_us = 0, uint32_t (* micros_func)(void) = nullptr);
+		/*!
+		 * \brief Sends all data waiting in the transmit FIFO to the host.
+		 *
+		 * \sa SetFlushPolicy()
+		 */
+		void Flush(void);
+		
 		uint32_t GetBufferAvailable(void) const;		//!< Getter for number of unread characters available in FIFO receive buffer
+		uint32_t GetTXEmpty(void) const;				//!< Getter for number of empty slots available in transmit FIFO
 		
 		bool IsConnected(void) const;					//!< Retrieves state of connection (true = connected)	
+		uint8_t GetInterface(void) const;				//!< Getter for index of CDC port managed by this controller
+		FlushPolicy GetFlushPolicy(void) const;			//!< Getter for transmit flush policy
 		
-		void Detach(void);								//!< Suspends USB device to go into low power mode	
-		void Reattach(void);							//!< Reattaches suspended USB device
+		void Detach(void);								//!< Suspends USB device (all CDC ports) to go into low power mode	
+		void Reattach(void);							//!< Reattaches suspended USB device (all CDC ports)
 		
 		
 		private:
+		friend void ::tud_cdc_rx_cb(uint8_t itf);
+		friend void ::tud_cdc_tx_complete_cb(uint8_t itf);
 		//private helper functions
-		void PutBuffer(char input);
+		void ReceiveFIFO(bool echo);
+		void TransmitFlush(const char * input, uint32_t num_bytes);
+		void FlushFIFO(void);
+		void TransmitEvent(void);
 		
 		//private data members
-		Serial::SerialBuffer usb_buffer;
+		Serial::SerialBuffer<Serial::SPSCLockFree> usb_buffer;
+		uint8_t itf;
+		FlushPolicy flush_policy;
+		uint32_t flush_interval;
+		uint32_t flush_start;
+		uint32_t (* flush_timer)(void);
+		bool flush_pending;
+		void (* event_wakeup)(void);
+		void (* event_int)(uint8_t, bool);
+		bool event_mode;
+		bool rx_echo;
 		bool usb_on;
 		bool detached;
 	}; //USBController
@@ -0,0 +1,633 @@
+/*
+ * Name				:	usb_benchmark.cpp
+ * Created			:	10/19/2026 3:12:40 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Throughput benchmarks for the tinyUSB class drivers, run against the virtual device controller on host (Linux/PC) builds.
+ */
+
+
+#include "serial_usb/usb_benchmark.h"
+
+#if CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "portable/virtual/dcd_virtual.h"
+
+//largest chunk moved per API call, also size of the verification pattern
+#define BENCHMARK_MAX_CHUNK		16384
+//number of loop iterations without progress before a run is aborted
+#define BENCHMARK_MAX_STALLS	1000
+
+namespace
+{
+	uint8_t pattern[BENCHMARK_MAX_CHUNK + 256];
+	uint8_t host_buffer[BENCHMARK_MAX_CHUNK];
+	uint8_t device_buffer[BENCHMARK_MAX_CHUNK];
+	#if CFG_TUD_MSC && USB_DISK_MSC_CALLBACKS
+	USBDisk::NullDisk null_disk(USB_BENCHMARK_BLOCK_COUNT, USB_BENCHMARK_BLOCK_SIZE);
+
+	//RAM disk which completes every read/write later, moving only part of the request or reporting not ready now and then
+	class AsyncDisk : public USBDisk::BlockDevice
+	{
+		public:
+		uint32_t BlockCount(void) const override { return USB_BENCHMARK_ASYNC_BLOCKS; }
+		uint16_t BlockSize(void) const override { return USB_BENCHMARK_BLOCK_SIZE; }
+		int32_t Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size) override { return Start(lba, offset, (uint8_t *)buffer, size, true); }
+		int32_t Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size) override { return Start(lba, offset, (uint8_t *)buffer, size, false); }
+		void Reset(void) { pending = false; count = 0; stale_accepted = 0; }
+		uint32_t StaleAccepted(void) const { return stale_accepted; }
+
+		//completes the I/O in progress (if any) and runs the usbd task to process it
+		bool Complete(void)
+		{
+			if(!pending) return false;
+			pending = false;
+			//a completion of an earlier command, e.g. one aborted by a reset, must be dropped
+			if(tud_msc_async_io_done_seq((uint16_t)(seq - 1), (int32_t)size, false)) stale_accepted++;
+			int32_t result = 0;
+			if(++count % 5 != 0)
+			{
+				result = (int32_t)((size > 64) ? size / 2 + 7 : size);
+				if(read) memcpy(buffer, &mem[address], (size_t)result);
+				else memcpy(&mem[address], buffer, (size_t)result);
+			}
+			tud_msc_async_io_done_seq(seq, result, false);
+			tud_task();
+			return true;
+		}
+
+		private:
+		int32_t Start(uint32_t lba, uint32_t offset, uint8_t * data, uint32_t data_size, bool is_read)
+		{
+			uint64_t mem_address;
+			if(pending || !GetAddress(lba, offset, data_size, &mem_address)) return -1;
+			buffer = data;
+			address = (uint32_t)mem_address;
+			size = data_size;
+			read = is_read;
+			seq = tud_msc_async_io_seq();
+			pending = true;
+			return TUD_MSC_RET_ASYNC;
+		}
+
+		//variables
+		uint8_t mem[USB_BENCHMARK_ASYNC_BLOCKS * USB_BENCHMARK_BLOCK_SIZE];
+		uint8_t * buffer;
+		uint32_t address, size, count, stale_accepted;
+		uint16_t seq;
+		bool pending = false, read;
+	};
+	AsyncDisk async_disk;
+	#endif
+	#if CFG_TUD_NCM
+	//state of the frames received by tud_network_recv_cb()
+	uint32_t ncm_received;
+	uint16_t ncm_frame_size;
+	bool ncm_recv_pending;
+	bool ncm_recv_valid;
+	#endif
+
+	struct Measurement {
+		std::chrono::steady_clock::time_point start;
+		uint64_t start_cycles;
+	};
+
+	uint64_t ReadCycles(void)
+	{
+		#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+		#else
+		return 0;
+		#endif
+	}
+
+	void InitPattern(void)
+	{
+		for(uint32_t i = 0; i < sizeof(pattern); i++) pattern[i] = (uint8_t)i;
+	}
+
+	//pattern is periodic over 256 bytes, so any stream offset can be checked with a single compare
+	bool CheckPattern(const uint8_t * data, uint32_t length, uint64_t offset)
+	{
+		return memcmp(data, &pattern[offset & 0xFF], length) == 0;
+	}
+
+	#if CFG_TUD_MSC
+	//every block holds the pattern starting at its lba, so a block can be checked without knowing which command wrote it
+	bool BlockPattern(uint8_t * data, uint32_t length, uint32_t position, uint32_t lba, uint16_t block_size, bool check)
+	{
+		uint32_t done = 0;
+		while(done < length)
+		{
+			uint32_t block = lba + (position + done) / block_size;
+			uint32_t index = (position + done) % block_size;
+			uint32_t size = tu_min32(length - done, block_size - index);
+			if(check)
+			{
+				if(!CheckPattern(&data[done], size, block + index)) return false;
+			}
+			else memcpy(&data[done], &pattern[(block + index) & 0xFF], size);
+			done += size;
+		}
+		return true;
+	}
+	#endif
+
+	void StartMeasurement(Measurement * measurement)
+	{
+		InitPattern();
+		dcd_virtual_reset_stats();
+		tud_event_stats_reset();
+		measurement->start = std::chrono::steady_clock::now();
+		measurement->start_cycles = ReadCycles();
+	}
+
+	USBBenchmark::Result FinishMeasurement(const Measurement & measurement, uint64_t bytes, bool success)
+	{
+		USBBenchmark::Result result;
+		uint64_t end_cycles = ReadCycles();
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		dcd_virtual_stats_t stats;
+		dcd_virtual_get_stats(&stats);
+		tud_event_stats_t event_stats;
+		tud_event_stats_get(&event_stats);
+
+		result.bytes = bytes;
+		result.transfers = stats.xfer_count;
+		result.packets = stats.packet_count;
+		result.elapsed_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - measurement.start).count();
+		result.cycles = end_cycles - measurement.start_cycles;
+		double seconds = (result.elapsed_ns != 0) ? (double)result.elapsed_ns / 1e9 : 1e-9;
+		result.mb_per_s = (double)bytes / seconds / 1e6;
+		result.transfers_per_s = (double)result.transfers / seconds;
+		result.cycles_per_byte = (bytes != 0) ? (double)result.cycles / (double)bytes : 0;
+		result.frames = 0;
+		result.frames_per_s = 0;
+		result.max_queue_depth = event_stats.max_depth;
+		result.queue_overflows = event_stats.overflows;
+		result.success = success;
+		return result;
+	}
+
+	//finds the n-th interface (alternate setting 0) of a class in the active configuration descriptor
+	const uint8_t * FindInterface(uint8_t itf_class, uint8_t index)
+	{
+		const uint8_t * desc = tud_descriptor_configuration_cb(0);
+		const uint8_t * end = desc + tu_le16toh(((const tusb_desc_configuration_t *)desc)->wTotalLength);
+		uint8_t count = 0;
+		for(const uint8_t * p = desc; p < end; p = tu_desc_next(p))
+		{
+			if(tu_desc_type(p) != TUSB_DESC_INTERFACE) continue;
+			const tusb_desc_interface_t * itf = (const tusb_desc_interface_t *)p;
+			if(itf->bInterfaceClass == itf_class && itf->bAlternateSetting == 0 && count++ == index) return p;
+		}
+		return nullptr;
+	}
+
+	bool FindEndpoints(uint8_t itf_class, uint8_t index, uint8_t * ep_out, uint8_t * ep_in)
+	{
+		const uint8_t * p = FindInterface(itf_class, index);
+		if(p == nullptr) return false;
+		const uint8_t * desc = tud_descriptor_configuration_cb(0);
+		const uint8_t * end = desc + tu_le16toh(((const tusb_desc_configuration_t *)desc)->wTotalLength);
+		*ep_out = 0;
+		*ep_in = 0;
+		for(p = tu_desc_next(p); p < end && tu_desc_type(p) != TUSB_DESC_INTERFACE; p = tu_desc_next(p))
+		{
+			if(tu_desc_type(p) != TUSB_DESC_ENDPOINT) continue;
+			const tusb_desc_endpoint_t * ep = (const tusb_desc_endpoint_t *)p;
+			if(ep->bmAttributes.xfer != TUSB_XFER_BULK) continue;
+			if(tu_edpt_dir(ep->bEndpointAddress) == TUSB_DIR_IN) *ep_in = ep->bEndpointAddress;
+			else *ep_out = ep->bEndpointAddress;
+		}
+		return *ep_out != 0 && *ep_in != 0;
+	}
+
+	#if CFG_TUD_NCM
+	//finds the endpoints of the NCM function, the data endpoints are in alternate setting 1 of the data interface
+	bool FindNCMEndpoints(uint8_t * itf_data, uint8_t * ep_notif, uint8_t * ep_out, uint8_t * ep_in)
+	{
+		const uint8_t * desc = tud_descriptor_configuration_cb(0);
+		const uint8_t * end = desc + tu_le16toh(((const tusb_desc_configuration_t *)desc)->wTotalLength);
+		const uint8_t * p = desc;
+		for(; p < end; p = tu_desc_next(p))
+		{
+			if(tu_desc_type(p) != TUSB_DESC_INTERFACE) continue;
+			const tusb_desc_interface_t * itf = (const tusb_desc_interface_t *)p;
+			if(itf->bInterfaceClass == TUSB_CLASS_CDC && itf->bInterfaceSubClass == CDC_COMM_SUBCLASS_NETWORK_CONTROL_MODEL) break;
+		}
+		if(p >= end) return false;
+		*itf_data = ((const tusb_desc_interface_t *)p)->bInterfaceNumber + 1;
+		*ep_notif = 0;
+		*ep_out = 0;
+		*ep_in = 0;
+		for(p = tu_desc_next(p); p < end && tu_desc_type(p) != TUSB_DESC_INTERFACE_ASSOCIATION; p = tu_desc_next(p))
+		{
+			if(tu_desc_type(p) != TUSB_DESC_ENDPOINT) continue;
+			const tusb_desc_endpoint_t * ep = (const tusb_desc_endpoint_t *)p;
+			if(ep->bmAttributes.xfer == TUSB_XFER_INTERRUPT) *ep_notif = ep->bEndpointAddress;
+			else if(tu_edpt_dir(ep->bEndpointAddress) == TUSB_DIR_IN) *ep_in = ep->bEndpointAddress;
+			else *ep_out = ep->bEndpointAddress;
+		}
+		return *ep_notif != 0 && *ep_out != 0 && *ep_in != 0;
+	}
+
+	//reads one NTB from the device and verifies its datagrams, returns the number of datagrams (frames) read
+	uint32_t ReadNTB(uint8_t ep_in, uint16_t frame_size, uint32_t * received, bool * success)
+	{
+		//the first packet has the block length, the rest is read exactly so the next NTB is left on the endpoint
+		uint32_t got = dcd_virtual_edpt_in(ep_in, host_buffer, CFG_TUD_NET_ENDPOINT_SIZE);
+		if(got == 0) return 0;
+		uint16_t block_length = (got >= 12) ? tu_le16toh(tu_unaligned_read16(&host_buffer[8])) : 0;
+		if(block_length < got || block_length > BENCHMARK_MAX_CHUNK || tu_le32toh(tu_unaligned_read32(host_buffer)) != 0x484D434E)
+		{
+			*success = false;
+			return 0;
+		}
+		if(got < block_length) got += dcd_virtual_edpt_in(ep_in, &host_buffer[got], block_length - got);
+		uint16_t ndp = tu_le16toh(tu_unaligned_read16(&host_buffer[10]));
+		if(got != block_length || ndp + 8u > got || tu_le32toh(tu_unaligned_read32(&host_buffer[ndp])) != 0x304D434E)
+		{
+			*success = false;
+			return 0;
+		}
+
+		uint32_t frames = 0;
+		uint16_t ndp_end = ndp + tu_le16toh(tu_unaligned_read16(&host_buffer[ndp + 4]));
+		for(uint16_t entry = ndp + 8; entry + 4u <= ndp_end && entry + 4u <= got; entry += 4)
+		{
+			uint16_t index = tu_le16toh(tu_unaligned_read16(&host_buffer[entry]));
+			uint16_t length = tu_le16toh(tu_unaligned_read16(&host_buffer[entry + 2]));
+			if(index == 0 || length == 0) break;
+			if(length != frame_size || index + (uint32_t)length > got || !CheckPattern(&host_buffer[index], length, *received)) *success = false;
+			(*received)++;
+			frames++;
+		}
+		return frames;
+	}
+
+	//builds an NTB of up to max_frames frames starting with frame number first, returns its length
+	uint16_t BuildNTB(uint32_t first, uint32_t max_frames, uint16_t frame_size, uint16_t sequence)
+	{
+		//datagrams are 4 byte aligned after the NTH (12 bytes) and the NDP (8 bytes + 4 bytes per datagram and the terminator)
+		uint16_t slot = (uint16_t)((frame_size + 3u) & ~3u);
+		uint32_t count = 0;
+		while(count < max_frames && count < 255 && 20 + (count + 2) * 4 + (count + 1) * slot <= tu_min32(CFG_TUD_NCM_OUT_NTB_MAX_SIZE, BENCHMARK_MAX_CHUNK)) count++;
+		uint16_t offset = (uint16_t)(20 + (count + 1) * 4);
+		uint16_t length = (uint16_t)(offset + count * slot);
+
+		memset(host_buffer, 0, offset);
+		tu_unaligned_write32(&host_buffer[0], tu_htole32(0x484D434E));		//NTH16 "NCMH"
+		tu_unaligned_write16(&host_buffer[4], tu_htole16(12));
+		tu_unaligned_write16(&host_buffer[6], tu_htole16(sequence));
+		tu_unaligned_write16(&host_buffer[8], tu_htole16(length));
+		tu_unaligned_write16(&host_buffer[10], tu_htole16(12));
+		tu_unaligned_write32(&host_buffer[12], tu_htole32(0x304D434E));		//NDP16 "NCM0"
+		tu_unaligned_write16(&host_buffer[16], tu_htole16((uint16_t)(8 + (count + 1) * 4)));
+		for(uint32_t i = 0; i < count; i++)
+		{
+			tu_unaligned_write16(&host_buffer[20 + i * 4], tu_htole16(offset));
+			tu_unaligned_write16(&host_buffer[22 + i * 4], tu_htole16(frame_size));
+			memcpy(&host_buffer[offset], &pattern[(first + i) & 0xFF], frame_size);
+			offset += slot;
+		}
+		return length;
+	}
+	#endif
+
+	//generic stream benchmark shared by CDC and vendor, the device API is passed as function pointers
+	USBBenchmark::Result RunStream(uint8_t ep_out, uint8_t ep_in, uint8_t itf, USBBenchmark::Direction direction, uint32_t total_bytes, uint32_t chunk_size,
+		uint32_t (* write)(uint8_t, void const *, uint32_t), uint32_t (* flush)(uint8_t), uint32_t (* read)(uint8_t, void *, uint32_t))
+	{
+		Measurement measurement;
+		uint64_t produced = 0, consumed = 0;
+		uint32_t stalls = 0;
+		bool success = true;
+		if(chunk_size == 0 || chunk_size > BENCHMARK_MAX_CHUNK) chunk_size = BENCHMARK_MAX_CHUNK;
+
+		StartMeasurement(&measurement);
+		while(consumed < total_bytes && stalls < BENCHMARK_MAX_STALLS)
+		{
+			uint32_t produce = (total_bytes - produced < chunk_size) ? (uint32_t)(total_bytes - produced) : chunk_size;
+			uint32_t got;
+			if(direction == USBBenchmark::Direction::DeviceToHost)
+			{
+				if(produce != 0)
+				{
+					produced += write(itf, &pattern[produced & 0xFF], produce);
+					flush(itf);
+				}
+				got = dcd_virtual_edpt_in(ep_in, host_buffer, BENCHMARK_MAX_CHUNK);
+				if(!CheckPattern(host_buffer, got, consumed)) success = false;
+			}
+			else
+			{
+				if(produce != 0) produced += dcd_virtual_edpt_out(ep_out, &pattern[produced & 0xFF], produce);
+				got = read(itf, device_buffer, chunk_size);
+				if(!CheckPattern(device_buffer, got, consumed)) success = false;
+			}
+			consumed += got;
+			stalls = (got == 0) ? stalls + 1 : 0;
+		}
+		return FinishMeasurement(measurement, consumed, success && consumed == total_bytes);
+	}
+}
+
+bool USBBenchmark::Enumerate(void)
+{
+	if(!tud_inited()) tud_init(BOARD_TUD_RHPORT);
+	if(!dcd_virtual_enumerate(1)) return false;
+
+	for(uint8_t i = 0; i < CFG_TUD_CDC; i++)
+	{
+		const tusb_desc_interface_t * itf = (const tusb_desc_interface_t *)FindInterface(TUSB_CLASS_CDC, i);
+		if(itf == nullptr) return false;
+		tusb_control_request_t request;
+		request.bmRequestType = 0x21;
+		request.bRequest = CDC_REQUEST_SET_CONTROL_LINE_STATE;
+		request.wValue = 0x0003;	//DTR and RTS
+		request.wIndex = itf->bInterfaceNumber;
+		request.wLength = 0;
+		if(!dcd_virtual_control_xfer(&request, nullptr, nullptr)) return false;
+	}
+
+	#if CFG_TUD_NCM
+	//activate the NCM data interface like a host network driver, then take the speed and connection notifications
+	uint8_t itf_data, ep_notif, ep_out, ep_in;
+	if(!FindNCMEndpoints(&itf_data, &ep_notif, &ep_out, &ep_in)) return false;
+	tusb_control_request_t request;
+	request.bmRequestType = 0x01;
+	request.bRequest = TUSB_REQ_SET_INTERFACE;
+	request.wValue = 1;
+	request.wIndex = itf_data;
+	request.wLength = 0;
+	if(!dcd_virtual_control_xfer(&request, nullptr, nullptr)) return false;
+	uint8_t notification[16];
+	while(dcd_virtual_edpt_in(ep_notif, notification, sizeof(notification)) != 0);
+	#endif
+	return tud_mounted();
+}
+
+USBBenchmark::Result USBBenchmark::RunCDC(uint8_t itf, Direction direction, uint32_t total_bytes, uint32_t chunk_size)
+{
+	uint8_t ep_out, ep_in;
+	if(itf >= CFG_TUD_CDC || !FindEndpoints(TUSB_CLASS_CDC_DATA, itf, &ep_out, &ep_in))
+	{
+		Measurement measurement;
+		StartMeasurement(&measurement);
+		return FinishMeasurement(measurement, 0, false);
+	}
+	return RunStream(ep_out, ep_in, itf, direction, total_bytes, chunk_size, tud_cdc_n_write, tud_cdc_n_write_flush, tud_cdc_n_read);
+}
+
+#if CFG_TUD_VENDOR
+USBBenchmark::Result USBBenchmark::RunVendor(uint8_t itf, Direction direction, uint32_t total_bytes, uint32_t chunk_size)
+{
+	uint8_t ep_out, ep_in;
+	if(itf >= CFG_TUD_VENDOR || !FindEndpoints(TUSB_CLASS_VENDOR_SPECIFIC, itf, &ep_out, &ep_in))
+	{
+		Measurement measurement;
+		StartMeasurement(&measurement);
+		return FinishMeasurement(measurement, 0, false);
+	}
+	return RunStream(ep_out, ep_in, itf, direction, total_bytes, chunk_size, tud_vendor_n_write, tud_vendor_n_flush, tud_vendor_n_read);
+}
+#endif
+
+#if CFG_TUD_MSC
+USBBenchmark::Result USBBenchmark::RunMSC(Direction direction, uint32_t total_bytes, uint16_t blocks_per_command, bool async)
+{
+	Measurement measurement;
+	uint8_t ep_out, ep_in;
+	#if USB_DISK_MSC_CALLBACKS
+	USBDisk::BlockDevice * previous = USBDisk::GetDevice(0);
+	if(async)
+	{
+		async_disk.Reset();
+		USBDisk::Attach(0, &async_disk);
+	}
+	else if(previous == nullptr) USBDisk::Attach(0, &null_disk);
+	#else
+	if(async)
+	{
+		StartMeasurement(&measurement);
+		return FinishMeasurement(measurement, 0, false);
+	}
+	#endif
+	uint32_t block_count = 0;
+	uint16_t block_size = 0;
+	tud_msc_capacity_cb(0, &block_count, &block_size);
+	uint32_t blocks = (block_size != 0) ? total_bytes / block_size : 0;
+	uint32_t lba = 0, tag = 0;
+	uint64_t moved = 0;
+	bool success = FindEndpoints(TUSB_CLASS_MSC, 0, &ep_out, &ep_in) && blocks_per_command <= block_count && block_size <= BENCHMARK_MAX_CHUNK;
+	//a NullDisk stores nothing, so there is no data to read back
+	#if USB_DISK_MSC_CALLBACKS
+	bool verify = USBDisk::GetDevice(0) != &null_disk;
+	#else
+	bool verify = true;
+	#endif
+	if(blocks_per_command == 0) blocks_per_command = 1;
+
+	StartMeasurement(&measurement);
+	while(success && blocks != 0)
+	{
+		uint16_t count = (uint16_t)tu_min32(blocks, blocks_per_command);
+		uint32_t length = (uint32_t)count * block_size;
+		if(lba + count > block_count) lba = 0;
+
+		//command stage
+		msc_cbw_t cbw;
+		memset(&cbw, 0, sizeof(cbw));
+		cbw.signature = MSC_CBW_SIGNATURE;
+		cbw.tag = ++tag;
+		cbw.total_bytes = length;
+		cbw.dir = (direction == Direction::DeviceToHost) ? TUSB_DIR_IN_MASK : 0;
+		cbw.cmd_len = 10;
+		cbw.command[0] = (direction == Direction::DeviceToHost) ? SCSI_CMD_READ_10 : SCSI_CMD_WRITE_10;
+		cbw.command[2] = (uint8_t)(lba >> 24);
+		cbw.command[3] = (uint8_t)(lba >> 16);
+		cbw.command[4] = (uint8_t)(lba >> 8);
+		cbw.command[5] = (uint8_t)lba;
+		cbw.command[7] = (uint8_t)(count >> 8);
+		cbw.command[8] = (uint8_t)count;
+		if(dcd_virtual_edpt_out(ep_out, &cbw, sizeof(cbw)) != sizeof(cbw))
+		{
+			success = false;
+			break;
+		}
+
+		//data stage
+		uint32_t done = 0, stalls = 0;
+		while(done < length && stalls < BENCHMARK_MAX_STALLS)
+		{
+			uint32_t request = tu_min32(length - done, BENCHMARK_MAX_CHUNK);
+			uint32_t got;
+			if(direction == Direction::DeviceToHost)
+			{
+				got = dcd_virtual_edpt_in(ep_in, host_buffer, request);
+				if(verify && !BlockPattern(host_buffer, got, done, lba, block_size, true)) success = false;
+			}
+			else
+			{
+				BlockPattern(host_buffer, request, done, lba, block_size, false);
+				got = dcd_virtual_edpt_out(ep_out, host_buffer, request);
+			}
+			#if USB_DISK_MSC_CALLBACKS
+			//data only moves on once the storage I/O completes
+			if(got == 0 && async_disk.Complete()) continue;
+			#endif
+			done += got;
+			stalls = (got == 0) ? stalls + 1 : 0;
+		}
+
+		//status stage, the CSW is queued once the last write completes
+		#if USB_DISK_MSC_CALLBACKS
+		while(async_disk.Complete());
+		#endif
+		msc_csw_t csw;
+		if(done != length || dcd_virtual_edpt_in(ep_in, &csw, sizeof(csw)) != sizeof(csw) || csw.signature != MSC_CSW_SIGNATURE || csw.tag != tag || csw.status != MSC_CSW_STATUS_PASSED || !success)
+		{
+			success = false;
+			break;
+		}
+		moved += length;
+		blocks -= count;
+		lba += count;
+	}
+	#if USB_DISK_MSC_CALLBACKS
+	if(async)
+	{
+		success = success && async_disk.StaleAccepted() == 0;
+		USBDisk::Attach(0, (previous != nullptr) ? previous : &null_disk);
+	}
+	#endif
+	return FinishMeasurement(measurement, moved, success);
+}
+#endif
+
+#if CFG_TUD_NCM
+USBBenchmark::Result USBBenchmark::RunNCM(Direction direction, uint32_t frame_count, uint16_t frame_size, bool zero_copy)
+{
+	Measurement measurement;
+	uint8_t itf_data, ep_notif, ep_out, ep_in;
+	uint32_t sent = 0, received = 0, stalls = 0;
+	uint16_t sequence = 0;
+	bool success = FindNCMEndpoints(&itf_data, &ep_notif, &ep_out, &ep_in) && frame_size != 0 && frame_size <= CFG_TUD_NET_MTU;
+	ncm_received = 0;
+	ncm_frame_size = frame_size;
+	ncm_recv_pending = false;
+	ncm_recv_valid = true;
+
+	StartMeasurement(&measurement);
+	while(success && received < frame_count && stalls < BENCHMARK_MAX_STALLS)
+	{
+		uint32_t got;
+		if(direction == Direction::DeviceToHost)
+		{
+			//device queues frames until the NTB being filled is full, each frame starts at a different pattern offset
+			while(sent < frame_count)
+			{
+				const uint8_t * frame = &pattern[sent & 0xFF];
+				if(zero_copy)
+				{
+					uint8_t * buffer = tud_network_xmit_reserve(frame_size);
+					if(buffer == nullptr) break;
+					memcpy(buffer, frame, frame_size);
+					tud_network_xmit_commit(frame_size);
+				}
+				else
+				{
+					if(!tud_network_can_xmit(frame_size)) break;
+					tud_network_xmit((void *)frame, frame_size);
+				}
+				sent++;
+			}
+			//nothing more to aggregate with after the last frame
+			if(sent == frame_count) tud_network_ncm_flush();
+
+			got = ReadNTB(ep_in, frame_size, &received, &success);
+			//let a time based flush policy see the bus frames go by
+			if(got == 0) dcd_virtual_sof();
+		}
+		else
+		{
+			if(sent < frame_count)
+			{
+				uint16_t length = BuildNTB(sent, frame_count - sent, frame_size, sequence);
+				uint32_t count = dcd_virtual_edpt_out(ep_out, host_buffer, length);
+				if(count == length)
+				{
+					//a short packet ends the NTB, unless it fills the receive buffer
+					if(length % CFG_TUD_NET_ENDPOINT_SIZE == 0 && length < CFG_TUD_NCM_OUT_NTB_MAX_SIZE) dcd_virtual_edpt_out(ep_out, nullptr, 0);
+					sent += (tu_le16toh(tu_unaligned_read16(&host_buffer[16])) - 12) / 4;
+					sequence++;
+				}
+				else if(count != 0) success = false;
+			}
+			//hand the device one datagram at a time, the last renew queues the next NTB transfer
+			while(ncm_recv_pending)
+			{
+				ncm_recv_pending = false;
+				tud_network_recv_renew();
+			}
+			got = ncm_received - received;
+			received = ncm_received;
+			if(!ncm_recv_valid) success = false;
+		}
+		stalls = (got == 0) ? stalls + 1 : 0;
+	}
+	Result result = FinishMeasurement(measurement, (uint64_t)received * frame_size, success && received == frame_count);
+	result.frames = received;
+	result.frames_per_s = (result.elapsed_ns != 0) ? (double)received * 1e9 / (double)result.elapsed_ns : 0;
+	return result;
+}
+
+//tinyUSB network callbacks
+const uint8_t tud_network_mac_address[6] = {0x02, 0x02, 0x84, 0x6A, 0x96, 0x00};
+
+bool tud_network_recv_cb(const uint8_t * src, uint16_t size)
+{
+	if(size != ncm_frame_size || !CheckPattern(src, size, ncm_received)) ncm_recv_valid = false;
+	ncm_received++;
+	ncm_recv_pending = true;
+	return true;
+}
+
+uint16_t tud_network_xmit_cb(uint8_t * dst, void * ref, uint16_t arg)
+{
+	//ref is the frame, arg its size
+	memcpy(dst, ref, arg);
+	return arg;
+}
+#endif
+
+void USBBenchmark::PrintConfig(void)
+{
+	printf("speed %s, task queue %u events\n", (tud_speed_get() == TUSB_SPEED_HIGH) ? "high" : "full", (unsigned)CFG_TUD_TASK_QUEUE_SZ);
+	printf("CDC rx %u, tx %u, ep %u bytes\n", (unsigned)CFG_TUD_CDC_RX_BUFSIZE, (unsigned)CFG_TUD_CDC_TX_BUFSIZE, (unsigned)CFG_TUD_CDC_EP_BUFSIZE);
+	#if CFG_TUD_MSC
+	printf("MSC ep %u bytes\n", (unsigned)CFG_TUD_MSC_EP_BUFSIZE);
+	#endif
+	#if CFG_TUD_VENDOR
+	printf("vendor rx %u, tx %u, ep %u bytes\n", (unsigned)CFG_TUD_VENDOR_RX_BUFSIZE, (unsigned)CFG_TUD_VENDOR_TX_BUFSIZE, (unsigned)CFG_TUD_VENDOR_EPSIZE);
+	#endif
+	#if CFG_TUD_NCM
+	printf("NCM ntb in %u, out %u bytes, %u datagrams per ntb\n", (unsigned)CFG_TUD_NCM_IN_NTB_MAX_SIZE, (unsigned)CFG_TUD_NCM_OUT_NTB_MAX_SIZE, (unsigned)CFG_TUD_NCM_MAX_DATAGRAMS_PER_NTB);
+	#endif
+}
+
+void USBBenchmark::PrintResult(const char * name, const Result & result)
+{
+	printf("%-20s %10.2f MB/s %12.0f xfer/s %8.2f cycles/B %10llu bytes %8lu xfers %3u queue %s", name, result.mb_per_s, result.transfers_per_s, result.cycles_per_byte,
+		(unsigned long long)result.bytes, (unsigned long)result.transfers, (unsigned)result.max_queue_depth, result.queue_overflows ? "OVERFLOW" : (result.success ? "ok" : "FAILED"));
+	if(result.frames != 0) printf(" %12.0f frames/s", result.frames_per_s);
+	printf("\n");
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Name				:	usb_benchmark.h
+ * Created			:	10/19/2026 3:12:40 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Throughput benchmarks for the tinyUSB class drivers, run against the virtual device controller on host (Linux/PC) builds.
+ */
+
+
+#ifndef __USB_BENCHMARK_H__
+#define __USB_BENCHMARK_H__
+
+#include "tusb.h"
+#include "serial_usb/usb_disk.h"
+
+#if CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+//size of the USBDisk::NullDisk used when no block device is attached to LUN 0
+#define USB_BENCHMARK_BLOCK_SIZE	512
+#define USB_BENCHMARK_BLOCK_COUNT	0x10000
+//number of blocks of the RAM disk used by asynchronous %MSC runs
+#define USB_BENCHMARK_ASYNC_BLOCKS	128
+
+/*!
+ * \brief %USB benchmark global namespace.
+	 *
+ * These benchmarks push sustained traffic through the unmodified tinyUSB stack and class drivers using the virtual device controller (refer to dcd_virtual.h).
+ * Both the device side (class driver API) and the host side (virtual host) run in the calling thread, so the results measure the CPU cost of the stack
+ * per byte and per transfer, which is what sets the ceiling on a real chip. Use them to size CFG_TUD_CDC_TX_BUFSIZE, CFG_TUD_MSC_EP_BUFSIZE, etc.
+ * by rebuilding with different values (all buffer sizes in tusb_config.h can be overridden from the build).\n
+ * %MSC, vendor and %NCM benchmarks require CFG_TUD_MSC/CFG_TUD_VENDOR/CFG_TUD_NCM to be set to 1 in the build, usb_descriptors.c adds their interfaces automatically.
+ */
+namespace USBBenchmark
+{
+	/*!
+	 * \brief Direction of benchmark traffic, named from the device's point of view.
+	 */
+	enum class Direction {
+		DeviceToHost,						//!< Device writes (IN endpoint), e.g. tud_cdc_n_write() or %MSC READ10
+		HostToDevice						//!< Device reads (OUT endpoint), e.g. tud_cdc_n_read() or %MSC WRITE10
+	};
+	/*!
+	 * \brief Results of a single benchmark run.
+	 */
+	struct Result {
+		uint64_t bytes;						//!< Number of payload bytes moved
+		uint32_t transfers;					//!< Number of device transfers completed (dcd_edpt_xfer() calls), including protocol overhead such as %MSC CBW/CSW
+		uint32_t packets;					//!< Number of packets moved on the bus
+		uint64_t elapsed_ns;				//!< Wall time of the run in nanoseconds
+		uint64_t cycles;					//!< CPU cycles of the run (0 if the host has no cycle counter)
+		double mb_per_s;					//!< Throughput in MB/s (10^6 bytes per second)
+		double transfers_per_s;				//!< Transfers completed per second
+		double cycles_per_byte;				//!< CPU cycles per payload byte (0 if the host has no cycle counter)
+		uint32_t frames;					//!< Number of network frames (datagrams) moved, %NCM benchmarks only
+		double frames_per_s;				//!< Network frames moved per second, %NCM benchmarks only
+		uint16_t max_queue_depth;			//!< Most events waiting in the usbd event queue at once (refer to tud_event_stats_get())
+		uint32_t queue_overflows;			//!< Number of events dropped because the usbd event queue was full
+		bool success;						//!< True if all bytes were moved and verified
+	};
+	/*!
+	 * \brief Initializes the device stack (if needed) and enumerates the device on the virtual host.
+	 *
+	 * Also sets DTR on every CDC port, like a terminal program opening the port. Must be called before any benchmark.
+	 *
+	 * \return success of enumeration
+	 */
+	bool Enumerate(void);
+	/*!
+	 * \brief Benchmarks a CDC port with tud_cdc_n_write()/tud_cdc_n_read().
+	 *
+	 * \note The port must not be owned by a SerialUSB::USBController in event mode, since it would drain the receive FIFO from the tinyUSB callbacks.
+	 * \param itf index of CDC port
+	 * \param direction direction of traffic
+	 * \param total_bytes number of bytes to move
+	 * \param chunk_size number of bytes passed to each tud_cdc_n_write()/tud_cdc_n_read() call
+	 * \return benchmark results
+	 */
+	Result RunCDC(uint8_t itf, Direction direction, uint32_t total_bytes, uint32_t chunk_size);
+	#if CFG_TUD_VENDOR
+	/*!
+	 * \brief Benchmarks a vendor interface with tud_vendor_n_write()/tud_vendor_n_read().
+	 *
+	 * \param itf index of vendor interface
+	 * \param direction direction of traffic
+	 * \param total_bytes number of bytes to move
+	 * \param chunk_size number of bytes passed to each tud_vendor_n_write()/tud_vendor_n_read() call
+	 * \return benchmark results
+	 */
+	Result RunVendor(uint8_t itf, Direction direction, uint32_t total_bytes, uint32_t chunk_size);
+	#endif
+	#if CFG_TUD_MSC
+	/*!
+	 * \brief Benchmarks the %MSC bulk-only transport with READ10 (DeviceToHost) or WRITE10 (HostToDevice) commands.
+	 *
+	 * Each command goes through CBW, data and CSW stages, so this exercises proc_read10_cmd()/proc_write10_cmd() in msc_device.c.
+	 * Uses the block device attached to LUN 0 (refer to USBDisk::Attach()), e.g. a USBDisk::RAMDisk, a USBDisk::ImageDisk or a USBDisk::SectorCache in front of one to profile the whole
+	 * path. If none is attached, a USBDisk::NullDisk which does no work is attached, so the result is the cost of the stack alone.
+	 *
+	 * WRITE10 fills every block with the verification pattern starting at its LBA, and READ10 checks the data against it (except with the NullDisk),
+	 * so run HostToDevice over the same blocks before DeviceToHost. Commands wrap around to LBA 0 at the end of the device.\n
+	 * With async set, LUN 0 is switched to an internal RAM disk of USB_BENCHMARK_ASYNC_BLOCKS blocks for the run, which returns TUD_MSC_RET_ASYNC from every read and write and completes it
+	 * later with tud_msc_async_io_done_seq(), moving only part of the request or reporting not ready now and then. Each completion is preceded by one tagged with the previous
+	 * command's sequence number, and the run fails if the stack accepts it.
+	 *
+	 * \param total_bytes number of bytes to move (rounded down to whole blocks)
+	 * \param blocks_per_command number of blocks per READ10/WRITE10 command
+	 * \param async complete storage I/O asynchronously (default = false)
+	 * \return benchmark results
+	 */
+	Result RunMSC(Direction direction, uint32_t total_bytes, uint16_t blocks_per_command, bool async = false);
+	#endif
+	#if CFG_TUD_NCM
+	/*!
+	 * \brief Benchmarks the %NCM network interface with fixed size frames, reporting frames per second.
+	 *
+	 * DeviceToHost frames are sent with tud_network_xmit() (copied by tud_network_xmit_cb()) or with tud_network_xmit_reserve()/tud_network_xmit_commit() (zero-copy), aggregated into NTBs
+	 * according to the flush policy set with tud_network_ncm_flush_policy(). The virtual host reads one NTB whenever the device stops accepting frames, and sends SOFs while the device holds
+	 * back a partly filled NTB, so timed flushes are exercised too.\n
+	 * HostToDevice the virtual host packs as many frames as fit into each NTB and the frames are received with tud_network_recv_cb().\n
+	 * Small frames are the worst case, since the per frame cost of the stack dominates. This file implements the tinyUSB network callbacks in %NCM builds.
+	 *
+	 * \param direction direction of traffic
+	 * \param frame_count number of frames to move
+	 * \param frame_size size of each frame in bytes, up to CFG_TUD_NET_MTU
+	 * \param zero_copy use tud_network_xmit_reserve()/tud_network_xmit_commit() instead of tud_network_xmit() (DeviceToHost only, default = false)
+	 * \return benchmark results
+	 */
+	Result RunNCM(Direction direction, uint32_t frame_count, uint16_t frame_size, bool zero_copy = false);
+	#endif
+	/*!
+	 * \brief Prints the buffer configuration the stack was built with.
+	 */
+	void PrintConfig(void);
+	/*!
+	 * \brief Prints one line of benchmark results.
+	 *
+	 * \param name name of benchmark run
+	 * \param result results to print
+	 */
+	void PrintResult(const char * name, const Result & result);
+}
+
+#endif
+
+#endif //__USB_BENCHMARK_H__
@@ -0,0 +1,248 @@
+/*
+ * Name				:	usb_disk.cpp
+ * Created			:	10/19/2026 5:20:14 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Block device backends (RAM disk, disk image file, LRU sector cache) for the tinyUSB MSC device class.
+ */
+
+
+#include "serial_usb/usb_disk.h"
+
+#if (SERCOM_MCU_OPT == OPT_SERCOM_HOST)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	USBDisk::BlockDevice * lun_devices[USB_DISK_MAX_LUN];
+}
+
+bool USBDisk::Attach(uint8_t lun, BlockDevice * device)
+{
+	if(lun >= USB_DISK_MAX_LUN) return false;
+	lun_devices[lun] = device;
+	return true;
+}
+
+USBDisk::BlockDevice * USBDisk::GetDevice(uint8_t lun)
+{
+	return (lun < USB_DISK_MAX_LUN) ? lun_devices[lun] : nullptr;
+}
+
+//Definition of RAMDisk Class
+int32_t USBDisk::RAMDisk::Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size)
+{
+	uint64_t address;
+	if(mem == nullptr || !GetAddress(lba, offset, size, &address)) return -1;
+	memcpy(buffer, &mem[address], size);
+	return (int32_t)size;
+}
+
+int32_t USBDisk::RAMDisk::Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size)
+{
+	uint64_t address;
+	if(mem == nullptr || !writable || !GetAddress(lba, offset, size, &address)) return -1;
+	memcpy(&mem[address], buffer, size);
+	return (int32_t)size;
+}
+
+const void * USBDisk::RAMDisk::Map(uint32_t lba, uint32_t offset, uint32_t * size)
+{
+	uint64_t address;
+	if(mem == nullptr || !GetAddress(lba, offset, *size, &address)) return nullptr;
+	//the SAMD21 USB descriptor ADDR needs a word aligned buffer, copy through the class buffer otherwise
+	if(((uintptr_t)&mem[address] & 0x03) != 0) return nullptr;
+	return &mem[address];
+}
+
+#if (SERCOM_MCU_OPT == OPT_SERCOM_HOST)
+//Definition of ImageDisk Class
+USBDisk::ImageDisk::ImageDisk(void)
+{
+	mem = nullptr;
+	mem_size = 0;
+	fd = -1;
+	block_count = 0;
+	block_size = 512;
+	writable = false;
+}
+
+USBDisk::ImageDisk::~ImageDisk(void)
+{
+	Close();
+}
+
+bool USBDisk::ImageDisk::Open(const char * path, uint16_t block_size, uint32_t block_count, bool writable)
+{
+	Close();
+	if(block_size == 0) return false;
+
+	fd = open(path, writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+	if(fd < 0) return false;
+	struct stat info;
+	if(block_count != 0 && ftruncate(fd, (off_t)block_count * block_size) != 0)
+	{
+		Close();
+		return false;
+	}
+	if(fstat(fd, &info) != 0 || info.st_size < block_size)
+	{
+		Close();
+		return false;
+	}
+
+	//trailing partial block is not used
+	uint64_t size = (uint64_t)info.st_size / block_size * block_size;
+	void * map = mmap(nullptr, (size_t)size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	//MSC mostly streams long runs of blocks
+	madvise(map, (size_t)size, MADV_SEQUENTIAL);
+
+	mem = (uint8_t *)map;
+	mem_size = size;
+	this->block_size = block_size;
+	this->block_count = (uint32_t)(size / block_size);
+	this->writable = writable;
+	return true;
+}
+
+void USBDisk::ImageDisk::Close(void)
+{
+	if(mem != nullptr)
+	{
+		Sync();
+		munmap(mem, (size_t)mem_size);
+	}
+	if(fd >= 0) close(fd);
+	mem = nullptr;
+	mem_size = 0;
+	fd = -1;
+	block_count = 0;
+	writable = false;
+}
+
+int32_t USBDisk::ImageDisk::Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size)
+{
+	uint64_t address;
+	if(mem == nullptr || !GetAddress(lba, offset, size, &address)) return -1;
+	memcpy(buffer, &mem[address], size);
+	return (int32_t)size;
+}
+
+int32_t USBDisk::ImageDisk::Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size)
+{
+	uint64_t address;
+	if(mem == nullptr || !writable || !GetAddress(lba, offset, size, &address)) return -1;
+	memcpy(&mem[address], buffer, size);
+	return (int32_t)size;
+}
+
+const void * USBDisk::ImageDisk::Map(uint32_t lba, uint32_t offset, uint32_t * size)
+{
+	uint64_t address;
+	if(mem == nullptr || !GetAddress(lba, offset, *size, &address)) return nullptr;
+	return &mem[address];
+}
+
+bool USBDisk::ImageDisk::Sync(void)
+{
+	if(mem == nullptr) return false;
+	return !writable || msync(mem, (size_t)mem_size, MS_SYNC) == 0;
+}
+#endif
+
+#if CFG_TUD_MSC && USB_DISK_MSC_CALLBACKS
+//tinyUSB MSC callbacks
+uint8_t tud_msc_get_maxlun_cb(void)
+{
+	uint8_t count = 1;
+	for(uint8_t lun = 0; lun < USB_DISK_MAX_LUN; lun++)
+	{
+		if(lun_devices[lun] != nullptr) count = lun + 1;
+	}
+	return count;
+}
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4])
+{
+	(void) lun;
+	memcpy(vendor_id, "TinyUSB ", 8);
+	memcpy(product_id, "USB Disk        ", 16);
+	memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun)
+{
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	if(device == nullptr || device->BlockCount() == 0)
+	{
+		//medium not present
+		tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+		return false;
+	}
+	return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t * block_count, uint16_t * block_size)
+{
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	*block_count = (device != nullptr) ? device->BlockCount() : 0;
+	*block_size = (device != nullptr) ? device->BlockSize() : 512;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun)
+{
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	return device != nullptr && device->IsWritable();
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject)
+{
+	(void) power_condition;
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	//write back cached data when the host ejects the medium
+	if(device != nullptr && load_eject && !start) return device->Sync();
+	return true;
+}
+
+int32_t tud_msc_read10_direct_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint32_t bufsize, void const ** data)
+{
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	if(device == nullptr) return 0;
+	*data = device->Map(lba, offset, &bufsize);
+	return (*data != nullptr) ? (int32_t)bufsize : 0;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void * buffer, uint32_t bufsize)
+{
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	return (device != nullptr) ? device->Read(lba, offset, buffer, bufsize) : -1;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t * buffer, uint32_t bufsize)
+{
+	USBDisk::BlockDevice * device = USBDisk::GetDevice(lun);
+	return (device != nullptr) ? device->Write(lba, offset, buffer, bufsize) : -1;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void * buffer, uint16_t bufsize)
+{
+	(void) buffer; (void) bufsize;
+	switch(scsi_cmd[0])
+	{
+		case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+			//the medium can always be removed, nothing to do
+			return 0;
+		default:
+			tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+			return -1;
+	}
+}
+#endif
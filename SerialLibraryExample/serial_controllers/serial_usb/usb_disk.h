@@ -0,0 +1,486 @@
+/*
+ * Name				:	usb_disk.h
+ * Created			:	10/19/2026 5:20:14 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Block device backends (RAM disk, disk image file, LRU sector cache) for the tinyUSB MSC device class.
+ */
+
+
+#ifndef __USB_DISK_H__
+#define __USB_DISK_H__
+
+#include "tusb.h"
+#include <string.h>
+
+//set to 0 if the application implements the tinyUSB MSC callbacks itself
+#ifndef USB_DISK_MSC_CALLBACKS
+#define USB_DISK_MSC_CALLBACKS	1
+#endif
+//number of logical units which can have a block device attached
+#ifndef USB_DISK_MAX_LUN
+#define USB_DISK_MAX_LUN		2
+#endif
+
+/*!
+ * \brief %USB Disk global namespace.
+ *
+ * This namespace contains block devices for the tinyUSB %MSC device class and the tinyUSB %MSC callbacks routing SCSI commands to them. Attach a device to a logical unit with Attach() and the
+ * host sees it as a disk.\n
+ * All devices follow the tinyUSB read/write callback convention: they return the number of bytes moved (may be less than requested, the rest is requested again), 0 if the storage is not
+ * ready yet, or a negative value on error (the command fails and the host retries or reports the error).
+ */
+namespace USBDisk
+{
+	/*!
+	 * \brief Abstract block device.
+	 *
+	 * Addresses are given as a block number plus a byte offset into that block, like the tinyUSB %MSC callbacks, so a transfer may start and end mid block when CFG_TUD_MSC_EP_BUFSIZE is smaller
+	 * than the block size.
+	 */
+	class BlockDevice
+	{
+		//functions
+		public:
+		/*!
+		 * \brief Destructor
+		 */
+		virtual ~BlockDevice(void) {}
+		/*!
+		 * \brief Gets the number of blocks on the device.
+		 *
+		 * \return number of blocks, 0 if there is no medium
+		 */
+		virtual uint32_t BlockCount(void) const = 0;
+		/*!
+		 * \brief Gets the block size of the device.
+		 *
+		 * \return block size in bytes
+		 */
+		virtual uint16_t BlockSize(void) const = 0;
+		/*!
+		 * \brief Reads from the device.
+		 *
+		 * \param lba block address
+		 * \param offset byte offset into block
+		 * \param buffer destination buffer
+		 * \param size number of bytes to read
+		 * \return number of bytes read, 0 if not ready, negative on error
+		 * \sa Map()
+		 */
+		virtual int32_t Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size) = 0;
+		/*!
+		 * \brief Writes to the device.
+		 *
+		 * \param lba block address
+		 * \param offset byte offset into block
+		 * \param buffer source buffer
+		 * \param size number of bytes to write
+		 * \return number of bytes written, 0 if not ready, negative on error
+		 * \sa Sync()
+		 */
+		virtual int32_t Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size) = 0;
+		/*!
+		 * \brief Gets a direct pointer to device contents for zero-copy reads.
+		 *
+		 * Devices which hold their contents in memory return a pointer into it, which the %MSC class sends without copying it into its own buffer (refer to tud_msc_read10_direct_cb()).
+		 * The memory must stay valid until the read command completes, and the pointer must be 4-byte aligned since the SAMD21 %USB controller only transfers from word aligned addresses.
+		 *
+		 * \param lba block address
+		 * \param offset byte offset into block
+		 * \param size number of bytes wanted, set to the number of bytes available at the returned pointer
+		 * \return pointer to contents, nullptr if the device can't be read directly (default) or the address isn't aligned
+		 * \sa Read()
+		 */
+		virtual const void * Map(uint32_t lba, uint32_t offset, uint32_t * size) { (void) lba; (void) offset; (void) size; return nullptr; }
+		/*!
+		 * \brief Writes any cached data to the storage medium.
+		 *
+		 * Called when the host ejects the medium.
+		 *
+		 * \return success of write
+		 */
+		virtual bool Sync(void) { return true; }
+		/*!
+		 * \brief Checks if the device accepts writes.
+		 *
+		 * \return true if writable (default)
+		 */
+		virtual bool IsWritable(void) const { return true; }
+
+		protected:
+		/*!
+		 * \brief Checks a request against the device size and converts it to a byte address.
+		 *
+		 * \param lba block address
+		 * \param offset byte offset into block
+		 * \param size number of bytes requested
+		 * \param address pointer to the byte address
+		 * \return true if the whole request is on the device
+		 */
+		bool GetAddress(uint32_t lba, uint32_t offset, uint32_t size, uint64_t * address) const
+		{
+			*address = (uint64_t)lba * BlockSize() + offset;
+			return *address + size <= (uint64_t)BlockCount() * BlockSize();
+		}
+	};
+	/*!
+	 * \brief Block device which stores nothing.
+	 *
+	 * Reads leave the buffer untouched and writes are discarded, so %MSC transfers only cost the stack itself. Used by the %USB benchmarks.
+	 */
+	class NullDisk : public BlockDevice
+	{
+		//functions
+		public:
+		/*!
+		 * \brief Constructor
+		 *
+		 * \param block_count number of blocks reported to the host
+		 * \param block_size block size in bytes (default = 512)
+		 */
+		NullDisk(uint32_t block_count, uint16_t block_size = 512) : block_count(block_count), block_size(block_size) {}
+		uint32_t BlockCount(void) const override { return block_count; }
+		uint16_t BlockSize(void) const override { return block_size; }
+		int32_t Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size) override { (void) lba; (void) offset; (void) buffer; return (int32_t)size; }
+		int32_t Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size) override { (void) lba; (void) offset; (void) buffer; return (int32_t)size; }
+
+		private:
+		//private data members
+		uint32_t block_count;
+		uint16_t block_size;
+	};
+	/*!
+	 * \brief Block device stored in a memory array.
+	 *
+	 * Works on target and host builds. Reads are zero-copy (refer to Map()), so the memory must be readable by the %USB controller and should be 4-byte aligned,
+	 * reads at unaligned addresses are copied through the %MSC class buffer instead.
+	 */
+	class RAMDisk : public BlockDevice
+	{
+		//functions
+		public:
+		/*!
+		 * \brief Constructor
+		 *
+		 * \param mem array holding the disk contents, at least block_count * block_size bytes
+		 * \param block_count number of blocks
+		 * \param block_size block size in bytes (default = 512)
+		 * \param writable allow the host to write (default = true)
+		 */
+		RAMDisk(uint8_t * mem, uint32_t block_count, uint16_t block_size = 512, bool writable = true) : mem(mem), block_count(block_count), block_size(block_size), writable(writable) {}
+		uint32_t BlockCount(void) const override { return (mem != nullptr) ? block_count : 0; }
+		uint16_t BlockSize(void) const override { return block_size; }
+		int32_t Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size) override;
+		int32_t Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size) override;
+		const void * Map(uint32_t lba, uint32_t offset, uint32_t * size) override;
+		bool IsWritable(void) const override { return writable; }
+
+		private:
+		//private data members
+		uint8_t * mem;
+		uint32_t block_count;
+		uint16_t block_size;
+		bool writable;
+	};
+	#if (SERCOM_MCU_OPT == OPT_SERCOM_HOST)
+	/*!
+	 * \brief Block device stored in a disk image file (host builds only).
+	 *
+	 * The file is memory mapped, so reads are zero-copy from the page cache (refer to Map()) and writes go to the file through the page cache. Sync() flushes them to the file.
+	 */
+	class ImageDisk : public BlockDevice
+	{
+		//functions
+		public:
+		/*!
+		 * \brief Constructor
+		 *
+		 * Instantiates an image disk with no file, call Open() before attaching it.
+		 */
+		ImageDisk(void);
+		/*!
+		 * \brief Destructor
+		 *
+		 * Closes the image file.
+		 */
+		~ImageDisk(void) override;
+		/*!
+		 * \brief Opens and maps a disk image file.
+		 *
+		 * \param path path of image file
+		 * \param block_size block size in bytes (default = 512)
+		 * \param block_count if not zero, the file is created or resized to this number of blocks (default = 0)
+		 * \param writable map the file for writing (default = true)
+		 * \return success of opening and mapping the file
+		 * \sa Close()
+		 */
+		bool Open(const char * path, uint16_t block_size = 512, uint32_t block_count = 0, bool writable = true);
+		/*!
+		 * \brief Writes back and closes the image file.
+		 *
+		 * \sa Open()
+		 */
+		void Close(void);
+		uint32_t BlockCount(void) const override { return block_count; }
+		uint16_t BlockSize(void) const override { return block_size; }
+		int32_t Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size) override;
+		int32_t Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size) override;
+		const void * Map(uint32_t lba, uint32_t offset, uint32_t * size) override;
+		bool Sync(void) override;
+		bool IsWritable(void) const override { return writable; }
+
+		private:
+		//private data members
+		uint8_t * mem;
+		uint64_t mem_size;
+		int fd;
+		uint32_t block_count;
+		uint16_t block_size;
+		bool writable;
+	};
+	#endif
+	/*!
+	 * \brief Statistics of a SectorCache.
+	 */
+	struct CacheStats {
+		uint32_t hits;							//!< Blocks found in the cache
+		uint32_t misses;						//!< Blocks read from the backing device into the cache
+		uint32_t write_allocs;					//!< Blocks fully overwritten without reading the backing device
+		uint32_t writebacks;					//!< Dirty blocks written to the backing device
+	};
+	/*!
+	 * \brief LRU sector cache template.
+	 *
+	 * Caches the blocks of a slow backing device (e.g. SPI flash) in LINES lines of SECTOR_SIZE bytes, evicting the least recently used line. Writes are cached too (write-back) and only reach the
+	 * backing device when a dirty line is evicted or on Sync(), so repeated writes to the same blocks (e.g. the FAT and directory entries) cost one backing write. Use write-through mode if the
+	 * device may lose power without the host ejecting it.\n
+	 * The backing device block size must not be larger than SECTOR_SIZE. The cache itself is synchronous: a backing device returning 0 (not ready) makes the cache return 0 too, and the request is
+	 * repeated later.
+	 */
+	template <uint8_t LINES, uint16_t SECTOR_SIZE = 512> class SectorCache : public BlockDevice
+	{
+		//functions
+		public:
+		/*!
+		 * \brief Constructor
+		 *
+		 * \param backing_device device to cache (default = nullptr)
+		 * \param write_through write every block to the backing device immediately (default = false)
+		 * \sa Attach()
+		 */
+		SectorCache(BlockDevice * backing_device = nullptr, bool write_through = false)
+		{
+			Attach(backing_device, write_through);
+		}
+		/*!
+		 * \brief Changes the backing device and empties the cache.
+		 *
+		 * Call Sync() first if the previous device has dirty blocks.
+		 *
+		 * \param backing_device device to cache
+		 * \param write_through write every block to the backing device immediately
+		 * \return false if the device block size is larger than SECTOR_SIZE
+		 */
+		bool Attach(BlockDevice * backing_device, bool write_through = false)
+		{
+			backing = backing_device;
+			through = write_through;
+			Invalidate();
+			ResetStats();
+			return backing == nullptr || backing->BlockSize() <= SECTOR_SIZE;
+		}
+		/*!
+		 * \brief Drops all cached blocks, including unwritten ones.
+		 */
+		void Invalidate(void)
+		{
+			for(uint8_t i = 0; i < LINES; i++)
+			{
+				lines[i].valid = false;
+				lines[i].dirty = false;
+				lines[i].last_use = 0;
+			}
+			use_count = 0;
+		}
+		/*!
+		 * \brief Gets the cache statistics.
+		 *
+		 * \return statistics since the last ResetStats()
+		 */
+		const CacheStats & GetStats(void) const { return stats; }
+		/*!
+		 * \brief Resets the cache statistics.
+		 */
+		void ResetStats(void) { memset(&stats, 0, sizeof(stats)); }
+		uint32_t BlockCount(void) const override { return Usable() ? backing->BlockCount() : 0; }
+		uint16_t BlockSize(void) const override { return (backing != nullptr) ? backing->BlockSize() : SECTOR_SIZE; }
+		bool IsWritable(void) const override { return Usable() && backing->IsWritable(); }
+		int32_t Read(uint32_t lba, uint32_t offset, void * buffer, uint32_t size) override
+		{
+			uint64_t address;
+			if(!Usable() || !GetAddress(lba, offset, size, &address)) return -1;
+			return Access(lba, offset, (uint8_t *)buffer, size, false);
+		}
+		int32_t Write(uint32_t lba, uint32_t offset, const uint8_t * buffer, uint32_t size) override
+		{
+			uint64_t address;
+			if(!Usable() || !GetAddress(lba, offset, size, &address)) return -1;
+			return Access(lba, offset, (uint8_t *)buffer, size, true);
+		}
+		bool Sync(void) override
+		{
+			if(backing == nullptr) return false;
+			for(uint8_t i = 0; i < LINES; i++)
+			{
+				if(lines[i].dirty && WriteBack(&lines[i]) <= 0) return false;
+			}
+			return backing->Sync();
+		}
+
+		private:
+		struct Line {
+			uint8_t data[SECTOR_SIZE];
+			uint32_t lba;
+			uint32_t last_use;
+			bool valid;
+			bool dirty;
+		};
+		//private helper functions
+		bool Usable(void) const
+		{
+			return backing != nullptr && backing->BlockSize() <= SECTOR_SIZE;
+		}
+		//moves whole or partial blocks between buffer and cache lines, returns bytes done or the first backing device failure
+		int32_t Access(uint32_t lba, uint32_t offset, uint8_t * buffer, uint32_t size, bool write)
+		{
+			const uint16_t block_size = backing->BlockSize();
+			uint32_t done = 0;
+			lba += offset / block_size;
+			offset %= block_size;
+			while(done < size)
+			{
+				uint32_t length = tu_min32(size - done, block_size - offset);
+				Line * line = Find(lba);
+				if(line != nullptr)
+				{
+					stats.hits++;
+				}
+				else
+				{
+					//full block writes don't need the old contents
+					int32_t result = Fill(lba, write && length == block_size, &line);
+					if(result <= 0) return (done != 0) ? (int32_t)done : result;
+				}
+				line->last_use = ++use_count;
+				if(write)
+				{
+					memcpy(&line->data[offset], &buffer[done], length);
+					line->dirty = true;
+					if(through)
+					{
+						int32_t result = WriteBack(line);
+						if(result <= 0) return (done != 0) ? (int32_t)done : result;
+					}
+				}
+				else
+				{
+					memcpy(&buffer[done], &line->data[offset], length);
+				}
+				done += length;
+				offset = 0;
+				lba++;
+			}
+			return (int32_t)done;
+		}
+		Line * Find(uint32_t lba)
+		{
+			for(uint8_t i = 0; i < LINES; i++)
+			{
+				if(lines[i].valid && lines[i].lba == lba) return &lines[i];
+			}
+			return nullptr;
+		}
+		//loads a block into the least recently used line, writing it back first if dirty
+		int32_t Fill(uint32_t lba, bool overwrite, Line ** line)
+		{
+			Line * victim = &lines[0];
+			for(uint8_t i = 0; i < LINES && victim->valid; i++)
+			{
+				if(!lines[i].valid || lines[i].last_use < victim->last_use) victim = &lines[i];
+			}
+			if(victim->valid && victim->dirty)
+			{
+				int32_t result = WriteBack(victim);
+				if(result <= 0) return result;
+			}
+			victim->valid = false;
+			if(overwrite)
+			{
+				stats.write_allocs++;
+			}
+			else
+			{
+				int32_t result = Transfer(lba, victim->data, false);
+				if(result <= 0) return result;
+				stats.misses++;
+			}
+			victim->lba = lba;
+			victim->valid = true;
+			victim->dirty = false;
+			*line = victim;
+			return 1;
+		}
+		int32_t WriteBack(Line * line)
+		{
+			int32_t result = Transfer(line->lba, line->data, true);
+			if(result > 0)
+			{
+				line->dirty = false;
+				stats.writebacks++;
+			}
+			return result;
+		}
+		//moves one whole block to or from the backing device, which may take several calls
+		int32_t Transfer(uint32_t lba, uint8_t * data, bool write)
+		{
+			const uint16_t block_size = backing->BlockSize();
+			uint32_t done = 0;
+			while(done < block_size)
+			{
+				int32_t result = write ? backing->Write(lba, done, &data[done], block_size - done) : backing->Read(lba, done, &data[done], block_size - done);
+				if(result <= 0) return result;
+				done += (uint32_t)result;
+			}
+			return (int32_t)done;
+		}
+
+		//private data members
+		Line lines[LINES];
+		BlockDevice * backing;
+		uint32_t use_count;
+		CacheStats stats;
+		bool through;
+	};
+	/*!
+	 * \brief Attaches a block device to a logical unit.
+	 *
+	 * The %MSC interface reports the highest attached unit + 1 as its number of units. A unit with no device reports "medium not present".
+	 *
+	 * \param lun logical unit number, must be less than USB_DISK_MAX_LUN
+	 * \param device block device, nullptr to detach
+	 * \return false if lun is out of range
+	 * \note Only has an effect with USB_DISK_MSC_CALLBACKS, which implements the tinyUSB %MSC callbacks in usb_disk.cpp.
+	 * \sa GetDevice()
+	 */
+	bool Attach(uint8_t lun, BlockDevice * device);
+	/*!
+	 * \brief Gets the block device attached to a logical unit.
+	 *
+	 * \param lun logical unit number
+	 * \return block device, nullptr if none
+	 * \sa Attach()
+	 */
+	BlockDevice * GetDevice(uint8_t lun);
+}
+
+#endif //__USB_DISK_H__
@@ -0,0 +1,353 @@
+/*
+ * Name				:	usb_host_benchmark.cpp
+ * Created			:	10/19/2026 7:58:03 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Multi-device throughput benchmarks for the tinyUSB host stack, run against the virtual host controller on host (Linux/PC) builds.
+ */
+
+
+#include "serial_usb/usb_host_benchmark.h"
+
+#if CFG_TUH_ENABLED && CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+//frames allowed for enumerating all devices, each one takes a little over 500 frames of reset delay in usbh.c
+#define BENCHMARK_ENUMERATE_FRAMES	20000
+//frames allowed for the transfers still running at the end of a run to complete
+#define BENCHMARK_DRAIN_FRAMES		1000
+
+namespace
+{
+	struct Device {
+		hcd_virtual_device_t type;
+		uint8_t address;					//address while mounted, 0 otherwise
+		bool busy;							//transfer submitted and not completed
+		uint8_t seq;						//CDC: next byte of the counter streamed by the device
+		uint32_t lba;						//MSC: first block of the next command
+		uint64_t bytes;
+		uint8_t buffer[USB_HOST_BENCHMARK_MAX_TRANSFER];
+	};
+
+	Device devices[USB_HOST_BENCHMARK_MAX_DEVICES];
+	uint8_t device_count;
+	uint32_t errors;
+
+	//traffic of the running benchmark, completions start the next transfer while running
+	bool running;
+	USBHostBenchmark::Direction run_direction;
+	uint16_t run_size;
+
+	void Start(Device & device);
+
+	Device * FindDevice(uint8_t dev_addr)
+	{
+		for(uint8_t i = 0; i < device_count; i++)
+		{
+			if(devices[i].address == dev_addr && dev_addr != 0) return &devices[i];
+		}
+		return nullptr;
+	}
+
+	//transfers of a device unplugged by a hotplug run fail until the stack closes it, that is not an error
+	bool IsUnplugged(const Device & device)
+	{
+		return hcd_virtual_get_address((uint8_t)(&device - devices + 1)) != device.address;
+	}
+
+	bool IsMounted(const Device & device, uint8_t dev_addr)
+	{
+		if(dev_addr == 0 || !tuh_mounted(dev_addr)) return false;
+		#if CFG_TUH_CDC
+		if(device.type == HCD_VIRTUAL_CDC) return tuh_cdc_serial_is_mounted(dev_addr);
+		#endif
+		#if CFG_TUH_MSC
+		if(device.type == HCD_VIRTUAL_MSC) return tuh_msc_mounted(dev_addr);
+		#endif
+		return false;
+	}
+
+	//follows mounts and unmounts, a device starts over (counter and first block) whenever it is mounted
+	void UpdateDevices(void)
+	{
+		for(uint8_t i = 0; i < device_count; i++)
+		{
+			Device & device = devices[i];
+			uint8_t dev_addr = hcd_virtual_get_address(i + 1);
+			bool mounted = IsMounted(device, dev_addr);
+			if(mounted && device.address == 0)
+			{
+				device.address = dev_addr;
+				device.busy = false;
+				device.seq = 0;
+				device.lba = 0;
+			}
+			else if(!mounted && device.address != 0)
+			{
+				device.address = 0;
+				device.busy = false;
+			}
+		}
+	}
+
+	bool AllMounted(void)
+	{
+		for(uint8_t i = 0; i < device_count; i++)
+		{
+			if(devices[i].address == 0) return false;
+		}
+		return true;
+	}
+
+	bool AnyBusy(void)
+	{
+		for(uint8_t i = 0; i < device_count; i++)
+		{
+			if(devices[i].busy) return true;
+		}
+		return false;
+	}
+
+	#if CFG_TUH_MSC
+	bool MSCComplete(uint8_t dev_addr, const msc_cbw_t * cbw, const msc_csw_t * csw)
+	{
+		Device * device = FindDevice(dev_addr);
+		if(device == nullptr) return true;
+		device->busy = false;
+
+		uint32_t lba = tu_ntohl(tu_unaligned_read32(&cbw->command[2]));
+		uint16_t count = tu_ntohs(tu_unaligned_read16(&cbw->command[7]));
+		if(csw->status != MSC_CSW_STATUS_PASSED || csw->data_residue != 0)
+		{
+			if(!IsUnplugged(*device)) errors++;
+			return true;
+		}
+		//simulated disk reads block lba as (uint8_t)lba in every byte
+		if(cbw->command[0] == SCSI_CMD_READ_10)
+		{
+			for(uint32_t i = 0; i < (uint32_t)count * HCD_VIRTUAL_MSC_BLOCK_SIZE; i++)
+			{
+				if(device->buffer[i] != (uint8_t)(lba + i / HCD_VIRTUAL_MSC_BLOCK_SIZE))
+				{
+					errors++;
+					return true;
+				}
+			}
+		}
+		device->bytes += (uint32_t)count * HCD_VIRTUAL_MSC_BLOCK_SIZE;
+		Start(*device);
+		return true;
+	}
+	#endif
+
+	bool Submit(Device & device, USBHostBenchmark::Direction direction, uint16_t transfer_size)
+	{
+		bool read = (direction == USBHostBenchmark::Direction::Read);
+		#if CFG_TUH_CDC
+		if(device.type == HCD_VIRTUAL_CDC)
+		{
+			if(read) return tuh_cdc_receive(device.address, device.buffer, transfer_size, false);
+			//simulated CDC device checks the host sends a byte counter
+			for(uint16_t i = 0; i < transfer_size; i++) device.buffer[i] = device.seq++;
+			return tuh_cdc_send(device.address, device.buffer, transfer_size, false);
+		}
+		#endif
+		#if CFG_TUH_MSC
+		if(device.type == HCD_VIRTUAL_MSC)
+		{
+			uint16_t count = (uint16_t)(transfer_size / HCD_VIRTUAL_MSC_BLOCK_SIZE);
+			if(count == 0) return false;
+			if(device.lba + count > HCD_VIRTUAL_MSC_BLOCK_COUNT) device.lba = 0;
+			uint32_t lba = device.lba;
+			device.lba += count;
+			if(read) return tuh_msc_read10(device.address, 0, device.buffer, lba, count, MSCComplete);
+			//simulated disk checks block lba is written as (uint8_t)lba in every byte
+			for(uint16_t i = 0; i < count; i++) memset(&device.buffer[(uint32_t)i * HCD_VIRTUAL_MSC_BLOCK_SIZE], (uint8_t)(lba + i), HCD_VIRTUAL_MSC_BLOCK_SIZE);
+			return tuh_msc_write10(device.address, 0, device.buffer, lba, count, MSCComplete);
+		}
+		#endif
+		(void) read;
+		return false;
+	}
+
+	//starts the next transfer of a mounted device which has none running, called from the completion callbacks so every device always has one waiting
+	void Start(Device & device)
+	{
+		if(!running || device.address == 0 || device.busy) return;
+		device.busy = true;
+		if(!Submit(device, run_direction, run_size))
+		{
+			device.busy = false;
+			if(!IsUnplugged(device)) errors++;
+		}
+	}
+
+	//starts devices which have no transfer running, the first one and after a mount
+	void StartAll(void)
+	{
+		for(uint8_t i = 0; i < device_count; i++) Start(devices[i]);
+	}
+}
+
+bool USBHostBenchmark::Enumerate(uint8_t cdc_count, uint8_t msc_count)
+{
+	if(cdc_count + msc_count > USB_HOST_BENCHMARK_MAX_DEVICES || cdc_count + msc_count > CFG_TUH_DEVICE_MAX) return false;
+	if(!CFG_TUH_HUB || (cdc_count != 0 && !CFG_TUH_CDC) || (msc_count != 0 && !CFG_TUH_MSC)) return false;
+	if(!tuh_inited()) tuh_init(TUH_OPT_RHPORT);
+
+	//unplug the previous devices and let the stack close them
+	hcd_virtual_detach(0);
+	tuh_task();
+
+	device_count = (uint8_t)(cdc_count + msc_count);
+	memset(devices, 0, sizeof(devices));
+	if(!hcd_virtual_attach(0, HCD_VIRTUAL_HUB)) return false;
+	for(uint8_t i = 0; i < device_count; i++)
+	{
+		devices[i].type = (i < cdc_count) ? HCD_VIRTUAL_CDC : HCD_VIRTUAL_MSC;
+		if(!hcd_virtual_attach(i + 1, devices[i].type)) return false;
+	}
+
+	for(uint32_t frame = 0; frame < BENCHMARK_ENUMERATE_FRAMES; frame++)
+	{
+		tuh_task();
+		UpdateDevices();
+		if(AllMounted()) return true;
+		hcd_virtual_frame();
+	}
+	return false;
+}
+
+USBHostBenchmark::Result USBHostBenchmark::Run(Direction direction, uint32_t frames, uint16_t transfer_size, bool hotplug)
+{
+	Result result;
+	memset(&result, 0, sizeof(result));
+	transfer_size = (uint16_t)tu_min32(transfer_size, USB_HOST_BENCHMARK_MAX_TRANSFER);
+	bool success = device_count != 0 && AllMounted() && transfer_size != 0;
+	uint8_t hotplug_port = device_count;
+
+	errors = 0;
+	run_direction = direction;
+	run_size = transfer_size;
+	running = true;
+	for(uint8_t i = 0; i < device_count; i++) devices[i].bytes = 0;
+	hcd_virtual_reset_stats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for(uint32_t frame = 0; success && frame < frames; frame++)
+	{
+		if(hotplug && frame == frames / 4) hcd_virtual_detach(hotplug_port);
+		if(hotplug && frame == frames / 2) hcd_virtual_attach(hotplug_port, devices[hotplug_port - 1].type);
+
+		tuh_task();
+		UpdateDevices();
+		StartAll();
+		hcd_virtual_frame();
+	}
+
+	//let the running transfers complete, they are part of the result
+	running = false;
+	for(uint32_t frame = 0; success && AnyBusy() && frame < BENCHMARK_DRAIN_FRAMES; frame++)
+	{
+		hcd_virtual_frame();
+		tuh_task();
+		UpdateDevices();
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	hcd_virtual_stats_t stats;
+	hcd_virtual_get_stats(&stats);
+
+	double sum = 0, sum_squares = 0;
+	result.devices = device_count;
+	for(uint8_t i = 0; i < device_count; i++)
+	{
+		result.device_bytes[i] = devices[i].bytes;
+		result.bytes += devices[i].bytes;
+		sum += (double)devices[i].bytes;
+		sum_squares += (double)devices[i].bytes * (double)devices[i].bytes;
+		if(devices[i].bytes == 0) success = false;
+	}
+	result.fairness = (sum_squares != 0) ? sum * sum / (device_count * sum_squares) : 0;
+	result.transfers = stats.xfer_count;
+	result.packets = stats.packet_count;
+	result.frames = stats.frame_count;
+	result.naks = stats.nak_count;
+	result.max_active = stats.max_active;
+	result.elapsed_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	result.bus_mb_per_s = (result.frames != 0) ? (double)result.bytes / ((double)result.frames / 1e3) / 1e6 : 0;
+	result.mb_per_s = (result.elapsed_ns != 0) ? (double)result.bytes / ((double)result.elapsed_ns / 1e9) / 1e6 : 0;
+	result.success = success && errors == 0 && stats.error_count == 0 && AllMounted() && !AnyBusy();
+	return result;
+}
+
+USBHostBenchmark::FairnessCheck USBHostBenchmark::CheckFairness(Direction direction, uint32_t frames, uint16_t transfer_size, uint8_t channels)
+{
+	FairnessCheck check;
+	memset(&check, 0, sizeof(check));
+	check.channels = channels;
+
+	uint8_t limit = 0;
+	if(!tuh_configure(TUH_OPT_RHPORT, TUH_CFGID_XFER_CHANNELS, &limit)) return check;
+	check.unlimited = Run(direction, frames, transfer_size);
+	limit = channels;
+	tuh_configure(TUH_OPT_RHPORT, TUH_CFGID_XFER_CHANNELS, &limit);
+	check.limited = Run(direction, frames, transfer_size);
+	limit = CFG_TUH_XFER_CHANNELS;
+	tuh_configure(TUH_OPT_RHPORT, TUH_CFGID_XFER_CHANNELS, &limit);
+
+	check.success = check.unlimited.success && check.limited.success && check.limited.fairness >= check.unlimited.fairness;
+	return check;
+}
+
+#if CFG_TUH_CDC
+//tinyUSB CDC host callback
+void tuh_cdc_xfer_isr(uint8_t dev_addr, xfer_result_t event, cdc_pipeid_t pipe_id, uint32_t xferred_bytes)
+{
+	Device * device = FindDevice(dev_addr);
+	if(device == nullptr || pipe_id == CDC_PIPE_NOTIFICATION) return;
+	device->busy = false;
+	if(event != XFER_RESULT_SUCCESS)
+	{
+		if(!IsUnplugged(*device)) errors++;
+		return;
+	}
+	//simulated CDC device streams a byte counter
+	if(pipe_id == CDC_PIPE_DATA_IN)
+	{
+		for(uint32_t i = 0; i < xferred_bytes; i++)
+		{
+			if(device->buffer[i] != device->seq++) errors++;
+		}
+	}
+	device->bytes += xferred_bytes;
+	Start(*device);
+}
+#endif
+
+void USBHostBenchmark::PrintConfig(void)
+{
+	printf("host: full speed, %u hub ports, %u packets per frame, %u devices max\n", (unsigned)HCD_VIRTUAL_HUB_PORTS, (unsigned)HCD_VIRTUAL_PACKETS_PER_FRAME, (unsigned)CFG_TUH_DEVICE_MAX);
+	if(CFG_TUH_XFER_CHANNELS != 0) printf("transfer channels %u\n", (unsigned)CFG_TUH_XFER_CHANNELS);
+	else printf("transfer channels unlimited\n");
+}
+
+void USBHostBenchmark::PrintResult(const char * name, const Result & result)
+{
+	printf("%-20s %8.3f MB/s bus %10.2f MB/s %10llu bytes %8lu xfers %6lu frames %6lu naks %2u active %5.3f fair %s\n", name, result.bus_mb_per_s, result.mb_per_s,
+		(unsigned long long)result.bytes, (unsigned long)result.transfers, (unsigned long)result.frames, (unsigned long)result.naks, (unsigned)result.max_active, result.fairness,
+		result.success ? "ok" : "FAILED");
+	printf("%-20s", "");
+	for(uint8_t i = 0; i < result.devices; i++) printf(" %llu", (unsigned long long)result.device_bytes[i]);
+	printf("\n");
+}
+
+void USBHostBenchmark::PrintFairnessCheck(const char * name, const FairnessCheck & check)
+{
+	printf("%-20s unlimited %5.3f fair %8.3f MB/s bus, %u channels %5.3f fair %8.3f MB/s bus %s\n", name, check.unlimited.fairness, check.unlimited.bus_mb_per_s,
+		(unsigned)check.channels, check.limited.fairness, check.limited.bus_mb_per_s, check.success ? "ok" : "FAILED");
+}
+
+#endif
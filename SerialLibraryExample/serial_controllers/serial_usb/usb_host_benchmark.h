@@ -0,0 +1,129 @@
+/*
+ * Name				:	usb_host_benchmark.h
+ * Created			:	10/19/2026 7:58:03 PM
+ * Author			:	Aaron Reilman
+ * Description		:	Multi-device throughput benchmarks for the tinyUSB host stack, run against the virtual host controller on host (Linux/PC) builds.
+ */
+
+
+#ifndef __USB_HOST_BENCHMARK_H__
+#define __USB_HOST_BENCHMARK_H__
+
+#include "tusb.h"
+
+#if CFG_TUH_ENABLED && CFG_TUSB_MCU == OPT_MCU_VIRTUAL
+
+#include "portable/virtual/hcd_virtual.h"
+
+//most devices behind the simulated hub
+#define USB_HOST_BENCHMARK_MAX_DEVICES		HCD_VIRTUAL_HUB_PORTS
+//largest transfer per device, one buffer of this size per device
+#define USB_HOST_BENCHMARK_MAX_TRANSFER		8192
+
+/*!
+ * \brief %USB host benchmark global namespace.
+ *
+ * These benchmarks keep bulk transfers active on several CDC and %MSC devices behind a hub at once, using the unmodified tinyUSB host stack and class drivers
+ * with the virtual host controller (refer to hcd_virtual.h), which simulates the hub and the devices on a full speed bus in 1 ms frames.
+ * Throughput is reported both in bus time (simulated frames), which shows how well the stack keeps the bus busy and how fairly the devices share it,
+ * and in wall time, which is the CPU cost of the stack.\n
+ * Use them to size CFG_TUH_XFER_CHANNELS, the number of bulk transfers the host controller runs at once (refer to host/usbh.c), and CheckFairness()
+ * to verify the scheduler behind it shares the bus fairly. The build must enable the host port with CFG_TUSB_RHPORT1_MODE = OPT_MODE_HOST.
+ * This file implements tuh_cdc_xfer_isr().
+ */
+namespace USBHostBenchmark
+{
+	/*!
+	 * \brief Direction of benchmark traffic, named from the host's point of view.
+	 */
+	enum class Direction {
+		Read,								//!< Host reads (IN endpoints), tuh_cdc_receive() and %MSC READ10
+		Write								//!< Host writes (OUT endpoints), tuh_cdc_send() and %MSC WRITE10
+	};
+	/*!
+	 * \brief Results of a single benchmark run.
+	 */
+	struct Result {
+		uint64_t bytes;						//!< Number of payload bytes moved and verified, all devices
+		uint32_t transfers;					//!< Number of transfers completed by the host controller, including control stages and %MSC CBW/CSW
+		uint32_t packets;					//!< Number of data packets moved on the bus
+		uint32_t frames;					//!< Number of 1 ms bus frames the run took
+		uint32_t naks;						//!< Number of packets NAKed by the devices
+		uint64_t elapsed_ns;				//!< Wall time of the run in nanoseconds
+		double bus_mb_per_s;				//!< Throughput in MB/s (10^6 bytes per second) of bus time
+		double mb_per_s;					//!< Throughput in MB/s of wall time
+		uint8_t devices;					//!< Number of devices taking part
+		uint64_t device_bytes[USB_HOST_BENCHMARK_MAX_DEVICES];	//!< Payload bytes moved per device, in hub port order
+		double fairness;					//!< Jain's fairness index of device_bytes, 1 when all devices moved the same, 1/devices when one device took everything
+		uint8_t max_active;					//!< Most bulk transfers running in the host controller at once
+		bool success;						//!< True if every device mounted, moved data and all data was verified
+	};
+	/*!
+	 * \brief Results of a fairness check, the same traffic without and with a transfer channel limit.
+	 */
+	struct FairnessCheck {
+		uint8_t channels;					//!< Transfer channel limit of the limited run
+		Result unlimited;					//!< Run without a channel limit
+		Result limited;						//!< Run with the channel limit
+		bool success;						//!< True if both runs succeeded and the limited run is at least as fair as the unlimited one
+	};
+	/*!
+	 * \brief Initializes the host stack (if needed), attaches a hub to the root port with the devices behind it and waits until all are mounted.
+	 *
+	 * CDC devices take the first hub ports, %MSC devices the ports after them. Devices are enumerated one at a time, like any tinyUSB host.
+	 * Must be called before any benchmark, calling it again replaces the devices.
+	 *
+	 * \param cdc_count number of CDC devices
+	 * \param msc_count number of %MSC devices
+	 * \return success of enumeration
+	 */
+	bool Enumerate(uint8_t cdc_count, uint8_t msc_count);
+	/*!
+	 * \brief Runs traffic on all devices for a number of frames, starting the next transfer of a device as soon as its previous one completes.
+	 *
+	 * With hotplug the last device is unplugged a quarter into the run and plugged back in halfway, so it enumerates while the others keep their transfers
+	 * going, and joins the traffic once mounted again.
+	 *
+	 * \param direction direction of traffic
+	 * \param frames number of 1 ms frames to run
+	 * \param transfer_size bytes per transfer, rounded down to whole blocks for %MSC (up to USB_HOST_BENCHMARK_MAX_TRANSFER)
+	 * \param hotplug unplug and replug the last device during the run (default = false)
+	 * \return benchmark results
+	 */
+	Result Run(Direction direction, uint32_t frames, uint16_t transfer_size, bool hotplug = false);
+	/*!
+	 * \brief Checks the transfer scheduler shares the bus between the devices at least as fairly as the host controller does on its own.
+	 *
+	 * Runs the same traffic without a channel limit and with \p channels, set with tuh_configure(TUH_CFGID_XFER_CHANNELS), and compares Jain's fairness
+	 * index of the two runs. Fails if the build has no transfer scheduler (CFG_TUH_XFER_CHANNELS = 0). The limit is set back to CFG_TUH_XFER_CHANNELS after.
+	 *
+	 * \param direction direction of traffic
+	 * \param frames number of 1 ms frames of each run
+	 * \param transfer_size bytes per transfer (refer to Run())
+	 * \param channels transfer channel limit of the limited run
+	 * \return results of both runs
+	 */
+	FairnessCheck CheckFairness(Direction direction, uint32_t frames, uint16_t transfer_size, uint8_t channels);
+	/*!
+	 * \brief Prints the host configuration the stack was built with.
+	 */
+	void PrintConfig(void);
+	/*!
+	 * \brief Prints one line of benchmark results followed by the bytes moved per device.
+	 *
+	 * \param name name of benchmark run
+	 * \param result results to print
+	 */
+	void PrintResult(const char * name, const Result & result);
+	/*!
+	 * \brief Prints the results of a fairness check.
+	 *
+	 * \param name name of the check
+	 * \param check results to print
+	 */
+	void PrintFairnessCheck(const char * name, const FairnessCheck & check);
+}
+
+#endif
+
+#endif //__USB_HOST_BENCHMARK_H__
@@ -70,18 +70,24 @@ bool tusb_inited(void)
 // Internal Helper for both Host and Device stack
 //--------------------------------------------------------------------+
 
+// Endpoint can take another transfer: idle, or ping-pong with its second slot free
+static inline bool _edpt_slot_free(tu_edpt_state_t const* ep_state)
+{
+  return (ep_state->busy == 0) || (ep_state->pingpong && (ep_state->queued == 0));
+}
+
 bool tu_edpt_claim(tu_edpt_state_t* ep_state, osal_mutex_t mutex)
 {
   (void) mutex;
 
 #if TUSB_OPT_MUTEX
   // pre-check to help reducing mutex lock
-  TU_VERIFY((ep_state->busy == 0) && (ep_state->claimed == 0));
+  TU_VERIFY(_edpt_slot_free(ep_state) && (ep_state->claimed == 0));
   osal_mutex_lock(mutex, OSAL_TIMEOUT_WAIT_FOREVER);
 #endif
 
-  // can only claim the endpoint if it is not busy and not claimed yet.
-  bool const available = (ep_state->busy == 0) && (ep_state->claimed == 0);
+  // can only claim the endpoint if it is not busy (or has a free ping-pong slot) and not claimed yet.
+  bool const available = _edpt_slot_free(ep_state) && (ep_state->claimed == 0);
   if (available)
   {
     ep_state->claimed = 1;
@@ -102,8 +108,8 @@ bool tu_edpt_release(tu_edpt_state_t* ep_state, osal_mutex_t mutex)
   osal_mutex_lock(mutex, OSAL_TIMEOUT_WAIT_FOREVER);
 #endif
 
-  // can only release the endpoint if it is claimed and not busy
-  bool const ret = (ep_state->claimed == 1) && (ep_state->busy == 0);
+  // can only release the endpoint if it is claimed and no transfer was queued since
+  bool const ret = (ep_state->claimed == 1) && _edpt_slot_free(ep_state);
   if (ret)
   {
     ep_state->claimed = 0;
@@ -56,6 +56,8 @@
 #include "serial_comm_config.h"
 	#if (SERCOM_MCU_OPT == OPT_SERCOM_SAMD21)
 		#define CFG_TUSB_MCU        OPT_MCU_SAMD21
+	#elif (SERCOM_MCU_OPT == OPT_SERCOM_HOST)
+		#define CFG_TUSB_MCU		OPT_MCU_VIRTUAL
 	#else
 		#define CFG_TUSB_MCU		OPT_MCU_NONE
 		#warning "USB not defined for this MCU!"
@@ -99,19 +101,100 @@
 #define CFG_TUD_ENDPOINT0_SIZE    64
 #endif
 
+// Double buffered (ping-pong) bulk endpoints, usb_descriptors.c gives each of them its own endpoint number.
+// Needs 3 endpoint numbers per CDC port, so at most 2 CDC ports on SAMD21
+// Only tested on the virtual controller (portable/virtual), not yet on SAMD hardware
+#ifndef CFG_TUD_EDPT_PINGPONG
+#define CFG_TUD_EDPT_PINGPONG     0
+#endif
+
+// Depth of the usbd event queue between the controller interrupt and tud_task()
+#ifndef CFG_TUD_TASK_QUEUE_SZ
+#define CFG_TUD_TASK_QUEUE_SZ     16
+#endif
+
 //------------- CLASS -------------//
+// Number of CDC ports, one SerialUSB::USBController per port (max 3, refer to usb_descriptors.c)
+#ifndef CFG_TUD_CDC
 #define CFG_TUD_CDC               1
+#endif
+// Class drivers not used by the serial library, may be enabled from the build (e.g. for the host benchmarks, refer to serial_usb/usb_benchmark.h)
+#ifndef CFG_TUD_MSC
 #define CFG_TUD_MSC               0
+#endif
 #define CFG_TUD_HID               0
 #define CFG_TUD_MIDI              0
+#ifndef CFG_TUD_VENDOR
 #define CFG_TUD_VENDOR            0
+#endif
 
-// CDC FIFO size of TX and RX
-#define CFG_TUD_CDC_RX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
-#define CFG_TUD_CDC_TX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
+// CDC FIFO size of TX and RX, RX has room for both transfers of a ping-pong endpoint
+#ifndef CFG_TUD_CDC_RX_BUFSIZE
+#define CFG_TUD_CDC_RX_BUFSIZE   ((TUD_OPT_HIGH_SPEED ? 512 : 64) * (CFG_TUD_EDPT_PINGPONG ? 2 : 1))
+#endif
+// TX holds two packets so writes can coalesce into the next packet while the previous one is sent
+#ifndef CFG_TUD_CDC_TX_BUFSIZE
+#define CFG_TUD_CDC_TX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 1024 : 128)
+#endif
 
 // CDC Endpoint transfer buffer size, more is faster
+#ifndef CFG_TUD_CDC_EP_BUFSIZE
 #define CFG_TUD_CDC_EP_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
+#endif
+
+// MSC buffer size, one block is the minimum, the more the better
+#ifndef CFG_TUD_MSC_EP_BUFSIZE
+#define CFG_TUD_MSC_EP_BUFSIZE   512
+#endif
+
+// Number of MSC buffers, 2 overlaps disk I/O with USB transfers (refer to msc_device.h)
+#ifndef CFG_TUD_MSC_BUFCOUNT
+#define CFG_TUD_MSC_BUFCOUNT     2
+#endif
+
+// Vendor FIFO size of TX and RX
+#ifndef CFG_TUD_VENDOR_RX_BUFSIZE
+#define CFG_TUD_VENDOR_RX_BUFSIZE ((TUD_OPT_HIGH_SPEED ? 512 : 64) * (CFG_TUD_EDPT_PINGPONG ? 2 : 1))
+#endif
+#ifndef CFG_TUD_VENDOR_TX_BUFSIZE
+#define CFG_TUD_VENDOR_TX_BUFSIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
+#endif
+#ifndef CFG_TUD_VENDOR_EPSIZE
+#define CFG_TUD_VENDOR_EPSIZE     (TUD_OPT_HIGH_SPEED ? 512 : 64)
+#endif
+
+//--------------------------------------------------------------------
+// HOST CONFIGURATION
+//--------------------------------------------------------------------
+
+// Only used when the build enables a host port, e.g. CFG_TUSB_RHPORT1_MODE = OPT_MODE_HOST
+// for the host benchmarks (refer to serial_usb/usb_host_benchmark.h)
+
+#ifndef CFG_TUH_ENUMERATION_BUFSIZE
+#define CFG_TUH_ENUMERATION_BUFSIZE 256
+#endif
+
+// One hub, devices behind it are enumerated one at a time
+#ifndef CFG_TUH_HUB
+#define CFG_TUH_HUB               1
+#endif
+// Devices other than hubs
+#ifndef CFG_TUH_DEVICE_MAX
+#define CFG_TUH_DEVICE_MAX        (CFG_TUH_HUB ? 4 : 1)
+#endif
+
+//------------- CLASS -------------//
+#ifndef CFG_TUH_CDC
+#define CFG_TUH_CDC               1
+#endif
+#ifndef CFG_TUH_MSC
+#define CFG_TUH_MSC               1
+#endif
+
+// Bulk transfers in the host controller at once, shared fairly by the devices (refer to host/usbh.c), 0 for no limit
+#ifndef CFG_TUH_XFER_CHANNELS
+#define CFG_TUH_XFER_CHANNELS     0
+#endif
 
 #ifdef __cplusplus
  }
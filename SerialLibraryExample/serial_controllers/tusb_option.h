@@ -154,6 +154,9 @@ typedef int make_iso_compilers_happy;
 // Allwinner
 #define OPT_MCU_F1C100S          2100 ///< Allwinner F1C100s family
 
+// Host (Linux/PC) simulation
+#define OPT_MCU_VIRTUAL          2200 ///< Virtual controller with in-process host (portable/virtual)
+
 // Helper to check if configured MCU is one of listed
 // Apply _TU_CHECK_MCU with || as separator to list of input
 #define _TU_CHECK_MCU(_m)   (CFG_TUSB_MCU == _m)
@@ -308,6 +311,12 @@ typedef int make_iso_compilers_happy;
   #define CFG_TUD_INTERFACE_MAX   16
 #endif
 
+// Queue up to two transfers on bulk endpoints of ports supporting it (dcd_edpt_pingpong()),
+// class drivers double their endpoint buffers so the next packet is ready while the current one is on the bus
+#ifndef CFG_TUD_EDPT_PINGPONG
+  #define CFG_TUD_EDPT_PINGPONG   0
+#endif
+
 #ifndef CFG_TUD_CDC
   #define CFG_TUD_CDC             0
 #endif
@@ -33,7 +33,7 @@
  */
 #define _PID_MAP(itf, n)  ( (CFG_TUD_##itf) << (n) )
 #define USB_PID           (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(HID, 2) | \
-                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) )
+                           _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4) | _PID_MAP(NCM, 5) )
 
 #define USB_VID   0xCafe
 #define USB_BCD   0x0200
@@ -75,34 +75,82 @@ uint8_t const * tud_descriptor_device_cb(void)
 //--------------------------------------------------------------------+
 // Configuration Descriptor
 //--------------------------------------------------------------------+
+#if CFG_TUD_CDC > 3
+  #error "usb_descriptors.c only defines descriptors for up to 3 CDC ports"
+#endif
+
 enum
 {
   ITF_NUM_CDC = 0,
   ITF_NUM_CDC_DATA,
+#if CFG_TUD_CDC > 1
+  ITF_NUM_CDC_1,
+  ITF_NUM_CDC_1_DATA,
+#endif
+#if CFG_TUD_CDC > 2
+  ITF_NUM_CDC_2,
+  ITF_NUM_CDC_2_DATA,
+#endif
+#if CFG_TUD_MSC
+  ITF_NUM_MSC,
+#endif
+#if CFG_TUD_VENDOR
+  ITF_NUM_VENDOR,
+#endif
+#if CFG_TUD_NCM
+  ITF_NUM_NCM,
+  ITF_NUM_NCM_DATA,
+#endif
   ITF_NUM_TOTAL
 };
 
-#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + CFG_TUD_CDC * TUD_CDC_DESC_LEN)
+// NCM MAC address string, generated by tud_descriptor_string_cb()
+#define STRID_MAC           10
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + CFG_TUD_CDC * TUD_CDC_DESC_LEN + CFG_TUD_MSC * TUD_MSC_DESC_LEN + \
+                             CFG_TUD_VENDOR * TUD_VENDOR_DESC_LEN + CFG_TUD_NCM * TUD_CDC_NCM_DESC_LEN)
 
+// Endpoints of CDC port n (notification IN, data OUT, data IN)
 #if CFG_TUSB_MCU == OPT_MCU_LPC175X_6X || CFG_TUSB_MCU == OPT_MCU_LPC177X_8X || CFG_TUSB_MCU == OPT_MCU_LPC40XX
   // LPC 17xx and 40xx endpoint type (bulk/interrupt/iso) are fixed by its number
   // 0 control, 1 In, 2 Bulk, 3 Iso, 4 In etc ...
-  #define EPNUM_CDC_NOTIF   0x81
-  #define EPNUM_CDC_OUT     0x02
-  #define EPNUM_CDC_IN      0x82
+  #define EPNUM_CDC_NOTIF(n)  (0x81 + 3 * (n))
+  #define EPNUM_CDC_OUT(n)    (0x02 + 3 * (n))
+  #define EPNUM_CDC_IN(n)     (0x82 + 3 * (n))
+  #define EPNUM_CDC_END       (0x01 + 3 * CFG_TUD_CDC)
 
-#elif CFG_TUSB_MCU == OPT_MCU_SAMG || CFG_TUSB_MCU ==  OPT_MCU_SAMX7X
+#elif CFG_TUSB_MCU == OPT_MCU_SAMG || CFG_TUSB_MCU ==  OPT_MCU_SAMX7X || CFG_TUD_EDPT_PINGPONG
   // SAMG & SAME70 don't support a same endpoint number with different direction IN and OUT
   //    e.g EP1 OUT & EP1 IN cannot exist together
-  #define EPNUM_CDC_NOTIF   0x81
-  #define EPNUM_CDC_OUT     0x02
-  #define EPNUM_CDC_IN      0x83
+  // Ping-pong (SAMD dual bank) endpoints take both banks of their number, so the other direction must stay unused
+  #define EPNUM_CDC_NOTIF(n)  (0x81 + 3 * (n))
+  #define EPNUM_CDC_OUT(n)    (0x02 + 3 * (n))
+  #define EPNUM_CDC_IN(n)     (0x83 + 3 * (n))
+  #define EPNUM_CDC_END       (0x01 + 3 * CFG_TUD_CDC)
 
 #else
-  #define EPNUM_CDC_NOTIF   0x81
-  #define EPNUM_CDC_OUT     0x02
-  #define EPNUM_CDC_IN      0x82
+  #define EPNUM_CDC_NOTIF(n)  (0x81 + 2 * (n))
+  #define EPNUM_CDC_OUT(n)    (0x02 + 2 * (n))
+  #define EPNUM_CDC_IN(n)     (0x82 + 2 * (n))
+  #define EPNUM_CDC_END       (0x01 + 2 * CFG_TUD_CDC)
+
+#endif
 
+// MSC, vendor and NCM (only enabled for host benchmarks) take the endpoint numbers after the last CDC port,
+// one number per interface or one per endpoint with ping-pong, NCM uses one more for its notification endpoint
+#define EPNUM_PER_ITF       (CFG_TUD_EDPT_PINGPONG ? 2 : 1)
+#define EPNUM_MSC_OUT       (EPNUM_CDC_END)
+#define EPNUM_MSC_IN        (0x80 | (EPNUM_CDC_END + EPNUM_PER_ITF - 1))
+#define EPNUM_VENDOR_OUT    (EPNUM_CDC_END + EPNUM_PER_ITF * CFG_TUD_MSC)
+#define EPNUM_VENDOR_IN     (0x80 | (EPNUM_VENDOR_OUT + EPNUM_PER_ITF - 1))
+#define EPNUM_NCM_BASE      (EPNUM_VENDOR_OUT + EPNUM_PER_ITF * CFG_TUD_VENDOR)
+#define EPNUM_NCM_NOTIF     (0x80 | EPNUM_NCM_BASE)
+#define EPNUM_NCM_OUT       (EPNUM_NCM_BASE + 1)
+#define EPNUM_NCM_IN        (0x80 | (EPNUM_NCM_BASE + EPNUM_PER_ITF))
+#define EPNUM_END           (EPNUM_NCM_BASE + (1 + EPNUM_PER_ITF) * CFG_TUD_NCM)
+
+#if EPNUM_END > TUP_DCD_ENDPOINT_MAX
+  #error "Not enough endpoints for the enabled CDC/MSC/vendor/NCM interfaces"
 #endif
 
 uint8_t const desc_fs_configuration[] =
@@ -111,7 +159,27 @@ uint8_t const desc_fs_configuration[] =
   TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
 
   // 1st CDC: Interface number, string index, EP notification address and size, EP data address (out, in) and size.
-  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, EPNUM_CDC_NOTIF(0), 8, EPNUM_CDC_OUT(0), EPNUM_CDC_IN(0), 64),
+#if CFG_TUD_CDC > 1
+  // 2nd CDC
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, 5, EPNUM_CDC_NOTIF(1), 8, EPNUM_CDC_OUT(1), EPNUM_CDC_IN(1), 64),
+#endif
+#if CFG_TUD_CDC > 2
+  // 3rd CDC
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_2, 6, EPNUM_CDC_NOTIF(2), 8, EPNUM_CDC_OUT(2), EPNUM_CDC_IN(2), 64),
+#endif
+#if CFG_TUD_MSC
+  // Interface number, string index, EP Out & EP In address, EP size
+  TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 7, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+#endif
+#if CFG_TUD_VENDOR
+  // Interface number, string index, EP Out & EP In address, EP size
+  TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 8, EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, 64),
+#endif
+#if CFG_TUD_NCM
+  // Interface number, string index, MAC address string index, EP notification address and size, EP data address (out, in), size and max segment size
+  TUD_CDC_NCM_DESCRIPTOR(ITF_NUM_NCM, 9, STRID_MAC, EPNUM_NCM_NOTIF, 64, EPNUM_NCM_OUT, EPNUM_NCM_IN, 64, CFG_TUD_NET_MTU),
+#endif
 };
 
 #if TUD_OPT_HIGH_SPEED
@@ -123,7 +191,24 @@ uint8_t const desc_hs_configuration[] =
   TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
 
   // 1st CDC: Interface number, string index, EP notification address and size, EP data address (out, in) and size.
-  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 512),
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, EPNUM_CDC_NOTIF(0), 8, EPNUM_CDC_OUT(0), EPNUM_CDC_IN(0), 512),
+#if CFG_TUD_CDC > 1
+  // 2nd CDC
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, 5, EPNUM_CDC_NOTIF(1), 8, EPNUM_CDC_OUT(1), EPNUM_CDC_IN(1), 512),
+#endif
+#if CFG_TUD_CDC > 2
+  // 3rd CDC
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_2, 6, EPNUM_CDC_NOTIF(2), 8, EPNUM_CDC_OUT(2), EPNUM_CDC_IN(2), 512),
+#endif
+#if CFG_TUD_MSC
+  TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 7, EPNUM_MSC_OUT, EPNUM_MSC_IN, 512),
+#endif
+#if CFG_TUD_VENDOR
+  TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 8, EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, 512),
+#endif
+#if CFG_TUD_NCM
+  TUD_CDC_NCM_DESCRIPTOR(ITF_NUM_NCM, 9, STRID_MAC, EPNUM_NCM_NOTIF, 64, EPNUM_NCM_OUT, EPNUM_NCM_IN, 512, CFG_TUD_NET_MTU),
+#endif
 };
 
 // device qualifier is mostly similar to device descriptor since we don't change configuration based on speed
@@ -191,6 +276,12 @@ char const* string_desc_arr [] =
   "TinyUSB Device",              // 2: Product
   "123456",                      // 3: Serials, should use chip ID
   "TinyUSB CDC",                 // 4: CDC Interface
+  "TinyUSB CDC 2",               // 5: 2nd CDC Interface
+  "TinyUSB CDC 3",               // 6: 3rd CDC Interface
+  "TinyUSB MSC",                 // 7: MSC Interface
+  "TinyUSB Vendor",              // 8: Vendor Interface
+  "TinyUSB Network",             // 9: NCM Interface
+                                 // 10: MAC address, made from tud_network_mac_address
 };
 
 static uint16_t _desc_str[32];
@@ -212,18 +303,32 @@ uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
     // Note: the 0xEE index string is a Microsoft OS 1.0 Descriptors.
     // https://docs.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-defined-usb-descriptors
 
-    if ( !(index < sizeof(string_desc_arr)/sizeof(string_desc_arr[0])) ) return NULL;
+#if CFG_TUD_NCM
+    if ( index == STRID_MAC )
+    {
+      // Convert MAC address into 12 hex digits
+      chr_count = 0;
+      for(uint8_t i=0; i<sizeof(tud_network_mac_address); i++)
+      {
+        _desc_str[1+chr_count++] = "0123456789ABCDEF"[(tud_network_mac_address[i] >> 4) & 0xf];
+        _desc_str[1+chr_count++] = "0123456789ABCDEF"[(tud_network_mac_address[i] >> 0) & 0xf];
+      }
+    }else
+#endif
+    {
+      if ( !(index < sizeof(string_desc_arr)/sizeof(string_desc_arr[0])) ) return NULL;
 
-    const char* str = string_desc_arr[index];
+      const char* str = string_desc_arr[index];
 
-    // Cap at max char
-    chr_count = (uint8_t) strlen(str);
-    if ( chr_count > 31 ) chr_count = 31;
+      // Cap at max char
+      chr_count = (uint8_t) strlen(str);
+      if ( chr_count > 31 ) chr_count = 31;
 
-    // Convert ASCII string into UTF-16
-    for(uint8_t i=0; i<chr_count; i++)
-    {
-      _desc_str[1+i] = str[i];
+      // Convert ASCII string into UTF-16
+      for(uint8_t i=0; i<chr_count; i++)
+      {
+        _desc_str[1+i] = str[i];
+      }
     }
   }
 
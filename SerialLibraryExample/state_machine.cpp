@@ -8,14 +8,439 @@
 
 #include "state_machine.h"
 
-void StateMachine::ExecuteAction(StateMachine::STT_MACHINE * state_table)
+#include <assert.h>
+#if STT_TRACE_ENABLE && !defined(__arm__)
+#include <chrono>
+#endif
+
+namespace
 {
-	state_table->current_state = state_table->state_actions[state_table->current_state]();
+	bool PushEvent(StateMachine::STT_EVENT_QUEUE * queue, StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+	{
+		uint8_t head = queue->head.load(std::memory_order_relaxed);
+		uint8_t next_head = (head + 1u) & (STT_EVENT_QUEUE_SIZE - 1u);
+		//acquire: the dispatcher has finished reading the entry before its tail is observed
+		if(next_head == queue->tail.load(std::memory_order_acquire)) return false;
+		//event and payload are stored before head is published so the dispatcher never reads a stale entry
+		queue->events[head] = event;
+		for(uint8_t i = 0; i < STT_EVENT_DATA_SIZE / 4u; i++) queue->data[head][i] = (data != nullptr) ? data->words[i] : 0u;
+		queue->head.store(next_head, std::memory_order_release);
+		return true;
+	}
+
+	bool PopEvent(StateMachine::STT_EVENT_QUEUE * queue, StateMachine::STT_EVENT * event, StateMachine::STT_EVENT_DATA * data)
+	{
+		uint8_t tail = queue->tail.load(std::memory_order_relaxed);
+		//acquire: the event and payload are visible once the published head is observed
+		if(tail == queue->head.load(std::memory_order_acquire)) return false;
+		*event = queue->events[tail];
+		for(uint8_t i = 0; i < STT_EVENT_DATA_SIZE / 4u; i++) data->words[i] = queue->data[tail][i];
+		queue->tail.store((tail + 1u) & (STT_EVENT_QUEUE_SIZE - 1u), std::memory_order_release);
+		return true;
+	}
+
+	uint8_t GetDepth(const StateMachine::STT_HSM * hsm, StateMachine::STT_STATE state)
+	{
+		uint8_t depth = 0;
+		for(; state != StateMachine::STT_NO_PARENT; state = hsm->state_table[state].parent) depth++;
+		return depth;
+	}
+
+	StateMachine::STT_STATE GetAncestor(const StateMachine::STT_HSM * hsm, StateMachine::STT_STATE state, uint8_t levels)
+	{
+		for(; levels; levels--) state = hsm->state_table[state].parent;
+		return state;
+	}
+
+	StateMachine::STT_STATE FindCommonAncestor(const StateMachine::STT_HSM * hsm, StateMachine::STT_STATE state_a, StateMachine::STT_STATE state_b)
+	{
+		uint8_t depth_a = GetDepth(hsm, state_a);
+		uint8_t depth_b = GetDepth(hsm, state_b);
+		//bring both states to the same depth, then walk up together until paths meet
+		if(depth_a > depth_b) state_a = GetAncestor(hsm, state_a, depth_a - depth_b);
+		else state_b = GetAncestor(hsm, state_b, depth_b - depth_a);
+		while(state_a != state_b)
+		{
+			state_a = hsm->state_table[state_a].parent;
+			state_b = hsm->state_table[state_b].parent;
+		}
+		return state_a;
+	}
+
+	void EnterStates(const StateMachine::STT_HSM * hsm, StateMachine::STT_STATE ancestor, StateMachine::STT_STATE target)
+	{
+		//entry actions run from the outermost state down to the target
+		uint8_t levels = 0;
+		for(StateMachine::STT_STATE state = target; state != ancestor; state = hsm->state_table[state].parent) levels++;
+		while(levels)
+		{
+			levels--;
+			StateMachine::STT_TRANSITION_ACTION entry_action = hsm->state_table[GetAncestor(hsm, target, levels)].entry_action;
+			if(entry_action != nullptr) entry_action();
+		}
+	}
+
+	void TransitionHSM(StateMachine::STT_HSM * hsm, StateMachine::STT_STATE target)
+	{
+		StateMachine::STT_STATE ancestor = FindCommonAncestor(hsm, hsm->current_state, target);
+		for(StateMachine::STT_STATE state = hsm->current_state; state != ancestor; state = hsm->state_table[state].parent)
+		{
+			StateMachine::STT_TRANSITION_ACTION exit_action = hsm->state_table[state].exit_action;
+			if(exit_action != nullptr) exit_action();
+		}
+		EnterStates(hsm, ancestor, target);
+		hsm->current_state = target;
+		hsm->entry_pending = true;
+	}
+
+	bool StepHSM(void * machine)
+	{
+		return StateMachine::DispatchEvent(static_cast<StateMachine::STT_HSM *>(machine));
+	}
+
+	bool IsHSMReady(const void * machine)
+	{
+		return StateMachine::HasEvents(static_cast<const StateMachine::STT_HSM *>(machine));
+	}
+
+	bool IsTaskReady(const StateMachine::STT_TASK * task)
+	{
+		if(task->is_ready != nullptr) return task->is_ready(task->machine);
+		return task->poll_ready == nullptr || task->poll_ready();
+	}
+
+	#if STT_TRACE_ENABLE
+	#if !defined(__arm__)
+	uint32_t HostTraceTimer(void)
+	{
+		//microseconds, so the 32 bit tick count wraps after ~71 minutes instead of ~4.3 seconds
+		return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	#endif
+
+	#if !defined(__arm__)
+	uint32_t (* trace_timer)(void) = &HostTraceTimer;
+	#else
+	uint32_t (* trace_timer)(void) = nullptr;
+	#endif
+	//trace of the machine being dispatched, so super state actions record into the right trace
+	StateMachine::STT_TRACE * active_trace = nullptr;
+
+	struct TraceWriter {
+		char * output;
+		uint32_t size;
+		uint32_t offset;
+		uint32_t position;
+		uint32_t written;
+	};
+
+	uint32_t GetTraceTime(void)
+	{
+		return (trace_timer != nullptr) ? trace_timer() : 0;
+	}
+
+	void TraceAction(StateMachine::STT_TRACE * trace, StateMachine::STT_STATE state, StateMachine::STT_STATE next_state, uint32_t start, bool is_super)
+	{
+		if(trace == nullptr || trace->paused) return;
+		uint32_t end = GetTraceTime();
+		uint32_t ticks = end - start;
+		if(state < STT_TRACE_NUM_STATES)
+		{
+			StateMachine::STT_TRACE_STATS * stats = &(trace->stats[state]);
+			stats->actions++;
+			stats->action_ticks += ticks;
+			if(ticks > stats->max_action_ticks) stats->max_action_ticks = ticks;
+		}
+		//super state actions only add to statistics, the sub state records the transition
+		if(is_super || next_state == state) return;
+		if(state < STT_TRACE_NUM_STATES) trace->stats[state].dwell_ticks += end - trace->state_entered;
+		if(next_state < STT_TRACE_NUM_STATES) trace->stats[next_state].entries++;
+		trace->state_entered = end;
+		StateMachine::STT_TRACE_RECORD record = {start, ticks, state, next_state};
+		trace->records[trace->head] = record;
+		trace->head = (trace->head + 1u) % STT_TRACE_SIZE;
+		if(trace->count < STT_TRACE_SIZE) trace->count++;
+		else if(trace->dropped < 0xFFFFu) trace->dropped++;
+	}
+
+	void WriteTraceByte(TraceWriter * writer, uint8_t value)
+	{
+		if(writer->position >= writer->offset && writer->written < writer->size) writer->output[writer->written++] = (char)value;
+		writer->position++;
+	}
+
+	void WriteTraceWord(TraceWriter * writer, uint32_t value, uint8_t num_bytes)
+	{
+		for(uint8_t i = 0; i < num_bytes; i++) WriteTraceByte(writer, (uint8_t)(value >> (8u * i)));
+	}
+	#endif
+}
+
+void StateMachine::ExecuteStateAction(StateMachine::STT_STATE * current_state, const StateMachine::STT_ACTION * state_actions, StateMachine::STT_TRACE * trace)
+{
+	#if STT_TRACE_ENABLE
+	STT_STATE state = *current_state;
+	active_trace = trace;
+	uint32_t start = GetTraceTime();
+	*current_state = state_actions[state]();
+	TraceAction(trace, state, *current_state, start, false);
+	active_trace = nullptr;
+	#else
+	(void)trace;
+	*current_state = state_actions[*current_state]();
+	#endif
 }
 
 void StateMachine::ProcessSuperState(StateMachine::STT_STATE * current_state, StateMachine::STT_STATE super_state, StateMachine::STT_ACTION super_function)
 {
+	#if STT_TRACE_ENABLE
+	uint32_t start = GetTraceTime();
+	STT_STATE temp_state = super_function();
+	TraceAction(active_trace, super_state, temp_state, start, true);
+	#else
 	STT_STATE temp_state = super_function();
+	#endif
 	if(temp_state != super_state)
 		*current_state = temp_state;
 }
+
+void StateMachine::ResetEventMachine(StateMachine::STT_EVENT_MACHINE_BASE * state_table, StateMachine::STT_STATE initial_state)
+{
+	state_table->current_state = initial_state;
+	state_table->entry_pending = true;
+	state_table->invalid_transitions = 0;
+	state_table->queue.tail.store(0, std::memory_order_relaxed);
+	state_table->queue.head.store(0, std::memory_order_release);
+}
+
+bool StateMachine::PostEvent(StateMachine::STT_EVENT_MACHINE_BASE * state_table, StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+{
+	return PushEvent(&(state_table->queue), event, data);
+}
+
+bool StateMachine::HasEvents(const StateMachine::STT_EVENT_MACHINE_BASE * state_table)
+{
+	return state_table->entry_pending || state_table->queue.head.load(std::memory_order_acquire) != state_table->queue.tail.load(std::memory_order_relaxed);
+}
+
+bool StateMachine::DispatchStateEvent(StateMachine::STT_EVENT_MACHINE_BASE * state_table, const StateMachine::STT_EVENT_ACTION * state_actions, uint8_t num_states)
+{
+	STT_EVENT event = EVENT_ENTRY;
+	STT_EVENT_DATA data = {};
+	if(state_table->entry_pending)
+	{
+		state_table->entry_pending = false;
+	}
+	else if(!PopEvent(&(state_table->queue), &event, &data))
+	{
+		return false;
+	}
+	#if STT_TRACE_ENABLE
+	active_trace = state_table->trace;
+	uint32_t start = GetTraceTime();
+	STT_STATE next_state = state_actions[state_table->current_state](event, &data);
+	TraceAction(state_table->trace, state_table->current_state, next_state, start, false);
+	active_trace = nullptr;
+	#else
+	STT_STATE next_state = state_actions[state_table->current_state](event, &data);
+	#endif
+	if(next_state != state_table->current_state)
+	{
+		//a state outside the machine is a bug in the state action
+		assert(next_state < num_states);
+		if(next_state < num_states)
+		{
+			state_table->current_state = next_state;
+			state_table->entry_pending = true;
+		}
+		else if(state_table->invalid_transitions < 0xFFFFu)
+		{
+			state_table->invalid_transitions++;
+		}
+	}
+	return true;
+}
+
+void StateMachine::ProcessSuperState(StateMachine::STT_STATE * current_state, StateMachine::STT_STATE super_state, StateMachine::STT_EVENT_ACTION super_function, StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+{
+	STT_STATE temp_state = super_function(event, data);
+	if(temp_state != super_state)
+		*current_state = temp_state;
+}
+
+void StateMachine::InitHSM(StateMachine::STT_HSM * hsm, const StateMachine::STT_HSM_STATE * state_table, uint8_t num_states, StateMachine::STT_STATE initial_state)
+{
+	hsm->state_table = state_table;
+	hsm->num_states = num_states;
+	hsm->queue.tail.store(0, std::memory_order_relaxed);
+	hsm->queue.head.store(0, std::memory_order_release);
+	hsm->invalid_transitions = 0;
+	EnterStates(hsm, STT_NO_PARENT, initial_state);
+	hsm->current_state = initial_state;
+	hsm->entry_pending = true;
+}
+
+bool StateMachine::PostEvent(StateMachine::STT_HSM * hsm, StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)
+{
+	return PushEvent(&(hsm->queue), event, data);
+}
+
+bool StateMachine::HasEvents(const StateMachine::STT_HSM * hsm)
+{
+	return hsm->entry_pending || hsm->queue.head.load(std::memory_order_acquire) != hsm->queue.tail.load(std::memory_order_relaxed);
+}
+
+bool StateMachine::DispatchEvent(StateMachine::STT_HSM * hsm)
+{
+	STT_EVENT event = EVENT_ENTRY;
+	STT_EVENT_DATA data = {};
+	if(hsm->entry_pending)
+	{
+		hsm->entry_pending = false;
+	}
+	else if(!PopEvent(&(hsm->queue), &event, &data))
+	{
+		return false;
+	}
+	#if STT_TRACE_ENABLE
+	STT_STATE traced_state = hsm->current_state;
+	active_trace = hsm->trace;
+	uint32_t start = GetTraceTime();
+	#endif
+	//bubble event up from current state until a state handles it
+	STT_STATE state = hsm->current_state;
+	STT_STATE next_state = STT_UNHANDLED;
+	while(state != STT_NO_PARENT)
+	{
+		next_state = hsm->state_table[state].state_action(event, &data);
+		if(next_state != STT_UNHANDLED) break;
+		state = hsm->state_table[state].parent;
+	}
+	if(state != STT_NO_PARENT && next_state != state)
+	{
+		//a state outside the table is a bug in the state action
+		assert(next_state < hsm->num_states);
+		if(next_state < hsm->num_states)
+			TransitionHSM(hsm, next_state);
+		else if(hsm->invalid_transitions < 0xFFFFu)
+			hsm->invalid_transitions++;
+	}
+	#if STT_TRACE_ENABLE
+	TraceAction(hsm->trace, traced_state, hsm->current_state, start, false);
+	active_trace = nullptr;
+	#endif
+	return true;
+}
+
+void StateMachine::ExecuteEvents(StateMachine::STT_HSM * hsm)
+{
+	while(DispatchEvent(hsm));
+}
+
+bool StateMachine::IsInState(const StateMachine::STT_HSM * hsm, StateMachine::STT_STATE state)
+{
+	for(STT_STATE current = hsm->current_state; current != STT_NO_PARENT; current = hsm->state_table[current].parent)
+	{
+		if(current == state) return true;
+	}
+	return false;
+}
+
+StateMachine::STT_TASK StateMachine::MakeTask(StateMachine::STT_HSM * machine, uint8_t priority)
+{
+	return {machine, &StepHSM, &IsHSMReady, nullptr, priority};
+}
+
+void StateMachine::InitScheduler(StateMachine::STT_SCHEDULER * scheduler, StateMachine::STT_TASK * tasks, uint8_t num_tasks, StateMachine::SchedulePolicy policy)
+{
+	scheduler->tasks = tasks;
+	scheduler->num_tasks = num_tasks;
+	scheduler->next_task = 0;
+	scheduler->policy = policy;
+}
+
+bool StateMachine::HasReadyTask(const StateMachine::STT_SCHEDULER * scheduler)
+{
+	for(uint8_t i = 0; i < scheduler->num_tasks; i++)
+	{
+		if(IsTaskReady(&(scheduler->tasks[i]))) return true;
+	}
+	return false;
+}
+
+bool StateMachine::RunScheduler(StateMachine::STT_SCHEDULER * scheduler)
+{
+	uint8_t selected = scheduler->num_tasks;
+	//search starts after the last task run, so ready tasks of equal priority take turns
+	for(uint8_t i = 0; i < scheduler->num_tasks; i++)
+	{
+		uint8_t index = (uint8_t)((scheduler->next_task + i) % scheduler->num_tasks);
+		STT_TASK * task = &(scheduler->tasks[index]);
+		if(!IsTaskReady(task)) continue;
+		if(selected == scheduler->num_tasks || task->priority < scheduler->tasks[selected].priority) selected = index;
+		if(scheduler->policy == SchedulePolicy::RoundRobin || task->priority == 0) break;
+	}
+	if(selected == scheduler->num_tasks) return false;
+	scheduler->next_task = (uint8_t)((selected + 1u) % scheduler->num_tasks);
+	STT_TASK * task = &(scheduler->tasks[selected]);
+	return task->step(task->machine);
+}
+
+#if STT_TRACE_ENABLE
+void StateMachine::SetTraceTimer(uint32_t (* timer_func)(void))
+{
+	trace_timer = timer_func;
+}
+
+void StateMachine::ClearTrace(StateMachine::STT_TRACE * trace)
+{
+	for(uint16_t i = 0; i < STT_TRACE_NUM_STATES; i++) trace->stats[i] = STT_TRACE_STATS();
+	trace->head = 0;
+	trace->count = 0;
+	trace->dropped = 0;
+	trace->paused = false;
+	trace->state_entered = GetTraceTime();
+}
+
+void StateMachine::PauseTrace(StateMachine::STT_TRACE * trace, bool pause)
+{
+	trace->paused = pause;
+}
+
+const StateMachine::STT_TRACE_STATS * StateMachine::GetTraceStats(const StateMachine::STT_TRACE * trace, StateMachine::STT_STATE state)
+{
+	return (state < STT_TRACE_NUM_STATES) ? &(trace->stats[state]) : nullptr;
+}
+
+uint32_t StateMachine::SerializeTrace(const StateMachine::STT_TRACE * trace, char * output, uint32_t size, uint32_t offset)
+{
+	TraceWriter writer = {output, size, offset, 0, 0};
+	WriteTraceByte(&writer, 'S');
+	WriteTraceByte(&writer, 'T');
+	WriteTraceByte(&writer, 1u);
+	WriteTraceByte(&writer, STT_TRACE_NUM_STATES);
+	WriteTraceWord(&writer, trace->count, 2);
+	WriteTraceWord(&writer, trace->dropped, 2);
+	for(uint16_t i = 0; i < STT_TRACE_NUM_STATES; i++)
+	{
+		const STT_TRACE_STATS * stats = &(trace->stats[i]);
+		WriteTraceWord(&writer, stats->entries, 4);
+		WriteTraceWord(&writer, stats->actions, 4);
+		WriteTraceWord(&writer, stats->dwell_ticks, 4);
+		WriteTraceWord(&writer, stats->action_ticks, 4);
+		WriteTraceWord(&writer, stats->max_action_ticks, 4);
+	}
+	//oldest record is at head once ring buffer has wrapped
+	uint16_t index = (trace->count < STT_TRACE_SIZE) ? 0 : trace->head;
+	for(uint16_t i = 0; i < trace->count && writer.written < size; i++)
+	{
+		const STT_TRACE_RECORD * record = &(trace->records[index]);
+		WriteTraceWord(&writer, record->timestamp, 4);
+		WriteTraceWord(&writer, record->action_ticks, 4);
+		WriteTraceByte(&writer, record->state);
+		WriteTraceByte(&writer, record->next_state);
+		index = (index + 1u) % STT_TRACE_SIZE;
+	}
+	return writer.written;
+}
+#endif
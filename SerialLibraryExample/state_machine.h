@@ -10,9 +10,23 @@
 #define __STATE_MACHINE_H__
 
 #include <stdint.h>
+#include <atomic>
 
 //edit consts to your need
 #define	NUM_STT_STATES	5
+#define	STT_EVENT_QUEUE_SIZE	8		//must be a power of 2
+#ifndef STT_EVENT_DATA_SIZE
+#define	STT_EVENT_DATA_SIZE		4		//bytes of payload carried by each event (multiple of 4)
+#endif
+#ifndef STT_TRACE_ENABLE
+#define	STT_TRACE_ENABLE		0		//1 to record transitions and action timing (refer to StateMachine::SerializeTrace())
+#endif
+#ifndef STT_TRACE_SIZE
+#define	STT_TRACE_SIZE			32		//number of transitions kept in trace ring buffer
+#endif
+#ifndef STT_TRACE_NUM_STATES
+#define	STT_TRACE_NUM_STATES	(NUM_STT_STATES + 1)		//number of states (including super states) with trace statistics
+#endif
 
 
 /*!
@@ -23,7 +37,24 @@
  * 2) Define and declare an enum of state types in a separate file if desired to improve readability of code.\n 
  * 3) Define and declare your state machine and all state action functions. Each state action should return StateMachine::STT_STATE and have 0 parameters.\n 
  * 4) Add super state functionality to your state action functions by calling StateMachine::ProcessSuperState() at the end of each sub-state. You should define and declare your super state action functions.\n 
- * 5) In your superloop, call StateMachine::ExecuteAction() and pass the address of your state machine (i.e. StateMachine::ExecuteAction(&my_state_machine);).
+ * 5) In your superloop, call StateMachine::ExecuteAction() and pass the address of your state machine (i.e. StateMachine::ExecuteAction(&my_state_machine);).\n 
+ *
+ * Event driven machines (STT_EVENT_MACHINE, or STT_EVENT_MACHINE_T for other sizes) are set up the same way, except:\n 
+ * 1) Each state action takes the STT_EVENT which woke it and its payload (STT_EVENT_DATA), and only runs when an event is pending.\n 
+ * 2) ISRs and drivers call StateMachine::PostEvent() instead of state actions polling for events, optionally with a payload (i.e. a parsed parameter).\n 
+ * 3) In your superloop, call StateMachine::ExecuteEvents() and sleep while StateMachine::HasEvents() is false.\n 
+ *
+ * Hierarchical state machines (STT_HSM) are event driven machines described by a constexpr table of STT_HSM_STATE rows:\n 
+ * 1) Each row holds the parent (super state, or STT_NO_PARENT), optional entry and exit actions, and the state action. Rows must be in STT_STATE order.\n 
+ * 2) A state action returns the state to transition to, its own state if the event was handled, or STT_UNHANDLED to pass the event to its parent.\n 
+ * 3) Transitions exit up to the least common ancestor of the current and target states, then enter down to the target state.\n 
+ * 4) Check the table with StateMachine::IsValidHSMTable() in a static_assert, and pass it to StateMachine::InitHSM().\n 
+ *
+ * Several state machines (of any type and size) can share one superloop through a cooperative scheduler (STT_SCHEDULER):\n 
+ * 1) Create an array with one StateMachine::MakeTask() per state machine and pass it to StateMachine::InitScheduler().\n 
+ * 2) In your superloop, call StateMachine::RunScheduler() and sleep while StateMachine::HasReadyTask() is false.\n 
+ *
+ * With STT_TRACE_ENABLE, each machine records into its own STT_TRACE (attached with StateMachine::SetTrace()), so machines sharing a superloop keep separate statistics.
  */
 namespace StateMachine
 {
@@ -42,15 +73,39 @@ namespace StateMachine
 	 * The function pointer which performs all actions during a specific state and returns the state to transition to.
 	 */
 	typedef STT_STATE (*STT_ACTION)(void);
+	/*!
+	 * \brief Trace of a single state machine (refer to StateMachine::SetTrace()), defined when STT_TRACE_ENABLE is 1.
+	 */
+	struct STT_TRACE;
 	/*!
 	 * \brief State machine struct containing the base state and all rows in the program.
 	 *
 	 * Contains the current state of the state machine and array of state action functions.
+	 *
+	 * \tparam num_states number of (non-super) states, so machines of different sizes can run in one program
 	*/
-	struct STT_MACHINE {
+	template <uint8_t num_states>
+	struct STT_MACHINE_T {
 		STT_STATE current_state;						//!< current state of machine
-		STT_ACTION state_actions[NUM_STT_STATES];		//!< array of state action function pointers
+		STT_ACTION state_actions[num_states];			//!< array of state action function pointers
+		#if STT_TRACE_ENABLE
+		STT_TRACE * trace = nullptr;					//!< trace of machine (nullptr if not traced)
+		#endif
 	};
+	/*!
+	 * \brief State machine with NUM_STT_STATES states.
+	 */
+	typedef STT_MACHINE_T<NUM_STT_STATES> STT_MACHINE;
+	/*!
+	 * \brief Executes the current state action and stores the state to transition to.
+	 *
+	 * Shared by state machines of all sizes, use StateMachine::ExecuteAction() instead.
+	 *
+	 * \param current_state pointer to current state of machine
+	 * \param state_actions array of state action function pointers
+	 * \param trace trace of machine (default = nullptr, not traced)
+	 */
+	void ExecuteStateAction(STT_STATE * current_state, const STT_ACTION * state_actions, STT_TRACE * trace = nullptr);
 	/*!
 	 * \brief Iterates through a state machine table
 	 *
@@ -58,7 +113,15 @@ namespace StateMachine
 	 *
 	 * \param state_table pointer to state table struct
 	 */
-	void ExecuteAction(STT_MACHINE * state_table);
+	template <uint8_t num_states>
+	void ExecuteAction(STT_MACHINE_T<num_states> * state_table)
+	{
+		#if STT_TRACE_ENABLE
+		ExecuteStateAction(&(state_table->current_state), state_table->state_actions, state_table->trace);
+		#else
+		ExecuteStateAction(&(state_table->current_state), state_table->state_actions);
+		#endif
+	}
 	/*!
 	 * \brief Super state processing function to be used in implementing your state machine.
 	 *
@@ -71,6 +134,503 @@ namespace StateMachine
 	 * \param super_function address of super state action function
 	 */
 	void ProcessSuperState(STT_STATE * current_state, STT_STATE super_state, STT_ACTION super_function);
+
+	/*!
+	 * \brief Type definition for events
+	 *
+	 * Defines the events which drive an event driven state machine.
+	 *
+	 * \note Create an enum of uint8_t to organize your event types, starting with EVENT_ENTRY.
+	 */
+	typedef uint8_t STT_EVENT;
+	/*!
+	 * \brief Event passed to a state action once after a transition into its state.
+	 *
+	 * Lets states without events (default transitions) run and lets states perform entry actions.
+	 */
+	const STT_EVENT EVENT_ENTRY = 0;
+	/*!
+	 * \brief Payload of an event
+	 *
+	 * Fixed size union copied into the event queue with each event. Events without a payload carry zeros.
+	 *
+	 * \note To pass more than STT_EVENT_DATA_SIZE bytes, increase STT_EVENT_DATA_SIZE or post an index into your own buffer.
+	 */
+	union STT_EVENT_DATA {
+		uint32_t u32;									//!< unsigned integer payload
+		int32_t i32;									//!< signed integer payload
+		float f32;										//!< floating point payload
+		uint8_t bytes[STT_EVENT_DATA_SIZE];				//!< raw payload
+		uint32_t words[STT_EVENT_DATA_SIZE / 4u];		//!< payload as words (used to copy payload through event queue)
+	};
+	/*!
+	 * \brief Type definition for event driven state action function pointer
+	 *
+	 * The function pointer which handles an event during a specific state and returns the state to transition to. Guard conditions are checked in the state action before returning a new state.
+	 */
+	typedef STT_STATE (*STT_EVENT_ACTION)(STT_EVENT event, const STT_EVENT_DATA * data);
+	static_assert((STT_EVENT_QUEUE_SIZE & (STT_EVENT_QUEUE_SIZE - 1u)) == 0u, "STT_EVENT_QUEUE_SIZE must be a power of 2");
+	static_assert(STT_EVENT_DATA_SIZE >= 4u && (STT_EVENT_DATA_SIZE % 4u) == 0u, "STT_EVENT_DATA_SIZE must be a multiple of 4");
+	/*!
+	 * \brief Fixed size event queue
+	 *
+	 * Lock-free ring buffer of events and their payloads. One context may post (i.e. an ISR) while another context dispatches, without disabling interrupts. The poster publishes head with 
+	 * release ordering after storing the event, and the dispatcher publishes tail after reading it, each observing the other index with acquire ordering.
+	 *
+	 * \note If events are posted from multiple interrupt priorities, mask interrupts around StateMachine::PostEvent() in the lower priority ISR.
+	 */
+	struct STT_EVENT_QUEUE {
+		std::atomic<uint8_t> head;						//!< index of next event to post (only written by poster)
+		std::atomic<uint8_t> tail;						//!< index of next event to dispatch (only written by dispatcher)
+		STT_EVENT events[STT_EVENT_QUEUE_SIZE];			//!< array of queued events
+		uint32_t data[STT_EVENT_QUEUE_SIZE][STT_EVENT_DATA_SIZE / 4u];	//!< array of queued event payloads
+	};
+	/*!
+	 * \brief Part of an event driven state machine shared by machines of all sizes.
+	 *
+	 * Contains the current state of the state machine and the event queue.
+	*/
+	struct STT_EVENT_MACHINE_BASE {
+		STT_STATE current_state;							//!< current state of machine
+		bool entry_pending;									//!< true if current state has not received EVENT_ENTRY yet
+		STT_EVENT_QUEUE queue;								//!< pending events
+		uint16_t invalid_transitions;						//!< number of state actions which returned a state outside the table (transition ignored)
+		#if STT_TRACE_ENABLE
+		STT_TRACE * trace = nullptr;						//!< trace of machine (nullptr if not traced)
+		#endif
+	};
+	/*!
+	 * \brief Event driven state machine struct containing the base state, all rows in the program and pending events.
+	 *
+	 * Contains the current state of the state machine, array of event driven state action functions and the event queue.
+	 *
+	 * \tparam num_states number of (non-super) states, so machines of different sizes can run in one program
+	*/
+	template <uint8_t num_states>
+	struct STT_EVENT_MACHINE_T : STT_EVENT_MACHINE_BASE {
+		STT_EVENT_ACTION state_actions[num_states];			//!< array of event driven state action function pointers
+	};
+	/*!
+	 * \brief Event driven state machine with NUM_STT_STATES states.
+	 */
+	typedef STT_EVENT_MACHINE_T<NUM_STT_STATES> STT_EVENT_MACHINE;
+	/*!
+	 * \brief Resets an event driven state machine
+	 *
+	 * Empties event queue and sets initial state, which will receive EVENT_ENTRY on the next dispatch.
+	 *
+	 * \param state_table pointer to event driven state machine struct
+	 * \param initial_state state to start in
+	 */
+	void ResetEventMachine(STT_EVENT_MACHINE_BASE * state_table, STT_STATE initial_state);
+	/*!
+	 * \brief Posts an event to an event driven state machine
+	 *
+	 * Safe to call from an ISR.
+	 *
+	 * \param state_table pointer to event driven state machine struct
+	 * \param event event to post
+	 * \param data payload passed to the state action with the event (default = nullptr, zeros)
+	 * \return success of posting (false if event queue is full)
+	 */
+	bool PostEvent(STT_EVENT_MACHINE_BASE * state_table, STT_EVENT event, const STT_EVENT_DATA * data = nullptr);
+	/*!
+	 * \brief Checks if an event driven state machine has pending work
+	 *
+	 * \param state_table pointer to event driven state machine struct
+	 * \return true if an event is queued or the current state has not been entered yet, false otherwise
+	 */
+	bool HasEvents(const STT_EVENT_MACHINE_BASE * state_table);
+	/*!
+	 * \brief Dispatches a single event to the current state action.
+	 *
+	 * Shared by event driven state machines of all sizes, use StateMachine::DispatchEvent() instead.
+	 *
+	 * \param state_table pointer to event driven state machine struct
+	 * \param state_actions array of event driven state action function pointers
+	 * \param num_states number of entries in state_actions
+	 * \return true if an event was dispatched, false if there was no pending work
+	 */
+	bool DispatchStateEvent(STT_EVENT_MACHINE_BASE * state_table, const STT_EVENT_ACTION * state_actions, uint8_t num_states);
+	/*!
+	 * \brief Dispatches a single event
+	 *
+	 * Passes EVENT_ENTRY to the current state if it was just transitioned to, otherwise passes the oldest queued event.\n 
+	 * A state action returning a state outside the machine asserts in debug builds. Otherwise the transition is ignored and counted in STT_EVENT_MACHINE_BASE::invalid_transitions.
+	 *
+	 * \param state_table pointer to event driven state machine struct
+	 * \return true if an event was dispatched, false if there was no pending work
+	 */
+	template <uint8_t num_states>
+	bool DispatchEvent(STT_EVENT_MACHINE_T<num_states> * state_table)
+	{
+		return DispatchStateEvent(state_table, state_table->state_actions, num_states);
+	}
+	/*!
+	 * \brief Dispatches events until an event driven state machine is idle
+	 *
+	 * Call from your superloop, then sleep until the next interrupt if StateMachine::HasEvents() is false.
+	 *
+	 * \param state_table pointer to event driven state machine struct
+	 */
+	template <uint8_t num_states>
+	void ExecuteEvents(STT_EVENT_MACHINE_T<num_states> * state_table)
+	{
+		while(DispatchEvent(state_table));
+	}
+	/*!
+	 * \brief Super state processing function for event driven state machines.
+	 *
+	 * Same as StateMachine::ProcessSuperState(), except the event and its payload are also passed to the super state action.
+	 *
+	 * \param current_state pointer to current transitory state, used to preserve current sub-state if super state function doesn't transition
+	 * \param super_state value of super state which sub state belongs to
+	 * \param super_function address of event driven super state action function
+	 * \param event event being dispatched to sub state
+	 * \param data payload of event
+	 */
+	void ProcessSuperState(STT_STATE * current_state, STT_STATE super_state, STT_EVENT_ACTION super_function, STT_EVENT event, const STT_EVENT_DATA * data);
+
+	/*!
+	 * \brief Parent of a top level state in a hierarchical state machine.
+	 */
+	const STT_STATE STT_NO_PARENT = 0xFF;
+	/*!
+	 * \brief Returned by a hierarchical state action to pass the event to its parent state.
+	 */
+	const STT_STATE STT_UNHANDLED = 0xFE;
+	/*!
+	 * \brief Type definition for entry and exit action function pointer
+	 *
+	 * The function pointer which is called when a hierarchical state is entered or exited.
+	 */
+	typedef void (*STT_TRANSITION_ACTION)(void);
+	/*!
+	 * \brief Row of a hierarchical state machine table.
+	 *
+	 * Declare tables as constexpr arrays so they are placed in flash.
+	 */
+	struct STT_HSM_STATE {
+		STT_STATE parent;								//!< super state (STT_NO_PARENT if top level)
+		STT_TRANSITION_ACTION entry_action;				//!< called when state is entered (nullptr if none)
+		STT_TRANSITION_ACTION exit_action;				//!< called when state is exited (nullptr if none)
+		STT_EVENT_ACTION state_action;					//!< handles events, returns state to transition to, own state, or STT_UNHANDLED
+	};
+	/*!
+	 * \brief Hierarchical state machine struct containing the state table, current (leaf) state and pending events.
+	 */
+	struct STT_HSM {
+		const STT_HSM_STATE * state_table;				//!< table of states, indexed by STT_STATE
+		uint8_t num_states;								//!< number of rows in state table
+		STT_STATE current_state;						//!< current leaf state of machine
+		bool entry_pending;								//!< true if current state has not received EVENT_ENTRY yet
+		STT_EVENT_QUEUE queue;							//!< pending events
+		uint16_t invalid_transitions;					//!< number of state actions which returned a state outside the table (transition ignored)
+		#if STT_TRACE_ENABLE
+		STT_TRACE * trace = nullptr;					//!< trace of machine (nullptr if not traced)
+		#endif
+	};
+	/*!
+	 * \brief Checks that a state's parent chain ends at a top level state
+	 *
+	 * \param state_table hierarchical state table
+	 * \param num_states number of rows in state table
+	 * \param state state to check
+	 * \param steps number of parents already walked (default = 0)
+	 * \return true if state is valid and has no parent cycle, false otherwise
+	 */
+	constexpr bool HSMStateReachesTop(const STT_HSM_STATE * state_table, uint8_t num_states, STT_STATE state, uint8_t steps = 0)
+	{
+		return state == STT_NO_PARENT || (state < num_states && steps < num_states && HSMStateReachesTop(state_table, num_states, state_table[state].parent, steps + 1u));
+	}
+	/*!
+	 * \brief Compile-time check of a hierarchical state table
+	 *
+	 * Use in a static_assert to reject tables with missing state actions, invalid parents, or parent cycles.
+	 *
+	 * \param state_table hierarchical state table
+	 * \param num_states number of rows in state table
+	 * \param index first row to check (default = 0)
+	 * \return true if table is valid, false otherwise
+	 */
+	constexpr bool IsValidHSMTable(const STT_HSM_STATE * state_table, uint8_t num_states, uint8_t index = 0)
+	{
+		return index >= num_states || (state_table[index].state_action != nullptr && HSMStateReachesTop(state_table, num_states, state_table[index].parent) && IsValidHSMTable(state_table, num_states, index + 1u));
+	}
+	/*!
+	 * \brief Initializes a hierarchical state machine
+	 *
+	 * Empties event queue and enters the initial state from the top level down (calling entry actions). The initial state receives EVENT_ENTRY on the next dispatch.
+	 *
+	 * \param hsm pointer to hierarchical state machine struct
+	 * \param state_table hierarchical state table (must outlive the state machine)
+	 * \param num_states number of rows in state table
+	 * \param initial_state state to start in
+	 */
+	void InitHSM(STT_HSM * hsm, const STT_HSM_STATE * state_table, uint8_t num_states, STT_STATE initial_state);
+	/*!
+	 * \brief Posts an event to a hierarchical state machine
+	 *
+	 * Safe to call from an ISR.
+	 *
+	 * \param hsm pointer to hierarchical state machine struct
+	 * \param event event to post
+	 * \param data payload passed to the state actions with the event (default = nullptr, zeros)
+	 * \return success of posting (false if event queue is full)
+	 */
+	bool PostEvent(STT_HSM * hsm, STT_EVENT event, const STT_EVENT_DATA * data = nullptr);
+	/*!
+	 * \brief Checks if a hierarchical state machine has pending work
+	 *
+	 * \param hsm pointer to hierarchical state machine struct
+	 * \return true if an event is queued or the current state has not been entered yet, false otherwise
+	 */
+	bool HasEvents(const STT_HSM * hsm);
+	/*!
+	 * \brief Dispatches a single event to a hierarchical state machine
+	 *
+	 * The event is passed to the current state, then to each parent until a state action handles it.\n 
+	 * A state action returning a state outside the table asserts in debug builds. Otherwise the transition is ignored and counted in STT_HSM::invalid_transitions.
+	 *
+	 * \param hsm pointer to hierarchical state machine struct
+	 * \return true if an event was dispatched, false if there was no pending work
+	 */
+	bool DispatchEvent(STT_HSM * hsm);
+	/*!
+	 * \brief Dispatches events until a hierarchical state machine is idle
+	 *
+	 * \param hsm pointer to hierarchical state machine struct
+	 */
+	void ExecuteEvents(STT_HSM * hsm);
+	/*!
+	 * \brief Checks if a hierarchical state machine is in a state
+	 *
+	 * \param hsm pointer to hierarchical state machine struct
+	 * \param state state to check
+	 * \return true if state is the current state or one of its super states, false otherwise
+	 */
+	bool IsInState(const STT_HSM * hsm, STT_STATE state);
+
+	/*!
+	 * \brief Scheduling policy of a cooperative scheduler
+	 */
+	enum class SchedulePolicy : uint8_t {
+		RoundRobin,										//!< ready state machines take turns
+		Priority										//!< highest priority ready state machine runs first, equal priorities take turns
+	};
+	/*!
+	 * \brief Task of a cooperative scheduler, one per state machine.
+	 *
+	 * Create with StateMachine::MakeTask().
+	 */
+	struct STT_TASK {
+		void * machine;									//!< pointer to state machine
+		bool (* step)(void * machine);					//!< runs one state action or event, returns false if there was no work
+		bool (* is_ready)(const void * machine);		//!< returns true if state machine has work (nullptr for polled state machines)
+		bool (* poll_ready)(void);						//!< optional check if a polled state machine has work (nullptr = always ready)
+		uint8_t priority;								//!< priority of task (0 = highest)
+	};
+	/*!
+	 * \brief Cooperative scheduler struct containing all tasks.
+	 *
+	 * Runs one state action or event of one ready state machine per call of StateMachine::RunScheduler(). Machines without work are skipped.
+	 */
+	struct STT_SCHEDULER {
+		STT_TASK * tasks;								//!< array of tasks
+		uint8_t num_tasks;								//!< number of tasks
+		uint8_t next_task;								//!< task to check first on next run (round robin position)
+		SchedulePolicy policy;							//!< scheduling policy
+	};
+	/*!
+	 * \brief Runs one state action of a polled state machine (used by StateMachine::MakeTask())
+	 *
+	 * \param machine pointer to state machine
+	 * \return true
+	 */
+	template <uint8_t num_states>
+	bool StepPolledMachine(void * machine)
+	{
+		ExecuteAction(static_cast<STT_MACHINE_T<num_states> *>(machine));
+		return true;
+	}
+	/*!
+	 * \brief Creates a task for a polled state machine
+	 *
+	 * \param machine pointer to state machine
+	 * \param priority priority of task (default = 0, highest)
+	 * \param poll_ready function which returns true if the state machine has work, so it can be skipped while idle (default = nullptr, always ready)
+	 * \return task to add to a scheduler's task array
+	 */
+	template <uint8_t num_states>
+	STT_TASK MakeTask(STT_MACHINE_T<num_states> * machine, uint8_t priority = 0, bool (* poll_ready)(void) = nullptr)
+	{
+		return {machine, &StepPolledMachine<num_states>, nullptr, poll_ready, priority};
+	}
+	/*!
+	 * \brief Dispatches one event of an event driven state machine (used by StateMachine::MakeTask())
+	 *
+	 * \param machine pointer to event driven state machine
+	 * \return true if an event was dispatched, false if there was no pending work
+	 */
+	template <uint8_t num_states>
+	bool StepEventMachine(void * machine)
+	{
+		return DispatchEvent(static_cast<STT_EVENT_MACHINE_T<num_states> *>(machine));
+	}
+	/*!
+	 * \brief Checks if an event driven state machine has pending work (used by StateMachine::MakeTask())
+	 *
+	 * \param machine pointer to event driven state machine
+	 * \return true if an event is queued or the current state has not been entered yet, false otherwise
+	 */
+	template <uint8_t num_states>
+	bool IsEventMachineReady(const void * machine)
+	{
+		return HasEvents(static_cast<const STT_EVENT_MACHINE_T<num_states> *>(machine));
+	}
+	/*!
+	 * \brief Creates a task for an event driven state machine
+	 *
+	 * \param machine pointer to event driven state machine
+	 * \param priority priority of task (default = 0, highest)
+	 * \return task to add to a scheduler's task array
+	 */
+	template <uint8_t num_states>
+	STT_TASK MakeTask(STT_EVENT_MACHINE_T<num_states> * machine, uint8_t priority = 0)
+	{
+		return {machine, &StepEventMachine<num_states>, &IsEventMachineReady<num_states>, nullptr, priority};
+	}
+	/*!
+	 * \brief Creates a task for a hierarchical state machine
+	 *
+	 * \param machine pointer to hierarchical state machine
+	 * \param priority priority of task (default = 0, highest)
+	 * \return task to add to a scheduler's task array
+	 */
+	STT_TASK MakeTask(STT_HSM * machine, uint8_t priority = 0);
+	/*!
+	 * \brief Initializes a cooperative scheduler
+	 *
+	 * \param scheduler pointer to scheduler struct
+	 * \param tasks array of tasks (must outlive the scheduler)
+	 * \param num_tasks number of tasks
+	 * \param policy scheduling policy (default = SchedulePolicy::RoundRobin)
+	 */
+	void InitScheduler(STT_SCHEDULER * scheduler, STT_TASK * tasks, uint8_t num_tasks, SchedulePolicy policy = SchedulePolicy::RoundRobin);
+	/*!
+	 * \brief Checks if any task of a scheduler has work
+	 *
+	 * \param scheduler pointer to scheduler struct
+	 * \return true if a task is ready, false if all state machines are idle (safe to sleep)
+	 */
+	bool HasReadyTask(const STT_SCHEDULER * scheduler);
+	/*!
+	 * \brief Runs one state action or event of the next ready state machine
+	 *
+	 * Call in your superloop, and sleep until the next interrupt once it returns false.
+	 *
+	 * \param scheduler pointer to scheduler struct
+	 * \return true if a task was run, false if all state machines are idle
+	 */
+	bool RunScheduler(STT_SCHEDULER * scheduler);
+
+	#if STT_TRACE_ENABLE
+	/*!
+	 * \brief Trace record of a single transition
+	 *
+	 * All times are in ticks of the trace timer (refer to StateMachine::SetTraceTimer()).
+	 */
+	struct STT_TRACE_RECORD {
+		uint32_t timestamp;								//!< time the state action started
+		uint32_t action_ticks;							//!< execution time of the state action (including super state actions)
+		STT_STATE state;								//!< state which was exited
+		STT_STATE next_state;							//!< state which was entered
+	};
+	/*!
+	 * \brief Trace statistics of a single state
+	 */
+	struct STT_TRACE_STATS {
+		uint32_t entries;								//!< number of transitions into state
+		uint32_t actions;								//!< number of state action executions
+		uint32_t dwell_ticks;							//!< total time spent in state (updated when state is exited)
+		uint32_t action_ticks;							//!< total execution time of state action
+		uint32_t max_action_ticks;						//!< longest execution time of state action
+	};
+	/*!
+	 * \brief Trace of a single state machine
+	 *
+	 * Ring buffer of transitions and per-state statistics, indexed by the machine's own STT_STATE values. Attach one to each traced machine with StateMachine::SetTrace().
+	 */
+	struct STT_TRACE {
+		STT_TRACE_RECORD records[STT_TRACE_SIZE];		//!< ring buffer of transitions
+		STT_TRACE_STATS stats[STT_TRACE_NUM_STATES];	//!< statistics of each state
+		uint32_t state_entered;							//!< time the current state was entered
+		uint16_t head;									//!< index of next record to write
+		uint16_t count;									//!< number of valid records
+		uint16_t dropped;								//!< number of records overwritten since last clear
+		bool paused;									//!< true while tracing is paused
+	};
+	/*!
+	 * \brief Sets the time source of all traces
+	 *
+	 * Defaults to a std::chrono::steady_clock microsecond counter on host builds and no timer (all times 0) on target builds.
+	 * Call before StateMachine::SetTrace() so dwell times start from the new time source.
+	 *
+	 * \param timer_func function which returns a free running tick count (i.e. Util::getCycleCount())
+	 */
+	void SetTraceTimer(uint32_t (* timer_func)(void));
+	/*!
+	 * \brief Clears all trace records and statistics
+	 *
+	 * \param trace trace to clear
+	 */
+	void ClearTrace(STT_TRACE * trace);
+	/*!
+	 * \brief Attaches a trace to a state machine
+	 *
+	 * Clears the trace, then records every transition of machine into it. Works for all state machine types.
+	 *
+	 * \param machine pointer to state machine
+	 * \param trace trace to record into, must outlive the state machine (nullptr to stop tracing)
+	 */
+	template <typename machine_type>
+	void SetTrace(machine_type * machine, STT_TRACE * trace)
+	{
+		if(trace != nullptr) ClearTrace(trace);
+		machine->trace = trace;
+	}
+	/*!
+	 * \brief Pauses or resumes tracing
+	 *
+	 * Pause while dumping the trace so it doesn't change between calls of StateMachine::SerializeTrace().
+	 *
+	 * \param trace trace to pause or resume
+	 * \param pause true to pause, false to resume
+	 */
+	void PauseTrace(STT_TRACE * trace, bool pause);
+	/*!
+	 * \brief Getter for trace statistics of a state
+	 *
+	 * \param trace trace to get statistics from
+	 * \param state state to get statistics of
+	 * \return pointer to statistics (nullptr if state is not below STT_TRACE_NUM_STATES)
+	 */
+	const STT_TRACE_STATS * GetTraceStats(const STT_TRACE * trace, STT_STATE state);
+	/*!
+	 * \brief Serializes the trace into a compact little-endian binary format, to be sent over a serial link.
+	 *
+	 * Format: 'S', 'T', version (1), STT_TRACE_NUM_STATES, record count (uint16), overwritten record count (uint16),
+	 * STT_TRACE_NUM_STATES x STT_TRACE_STATS (5 x uint32), record count x STT_TRACE_RECORD (2 x uint32, 2 x uint8) oldest first.\n 
+	 * Call repeatedly with increasing offsets to send the trace in chunks smaller than the serial transmit buffer.
+	 *
+	 * \param trace trace to serialize
+	 * \param output array to serialize into
+	 * \param size maximum number of bytes to write
+	 * \param offset byte offset into serialized trace to start at (default = 0)
+	 * \return number of bytes written (0 once offset passes the end of the trace)
+	 */
+	uint32_t SerializeTrace(const STT_TRACE * trace, char * output, uint32_t size, uint32_t offset = 0);
+	#endif
 }
 
 #endif //__STATE_MACHINE_H__
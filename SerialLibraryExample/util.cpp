@@ -8,12 +8,22 @@
 #include "util.h"
 
 uint32_t Util::critical_section_count = 0;
+volatile uint32_t Util::cycle_counter_reloads = 0;
+
+namespace
+{
+    //interrupt state before the outermost Util::enterCriticalSection()
+    uint32_t critical_section_primask = 0;
+}
 
 void Util::enterCriticalSection()
 {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    //counter is only touched with interrupts disabled
     if(Util::critical_section_count == 0)
     {
-        __disable_irq();
+        critical_section_primask = primask;
     }
     Util::critical_section_count++;
 }
@@ -24,6 +34,52 @@ void Util::exitCriticalSection()
 
     if(Util::critical_section_count == 0)
     {
-        __enable_irq();
+        __set_PRIMASK(critical_section_primask);
+    }
+}
+
+void Util::waitForInterrupt(bool (* has_work)(void))
+{
+    if(Util::critical_section_count != 0 || __get_PRIMASK() != 0)
+    {
+        return;
+    }
+    //pending interrupts still wake the core while PRIMASK is set, and run once it is cleared
+    __disable_irq();
+    if(has_work == nullptr || !has_work())
+    {
+        __WFI();
     }
+    __enable_irq();
+}
+
+void Util::startCycleCounter()
+{
+    Util::cycle_counter_reloads = 0;
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+uint32_t Util::getCycleCount()
+{
+    uint32_t reloads;
+    uint32_t value;
+    bool pending;
+    //re-read if a reload was counted while reading the counter value
+    do
+    {
+        reloads = Util::cycle_counter_reloads;
+        value = SysTick->VAL;
+        //counter wrapped but SysTick_Handler hasn't run yet (interrupts masked), re-read so the value is after the wrap
+        pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+        if(pending) value = SysTick->VAL;
+    } while(reloads != Util::cycle_counter_reloads);
+    if(pending) reloads++;
+    return (reloads << 24) | (SysTick_LOAD_RELOAD_Msk - value);
+}
+
+void Util::cycleCounterISR()
+{
+    Util::cycle_counter_reloads++;
 }
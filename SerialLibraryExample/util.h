@@ -28,16 +28,78 @@ namespace Util
     /*!
      * \brief Exits a critical section.
      * 
-     * Declares the end of a critical section and re-enables interrupts if there are no nested critical sections currently being
-     * handled.
+     * Declares the end of a critical section and restores the interrupt state saved by the outermost
+     * Util::enterCriticalSection() if there are no nested critical sections currently being handled.
      */
     void exitCriticalSection();
+
+    /*!
+     * \brief Scoped critical section.
+     *
+     * Saves PRIMASK and disables interrupts on construction, then restores the saved PRIMASK on destruction. Nesting needs no
+     * shared counter, and a guard used where interrupts were already disabled (such as inside an interrupt handler running
+     * from a critical section) leaves them disabled.
+     */
+    class CriticalSection
+    {
+        public:
+            CriticalSection() : primask(__get_PRIMASK())
+            {
+                __disable_irq();
+            }
+            ~CriticalSection()
+            {
+                __set_PRIMASK(primask);
+            }
+            CriticalSection(const CriticalSection &) = delete;
+            CriticalSection & operator=(const CriticalSection &) = delete;
+
+        private:
+            uint32_t primask;
+    };
+
+    /*!
+     * \brief Sleeps until the next interrupt.
+     *
+     * Enters sleep (WFI) with interrupts masked, so an event raised between the check and sleep still wakes the core. Returns
+     * immediately if called inside a critical section (including Util::CriticalSection) or if has_work reports pending work.
+     *
+     * \param has_work optional function which returns true if there is work pending and sleep should be skipped (default = nullptr)
+     */
+    void waitForInterrupt(bool (* has_work)(void) = nullptr);
+
+    /*!
+     * \brief Starts the cycle counter.
+     *
+     * Configures SysTick as a free running down counter on the CPU clock (Cortex-M0+ has no DWT cycle counter). Call
+     * Util::cycleCounterISR() from SysTick_Handler() so the 24-bit counter is extended to 32 bits.
+     */
+    void startCycleCounter();
+
+    /*!
+     * \brief Gets the number of CPU cycles since Util::startCycleCounter() was called.
+     *
+     * Also correct with interrupts masked, as long as SysTick_Handler() is not held off for more than one 2^24 cycle reload.
+     *
+     * \return cycle count (wraps at 32 bits)
+     */
+    uint32_t getCycleCount();
+
+    /*!
+     * \brief Counts SysTick reloads of the cycle counter. Must be called from SysTick_Handler().
+     */
+    void cycleCounterISR();
 	/*!
      * \brief Keeps track of nested critical sections. Each additional entry into a critical section increments by 1 and each
-     *        exit decrements by 1. If it reaches zero then all nested critical sections have been exited and interrupts are
-     *        re-enabled. Should not be modified by the user.
+     *        exit decrements by 1. If it reaches zero then all nested critical sections have been exited and the saved interrupt
+     *        state is restored. Should not be modified by the user.
      */
 	extern uint32_t critical_section_count;
+	/*!
+     * \brief Number of times the 24-bit SysTick counter has reloaded since Util::startCycleCounter() was called. Should not be
+     *        modified by the user.
+     */
+	extern volatile uint32_t cycle_counter_reloads;
 }
 
 #endif
@@ -1,7 +1,10 @@
 import csv
 import os
+import sys
 from datetime import datetime
 
+PAYLOAD_TYPES = ["u32", "i32", "f32"]
+
 class State:
     def __init__(self, state_name = ""):
         self.state = state_name
@@ -9,6 +12,8 @@ class State:
         self.super = None
         self.isSuper = False
         self.events = {}
+        self.guards = {}
+        self.payloads = {}
     
     def set_default(self, default_state):
         self.default = default_state
@@ -24,6 +29,12 @@ class State:
 
     def add_event(self, event_name, event_result):
             self.events[event_name] = event_result
+
+    def set_guard(self, event_name, guard_name):
+        self.guards[event_name] = guard_name
+
+    def set_payload(self, event_name, payload_type):
+        self.payloads[event_name] = payload_type
     
     def __str__(self):
         out = ""
@@ -71,25 +82,33 @@ def populate_state_machine(input, state_machine):
         getDefault = False
         getSuper = False
         getEvent = False
+        getGuard = False
         eventName = ""
         isFirst = True
         for entry in row:
             if not isFirst:
                 if entry == "\s":
-                    if getDefault or getSuper or getEvent:
+                    if getDefault or getSuper or getEvent or getGuard:
                         print(f"Warning, invalid \s parameter in row {row[0]}")
                         return False
                     state_machine[row[0]].set_as_super()    
                 elif entry == "\DEFAULT":
-                    if getDefault or getSuper or getEvent:
+                    if getDefault or getSuper or getEvent or getGuard:
                         print(f"Warning, invalid \DEFAULT parameter in row {row[0]}")
                         return False
                     getDefault = True   
+                    eventName = ""
                 elif entry == "\SUPER":
-                    if getDefault or getSuper or getEvent:
+                    if getDefault or getSuper or getEvent or getGuard:
                         print(f"Warning, invalid \SUPER parameter in row {row[0]}")
                         return False
                     getSuper = True
+                    eventName = ""
+                elif entry == "\GUARD":
+                    if getDefault or getSuper or getEvent or getGuard or eventName not in state_machine[row[0]].events:
+                        print(f"Warning, invalid \GUARD parameter in row {row[0]}")
+                        return False
+                    getGuard = True
                 else:
                     if getDefault:
                         getDefault = False
@@ -109,13 +128,32 @@ def populate_state_machine(input, state_machine):
                             print(f"Warning, invalid event parameter {entry} in row {row[0]}")
                             return False
                         state_machine[row[0]].add_event(eventName, state_machine[entry])   
+                    elif getGuard:
+                        getGuard = False
+                        if entry in state_machine:
+                            print(f"Warning, state name used as guard in row {row[0]}")
+                            return False
+                        state_machine[row[0]].set_guard(eventName, entry)
+                        eventName = ""
                     else:
+                        # event with a payload is written as event_name(type)
+                        payloadType = None
+                        if entry.endswith(")") and "(" in entry:
+                            entry, payloadType = entry[:-1].split("(", 1)
+                            if payloadType not in PAYLOAD_TYPES:
+                                print(f"Warning, invalid payload type {payloadType} in row {row[0]}")
+                                return False
                         if entry in state_machine:
                             print(f"Warning, state name used as event in row {row[0]}")
                             return False
                         getEvent = True
                         eventName = entry
+                        if payloadType is not None:
+                            state_machine[row[0]].set_payload(eventName, payloadType)
             isFirst = False
+        if getDefault or getSuper or getEvent or getGuard:
+            print(f"Warning, missing parameter at end of row {row[0]}")
+            return False
     return True
 
 def write_header_on_file(file, filename, description):
@@ -139,7 +177,515 @@ def generate_string(raw_string, style="CamelCase"):
         out += part
     return out
 
-def create_code_from_csv(file_name):
+def get_ordered_events(state_machine):
+    # events of super states come first so they keep priority over sub-state events
+    events = []
+    for state in sorted(state_machine.values(), key=lambda x: not x.isSuper):
+        for event in state.events.keys():
+            if event not in events:
+                events.append(event)
+    return events
+
+def get_table_transition(state, event):
+    # outermost super state wins, matching ProcessSuperState() overriding sub-state transitions
+    next_state = None
+    current = state
+    while current is not None:
+        if event in current.events:
+            next_state = current.events[event]
+        current = current.super
+    if next_state is None:
+        next_state = state.default
+    return next_state
+
+def get_table_guard(state, event):
+    # guard of the transition chosen by get_table_transition()
+    guard = None
+    current = state
+    while current is not None:
+        if event in current.events:
+            guard = current.guards.get(event)
+        current = current.super
+    return guard
+
+def get_event_payloads(state_machine):
+    payloads = {}
+    for state in state_machine.values():
+        payloads.update(state.payloads)
+    return payloads
+
+def get_guards(state_machine):
+    guards = []
+    for state in state_machine.values():
+        for guard in state.guards.values():
+            if guard not in guards:
+                guards.append(guard)
+    return guards
+
+def get_event_condition(event, guard, payloads, data="&data"):
+    condition = f"{generate_string(event)}({data if event in payloads else ''})"
+    if guard is not None:
+        condition += f" && {generate_string(guard)}Guard({data})"
+    return condition
+
+def get_transitions(state):
+    # effective transitions of a state, including the events of its super states
+    transitions = {"\\DEFAULT": state.default}
+    current = state
+    while current is not None:
+        for event in current.events.keys():
+            transitions[event] = get_table_transition(state, event)
+        current = current.super
+    return transitions
+
+def get_state_events(state, events):
+    # events with a transition in the state's row (its own or a super state's), in priority order
+    transitions = get_transitions(state)
+    return [event for event in events if event in transitions]
+
+def is_overridden(state, event):
+    # outermost super state wins, so the event of an inner state never fires
+    current = state.super
+    while current is not None:
+        if event in current.events:
+            return True
+        current = current.super
+    return False
+
+def get_reachable_states(state_machine):
+    initial = list(state_machine.values())[0]
+    reachable = [initial]
+    i = 0
+    while i < len(reachable):
+        for next_state in get_transitions(reachable[i]).values():
+            if next_state not in reachable:
+                reachable.append(next_state)
+        i += 1
+    # super states are reachable through their sub-states
+    for state in list(reachable):
+        current = state.super
+        while current is not None:
+            if current not in reachable:
+                reachable.append(current)
+            current = current.super
+    return reachable
+
+def get_cycles(state_machine):
+    # strongly connected components (Tarjan) with more than one state
+    index = {}
+    low = {}
+    stack = []
+    cycles = []
+    def visit(state):
+        index[state] = low[state] = len(index)
+        stack.append(state)
+        for next_state in get_transitions(state).values():
+            if next_state not in index:
+                visit(next_state)
+                low[state] = min(low[state], low[next_state])
+            elif next_state in stack:
+                low[state] = min(low[state], index[next_state])
+        if low[state] == index[state]:
+            component = []
+            while component[-1:] != [state]:
+                component.append(stack.pop())
+            if len(component) > 1:
+                cycles.append(list(reversed(component)))
+    for state in state_machine.values():
+        if not state.isSuper and state not in index:
+            visit(state)
+    return cycles
+
+def analyze_state_machine(state_machine, strict=False):
+    print("Analyzing state machine...")
+    payloads = {}
+    for state in state_machine.values():
+        for event, payload in state.payloads.items():
+            if payloads.setdefault(event, payload) != payload:
+                print(f"Warning, event {event} has payload types {payloads[event]} and {payload}")
+                return False
+        ancestors = []
+        current = state.super
+        while current is not None:
+            if current is state or current in ancestors:
+                print(f"Warning, super state loop in row {state.state}")
+                return False
+            if not current.isSuper:
+                print(f"Warning, super state {current.state} of row {state.state} is not marked \\s")
+                return False
+            ancestors.append(current)
+            current = current.super
+        for event, next_state in list(state.events.items()) + [("\\DEFAULT", state.default)]:
+            if next_state.isSuper and next_state is not state:
+                print(f"Warning, {event} in row {state.state} transitions to super state {next_state.state}")
+                return False
+    warnings = 0
+    initial = list(state_machine.values())[0]
+    reachable = get_reachable_states(state_machine)
+    handled_events = []
+    for state in reachable:
+        if not state.isSuper:
+            handled_events.extend(get_transitions(state).keys())
+    for state in state_machine.values():
+        if state not in reachable:
+            print(f"Warning, state {state.state} is unreachable from initial state {initial.state}")
+            warnings += 1
+            continue
+        for event in state.events.keys():
+            if is_overridden(state, event):
+                print(f"Warning, event {event} in row {state.state} is always overridden by a super state")
+                warnings += 1
+        if not state.isSuper and all(s is state for s in get_transitions(state).values()):
+            print(f"Warning, state {state.state} can never be left")
+            warnings += 1
+    for event in get_ordered_events(state_machine):
+        if event not in handled_events:
+            print(f"Warning, event {event} is never handled by a reachable state")
+            warnings += 1
+    for cycle in get_cycles(state_machine):
+        print(f"Cycle: {' -> '.join([s.state for s in cycle])}")
+    print(f"Analysis found {warnings} warning(s)\n")
+    return not (strict and warnings)
+
+def optimize_state_machine(state_machine):
+    # drops unreachable states, then numbers states along default transitions (taken whenever no event occurs)
+    # so consecutive states sit in adjacent action and table entries
+    reachable = get_reachable_states(state_machine)
+    ordered = []
+    pending = [list(state_machine.values())[0]]
+    while pending:
+        state = pending.pop(0)
+        while state is not None and state not in ordered:
+            ordered.append(state)
+            next_states = [s for s in get_transitions(state).values() if not s.isSuper and s not in ordered]
+            pending.extend(next_states[1:])
+            state = next_states[0] if next_states else None
+    ordered.extend([s for s in state_machine.values() if s.isSuper and s in reachable])
+    print(f"Optimized state order: {', '.join([s.state for s in ordered])}\n")
+    return {state.state: state for state in ordered}
+
+def create_graphviz_file(path, file_name, state_machine):
+    initial = list(state_machine.values())[0]
+    reachable = get_reachable_states(state_machine)
+    with open(path, "w") as dotOut:
+        dotOut.write(f"digraph {generate_string(file_name)} {{\n")
+        dotOut.write("\trankdir=LR;\n")
+        for state in state_machine.values():
+            attributes = []
+            if state.isSuper:
+                attributes.append("shape=box, style=dashed")
+            if state is initial:
+                attributes.append("peripheries=2")
+            if state not in reachable:
+                attributes.append("color=gray, fontcolor=gray")
+            dotOut.write(f"\t\"{state.state}\"")
+            if attributes:
+                dotOut.write(f" [{', '.join(attributes)}]")
+            dotOut.write(";\n")
+        for state in state_machine.values():
+            if state.super is not None:
+                dotOut.write(f"\t\"{state.state}\" -> \"{state.super.state}\" [style=dotted, arrowhead=empty];\n")
+            if state.default is not state:
+                dotOut.write(f"\t\"{state.state}\" -> \"{state.default.state}\" [style=dashed, label=\"default\"];\n")
+            for event, next_state in state.events.items():
+                label = event
+                if event in state.guards:
+                    label += f" [{state.guards[event]}]"
+                dotOut.write(f"\t\"{state.state}\" -> \"{next_state.state}\" [label=\"{label}\"];\n")
+        dotOut.write("}\n")
+    print(f"{os.path.basename(path)} successfully generated!")
+
+def write_event_prototypes(hOut, events, payloads, guards):
+    for event in events:
+        event_name = generate_string(event,"Name")[:-1]
+        event_func = generate_string(event)
+        hOut.write("/*!\n")
+        hOut.write(f" * \\brief Your {event_name} event description\n")
+        hOut.write(" *\n")
+        hOut.write(f" * Your extended {event_name} event description\n")
+        hOut.write(" *\n")
+        if event in payloads:
+            hOut.write(f" * \\param data payload of event, set data->{payloads[event]} when event occurred\n")
+        hOut.write(" * \\return true if [event true description], false otherwise\n")
+        hOut.write(" */\n")
+        if event in payloads:
+            hOut.write(f"bool {event_func}(STT_EVENT_DATA * data);\n")
+        else:
+            hOut.write(f"bool {event_func}(void);\n")
+    for guard in guards:
+        guard_name = generate_string(guard,"Name")[:-1]
+        guard_func = generate_string(guard)
+        hOut.write("/*!\n")
+        hOut.write(f" * \\brief Your {guard_name} guard description\n")
+        hOut.write(" *\n")
+        hOut.write(" * Checked after its event occurred, the transition is only taken if the guard returns true.\n")
+        hOut.write(" *\n")
+        hOut.write(" * \\param data payload of event\n")
+        hOut.write(" * \\return true if transition is allowed, false otherwise\n")
+        hOut.write(" */\n")
+        hOut.write(f"bool {guard_func}Guard(const STT_EVENT_DATA * data);\n")
+
+def write_event_definitions(cOut, events, payloads, guards, event_result):
+    for event in events:
+        event_name = generate_string(event,"Name")[:-1]
+        event_func = generate_string(event)
+        if event in payloads:
+            cOut.write(f"bool {event_func}(STT_EVENT_DATA * data)\n")
+        else:
+            cOut.write(f"bool {event_func}(void)\n")
+        cOut.write("{\n")
+        if event in payloads:
+            cOut.write("\t(void)data;\n")
+        cOut.write("\t/*\n")
+        cOut.write(f"\t * TODO: implement {event_name} Event\n")
+        if event in payloads:
+            cOut.write(f"\t * store its payload in data->{payloads[event]}\n")
+        cOut.write("\t */\n")
+        cOut.write(f"\treturn {event_result};\n")
+        cOut.write("}\n\n")
+    if guards:
+        cOut.write("//guard functions\n\n")
+    for guard in guards:
+        guard_name = generate_string(guard,"Name")[:-1]
+        guard_func = generate_string(guard)
+        cOut.write(f"bool {guard_func}Guard(const STT_EVENT_DATA * data)\n")
+        cOut.write("{\n")
+        cOut.write("\t(void)data;\n")
+        cOut.write("\t/*\n")
+        cOut.write(f"\t * TODO: implement {guard_name} Guard\n")
+        cOut.write("\t */\n")
+        cOut.write("\treturn true;\n")
+        cOut.write("}\n\n")
+
+def create_table_code(file_name, state_machine):
+    states = [s for s in state_machine.values() if not s.isSuper]
+    events = get_ordered_events(state_machine)
+    payloads = get_event_payloads(state_machine)
+    guards = get_guards(state_machine)
+    namespace = generate_string(file_name)
+    fNameAllCaps = generate_string(file_name, "ALL_CAPS")
+    with open(os.path.join(file_name+"_c",f"{file_name}.h"),"w") as hOut:
+        write_header_on_file(hOut, f"{file_name}.h", "State, event, transition table, and function definitions for your table-driven state machine.")
+        hOut.write(f"#ifndef __{fNameAllCaps}H__\n")
+        hOut.write(f"#define __{fNameAllCaps}H__\n\n")
+        hOut.write("#include \"state_machine.h\"\n\n")
+        hOut.write("#ifdef __cplusplus\n")
+        hOut.write("extern \"C\" {\n")
+        hOut.write("#endif\n\n")
+        hOut.write("//Add your includes---------------------\n\n\n")
+        hOut.write("//Add your macros-----------------------\n\n\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Defined enum of STT_STATE_T\n")
+        hOut.write(" *\n")
+        hOut.write(" * Enum for all implemented states. Super states are merged into their sub-states' transition table rows.\n")
+        hOut.write(" */\n")
+        hOut.write("typedef enum STT_STATE_T\n{\n")
+        for i, state in enumerate(states):
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            hOut.write(f"\t{state_enum}")
+            if i < len(states) - 1:
+                hOut.write(",")
+            hOut.write("\n")
+        hOut.write("} STT_STATE_T;\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Defined enum of STT_EVENT_T\n")
+        hOut.write(" *\n")
+        hOut.write(" * Enum for all events, NO_EVENT selects each state's default transition.\n")
+        hOut.write(" */\n")
+        hOut.write("typedef enum STT_EVENT_T\n{\n")
+        hOut.write("\tNO_EVENT,\n")
+        for event in events:
+            event_enum = generate_string(event, "ALL_CAPS")[:-1]
+            hOut.write(f"\t{event_enum},\n")
+        hOut.write("\tNUM_STT_EVENTS\n")
+        hOut.write("} STT_EVENT_T;\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Type definition for table-driven state action function pointer\n")
+        hOut.write(" *\n")
+        hOut.write(" * The function pointer which performs all actions during a specific state, given the event read this cycle. Transitions are handled by the transition table.\n")
+        hOut.write(" */\n")
+        hOut.write("typedef void (*STT_TABLE_ACTION)(STT_EVENT_T event, const STT_EVENT_DATA * data);\n")
+        if guards:
+            hOut.write("/*!\n")
+            hOut.write(" * \\brief Type definition for guard function pointer\n")
+            hOut.write(" *\n")
+            hOut.write(" * The function pointer which allows (true) or blocks (false) a transition, given the payload of its event.\n")
+            hOut.write(" */\n")
+            hOut.write("typedef bool (*STT_GUARD)(const STT_EVENT_DATA * data);\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Sets initial state of state machine\n")
+        hOut.write(" *\n")
+        hOut.write(" * \\param current_state pointer to state variable of state machine\n")
+        hOut.write(" */\n")
+        hOut.write(f"void Get{namespace}(STT_STATE * current_state);\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Looks up the state to transition to\n")
+        hOut.write(" *\n")
+        hOut.write(" * \\param current_state current state of state machine\n")
+        hOut.write(" * \\param event event which occurred (NO_EVENT for default transition)\n")
+        hOut.write(" * \\param data payload of event, passed to the transition's guard\n")
+        hOut.write(" * \\return state to transition to (current state if a guard blocks the transition)\n")
+        hOut.write(" */\n")
+        hOut.write("STT_STATE GetNextState(STT_STATE current_state, STT_EVENT_T event, const STT_EVENT_DATA * data);\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Dispatch loop of state machine\n")
+        hOut.write(" *\n")
+        hOut.write(" * Reads one event with GetEvent(), performs the current state action with it and transitions with a single table lookup. Call in your superloop.\n")
+        hOut.write(" *\n")
+        hOut.write(" * \\param current_state pointer to state variable of state machine\n")
+        hOut.write(" */\n")
+        hOut.write("void ExecuteTable(STT_STATE * current_state);\n")
+        for state in states:
+            stateName = generate_string(state.state,"Name")[:-1]
+            state_cap = generate_string(state.state, "ALL_CAPS")[:-1]
+            state_function = generate_string(state.state)
+            hOut.write("/*!\n")
+            hOut.write(f" * \\brief {stateName} State action function ({state_cap})\n")
+            hOut.write(" *\n")
+            hOut.write(f" * Your description for {stateName} State action function\n")
+            hOut.write(" *\n")
+            hOut.write(" * \\param event event read this cycle (NO_EVENT if none)\n")
+            hOut.write(" * \\param data payload of event\n")
+            hOut.write(" */\n")
+            hOut.write(f"void {state_function}StateAction(STT_EVENT_T event, const STT_EVENT_DATA * data);\n")
+        hOut.write("\n//common action functions and events----------------\n\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Reads the next event\n")
+        hOut.write(" *\n")
+        hOut.write(" * Returns the highest priority event which occurred, or NO_EVENT. Only the events with a transition in the current state are checked.\n")
+        hOut.write(" *\n")
+        hOut.write(" * \\param current_state current state of state machine\n")
+        hOut.write(" * \\param data payload of event (filled in by events with a payload type)\n")
+        hOut.write(" * \\return event to dispatch\n")
+        hOut.write(" */\n")
+        hOut.write("STT_EVENT_T GetEvent(STT_STATE current_state, STT_EVENT_DATA * data);\n")
+        hOut.write("/* #######################################################################################################################\n")
+        hOut.write(" * TODO: add function prototypes here for common actions and modify/add events below to implement your state machine here.\n")
+        hOut.write(" * #######################################################################################################################\n")
+        hOut.write(" */\n\n")
+        write_event_prototypes(hOut, events, payloads, guards)
+        hOut.write("\n#ifdef __cplusplus\n")
+        hOut.write("}\n")
+        hOut.write("#endif\n\n")
+        hOut.write(f"#endif //__{fNameAllCaps}H__\n")
+    print(f"{file_name}.h successfully generated!")
+    with open(os.path.join(file_name+"_c",f"{file_name}.c"),"w") as cOut:
+        write_header_on_file(cOut, f"{file_name}.c", "State, event, transition table, and function definitions for your table-driven state machine.")
+        cOut.write(f"#include \"{file_name}.h\"\n\n")
+        if guards:
+            cOut.write("#include <stddef.h>\n\n")
+        cOut.write("//Add your public vars----------------\n\n\n")
+        cOut.write("//transition and action tables (placed in flash)\n")
+        cOut.write("//[state][event] -> next state\n")
+        cOut.write("static const STT_STATE TRANSITION_TABLE[NUM_STT_STATES][NUM_STT_EVENTS] = {\n")
+        event_header = "NO_EVENT"
+        for event in events:
+            event_header += ", " + generate_string(event, "ALL_CAPS")[:-1]
+        cOut.write(f"\t//{event_header}\n")
+        for i, state in enumerate(states):
+            row = [generate_string(state.default.state, "ALL_CAPS")[:-1]]
+            for event in events:
+                row.append(generate_string(get_table_transition(state, event).state, "ALL_CAPS")[:-1])
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            cOut.write(f"\t{{{', '.join(row)}}}")
+            if i < len(states) - 1:
+                cOut.write(",")
+            cOut.write(f"\t\t//{state_enum}\n")
+        cOut.write("};\n")
+        if guards:
+            cOut.write("//[state][event] -> guard of transition (NULL if none)\n")
+            cOut.write("static const STT_GUARD GUARD_TABLE[NUM_STT_STATES][NUM_STT_EVENTS] = {\n")
+            for i, state in enumerate(states):
+                row = ["NULL"]
+                for event in events:
+                    guard = get_table_guard(state, event)
+                    row.append(f"&{generate_string(guard)}Guard" if guard is not None else "NULL")
+                state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+                cOut.write(f"\t{{{', '.join(row)}}}")
+                if i < len(states) - 1:
+                    cOut.write(",")
+                cOut.write(f"\t\t//{state_enum}\n")
+            cOut.write("};\n")
+        cOut.write("static const STT_TABLE_ACTION STATE_ACTIONS[NUM_STT_STATES] = {\n")
+        for i, state in enumerate(states):
+            state_func = generate_string(state.state)
+            cOut.write(f"\t&{state_func}StateAction")
+            if i < len(states) - 1:
+                cOut.write(",")
+            cOut.write("\n")
+        cOut.write("};\n\n")
+        cOut.write("//state machine getter\n")
+        init_state = generate_string(list(state_machine.keys())[0], "ALL_CAPS")[:-1]
+        cOut.write(f"void Get{namespace}(STT_STATE * current_state)\n")
+        cOut.write("{\n")
+        cOut.write(f"\t*current_state = {init_state};\n")
+        cOut.write("}\n\n")
+        cOut.write("//dispatch functions\n")
+        cOut.write("STT_STATE GetNextState(STT_STATE current_state, STT_EVENT_T event, const STT_EVENT_DATA * data)\n")
+        cOut.write("{\n")
+        if guards:
+            cOut.write("\tSTT_GUARD guard = GUARD_TABLE[current_state][event];\n")
+            cOut.write("\tif(guard != NULL && !guard(data)) return current_state;\n")
+        else:
+            cOut.write("\t(void)data;\n")
+        cOut.write("\treturn TRANSITION_TABLE[current_state][event];\n")
+        cOut.write("}\n\n")
+        cOut.write("void ExecuteTable(STT_STATE * current_state)\n")
+        cOut.write("{\n")
+        cOut.write("\tSTT_EVENT_DATA data = {0};\n")
+        cOut.write("\tSTT_EVENT_T event = GetEvent(*current_state, &data);\n")
+        cOut.write("\tSTATE_ACTIONS[*current_state](event, &data);\n")
+        cOut.write("\t*current_state = GetNextState(*current_state, event, &data);\n")
+        cOut.write("}\n\n")
+        cOut.write("//state action functions\n")
+        for state in states:
+            state_func = generate_string(state.state)
+            state_name = generate_string(state.state, "Name")[:-1]
+            cOut.write(f"void {state_func}StateAction(STT_EVENT_T event, const STT_EVENT_DATA * data)\n")
+            cOut.write("{\n")
+            cOut.write("\t(void)event;\n")
+            cOut.write("\t(void)data;\n")
+            cOut.write("\t/*\n")
+            cOut.write(f"\t * TODO: implement actions for {state_name} State\n")
+            cOut.write("\t */\n")
+            cOut.write("}\n\n")
+        cOut.write("//common event functions\n\n")
+        cOut.write("STT_EVENT_T GetEvent(STT_STATE current_state, STT_EVENT_DATA * data)\n")
+        cOut.write("{\n")
+        cOut.write("\t/*\n")
+        cOut.write("\t * TODO: replace polling with events posted from ISRs if desired, earlier events have higher priority\n")
+        cOut.write("\t */\n")
+        if not [e for e in events if e in payloads]:
+            cOut.write("\t(void)data;\n")
+        cOut.write("\tswitch(current_state)\n")
+        cOut.write("\t{\n")
+        for state in states:
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            cOut.write(f"\t\tcase {state_enum}:\n")
+            for event in get_state_events(state, events):
+                event_func = generate_string(event)
+                event_enum = generate_string(event, "ALL_CAPS")[:-1]
+                cOut.write(f"\t\t\tif({event_func}({'data' if event in payloads else ''})) return {event_enum};\n")
+            cOut.write("\t\t\tbreak;\n")
+        cOut.write("\t\tdefault:\n")
+        cOut.write("\t\t\tbreak;\n")
+        cOut.write("\t}\n")
+        cOut.write("\treturn NO_EVENT;\n")
+        cOut.write("}\n\n")
+        cOut.write("/* ############################################################\n")
+        cOut.write(" * TODO: add/remove/implement event function definitions below.\n")
+        cOut.write(" * ############################################################\n")
+        cOut.write(" */\n\n")
+        write_event_definitions(cOut, events, payloads, guards, "false")
+        cOut.write("//common action functions\n\n")
+        cOut.write("/* #############################################\n")
+        cOut.write(" * TODO: implement common action functions here.\n")
+        cOut.write(" * #############################################\n")
+        cOut.write(" */\n\n")
+    print(f"{file_name}.c successfully generated!")
+    return True
+
+def create_code_from_csv(file_name, table_mode=False, optimize=False, strict=False):
     MY_STATE_MACHINE = "my_state_machine"
     input = read_csv(file_name)
     print(f"Reading from {file_name}...\n")
@@ -147,6 +693,10 @@ def create_code_from_csv(file_name):
     state_machine = {}
     if not(initialize_state_machine(input, state_machine) and populate_state_machine(input, state_machine)):
         return False
+    if not analyze_state_machine(state_machine, strict):
+        return False
+    if optimize:
+        state_machine = optimize_state_machine(state_machine)
     for state in state_machine.values():
         print(state)
     print("\n")
@@ -154,6 +704,7 @@ def create_code_from_csv(file_name):
         file_name = MY_STATE_MACHINE
     if not os.path.isdir(file_name + "_c"):
         os.mkdir(file_name+"_c")
+    create_graphviz_file(os.path.join(file_name+"_c",f"{file_name}.dot"), file_name, state_machine)
     with open(os.path.join(file_name+"_c","state_machine.h"),"w") as hOut:
         write_header_on_file(hOut, "state_machine.h", "Simple process manager for creating streamlined code with multiple states, events, and actions.")
         hOut.write("#ifndef __STATE_MACHINE_H__\n")
@@ -180,6 +731,16 @@ def create_code_from_csv(file_name):
         hOut.write(" */\n")
         hOut.write("typedef STT_STATE (*STT_ACTION)(void);\n")
         hOut.write("/*!\n")
+        hOut.write(" * \\brief Payload of an event\n")
+        hOut.write(" *\n")
+        hOut.write(" * Filled in by event functions with a payload type, and passed to guard functions.\n")
+        hOut.write(" */\n")
+        hOut.write("typedef union STT_EVENT_DATA {\n")
+        hOut.write("\tuint32_t u32;\t\t//!< unsigned integer payload\n")
+        hOut.write("\tint32_t i32;\t\t//!< signed integer payload\n")
+        hOut.write("\tfloat f32;\t\t\t//!< floating point payload\n")
+        hOut.write("} STT_EVENT_DATA;\n")
+        hOut.write("/*!\n")
         hOut.write(" * \\brief State machine struct containing the base state and all rows in the program.\n")
         hOut.write(" *\n")
         hOut.write(" * Contains the current state of the state machine and array of state action functions.\n")
@@ -227,7 +788,11 @@ def create_code_from_csv(file_name):
         cppOut.write("\t\t*current_state = temp_state;\n")
         cppOut.write("}\n")
     print("state_machine.c successfully generated!")
+    if table_mode:
+        return create_table_code(file_name, state_machine)
     all_events = []
+    payloads = get_event_payloads(state_machine)
+    guards = get_guards(state_machine)
     with open(os.path.join(file_name+"_c",f"{file_name}.h"),"w") as hOut:
         write_header_on_file(hOut, f"{file_name}.h", "State, event, action, and function definitions for your state machine.")
         fNameAllCaps = generate_string(file_name, "ALL_CAPS")
@@ -302,17 +867,7 @@ def create_code_from_csv(file_name):
         hOut.write(" * #######################################################################################################################\n")
         hOut.write(" */\n\n")
         all_events = [*set(all_events)]
-        for event in all_events:
-            event_name = generate_string(event,"Name")[:-1]
-            event_func = generate_string(event)
-            hOut.write("/*!\n")
-            hOut.write(f" * \\brief Your {event_name} event description\n")
-            hOut.write(" *\n")
-            hOut.write(f" * Your extended {event_name} event description\n")
-            hOut.write(" *\n")
-            hOut.write(" * \\return true if [event true description], false otherwise\n")
-            hOut.write(" */\n")
-            hOut.write(f"bool {event_func}(void);\n")
+        write_event_prototypes(hOut, all_events, payloads, guards)
         hOut.write("\n#ifdef __cplusplus\n")
         hOut.write("}\n")
         hOut.write("#endif\n\n")
@@ -345,18 +900,20 @@ def create_code_from_csv(file_name):
             if state.super:
                 cppOut.write(f"\tSTT_STATE current_state = {state_default};\n")
                 state_trans_str = "current_state = "
+            if state.guards or [e for e in state.events.keys() if e in payloads]:
+                cppOut.write("\tSTT_EVENT_DATA data = {0};\n")
             cppOut.write("\t/*\n")
             cppOut.write(f"\t * TODO: implement actions for {state_name} State\n")
             cppOut.write("\t */\n")
             else_suffix = ""
             for event, s in state.events.items():
                 next_state = generate_string(s.state, "ALL_CAPS")[:-1]
-                event_func = generate_string(event)
                 event_name = generate_string(event, "Name")[:-1]
-                cppOut.write(f"\t{else_suffix}if({event_func}())\n")
+                payload_str = f" (payload in data.{payloads[event]})" if event in payloads else ""
+                cppOut.write(f"\t{else_suffix}if({get_event_condition(event, state.guards.get(event), payloads)})\n")
                 cppOut.write("\t{\n")
                 cppOut.write("\t\t/*\n")
-                cppOut.write(f"\t\t * TODO: implement actions for {event_name} Event\n")
+                cppOut.write(f"\t\t * TODO: implement actions for {event_name} Event{payload_str}\n")
                 cppOut.write("\t\t */\n")
                 cppOut.write(f"\t\t{state_trans_str}{next_state};\n")
                 cppOut.write("\t}\n")
@@ -374,16 +931,7 @@ def create_code_from_csv(file_name):
         cppOut.write(" * TODO: add/remove/implement event function definitions below.\n")
         cppOut.write(" * ############################################################\n")
         cppOut.write(" */\n\n")
-        for event in all_events:
-            event_name = generate_string(event,"Name")[:-1]
-            event_func = generate_string(event)
-            cppOut.write(f"bool {event_func}(void)\n")
-            cppOut.write("{\n")
-            cppOut.write("\t/*\n")
-            cppOut.write(f"\t * TODO: implement {event_name} Event\n")
-            cppOut.write("\t */\n")
-            cppOut.write("\treturn true;\n")
-            cppOut.write("}\n\n")
+        write_event_definitions(cppOut, all_events, payloads, guards, "true")
         cppOut.write("//common action functions\n\n")
         cppOut.write("/* #############################################\n")
         cppOut.write(" * TODO: implement common action functions here.\n")
@@ -394,12 +942,15 @@ def create_code_from_csv(file_name):
 
 
 def main():
+    table_mode = "--table" in sys.argv[1:]
+    optimize = "--optimize" in sys.argv[1:]
+    strict = "--strict" in sys.argv[1:]
     files = get_csv_files_in_dir()
     if not files:
         print("Could not find csv file in directory!")
         return
     for file in files:
-        create_code_from_csv(file)
+        create_code_from_csv(file, table_mode, optimize, strict)
     
 
 
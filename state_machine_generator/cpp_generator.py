@@ -1,7 +1,10 @@
 import csv
 import os
+import sys
 from datetime import datetime
 
+PAYLOAD_TYPES = ["u32", "i32", "f32"]
+
 class State:
     def __init__(self, state_name = ""):
         self.state = state_name
@@ -9,6 +12,8 @@ class State:
         self.super = None
         self.isSuper = False
         self.events = {}
+        self.guards = {}
+        self.payloads = {}
     
     def set_default(self, default_state):
         self.default = default_state
@@ -24,6 +29,12 @@ class State:
 
     def add_event(self, event_name, event_result):
             self.events[event_name] = event_result
+
+    def set_guard(self, event_name, guard_name):
+        self.guards[event_name] = guard_name
+
+    def set_payload(self, event_name, payload_type):
+        self.payloads[event_name] = payload_type
     
     def __str__(self):
         out = ""
@@ -71,25 +82,33 @@ def populate_state_machine(input, state_machine):
         getDefault = False
         getSuper = False
         getEvent = False
+        getGuard = False
         eventName = ""
         isFirst = True
         for entry in row:
             if not isFirst:
                 if entry == "\s":
-                    if getDefault or getSuper or getEvent:
+                    if getDefault or getSuper or getEvent or getGuard:
                         print(f"Warning, invalid \s parameter in row {row[0]}")
                         return False
                     state_machine[row[0]].set_as_super()    
                 elif entry == "\DEFAULT":
-                    if getDefault or getSuper or getEvent:
+                    if getDefault or getSuper or getEvent or getGuard:
                         print(f"Warning, invalid \DEFAULT parameter in row {row[0]}")
                         return False
                     getDefault = True   
+                    eventName = ""
                 elif entry == "\SUPER":
-                    if getDefault or getSuper or getEvent:
+                    if getDefault or getSuper or getEvent or getGuard:
                         print(f"Warning, invalid \SUPER parameter in row {row[0]}")
                         return False
                     getSuper = True
+                    eventName = ""
+                elif entry == "\GUARD":
+                    if getDefault or getSuper or getEvent or getGuard or eventName not in state_machine[row[0]].events:
+                        print(f"Warning, invalid \GUARD parameter in row {row[0]}")
+                        return False
+                    getGuard = True
                 else:
                     if getDefault:
                         getDefault = False
@@ -109,13 +128,32 @@ def populate_state_machine(input, state_machine):
                             print(f"Warning, invalid event parameter {entry} in row {row[0]}")
                             return False
                         state_machine[row[0]].add_event(eventName, state_machine[entry])   
+                    elif getGuard:
+                        getGuard = False
+                        if entry in state_machine:
+                            print(f"Warning, state name used as guard in row {row[0]}")
+                            return False
+                        state_machine[row[0]].set_guard(eventName, entry)
+                        eventName = ""
                     else:
+                        # event with a payload is written as event_name(type)
+                        payloadType = None
+                        if entry.endswith(")") and "(" in entry:
+                            entry, payloadType = entry[:-1].split("(", 1)
+                            if payloadType not in PAYLOAD_TYPES:
+                                print(f"Warning, invalid payload type {payloadType} in row {row[0]}")
+                                return False
                         if entry in state_machine:
                             print(f"Warning, state name used as event in row {row[0]}")
                             return False
                         getEvent = True
                         eventName = entry
+                        if payloadType is not None:
+                            state_machine[row[0]].set_payload(eventName, payloadType)
             isFirst = False
+        if getDefault or getSuper or getEvent or getGuard:
+            print(f"Warning, missing parameter at end of row {row[0]}")
+            return False
     return True
 
 def write_header_on_file(file, filename, description):
@@ -139,7 +177,672 @@ def generate_string(raw_string, style="CamelCase"):
         out += part
     return out
 
-def create_code_from_csv(file_name):
+def get_ordered_events(state_machine):
+    # events of super states come first so they keep priority over sub-state events
+    events = []
+    for state in sorted(state_machine.values(), key=lambda x: not x.isSuper):
+        for event in state.events.keys():
+            if event not in events:
+                events.append(event)
+    return events
+
+def get_table_transition(state, event):
+    # outermost super state wins, matching ProcessSuperState() overriding sub-state transitions
+    next_state = None
+    current = state
+    while current is not None:
+        if event in current.events:
+            next_state = current.events[event]
+        current = current.super
+    if next_state is None:
+        next_state = state.default
+    return next_state
+
+def get_table_guard(state, event):
+    # guard of the transition chosen by get_table_transition()
+    guard = None
+    current = state
+    while current is not None:
+        if event in current.events:
+            guard = current.guards.get(event)
+        current = current.super
+    return guard
+
+def get_event_payloads(state_machine):
+    payloads = {}
+    for state in state_machine.values():
+        payloads.update(state.payloads)
+    return payloads
+
+def get_guards(state_machine):
+    guards = []
+    for state in state_machine.values():
+        for guard in state.guards.values():
+            if guard not in guards:
+                guards.append(guard)
+    return guards
+
+def get_event_condition(event, guard, payloads, data="&data"):
+    condition = f"{generate_string(event)}({data if event in payloads else ''})"
+    if guard is not None:
+        condition += f" && {generate_string(guard)}Guard({data})"
+    return condition
+
+def get_transitions(state):
+    # effective transitions of a state, including the events of its super states
+    transitions = {"\\DEFAULT": state.default}
+    current = state
+    while current is not None:
+        for event in current.events.keys():
+            transitions[event] = get_table_transition(state, event)
+        current = current.super
+    return transitions
+
+def get_state_events(state, events):
+    # events with a transition in the state's row (its own or a super state's), in priority order
+    transitions = get_transitions(state)
+    return [event for event in events if event in transitions]
+
+def is_overridden(state, event):
+    # outermost super state wins, so the event of an inner state never fires
+    current = state.super
+    while current is not None:
+        if event in current.events:
+            return True
+        current = current.super
+    return False
+
+def get_reachable_states(state_machine):
+    initial = list(state_machine.values())[0]
+    reachable = [initial]
+    i = 0
+    while i < len(reachable):
+        for next_state in get_transitions(reachable[i]).values():
+            if next_state not in reachable:
+                reachable.append(next_state)
+        i += 1
+    # super states are reachable through their sub-states
+    for state in list(reachable):
+        current = state.super
+        while current is not None:
+            if current not in reachable:
+                reachable.append(current)
+            current = current.super
+    return reachable
+
+def get_cycles(state_machine):
+    # strongly connected components (Tarjan) with more than one state
+    index = {}
+    low = {}
+    stack = []
+    cycles = []
+    def visit(state):
+        index[state] = low[state] = len(index)
+        stack.append(state)
+        for next_state in get_transitions(state).values():
+            if next_state not in index:
+                visit(next_state)
+                low[state] = min(low[state], low[next_state])
+            elif next_state in stack:
+                low[state] = min(low[state], index[next_state])
+        if low[state] == index[state]:
+            component = []
+            while component[-1:] != [state]:
+                component.append(stack.pop())
+            if len(component) > 1:
+                cycles.append(list(reversed(component)))
+    for state in state_machine.values():
+        if not state.isSuper and state not in index:
+            visit(state)
+    return cycles
+
+def analyze_state_machine(state_machine, strict=False, hsm_mode=False):
+    print("Analyzing state machine...")
+    payloads = {}
+    for state in state_machine.values():
+        for event, payload in state.payloads.items():
+            if payloads.setdefault(event, payload) != payload:
+                print(f"Warning, event {event} has payload types {payloads[event]} and {payload}")
+                return False
+        ancestors = []
+        current = state.super
+        while current is not None:
+            if current is state or current in ancestors:
+                print(f"Warning, super state loop in row {state.state}")
+                return False
+            if not current.isSuper:
+                print(f"Warning, super state {current.state} of row {state.state} is not marked \\s")
+                return False
+            ancestors.append(current)
+            current = current.super
+        for event, next_state in list(state.events.items()) + [("\\DEFAULT", state.default)]:
+            if next_state.isSuper and next_state is not state:
+                print(f"Warning, {event} in row {state.state} transitions to super state {next_state.state}")
+                return False
+    warnings = 0
+    initial = list(state_machine.values())[0]
+    reachable = get_reachable_states(state_machine)
+    handled_events = []
+    for state in reachable:
+        if not state.isSuper:
+            handled_events.extend(get_transitions(state).keys())
+    for state in state_machine.values():
+        if state not in reachable:
+            print(f"Warning, state {state.state} is unreachable from initial state {initial.state}")
+            warnings += 1
+            continue
+        for event in state.events.keys():
+            # a hierarchical state machine passes events to the innermost state first, so nothing is overridden
+            if not hsm_mode and is_overridden(state, event):
+                print(f"Warning, event {event} in row {state.state} is always overridden by a super state")
+                warnings += 1
+        if not state.isSuper and all(s is state for s in get_transitions(state).values()):
+            print(f"Warning, state {state.state} can never be left")
+            warnings += 1
+    for event in get_ordered_events(state_machine):
+        if event not in handled_events:
+            print(f"Warning, event {event} is never handled by a reachable state")
+            warnings += 1
+    for cycle in get_cycles(state_machine):
+        print(f"Cycle: {' -> '.join([s.state for s in cycle])}")
+    print(f"Analysis found {warnings} warning(s)\n")
+    return not (strict and warnings)
+
+def optimize_state_machine(state_machine):
+    # drops unreachable states, then numbers states along default transitions (taken whenever no event occurs)
+    # so consecutive states sit in adjacent action and table entries
+    reachable = get_reachable_states(state_machine)
+    ordered = []
+    pending = [list(state_machine.values())[0]]
+    while pending:
+        state = pending.pop(0)
+        while state is not None and state not in ordered:
+            ordered.append(state)
+            next_states = [s for s in get_transitions(state).values() if not s.isSuper and s not in ordered]
+            pending.extend(next_states[1:])
+            state = next_states[0] if next_states else None
+    ordered.extend([s for s in state_machine.values() if s.isSuper and s in reachable])
+    print(f"Optimized state order: {', '.join([s.state for s in ordered])}\n")
+    return {state.state: state for state in ordered}
+
+def create_graphviz_file(path, file_name, state_machine):
+    initial = list(state_machine.values())[0]
+    reachable = get_reachable_states(state_machine)
+    with open(path, "w") as dotOut:
+        dotOut.write(f"digraph {generate_string(file_name)} {{\n")
+        dotOut.write("\trankdir=LR;\n")
+        for state in state_machine.values():
+            attributes = []
+            if state.isSuper:
+                attributes.append("shape=box, style=dashed")
+            if state is initial:
+                attributes.append("peripheries=2")
+            if state not in reachable:
+                attributes.append("color=gray, fontcolor=gray")
+            dotOut.write(f"\t\"{state.state}\"")
+            if attributes:
+                dotOut.write(f" [{', '.join(attributes)}]")
+            dotOut.write(";\n")
+        for state in state_machine.values():
+            if state.super is not None:
+                dotOut.write(f"\t\"{state.state}\" -> \"{state.super.state}\" [style=dotted, arrowhead=empty];\n")
+            if state.default is not state:
+                dotOut.write(f"\t\"{state.state}\" -> \"{state.default.state}\" [style=dashed, label=\"default\"];\n")
+            for event, next_state in state.events.items():
+                label = event
+                if event in state.guards:
+                    label += f" [{state.guards[event]}]"
+                dotOut.write(f"\t\"{state.state}\" -> \"{next_state.state}\" [label=\"{label}\"];\n")
+        dotOut.write("}\n")
+    print(f"{os.path.basename(path)} successfully generated!")
+
+def write_event_prototypes(hOut, events, payloads, guards):
+    for event in events:
+        event_name = generate_string(event,"Name")[:-1]
+        event_func = generate_string(event)
+        hOut.write("\t/*!\n")
+        hOut.write(f"\t * \\brief Your {event_name} event description\n")
+        hOut.write("\t *\n")
+        hOut.write(f"\t * Your extended {event_name} event description\n")
+        hOut.write("\t *\n")
+        if event in payloads:
+            hOut.write(f"\t * \\param data payload of event, set data->{payloads[event]} when event occurred\n")
+        hOut.write("\t * \\return true if [event true description], false otherwise\n")
+        hOut.write("\t */\n")
+        if event in payloads:
+            hOut.write(f"\tbool {event_func}(StateMachine::STT_EVENT_DATA * data);\n")
+        else:
+            hOut.write(f"\tbool {event_func}(void);\n")
+    for guard in guards:
+        guard_name = generate_string(guard,"Name")[:-1]
+        guard_func = generate_string(guard)
+        hOut.write("\t/*!\n")
+        hOut.write(f"\t * \\brief Your {guard_name} guard description\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Checked after its event occurred, the transition is only taken if the guard returns true.\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * \\param data payload of event\n")
+        hOut.write("\t * \\return true if transition is allowed, false otherwise\n")
+        hOut.write("\t */\n")
+        hOut.write(f"\tbool {guard_func}Guard(const StateMachine::STT_EVENT_DATA * data);\n")
+
+def write_event_definitions(cppOut, namespace, events, payloads, guards, event_result):
+    for event in events:
+        event_name = generate_string(event,"Name")[:-1]
+        event_func = generate_string(event)
+        if event in payloads:
+            cppOut.write(f"bool {namespace}::{event_func}(StateMachine::STT_EVENT_DATA * data)\n")
+        else:
+            cppOut.write(f"bool {namespace}::{event_func}(void)\n")
+        cppOut.write("{\n")
+        if event in payloads:
+            cppOut.write("\t(void)data;\n")
+        cppOut.write("\t/*\n")
+        cppOut.write(f"\t * TODO: implement {event_name} Event\n")
+        if event in payloads:
+            cppOut.write(f"\t * store its payload in data->{payloads[event]}\n")
+        cppOut.write("\t */\n")
+        cppOut.write(f"\treturn {event_result};\n")
+        cppOut.write("}\n\n")
+    if guards:
+        cppOut.write("//guard functions\n\n")
+    for guard in guards:
+        guard_name = generate_string(guard,"Name")[:-1]
+        guard_func = generate_string(guard)
+        cppOut.write(f"bool {namespace}::{guard_func}Guard(const StateMachine::STT_EVENT_DATA * data)\n")
+        cppOut.write("{\n")
+        cppOut.write("\t(void)data;\n")
+        cppOut.write("\t/*\n")
+        cppOut.write(f"\t * TODO: implement {guard_name} Guard\n")
+        cppOut.write("\t */\n")
+        cppOut.write("\treturn true;\n")
+        cppOut.write("}\n\n")
+
+def create_table_code(file_name, state_machine):
+    states = [s for s in state_machine.values() if not s.isSuper]
+    events = get_ordered_events(state_machine)
+    payloads = get_event_payloads(state_machine)
+    guards = get_guards(state_machine)
+    namespace = generate_string(file_name)
+    fNameAllCaps = generate_string(file_name, "ALL_CAPS")
+    with open(os.path.join(file_name+"_cpp",f"{file_name}.h"),"w") as hOut:
+        write_header_on_file(hOut, f"{file_name}.h", "State, event, transition table, and function definitions for your table-driven state machine.")
+        hOut.write(f"#ifndef __{fNameAllCaps}H__\n")
+        hOut.write(f"#define __{fNameAllCaps}H__\n\n")
+        hOut.write("#include \"state_machine.h\"\n")
+        hOut.write("//Add your includes---------------------\n\n\n")
+        hOut.write("//Add your macros-----------------------\n\n\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Namespace containing all function and structure definitions to implement your table-driven state machine.\n")
+        hOut.write(" *\n")
+        hOut.write(" * Contains defined STT_STATEs and STT_EVENTs, state functions, and the dispatch loop. Transitions are looked up in a constant [state][event] table.\n")
+        hOut.write(" */\n")
+        hOut.write(f"namespace {namespace}\n")
+        hOut.write("{\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Defined enum of STT_STATEs\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Enum of uint8_t for all implemented states. Super states are merged into their sub-states' transition table rows.\n")
+        hOut.write("\t */\n")
+        hOut.write("\tenum STT_STATE : uint8_t {\n")
+        for i, state in enumerate(states):
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            hOut.write(f"\t\t{state_enum}")
+            if i < len(states) - 1:
+                hOut.write(",")
+            hOut.write("\n")
+        hOut.write("\t};\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Defined enum of STT_EVENTs\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Enum of uint8_t for all events, NO_EVENT selects each state's default transition.\n")
+        hOut.write("\t */\n")
+        hOut.write("\tenum STT_EVENT : uint8_t {\n")
+        hOut.write("\t\tNO_EVENT,\n")
+        for event in events:
+            event_enum = generate_string(event, "ALL_CAPS")[:-1]
+            hOut.write(f"\t\t{event_enum},\n")
+        hOut.write("\t\tNUM_STT_EVENTS\n")
+        hOut.write("\t};\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Type definition for table-driven state action function pointer\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * The function pointer which performs all actions during a specific state, given the event read this cycle. Transitions are handled by the transition table.\n")
+        hOut.write("\t */\n")
+        hOut.write("\ttypedef void (*STT_TABLE_ACTION)(STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);\n")
+        if guards:
+            hOut.write("\t/*!\n")
+            hOut.write("\t * \\brief Type definition for guard function pointer\n")
+            hOut.write("\t *\n")
+            hOut.write("\t * The function pointer which allows (true) or blocks (false) a transition, given the payload of its event.\n")
+            hOut.write("\t */\n")
+            hOut.write("\ttypedef bool (*STT_GUARD)(const StateMachine::STT_EVENT_DATA * data);\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Sets initial state of state machine\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * \\param current_state pointer to state variable of state machine\n")
+        hOut.write("\t */\n")
+        hOut.write(f"\tvoid Get{namespace}(StateMachine::STT_STATE * current_state);\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Looks up the state to transition to\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * \\param current_state current state of state machine\n")
+        hOut.write("\t * \\param event event which occurred (NO_EVENT for default transition)\n")
+        hOut.write("\t * \\param data payload of event, passed to the transition's guard\n")
+        hOut.write("\t * \\return state to transition to (current state if a guard blocks the transition)\n")
+        hOut.write("\t */\n")
+        hOut.write("\tStateMachine::STT_STATE GetNextState(StateMachine::STT_STATE current_state, STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Dispatch loop of state machine\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Reads one event with GetEvent(), performs the current state action with it and transitions with a single table lookup. Call in your superloop.\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * \\param current_state pointer to state variable of state machine\n")
+        hOut.write("\t */\n")
+        hOut.write("\tvoid ExecuteTable(StateMachine::STT_STATE * current_state);\n")
+        for state in states:
+            stateName = generate_string(state.state,"Name")[:-1]
+            state_cap = generate_string(state.state, "ALL_CAPS")[:-1]
+            state_function = generate_string(state.state)
+            hOut.write("\t/*!\n")
+            hOut.write(f"\t * \\brief {stateName} State action function ({state_cap})\n")
+            hOut.write("\t *\n")
+            hOut.write(f"\t * Your description for {stateName} State action function\n")
+            hOut.write("\t *\n")
+            hOut.write("\t * \\param event event read this cycle (NO_EVENT if none)\n")
+            hOut.write("\t * \\param data payload of event\n")
+            hOut.write("\t */\n")
+            hOut.write(f"\tvoid {state_function}StateAction(STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);\n")
+        hOut.write("\n\t//common action functions and events----------------\n\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Reads the next event\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Returns the highest priority event which occurred, or NO_EVENT. Only the events with a transition in the current state are checked.\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * \\param current_state current state of state machine\n")
+        hOut.write("\t * \\param data payload of event (filled in by events with a payload type)\n")
+        hOut.write("\t * \\return event to dispatch\n")
+        hOut.write("\t */\n")
+        hOut.write("\tSTT_EVENT GetEvent(StateMachine::STT_STATE current_state, StateMachine::STT_EVENT_DATA * data);\n")
+        hOut.write("\t/* #######################################################################################################################\n")
+        hOut.write("\t * TODO: add function prototypes here for common actions and modify/add events below to implement your state machine here.\n")
+        hOut.write("\t * #######################################################################################################################\n")
+        hOut.write("\t */\n\n")
+        write_event_prototypes(hOut, events, payloads, guards)
+        hOut.write("}\n\n")
+        hOut.write(f"#endif //__{fNameAllCaps}H__\n")
+    print(f"{file_name}.h successfully generated!")
+    with open(os.path.join(file_name+"_cpp",f"{file_name}.cpp"),"w") as cppOut:
+        write_header_on_file(cppOut, f"{file_name}.cpp", "State, event, transition table, and function definitions for your table-driven state machine.")
+        cppOut.write(f"#include \"{file_name}.h\"\n\n")
+        cppOut.write("//Add your public vars----------------\n\n\n")
+        cppOut.write("//transition and action tables (placed in flash)\n")
+        cppOut.write(f"namespace {namespace}\n")
+        cppOut.write("{\n")
+        cppOut.write("\t//[state][event] -> next state\n")
+        cppOut.write("\tconstexpr StateMachine::STT_STATE TRANSITION_TABLE[NUM_STT_STATES][NUM_STT_EVENTS] = {\n")
+        event_header = "NO_EVENT"
+        for event in events:
+            event_header += ", " + generate_string(event, "ALL_CAPS")[:-1]
+        cppOut.write(f"\t\t//{event_header}\n")
+        for i, state in enumerate(states):
+            row = [generate_string(state.default.state, "ALL_CAPS")[:-1]]
+            for event in events:
+                row.append(generate_string(get_table_transition(state, event).state, "ALL_CAPS")[:-1])
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            cppOut.write(f"\t\t{{{', '.join(row)}}}")
+            if i < len(states) - 1:
+                cppOut.write(",")
+            cppOut.write(f"\t\t//{state_enum}\n")
+        cppOut.write("\t};\n")
+        if guards:
+            cppOut.write("\t//[state][event] -> guard of transition (nullptr if none)\n")
+            cppOut.write("\tconstexpr STT_GUARD GUARD_TABLE[NUM_STT_STATES][NUM_STT_EVENTS] = {\n")
+            for i, state in enumerate(states):
+                row = ["nullptr"]
+                for event in events:
+                    guard = get_table_guard(state, event)
+                    row.append(f"&{generate_string(guard)}Guard" if guard is not None else "nullptr")
+                state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+                cppOut.write(f"\t\t{{{', '.join(row)}}}")
+                if i < len(states) - 1:
+                    cppOut.write(",")
+                cppOut.write(f"\t\t//{state_enum}\n")
+            cppOut.write("\t};\n")
+        cppOut.write("\tconstexpr STT_TABLE_ACTION STATE_ACTIONS[NUM_STT_STATES] = {\n")
+        for i, state in enumerate(states):
+            state_func = generate_string(state.state)
+            cppOut.write(f"\t\t&{state_func}StateAction")
+            if i < len(states) - 1:
+                cppOut.write(",")
+            cppOut.write("\n")
+        cppOut.write("\t};\n")
+        cppOut.write("}\n\n")
+        cppOut.write("//state machine getter\n")
+        init_state = generate_string(list(state_machine.keys())[0], "ALL_CAPS")[:-1]
+        cppOut.write(f"void {namespace}::Get{namespace}(StateMachine::STT_STATE * current_state)\n")
+        cppOut.write("{\n")
+        cppOut.write(f"\t*current_state = STT_STATE::{init_state};\n")
+        cppOut.write("}\n\n")
+        cppOut.write("//dispatch functions\n")
+        cppOut.write(f"StateMachine::STT_STATE {namespace}::GetNextState(StateMachine::STT_STATE current_state, {namespace}::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)\n")
+        cppOut.write("{\n")
+        if guards:
+            cppOut.write("\tSTT_GUARD guard = GUARD_TABLE[current_state][event];\n")
+            cppOut.write("\tif(guard != nullptr && !guard(data)) return current_state;\n")
+        else:
+            cppOut.write("\t(void)data;\n")
+        cppOut.write("\treturn TRANSITION_TABLE[current_state][event];\n")
+        cppOut.write("}\n\n")
+        cppOut.write(f"void {namespace}::ExecuteTable(StateMachine::STT_STATE * current_state)\n")
+        cppOut.write("{\n")
+        cppOut.write("\tStateMachine::STT_EVENT_DATA data = {};\n")
+        cppOut.write("\tSTT_EVENT event = GetEvent(*current_state, &data);\n")
+        cppOut.write("\tSTATE_ACTIONS[*current_state](event, &data);\n")
+        cppOut.write("\t*current_state = GetNextState(*current_state, event, &data);\n")
+        cppOut.write("}\n\n")
+        cppOut.write("//state action functions\n")
+        for state in states:
+            state_func = generate_string(state.state)
+            state_name = generate_string(state.state, "Name")[:-1]
+            cppOut.write(f"void {namespace}::{state_func}StateAction({namespace}::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)\n")
+            cppOut.write("{\n")
+            cppOut.write("\t(void)event;\n")
+            cppOut.write("\t(void)data;\n")
+            cppOut.write("\t/*\n")
+            cppOut.write(f"\t * TODO: implement actions for {state_name} State\n")
+            cppOut.write("\t */\n")
+            cppOut.write("}\n\n")
+        cppOut.write("//common event functions\n\n")
+        cppOut.write(f"{namespace}::STT_EVENT {namespace}::GetEvent(StateMachine::STT_STATE current_state, StateMachine::STT_EVENT_DATA * data)\n")
+        cppOut.write("{\n")
+        cppOut.write("\t/*\n")
+        cppOut.write("\t * TODO: replace polling with events posted from ISRs if desired, earlier events have higher priority\n")
+        cppOut.write("\t */\n")
+        if not [e for e in events if e in payloads]:
+            cppOut.write("\t(void)data;\n")
+        cppOut.write("\tswitch(current_state)\n")
+        cppOut.write("\t{\n")
+        for state in states:
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            cppOut.write(f"\t\tcase STT_STATE::{state_enum}:\n")
+            for event in get_state_events(state, events):
+                event_func = generate_string(event)
+                event_enum = generate_string(event, "ALL_CAPS")[:-1]
+                cppOut.write(f"\t\t\tif({event_func}({'data' if event in payloads else ''})) return STT_EVENT::{event_enum};\n")
+            cppOut.write("\t\t\tbreak;\n")
+        cppOut.write("\t\tdefault:\n")
+        cppOut.write("\t\t\tbreak;\n")
+        cppOut.write("\t}\n")
+        cppOut.write("\treturn STT_EVENT::NO_EVENT;\n")
+        cppOut.write("}\n\n")
+        cppOut.write("/* ############################################################\n")
+        cppOut.write(" * TODO: add/remove/implement event function definitions below.\n")
+        cppOut.write(" * ############################################################\n")
+        cppOut.write(" */\n\n")
+        write_event_definitions(cppOut, namespace, events, payloads, guards, "false")
+        cppOut.write("//common action functions\n\n")
+        cppOut.write("/* #############################################\n")
+        cppOut.write(" * TODO: implement common action functions here.\n")
+        cppOut.write(" * #############################################\n")
+        cppOut.write(" */\n\n")
+    print(f"{file_name}.cpp successfully generated!")
+    return True
+
+def get_hsm_transition(state, event):
+    # transition of the state's own row, a hierarchical state machine passes other events to the super state
+    return state.events[event] if event in state.events else None
+
+def create_hsm_code(file_name, state_machine):
+    states = list(state_machine.values())
+    events = get_ordered_events(state_machine)
+    payloads = get_event_payloads(state_machine)
+    guards = get_guards(state_machine)
+    namespace = generate_string(file_name)
+    fNameAllCaps = generate_string(file_name, "ALL_CAPS")
+    with open(os.path.join(file_name+"_cpp",f"{file_name}.h"),"w") as hOut:
+        write_header_on_file(hOut, f"{file_name}.h", "State, event, state table, and function definitions for your hierarchical state machine.")
+        hOut.write(f"#ifndef __{fNameAllCaps}H__\n")
+        hOut.write(f"#define __{fNameAllCaps}H__\n\n")
+        hOut.write("#include \"state_machine.h\"\n")
+        hOut.write("//Add your includes---------------------\n\n\n")
+        hOut.write("//Add your macros-----------------------\n\n\n")
+        hOut.write("/*!\n")
+        hOut.write(" * \\brief Namespace containing all function and structure definitions to implement your hierarchical state machine.\n")
+        hOut.write(" *\n")
+        hOut.write(" * Contains defined STT_STATEs and STT_EVENTs and state functions. Each state is a row of a constant StateMachine::STT_HSM_STATE table, with its super state as parent.\n")
+        hOut.write(" */\n")
+        hOut.write(f"namespace {namespace}\n")
+        hOut.write("{\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Defined enum of STT_STATEs\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Enum of uint8_t for all implemented states, in state table row order. Super states get rows like any other state.\n")
+        hOut.write("\t */\n")
+        hOut.write("\tenum STT_STATE : uint8_t {\n")
+        for i, state in enumerate(states):
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            hOut.write(f"\t\t{state_enum}")
+            if i < len(states) - 1:
+                hOut.write(",")
+            hOut.write("\n")
+        hOut.write("\t};\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Defined enum of STT_EVENTs\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Enum of uint8_t for all events posted to the state machine with StateMachine::PostEvent().\n")
+        for event in events:
+            if event in payloads:
+                hOut.write(f"\t * {generate_string(event, 'ALL_CAPS')[:-1]} is posted with its payload in data->{payloads[event]}.\n")
+        hOut.write("\t */\n")
+        hOut.write("\tenum STT_EVENT : uint8_t {\n")
+        hOut.write("\t\tENTRY_EVENT = StateMachine::EVENT_ENTRY")
+        for event in events:
+            event_enum = generate_string(event, "ALL_CAPS")[:-1]
+            hOut.write(f",\n\t\t{event_enum}")
+        hOut.write("\n\t};\n")
+        hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Populates state machine struct with values\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Initializes hierarchical state machine with the state table and enters the initial state.\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * \\param state_machine pointer to state machine which will be populated with values\n")
+        hOut.write("\t */\n")
+        hOut.write(f"\tvoid Get{namespace}(StateMachine::STT_HSM * state_machine);\n")
+        for state in states:
+            stateName = generate_string(state.state,"Name")[:-1]
+            state_cap = generate_string(state.state, "ALL_CAPS")[:-1]
+            state_function = generate_string(state.state)
+            hOut.write("\t/*!\n")
+            hOut.write(f"\t * \\brief {stateName} State action function ({state_cap})\n")
+            hOut.write("\t *\n")
+            hOut.write(f"\t * Your description for {stateName} State action function\n")
+            hOut.write("\t *\n")
+            hOut.write("\t * \\param event event being dispatched\n")
+            hOut.write("\t * \\param data payload of event\n")
+            if state.super is not None:
+                hOut.write("\t * \\return state to transition to, or StateMachine::STT_UNHANDLED to pass the event to the super state\n")
+            else:
+                hOut.write("\t * \\return state to transition to\n")
+            hOut.write("\t */\n")
+            hOut.write(f"\tStateMachine::STT_STATE {state_function}StateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data);\n")
+        hOut.write("\n\t//common action functions and events----------------\n\n")
+        hOut.write("\t/* #######################################################################################################################\n")
+        hOut.write("\t * TODO: add function prototypes here for common actions, and post events from your ISRs with StateMachine::PostEvent().\n")
+        hOut.write("\t * #######################################################################################################################\n")
+        hOut.write("\t */\n\n")
+        write_event_prototypes(hOut, [], payloads, guards)
+        hOut.write("}\n\n")
+        hOut.write(f"#endif //__{fNameAllCaps}H__\n")
+    print(f"{file_name}.h successfully generated!")
+    with open(os.path.join(file_name+"_cpp",f"{file_name}.cpp"),"w") as cppOut:
+        write_header_on_file(cppOut, f"{file_name}.cpp", "State, event, state table, and function definitions for your hierarchical state machine.")
+        cppOut.write(f"#include \"{file_name}.h\"\n\n")
+        cppOut.write("//Add your public vars----------------\n\n\n")
+        cppOut.write("//state table, rows in STT_STATE order\n")
+        cppOut.write("constexpr StateMachine::STT_HSM_STATE STATE_TABLE[] = {\n")
+        cppOut.write("\t//parent, entry action, exit action, state action\n")
+        for i, state in enumerate(states):
+            if state.super is None:
+                parent = "StateMachine::STT_NO_PARENT"
+            else:
+                parent = f"{namespace}::STT_STATE::{generate_string(state.super.state, 'ALL_CAPS')[:-1]}"
+            cppOut.write(f"\t{{{parent}, nullptr, nullptr, &{namespace}::{generate_string(state.state)}StateAction}}")
+            if i < len(states) - 1:
+                cppOut.write(",")
+            cppOut.write("\n")
+        cppOut.write("};\n")
+        cppOut.write(f"static_assert(StateMachine::IsValidHSMTable(STATE_TABLE, sizeof(STATE_TABLE) / sizeof(STATE_TABLE[0])), \"Invalid {generate_string(file_name, 'Name')[:-1].lower()} state table\");\n\n")
+        cppOut.write("//state machine struct getter\n")
+        init_state = generate_string(states[0].state, "ALL_CAPS")[:-1]
+        cppOut.write(f"void {namespace}::Get{namespace}(StateMachine::STT_HSM * state_machine)\n")
+        cppOut.write("{\n")
+        cppOut.write(f"\tStateMachine::InitHSM(state_machine, STATE_TABLE, sizeof(STATE_TABLE) / sizeof(STATE_TABLE[0]), STT_STATE::{init_state});\n")
+        cppOut.write("}\n\n")
+        cppOut.write("//state action functions\n")
+        for state in states:
+            state_func = generate_string(state.state)
+            state_name = generate_string(state.state, "Name")[:-1]
+            state_enum = generate_string(state.state, "ALL_CAPS")[:-1]
+            cppOut.write(f"StateMachine::STT_STATE {namespace}::{state_func}StateAction(StateMachine::STT_EVENT event, const StateMachine::STT_EVENT_DATA * data)\n")
+            cppOut.write("{\n")
+            cppOut.write("\t(void)data;\n")
+            cppOut.write("\t/*\n")
+            cppOut.write(f"\t * TODO: implement actions for {state_name} State\n")
+            cppOut.write("\t */\n")
+            cppOut.write("\tswitch(event)\n")
+            cppOut.write("\t{\n")
+            if state.default is not state:
+                cppOut.write("\t\tcase STT_EVENT::ENTRY_EVENT:\n")
+                cppOut.write(f"\t\t\treturn STT_STATE::{generate_string(state.default.state, 'ALL_CAPS')[:-1]};\n")
+            for event in events:
+                next_state = get_hsm_transition(state, event)
+                if next_state is None:
+                    continue
+                guard = state.guards.get(event)
+                cppOut.write(f"\t\tcase STT_EVENT::{generate_string(event, 'ALL_CAPS')[:-1]}:\n")
+                if guard is not None:
+                    cppOut.write(f"\t\t\tif(!{generate_string(guard)}Guard(data)) return STT_STATE::{state_enum};\n")
+                cppOut.write(f"\t\t\treturn STT_STATE::{generate_string(next_state.state, 'ALL_CAPS')[:-1]};\n")
+            cppOut.write("\t\tdefault:\n")
+            cppOut.write("\t\t\tbreak;\n")
+            cppOut.write("\t}\n")
+            if state.super is not None:
+                cppOut.write("\t//super state handles all other events\n")
+                cppOut.write("\treturn StateMachine::STT_UNHANDLED;\n")
+            else:
+                cppOut.write(f"\treturn STT_STATE::{state_enum};\n")
+            cppOut.write("}\n\n")
+        write_event_definitions(cppOut, namespace, [], payloads, guards, "false")
+        cppOut.write("//common action functions\n\n")
+        cppOut.write("/* #############################################\n")
+        cppOut.write(" * TODO: implement common action functions here.\n")
+        cppOut.write(" * #############################################\n")
+        cppOut.write(" */\n\n")
+    print(f"{file_name}.cpp successfully generated!")
+    return True
+
+def create_code_from_csv(file_name, table_mode=False, optimize=False, strict=False, hsm_mode=False):
     MY_STATE_MACHINE = "my_state_machine"
     input = read_csv(file_name)
     print(f"Reading from {file_name}...\n")
@@ -147,6 +850,10 @@ def create_code_from_csv(file_name):
     state_machine = {}
     if not(initialize_state_machine(input, state_machine) and populate_state_machine(input, state_machine)):
         return False
+    if not analyze_state_machine(state_machine, strict, hsm_mode):
+        return False
+    if optimize:
+        state_machine = optimize_state_machine(state_machine)
     for state in state_machine.values():
         print(state)
     print("\n")
@@ -154,6 +861,11 @@ def create_code_from_csv(file_name):
         file_name = MY_STATE_MACHINE
     if not os.path.isdir(file_name+"_cpp"):
         os.mkdir(file_name+"_cpp")
+    create_graphviz_file(os.path.join(file_name+"_cpp",f"{file_name}.dot"), file_name, state_machine)
+    if hsm_mode:
+        # STT_HSM is only in the library's state_machine.h, so it is not generated
+        print("Copy state_machine.h and state_machine.cpp from SerialLibraryExample next to the generated files.")
+        return create_hsm_code(file_name, state_machine)
     with open(os.path.join(file_name+"_cpp","state_machine.h"),"w") as hOut:
         write_header_on_file(hOut, "state_machine.h", "Simple process manager for creating streamlined code with multiple states, events, and actions.")
         hOut.write("#ifndef __STATE_MACHINE_H__\n")
@@ -188,6 +900,16 @@ def create_code_from_csv(file_name):
         hOut.write("\t */\n")
         hOut.write("\ttypedef STT_STATE (*STT_ACTION)(void);\n")
         hOut.write("\t/*!\n")
+        hOut.write("\t * \\brief Payload of an event\n")
+        hOut.write("\t *\n")
+        hOut.write("\t * Filled in by event functions with a payload type, and passed to guard functions.\n")
+        hOut.write("\t */\n")
+        hOut.write("\tunion STT_EVENT_DATA {\n")
+        hOut.write("\t\tuint32_t u32;\t\t//!< unsigned integer payload\n")
+        hOut.write("\t\tint32_t i32;\t\t//!< signed integer payload\n")
+        hOut.write("\t\tfloat f32;\t\t\t//!< floating point payload\n")
+        hOut.write("\t};\n")
+        hOut.write("\t/*!\n")
         hOut.write("\t * \\brief State machine struct containing the base state and all rows in the program.\n")
         hOut.write("\t *\n")
         hOut.write("\t * Contains the current state of the state machine and array of state action functions.\n")
@@ -233,7 +955,11 @@ def create_code_from_csv(file_name):
         cppOut.write("\t\t*current_state = temp_state;\n")
         cppOut.write("}\n")
     print("state_machine.cpp successfully generated!")
+    if table_mode:
+        return create_table_code(file_name, state_machine)
     all_events = []
+    payloads = get_event_payloads(state_machine)
+    guards = get_guards(state_machine)
     with open(os.path.join(file_name+"_cpp",f"{file_name}.h"),"w") as hOut:
         write_header_on_file(hOut, f"{file_name}.h", "State, event, action, and function definitions for your state machine.")
         fNameAllCaps = generate_string(file_name, "ALL_CAPS")
@@ -313,17 +1039,7 @@ def create_code_from_csv(file_name):
         hOut.write("\t * #######################################################################################################################\n")
         hOut.write("\t */\n\n")
         all_events = [*set(all_events)]
-        for event in all_events:
-            event_name = generate_string(event,"Name")[:-1]
-            event_func = generate_string(event)
-            hOut.write("\t/*!\n")
-            hOut.write(f"\t * \\brief Your {event_name} event description\n")
-            hOut.write("\t *\n")
-            hOut.write(f"\t * Your extended {event_name} event description\n")
-            hOut.write("\t *\n")
-            hOut.write("\t * \\return true if [event true description], false otherwise\n")
-            hOut.write("\t */\n")
-            hOut.write(f"\tbool {event_func}(void);\n")
+        write_event_prototypes(hOut, all_events, payloads, guards)
         hOut.write("}\n\n")
         hOut.write(f"#endif //__{fNameAllCaps}H__\n")
     print(f"{file_name}.h successfully generated!")
@@ -354,18 +1070,20 @@ def create_code_from_csv(file_name):
             if state.super:
                 cppOut.write(f"\tStateMachine::STT_STATE current_state = STT_STATE::{state_default};\n")
                 state_trans_str = "current_state = STT_STATE::"
+            if state.guards or [e for e in state.events.keys() if e in payloads]:
+                cppOut.write("\tStateMachine::STT_EVENT_DATA data = {};\n")
             cppOut.write("\t/*\n")
             cppOut.write(f"\t * TODO: implement actions for {state_name} State\n")
             cppOut.write("\t */\n")
             else_suffix = ""
             for event, s in state.events.items():
                 next_state = generate_string(s.state, "ALL_CAPS")[:-1]
-                event_func = generate_string(event)
                 event_name = generate_string(event, "Name")[:-1]
-                cppOut.write(f"\t{else_suffix}if({event_func}())\n")
+                payload_str = f" (payload in data.{payloads[event]})" if event in payloads else ""
+                cppOut.write(f"\t{else_suffix}if({get_event_condition(event, state.guards.get(event), payloads)})\n")
                 cppOut.write("\t{\n")
                 cppOut.write("\t\t/*\n")
-                cppOut.write(f"\t\t * TODO: implement actions for {event_name} Event\n")
+                cppOut.write(f"\t\t * TODO: implement actions for {event_name} Event{payload_str}\n")
                 cppOut.write("\t\t */\n")
                 cppOut.write(f"\t\t{state_trans_str}{next_state};\n")
                 cppOut.write("\t}\n")
@@ -383,16 +1101,7 @@ def create_code_from_csv(file_name):
         cppOut.write(" * TODO: add/remove/implement event function definitions below.\n")
         cppOut.write(" * ############################################################\n")
         cppOut.write(" */\n\n")
-        for event in all_events:
-            event_name = generate_string(event,"Name")[:-1]
-            event_func = generate_string(event)
-            cppOut.write(f"bool {namespace}::{event_func}(void)\n")
-            cppOut.write("{\n")
-            cppOut.write("\t/*\n")
-            cppOut.write(f"\t * TODO: implement {event_name} Event\n")
-            cppOut.write("\t */\n")
-            cppOut.write("\treturn true;\n")
-            cppOut.write("}\n\n")
+        write_event_definitions(cppOut, namespace, all_events, payloads, guards, "true")
         cppOut.write("//common action functions\n\n")
         cppOut.write("/* #############################################\n")
         cppOut.write(" * TODO: implement common action functions here.\n")
@@ -403,12 +1112,19 @@ def create_code_from_csv(file_name):
 
 
 def main():
+    table_mode = "--table" in sys.argv[1:]
+    optimize = "--optimize" in sys.argv[1:]
+    strict = "--strict" in sys.argv[1:]
+    hsm_mode = "--hsm" in sys.argv[1:]
+    if hsm_mode and table_mode:
+        print("--hsm and --table can't be combined!")
+        return
     files = get_csv_files_in_dir()
     if not files:
         print("Could not find csv file in directory!")
         return
     for file in files:
-        create_code_from_csv(file)
+        create_code_from_csv(file, table_mode, optimize, strict, hsm_mode)
     
 
 